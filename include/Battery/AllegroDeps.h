@@ -2,6 +2,11 @@
 
 #include "Battery/Core/Config.h"
 
+// The GLX declarations would pull in the X11 headers, whose macros (None, Bool, Status...) clash with the engine
+#ifndef _WIN32
+#define ALLEGRO_EXCLUDE_GLX
+#endif
+
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_font.h>
 #include <allegro5/allegro_ttf.h>
@@ -9,5 +14,7 @@
 #include <allegro5/allegro_native_dialog.h>
 #include <allegro5/allegro_image.h>
 #include <allegro5/allegro_opengl.h>
+#ifdef _WIN32
 #include <allegro5/allegro_windows.h>
+#endif
 #include <allegro5/allegro_memfile.h>
@@ -13,11 +13,32 @@
 #include "Battery/Core/Event.h"
 #include "Battery/Utils/TimeUtils.h"
 #include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/HashUtils.h"
+#include "Battery/Utils/JsonUtils.h"
+#include "Battery/Utils/BinaryUtils.h"
 #include "Battery/Utils/MathUtils.h"
+#include "Battery/Utils/ThreadPool.h"
 #include "Battery/Platform/Dialog.h"
 #include "Battery/Log/Log.h"
 #include "Battery/Renderer/Renderer2D.h"
 #include "Battery/Renderer/Texture2D.h"
+#include "Battery/Renderer/SharedTexture.h"
+#include "Battery/Renderer/MipmapChain.h"
+#include "Battery/Renderer/ImageFilter.h"
+#include "Battery/Renderer/AsyncTextureLoader.h"
+#include "Battery/Renderer/AtlasPacker.h"
+#include "Battery/Renderer/TextureAtlas.h"
+#include "Battery/Renderer/TextureResidency.h"
+#include "Battery/Renderer/TiledImage.h"
+#include "Battery/Renderer/SoftwareRasterizer.h"
+#include "Battery/Renderer/RenderRegression.h"
+#include "Battery/Renderer/PathTessellator.h"
+#include "Battery/Renderer/PlotSeries.h"
+#include "Battery/Renderer/SpatialIndex.h"
+#include "Battery/Renderer/Font.h"
+#include "Battery/Renderer/StreamBuffer.h"
+#include "Battery/Core/AssetCache.h"
 #include "Battery/Renderer/ShaderProgram.h"
 #include "Battery/Renderer/StaticImGuiWindow.h"
 
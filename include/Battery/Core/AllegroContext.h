@@ -16,7 +16,8 @@ namespace Battery {
 
 	public:
 
-		bool Initialize(const std::string& applicationName);
+		// Without a display there are no input devices, headless skips installing them
+		bool Initialize(const std::string& applicationName, bool headless = false);
 		bool IsInitialized();
 		void Destroy();
 
@@ -36,6 +36,8 @@ namespace Battery {
 		void SetEventCallback(std::function<void(Battery::Event* event)> eventCallback);
 		void HandleEvents();
 		void HandleEvent(Battery::Event* event);
+		// Blocks until an event is queued or the timeout in seconds ran out, the event stays queued
+		bool WaitForEvent(double timeout);
 
 		glm::ivec2 GetScreenPosition();
 		void SetScreenPosition(const glm::ivec2& position);
@@ -51,7 +53,9 @@ namespace Battery {
 		bool GetLeftMouseButton();
 		bool GetRightMouseButton();
 		bool GetMouseWheel();
+#ifdef _WIN32
 		HWND GetWinHandle();
+#endif
 		bool IsFocused();
 		bool Focus();
 		bool Hide();
@@ -86,7 +90,7 @@ namespace Battery {
 		/// of your final project.
 		/// </summary>
 		/// <param name="iconID">- the id of the embedded icon in the executable.</param>
-		/// <returns>bool - if loading the icon was successful</returns>
+		/// <returns>bool - if loading the icon was successful, always false on other platforms than Windows</returns>
 		bool __setWindowsIconID(int iconID);
 
 		ALLEGRO_DISPLAY* allegroDisplayPointer = nullptr;
@@ -100,6 +104,7 @@ namespace Battery {
 		int width = 0;
 		int height = 0;
 		bool valid = false;
+		bool focused = true;					// Only used where the window system can't be asked
 
 		ParentEventContainer eventContainer;
 		std::function<void(Battery::Event* event)> eventCallback = nullptr;
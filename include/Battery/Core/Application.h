@@ -8,6 +8,7 @@
 #include "Battery/Core/AllegroWindow.h"
 #include "Battery/Core/Config.h"
 #include "Battery/Core/Event.h"
+#include "Battery/Renderer/Renderer2D.h"
 #include "Battery/Utils/TimeUtils.h"
 #include "Battery/Platform/Dialog.h"
 #include "Battery/Log/Log.h"
@@ -35,7 +36,9 @@ namespace Battery {
 	class Application {
 	public:
 
-		Application(int width, int height, const std::string applicationFolderName = BATTERY_DEFAULT_FOLDER_NAME);
+		// The software backend renders without a window, see Renderer2D::GetSoftwareRasterizer()
+		Application(int width, int height, const std::string applicationFolderName = BATTERY_DEFAULT_FOLDER_NAME,
+			RenderBackend renderBackend = RenderBackend::OPENGL);
 		virtual ~Application();
 
 		virtual bool OnStartup() { return true; }
@@ -50,14 +53,44 @@ namespace Battery {
 		// TODO: Add keyboard leds cuz why not
 
 		void SetFramerate(double f);
-		void SetWindowFlag(enum class WindowFlags flag);
-		void ClearWindowFlag(enum class WindowFlags flag);
+		void SetWindowFlag(WindowFlags flag);
+		void ClearWindowFlag(WindowFlags flag);
 		void PushLayer(Layer* layer);
 		void PushOverlay(Layer* overlay);
 		void ClearLayerStack();
-		void CloseApplication();
+		// The exit code is returned by main(), e.g. for test applications
+		void CloseApplication(int exitCode = 0);
+		int GetExitCode() const;
 		void DiscardFrame();
 
+		/// <summary>
+		/// In dirty rectangle mode, a frame is only rendered when something was invalidated since the last one and
+		/// drawing is clipped to the invalidated region (see Renderer2D::PushClipRect()), the rest of the window
+		/// keeps its content. Idle frames are neither rendered nor flipped. Layers report what they changed through
+		/// their application pointer. Enable it in the constructor, so the window gets a back buffer which keeps its
+		/// content after flipping, otherwise every rendered frame is drawn completely.
+		/// </summary>
+		void SetDirtyRectMode(bool enabled);
+		bool GetDirtyRectMode() const;
+		void Invalidate(const glm::vec2& min, const glm::vec2& max);
+		void InvalidateAll();
+		// Whether the next frame is rendered
+		bool IsInvalidated() const;
+
+		/// <summary>
+		/// In lazy rendering mode, the main loop blocks on the event queue while nothing has to be drawn, for tools
+		/// which are idle most of the time. A frame is rendered after an event, when a redraw was requested or
+		/// when something was invalidated. Updates still run at least every BATTERY_LAZY_RENDERING_MAX_WAIT
+		/// seconds. Together with the dirty rectangle mode, events only wake the loop and layers invalidate what
+		/// they changed.
+		/// </summary>
+		void SetLazyRendering(bool enabled);
+		bool GetLazyRendering() const;
+		// Renders at least the next few frames completely, e.g. while something animates
+		void RequestRedraw(int frames = 1);
+		// Renders a frame once the time has passed, the earliest request wins
+		void RequestRedrawAfter(double seconds);
+
 		static Application* GetApplicationPointer();
 
 	private:
@@ -73,6 +106,7 @@ namespace Battery {
 		void _updateApp();
 		void _renderApp();
 		void _onEvent(Battery::Event* e);
+		void _waitForRedraw();
 
 	// All layers should have access through the application pointer
 	public:
@@ -91,8 +125,23 @@ namespace Battery {
 	private:
 		static Application* applicationPointer;
 		std::string applicationFolderName;
+		RenderBackend renderBackend = RenderBackend::OPENGL;
 		int windowFlags = (int)WindowFlags::NONE;
 		bool frameDiscarded = false;
+		int exitCode = 0;
+
+		bool dirtyRectMode = false;
+		bool backbufferPreserved = true;		// Otherwise every rendered frame is drawn completely
+		bool invalidated = false;				// Since the last rendered frame
+		bool invalidatedAll = false;
+		glm::vec2 invalidMin = { 0, 0 };
+		glm::vec2 invalidMax = { 0, 0 };
+		glm::ivec2 frameClipMin = { 0, 0 };		// The region drawn by the current frame
+		glm::ivec2 frameClipMax = { 0, 0 };
+
+		bool lazyRendering = false;
+		int redrawFrames = 0;
+		double redrawTime = INFINITY;			// Of the earliest RequestRedrawAfter()
 	};
 
 }
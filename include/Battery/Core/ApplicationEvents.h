@@ -397,8 +397,8 @@ namespace Battery {
 		MouseScrolledEvent			mouseScrolledEvent;
 		PureAllegroEvent			pureAllegroEvent;
 
-		enum class EventType primaryEventType = EventType::None;
-		enum class EventType secondaryEventType = EventType::None;
+		EventType primaryEventType = EventType::None;
+		EventType secondaryEventType = EventType::None;
 		Battery::Event* primaryEvent = nullptr;
 		Battery::Event* secondaryEvent = nullptr;
 	};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+#include "Battery/Renderer/Texture2D.h"
+
+#undef LoadBitmap
+
+namespace Battery {
+
+	struct AssetCacheStats {
+		uint64_t memoryHits = 0;		// Served from an asset which was still loaded
+		uint64_t diskHits = 0;			// Decoded pixels read from the disk cache
+		uint64_t misses = 0;			// Loaded and decoded from the source file
+		uint64_t bytesHashed = 0;		// Source files are only hashed when their size or modification time changed
+		size_t loadedTextures = 0;
+		size_t loadedFiles = 0;
+	};
+
+	/// <summary>
+	/// Content-addressed cache for textures and files. Assets are identified by the xxHash of the source file,
+	/// so identical content is only held once in memory, even when loaded from different paths. Handles are
+	/// reference counted, an asset is freed as soon as the last handle is released.
+	/// Optionally, decoded textures are stored on disk, keyed by content hash and the flags which
+	/// change the pixels (e.g. ALLEGRO_NO_PREMULTIPLIED_ALPHA). Together with an index of
+	/// modification times this lets warm starts skip both hashing and decoding.
+	/// </summary>
+	class AssetCache {
+	public:
+
+		// These 2 functions are called automatically
+		static void Setup();
+		static void Shutdown();
+		static bool IsInitialized();
+
+		// Returns a shared texture, nullptr if it could not be loaded
+		static std::shared_ptr<const Texture2D> LoadTexture(const std::string& path, int flags = 0);
+
+		// Returns the raw content of the file without line ending conversion, nullptr if it could not be loaded
+		static std::shared_ptr<const std::string> LoadFile(const std::string& path);
+
+		// Returns a new bitmap owned by the caller, but uses the cache for decoding. Used by Texture2D::Load()
+		static ALLEGRO_BITMAP* LoadBitmap(const std::string& path, int flags = 0);
+
+		// Decoded textures are stored in the directory, pass "" to disable the disk cache (default)
+		static void SetDiskCacheDirectory(const std::string& directory);
+		static bool SaveDiskCacheIndex();		// Called automatically on shutdown
+
+		static std::optional<uint64_t> GetContentHash(const std::string& path);
+		static AssetCacheStats GetStats();
+	};
+
+}
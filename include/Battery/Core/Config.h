@@ -29,6 +29,30 @@
 #define BATTERY_MIN_WINDOW_HEIGHT 200
 #define BATTERY_ANTIALIASING_LINE_FALLOFF 1
 #define BATTERY_DEFAULT_BACKGROUND_COLOR glm::vec4(60, 60, 60, 255)
+#define BATTERY_TEXTURE_ATLAS_PAGE_SIZE 2048
+#define BATTERY_TEXTURE_ATLAS_PADDING 1			// Pixels around every sub-texture, filled with its edge pixels
+#define BATTERY_TEXTURE_ATLAS_MAX_PAGES 4
+#define BATTERY_TEXTURE_MEMORY_BUDGET ((size_t)512 * 1024 * 1024)	// Bytes of video memory, see TextureResidency
+#define BATTERY_SOFTWARE_RENDERER_TILE_SIZE 64		// Pixels, the software renderer rasterizes tiles in parallel
+#define BATTERY_RENDER_REGRESSION_TOLERANCE 2	// Per channel (0-255), see RenderRegression
+#define BATTERY_MITER_LIMIT 4					// Longer miter joins are beveled, in multiples of half the line thickness
+#define BATTERY_PARALLEL_TESSELLATION_POINTS 4096	// Polylines with more points are tessellated on the ThreadPool
+#define BATTERY_PLOT_SERIES_MAX_LEVELS 8		// Zoom levels of decimated buckets cached per PlotSeries
+#define BATTERY_PLOT_SERIES_BUCKETS_PER_COLUMN 8		// At least, cached buckets are merged into pixel columns
+#define BATTERY_FRAMETIME_HISTORY_SECONDS 600.0	// The debug window plots the frame times of the last 10 minutes
+#define BATTERY_SPATIAL_INDEX_ITEMS_PER_CELL 4	// On average, the grid of a SpatialIndex is sized for it
+#define BATTERY_SPATIAL_INDEX_MAX_CELLS (1 << 22)
+#define BATTERY_SPATIAL_INDEX_LARGE_ITEM_CELLS 64	// Items covering more cells are kept in a list instead
+#define BATTERY_DEFAULT_FONT_SIZE 16				// Pixels, fonts are checked by loading this size
+#define BATTERY_FONT_ATLAS_PAGE_SIZE 1024
+#define BATTERY_FONT_ATLAS_MAX_PAGES 4
+#define BATTERY_FONT_MAX_CACHED_RUNS 16384		// Shaped strings per Font, the least recently used half is dropped
+#define BATTERY_STREAM_BUFFER_FRAMES 3			// Frames a StreamBuffer keeps, the GPU may still be drawing them
+#define BATTERY_STREAM_BUFFER_VERTICES 65536	// Initial size, StreamBuffer grows when a frame needs more
+#define BATTERY_STREAM_BUFFER_INDICES 98304
+#define BATTERY_LAZY_RENDERING_MAX_WAIT 1.0		// Seconds, an idle application in lazy rendering mode still updates this often
+#define BATTERY_IMGUI_SETTLE_FRAMES 3			// Rendered after input in lazy rendering mode, ImGui reacts a frame late
+#define BATTERY_IMGUI_TEXT_INPUT_INTERVAL 0.2	// Seconds between frames for the blinking cursor of a focused text field
 
 // Some logging
 #define BATTERY_LOG_LEVEL_CRITICAL	spdlog::level::critical
@@ -41,4 +65,16 @@
 #define BATTERY_DEFAULT_LOG_LEVEL BATTERY_LOG_LEVEL_INFO
 
 // File I/O
-#define BATTERY_FILE_BLOCK_SIZE 1024
\ No newline at end of file
+#define BATTERY_FILE_BLOCK_SIZE 1024
+#define BATTERY_JSON_WRITER_BUFFER_SIZE 65536
+#define BATTERY_BINARY_MAX_DEPTH 512		// Nested arrays and maps of MessagePack converted to json, deeper input is rejected
+
+// Asset loading
+#define BATTERY_ASSET_CACHE_INDEX_FILE "index.msgpack"
+#define BATTERY_ASSET_CACHE_EXTENSION ".texcache"
+#define BATTERY_ASSET_CACHE_VERSION 2			// Increase when the decoded pixels change, older cache files are decoded again
+#define BATTERY_TEXTURE_UPLOAD_BUDGET 0.004		// Seconds per frame for uploading asynchronously loaded textures
+#define BATTERY_TILE_SIZE 256
+#define BATTERY_TILE_CACHE_SIZE 4096			// Width and height of the texture holding the resident tiles
+#define BATTERY_TILE_UPLOADS_PER_FRAME 16
+#define BATTERY_TILED_IMAGE_INFO_FILE "info.msgpack"
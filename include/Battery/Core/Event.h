@@ -6,10 +6,10 @@
 #define EVENT_CLASS_TYPE_BASE(type) virtual const char* GetTypeString() { return #type; }
 #define EVENT_CLASS_TYPE(type) const char* GetTypeString() override { return #type; }
 #define EVENT_INFO_STRING_BASE(__format, ...) virtual void GetInfoString(char* buffer, size_t length) { \
-	snprintf(buffer, length, "%s: " __format, GetTypeString(), __VA_ARGS__);	\
+	snprintf(buffer, length, "%s: " __format, GetTypeString(), ##__VA_ARGS__);	\
 }
 #define EVENT_INFO_STRING(__format, ...) void GetInfoString(char* buffer, size_t length) override { \
-	snprintf(buffer, length, "%s: " __format, GetTypeString(), __VA_ARGS__);	\
+	snprintf(buffer, length, "%s: " __format, GetTypeString(), ##__VA_ARGS__);	\
 }
 #else
 #define EVENT_CLASS_TYPE_BASE(type)
@@ -33,9 +33,9 @@ namespace Battery {
 		Event();
 		virtual ~Event();
 
-		void Load(enum class EventType type, ALLEGRO_EVENT* allegroEvent);
+		void Load(EventType type, ALLEGRO_EVENT* allegroEvent);
 		
-		enum class EventType GetType();
+		EventType GetType();
 		bool WasHandled();
 		void SetHandled(bool h = true);
 		ALLEGRO_EVENT* GetAllegroEvent();
@@ -45,7 +45,7 @@ namespace Battery {
 		EVENT_INFO_STRING_BASE("No specific event data");
 
 	private:
-		enum class EventType eventType = EventType::None;
+		EventType eventType = EventType::None;
 		bool handled = false;
 		ALLEGRO_EVENT* event;
 	};
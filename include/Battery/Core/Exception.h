@@ -10,6 +10,11 @@ namespace Battery {
 	class Exception : public std::exception {
 	public:
 		Exception(const std::string& msg);
+
+		const char* what() const noexcept override;
+
+	private:
+		std::string message;
 	};
 
 }
@@ -4,6 +4,11 @@
 #include "Battery/Core/Layer.h"
 #include "Battery/Core/Config.h"
 #include "Battery/Core/Application.h"
+#include "Battery/Core/ImGuiRenderer.h"
+#include "Battery/Renderer/AsyncTextureLoader.h"
+#include "Battery/Renderer/TextureResidency.h"
+#include "Battery/Renderer/PlotSeries.h"
+#include "Battery/Renderer/Renderer2D.h"
 
 namespace Battery {
 
@@ -32,12 +37,14 @@ namespace Battery {
 			OnImGuiAttach();
 
 			ImGui_ImplAllegro5_CreateDeviceObjects();
+			renderer.Create(applicationPointer->window.allegroDisplayPointer);
 			memset(profilerFilter, 0, BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER - 1);
 		}
 
 		void OnDetach() final {
 			io = ImGui::GetIO();
 			OnImGuiDetach();
+			renderer.Destroy();
 			ImGui_ImplAllegro5_Shutdown();
 
 			ImPlot::DestroyContext();
@@ -45,6 +52,8 @@ namespace Battery {
 		}
 		
 		void OnRender() final {
+			PROFILE_CORE_SCOPE(useAllegroBackend ? "ImGuiLayer::OnRender() [Allegro backend]" : "ImGuiLayer::OnRender() [ImGuiRenderer]");
+			double start = TimeUtils::GetRuntime();
 
 			// Start ImGui Frame
 			ImGui_ImplAllegro5_NewFrame();
@@ -66,28 +75,68 @@ namespace Battery {
 			
 			// Draw the result on the screen
 			ImGui::Render();
-			ImGui_ImplAllegro5_RenderDrawData(ImGui::GetDrawData());
+			double drawStart = TimeUtils::GetRuntime();
+			if (useAllegroBackend)
+				ImGui_ImplAllegro5_RenderDrawData(ImGui::GetDrawData());
+			else
+				renderer.Render(ImGui::GetDrawData());
+
+			// Moving average filter, kept per backend so both can be compared after switching
+			double end = TimeUtils::GetRuntime();
+			int backend = useAllegroBackend ? 1 : 0;
+			renderTimeFilter[backend] = renderTimeFilter[backend] * 0.8 + (end - start) * 1000.0 * 0.2;
+			drawTimeFilter[backend] = drawTimeFilter[backend] * 0.8 + (end - drawStart) * 1000.0 * 0.2;
 		}
 
 		void OnUpdate() final {
 			io = ImGui::GetIO();
 			OnImGuiUpdate();
+
+			// ImGui clips its windows itself, drawing them over a partially redrawn frame would blend them twice
+			if (applicationPointer->GetDirtyRectMode()) {
+				if (enableProfiling || ImGui::IsAnyItemActive() || (IsVisible() && applicationPointer->IsInvalidated())) {
+					applicationPointer->InvalidateAll();
+				}
+			}
+
+			// The profiler shows live timings, the cursor of a focused text field blinks
+			if (applicationPointer->GetLazyRendering()) {
+				if (enableProfiling)
+					applicationPointer->RequestRedraw();
+				else if (ImGui::GetIO().WantTextInput)
+					applicationPointer->RequestRedrawAfter(BATTERY_IMGUI_TEXT_INPUT_INTERVAL);
+			}
 		}
 
 		void OnEvent(Battery::Event* event) final {
 			
 			ImGui_ImplAllegro5_ProcessEvent(event->GetAllegroEvent());
+
+			// Any input can change what ImGui shows
+			if (applicationPointer->GetDirtyRectMode() && IsVisible()) {
+				applicationPointer->InvalidateAll();
+			}
+
+			// ImGui reacts to input in the next frame and may take a few more to settle, e.g. hover states
+			if (applicationPointer->GetLazyRendering()) {
+				applicationPointer->RequestRedraw(BATTERY_IMGUI_SETTLE_FRAMES);
+			}
 			
+			// The font texture survives a resize, only the display size changes
 			if (event->GetType() == EventType::WindowResize) {
-				ImGui_ImplAllegro5_InvalidateDeviceObjects();
 				al_acknowledge_resize(applicationPointer->window.allegroDisplayPointer);
-				ImGui_ImplAllegro5_CreateDeviceObjects();
 			}
 			
 			io = ImGui::GetIO();
 			OnImGuiEvent(event);
 		}
 
+		// Whether the last frame drew anything
+		bool IsVisible() {
+			ImDrawData* drawData = ImGui::GetDrawData();
+			return drawData != nullptr && drawData->TotalVtxCount > 0;
+		}
+
 		virtual void OnImGuiRender() {
 			LOG_CORE_WARN("The function ImGuiLayer::OnImGuiRender() was not overridden, you probably want to?");
 		}
@@ -101,11 +150,11 @@ namespace Battery {
 		void RenderProfiler() {
 			TimeUtils::ProfilerStorage& storage = TimeUtils::ProfilerStorage::GetInstance();
 			
-			TimeUtils::ScopedTimer timer(__FUNCTION__"()",
+			TimeUtils::ScopedTimer timer(std::string(__FUNCTION__) + "()",
 				&storage.temp_profilerResultsRenderTime);
 
 #ifndef BATTERY_PROFILING
-			LOG_CORE_WARN(__FUNCTION__"(): Can't render profiler results: Battery engine was compiled without profiler support!");
+			LOG_CORE_WARN("{}(): Can't render profiler results: Battery engine was compiled without profiler support!", __FUNCTION__);
 			storage.engineProfilingResults.Clear();
 			storage.clientProfilingResults.Clear();
 			return;
@@ -167,6 +216,47 @@ namespace Battery {
 
 			ImGui::Separator();
 
+			// Asynchronous texture loading
+			if (AsyncTextureLoader::IsInitialized()) {
+				AsyncTextureLoaderStats stats = AsyncTextureLoader::GetStats();
+				ImGui::Text("Texture loading: %zu queued, %zu waiting for upload", stats.queued, stats.decoded);
+				ImGui::Text("Uploaded %zu textures in % 8.03f ms last frame", stats.uploadedLastFrame,
+					stats.uploadTimeLastFrame * 1000.0);
+				ImGui::Separator();
+			}
+
+			// Texture memory
+			if (TextureResidency::IsInitialized()) {
+				TextureMemoryStats stats = TextureResidency::GetStats();
+				ImGui::Text("Texture memory: %.1f / %.1f MB in %zu textures", stats.residentBytes / 1048576.0,
+					stats.budget / 1048576.0, stats.residentTextures);
+				ImGui::Text("Evicted: %.1f MB in %zu textures (%llu evictions, %llu reloads, %llu failed)",
+					stats.evictedBytes / 1048576.0, stats.evictedTextures, (unsigned long long)stats.evictions,
+					(unsigned long long)stats.reloads, (unsigned long long)stats.failedReloads);
+				ImGui::Separator();
+			}
+
+			// 2D renderer, the stats are the ones of the last frame
+			{
+				Renderer2DStats stats = Renderer2D::GetStats();
+				ImGui::Text("Renderer2D: %zu draw calls, %zu vertices, %zu culled", stats.drawCalls, stats.vertices,
+					stats.culled);
+				ImGui::Text("Sprites: %zu in %zu batches (%zu saved by sorting)", stats.sprites, stats.spriteBatches,
+					stats.batchesSaved);
+				ImGui::Text("Streamed to the GPU: %.1f KB", stats.streamedBytes / 1024.0);
+				ImGuiRendererStats imguiStats = renderer.GetStats();
+				if (useAllegroBackend)
+					ImGui::Text("ImGui: Drawn by the Allegro backend");
+				else
+					ImGui::Text("ImGui: %zu draw calls, %zu vertices, %.1f KB streamed", imguiStats.drawCalls,
+						imguiStats.vertices, imguiStats.streamedBytes / 1024.0);
+				ImGui::Checkbox("Draw ImGui with the Allegro backend", &useAllegroBackend);
+				ImGui::Text("ImGui OnRender(): ImGuiRenderer % 8.03f ms (draw % 8.03f ms)", renderTimeFilter[0],
+					drawTimeFilter[0]);
+				ImGui::Text("ImGui OnRender(): Allegro backend % 8.03f ms (draw % 8.03f ms)", renderTimeFilter[1],
+					drawTimeFilter[1]);
+				ImGui::Separator();
+			}
 
 
 
@@ -203,6 +293,21 @@ namespace Battery {
 				LOG_CORE_TRACE("Skipping rendering timestamp profiling: Buffer is empty!");
 			}
 			
+			// Frame time history, decimated to the width of the plot. Old samples are dropped in steps of
+			// a quarter of the window, not every frame
+			double now = TimeUtils::GetRuntime();
+			frametimeHistory.Append(now, applicationPointer->frametime * 1000.0);
+			if (frametimeHistory.GetSize() > 0 &&
+					frametimeHistory.GetSamples().front().x < now - BATTERY_FRAMETIME_HISTORY_SECONDS * 1.25) {
+				frametimeHistory.RemoveBefore(now - BATTERY_FRAMETIME_HISTORY_SECONDS);
+			}
+			ImGui::Text("Frame time history:");
+			ImPlot::SetNextPlotLimits(0, 10, 0, 50, ImGuiCond_FirstUseEver);
+			if (ImPlot::BeginPlot("##Frametime", "s", "ms", ImVec2(-1, 200))) {
+				frametimeHistory.PlotLine("Frame time");
+				ImPlot::EndPlot();
+			}
+
 			ImPlot::SetNextPlotLimits(0, 1, 0, 1, ImGuiCond_Always);
 			if (ImPlot::BeginPlot("##Pie1", NULL, NULL, ImVec2(600, 600), ImPlotFlags_Equal | ImPlotFlags_NoMousePos, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations)) {
 				ImPlot::PlotPieChart(labels, profilerFilter, (int)size - 1, 0.5, 0.5, 0.4, true, "%.2f");
@@ -218,10 +323,17 @@ namespace Battery {
 		bool enableImGuiDemoWindow = false;
 		bool enableImPlotDemoWindow = false;
 
+		// Draw with ImGui_ImplAllegro5_RenderDrawData() instead of ImGuiRenderer, e.g. to compare them in the profiler
+		bool useAllegroBackend = false;
+
 	private:
 		ImGuiIO dummyIO;
 		ImFont* font = nullptr;
+		ImGuiRenderer renderer;
 		float profilerFilter[BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER - 1];
+		double renderTimeFilter[2] = { 0.0, 0.0 };
+		double drawTimeFilter[2] = { 0.0, 0.0 };
+		PlotSeries frametimeHistory;
 	};
 
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+#include "Battery/Renderer/ShaderProgram.h"
+#include "Battery/Renderer/StreamBuffer.h"
+
+namespace Battery {
+
+	struct ImGuiRendererStats {
+		size_t drawCalls = 0;
+		size_t vertices = 0;
+		size_t streamedBytes = 0;
+	};
+
+	/// <summary>
+	/// Draws ImGui::GetDrawData() instead of ImGui_ImplAllegro5_RenderDrawData(), which converts every ImDrawVert
+	/// into an ALLEGRO_VERTEX each frame. The vertex declaration matches ImDrawVert, so the draw lists are
+	/// copied into a StreamBuffer as they are and the colors are read as bytes by the sprite shader. The
+	/// rest of the Allegro backend (events, fonts, NewFrame) is still used.
+	/// </summary>
+	class ImGuiRenderer {
+	public:
+		ImGuiRenderer();
+		ImGuiRenderer(const ImGuiRenderer& renderer) = delete;
+		void operator=(const ImGuiRenderer& renderer) = delete;
+		~ImGuiRenderer();
+
+		// Falls back to the Allegro backend when the shader can't be loaded
+		bool Create(ALLEGRO_DISPLAY* display);
+		void Destroy();
+
+		void Render(ImDrawData* drawData);
+
+		// Of the most recent Render()
+		ImGuiRendererStats GetStats() const;
+
+	private:
+		void SetupRenderState(ImDrawData* drawData);
+
+		ShaderProgram shader;
+		ALLEGRO_VERTEX_DECL* decl = nullptr;
+		std::unique_ptr<StreamBuffer> stream;
+		std::vector<int> fallbackIndices;
+		ImGuiRendererStats stats;
+	};
+
+}
@@ -12,4 +12,7 @@ namespace Battery {
 
 	extern const std::string BATTERY_SHADER_SOURCE_FRAGMENT_COLOR_GRADIENT;
 
+	extern const std::string BATTERY_SHADER_SOURCE_VERTEX_SPRITE;
+	extern const std::string BATTERY_SHADER_SOURCE_FRAGMENT_SPRITE;
+
 }
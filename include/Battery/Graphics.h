@@ -30,8 +30,10 @@ namespace Battery {
 		void Stroke(glm::vec3 color, double thickness);
 		void NoFill();
 		void NoStroke();
-		void UseLineCap(enum class LINECAP linecap);
-		void UseLineJoin(enum class LINEJOIN linejoin);
+		void UseLineCap(LINECAP linecap);
+		void UseLineJoin(LINEJOIN linejoin);
+		LINECAP GetLineCap();
+		LINEJOIN GetLineJoin();
 
 		void DrawLine(glm::vec2 p1, glm::vec2 p2);
 
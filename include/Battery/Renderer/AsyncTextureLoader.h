@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Texture2D.h"
+
+namespace Battery {
+
+	enum class TextureLoadState {
+		QUEUED,			// Waiting for a worker thread
+		DECODED,		// Decoded into system memory, waiting to be uploaded
+		RESIDENT,		// Uploaded to the GPU and ready to be drawn
+		FAILED
+	};
+
+	struct AsyncTextureRequest;
+
+	// Handle to a texture which is being loaded in the background. Handles are cheap to copy,
+	// if all handles to a texture are dropped before it is resident, loading it is cancelled.
+	// Must only be used on the main thread
+	class TextureHandle {
+	public:
+		TextureHandle();
+
+		bool IsValid() const;			// False for default-constructed handles
+		bool IsResident() const;
+		bool HasFailed() const;
+		TextureLoadState GetState() const;
+
+		// Returns the texture once it is resident, the placeholder texture until then or if loading failed
+		const Texture2D& Get() const;
+
+		// Returns nullptr until the texture is resident
+		std::shared_ptr<const Texture2D> GetTexture() const;
+
+	private:
+		friend class AsyncTextureLoader;
+		TextureHandle(std::shared_ptr<AsyncTextureRequest> request);
+
+		std::shared_ptr<AsyncTextureRequest> request;
+	};
+
+	struct AsyncTextureLoaderStats {
+		size_t queued = 0;					// Waiting to be decoded
+		size_t decoded = 0;					// Decoded, waiting to be uploaded
+		size_t uploadedLastFrame = 0;
+		double uploadTimeLastFrame = 0.0;	// In seconds
+		uint64_t totalUploaded = 0;
+		uint64_t totalFailed = 0;
+	};
+
+	/// <summary>
+	/// Loads textures without stalling the main loop: Worker threads read and decode the image files into
+	/// memory bitmaps, the main thread uploads them to the GPU before rendering, but only as many as fit
+	/// into the upload budget of the frame (at least one per frame).
+	/// </summary>
+	class AsyncTextureLoader {
+	public:
+
+		// These 2 functions are called automatically, a thread count of 0 uses all but one hardware thread
+		static void Setup(size_t threadCount = 0);
+		static void Shutdown();
+		static bool IsInitialized();
+
+		// Queues the texture for loading and returns immediately
+		static TextureHandle Load(const std::string& path, int flags = 0);
+
+		// Uploads decoded textures until the budget is used up, called automatically before rendering
+		static void Update();
+
+		// Maximum time in seconds spent uploading textures per frame
+		static void SetUploadBudget(double seconds);
+		static AsyncTextureLoaderStats GetStats();
+	};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Battery/pch.h"
+
+namespace Battery {
+
+	struct AtlasRect {
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	/// <summary>
+	/// Packs rectangles into a fixed area using the skyline bottom-left heuristic. This is only the bookkeeping,
+	/// it does not touch any pixels, see TextureAtlas for that. Rectangles can't be removed individually,
+	/// only the whole packer can be cleared.
+	/// </summary>
+	class AtlasPacker {
+	public:
+		AtlasPacker(int width, int height, int padding = 0);
+
+		// Returns the position of the rectangle without its padding, nullopt if it does not fit anymore
+		std::optional<AtlasRect> Insert(int width, int height);
+		void Clear();
+
+		int GetWidth() const;
+		int GetHeight() const;
+		int GetPadding() const;
+		size_t GetRectCount() const;
+
+		// Fraction of the area which is covered by packed rectangles, including their padding
+		float GetOccupancy() const;
+
+	private:
+		struct SkylineNode {
+			int x;
+			int y;			// Top of the free space above this node
+			int width;
+		};
+
+		bool Fits(size_t index, int width, int height, int& y) const;
+		void AddLevel(size_t index, int x, int y, int width, int height);
+
+		int width = 0;
+		int height = 0;
+		int padding = 0;
+		size_t rectCount = 0;
+		uint64_t usedArea = 0;
+		std::vector<SkylineNode> skyline;
+	};
+
+}
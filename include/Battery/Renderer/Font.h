@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Renderer/TextureAtlas.h"
+
+namespace Battery {
+
+	// A glyph of a shaped string, relative to the top left corner of the text
+	struct GlyphQuad {
+		glm::vec2 point1;
+		glm::vec2 point2;
+		AtlasRegion region;
+	};
+
+	// A string laid out at one pixel size
+	struct TextRun {
+		std::vector<GlyphQuad> glyphs;
+		glm::vec2 size = { 0, 0 };			// The widest line and the height of all lines
+		glm::vec2 boundsMin = { 0, 0 };		// Of all glyph quads
+		glm::vec2 boundsMax = { 0, 0 };
+		uint64_t lastUse = 0;
+		uint64_t evictedCount = 0;			// Of the atlas when the glyphs were looked up
+	};
+
+	/// <summary>
+	/// A TrueType font for Renderer2D::DrawString(). Glyphs are rasterized by Allegro the first time they are
+	/// used at a pixel size and copied into the texture atlas of the font, so all text of a frame ends up in a
+	/// few sprite batches. The layout of every string is cached as well, a label drawn every frame only costs
+	/// a hash lookup and its quads.
+	/// </summary>
+	class Font {
+	public:
+		Font();
+		Font(const std::string& path);
+		Font(const Font& font) = delete;
+		void operator=(const Font& font) = delete;
+		~Font();
+
+		// The file is opened again for every size which is used, so it has to stay available
+		bool Load(const std::string& path);
+		void Unload();
+		bool IsLoaded() const;
+
+		// The size is the line height in pixels, glyphs are rasterized at the nearest whole size.
+		// The run is valid until the next call
+		const TextRun& Shape(const std::string& text, int pixelSize);
+		glm::vec2 Measure(const std::string& text, float size);
+
+		const TextureAtlas& GetAtlas() const;
+		size_t GetCachedRuns() const;
+		uint64_t GetRasterizedGlyphs() const;
+
+	private:
+		struct Glyph {
+			AtlasRegion region;
+			glm::vec2 offset = { 0, 0 };	// Of the pixels from the pen position
+			bool empty = false;				// Whitespace or not in the font
+		};
+
+		struct Face {
+			ALLEGRO_FONT* font = nullptr;
+			std::unordered_map<int32_t, Glyph> glyphs;
+			std::unordered_map<std::string, TextRun> runs;
+		};
+
+		Face* GetFace(int pixelSize);
+		const Glyph& GetGlyph(Face& face, int pixelSize, int32_t codepoint);
+		bool IsValid(const TextRun& run) const;
+		void TrimRuns();
+
+		std::string path;
+		std::map<int, Face> faces;			// By pixel size
+		TextureAtlas atlas;
+		size_t runCount = 0;
+		uint64_t useCounter = 0;
+		uint64_t rasterizedGlyphs = 0;
+		TextRun emptyRun;
+	};
+
+}
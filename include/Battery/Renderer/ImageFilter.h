@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Utils/ThreadPool.h"
+
+// Filtered resizing of images with 4 channels of 8 bits each. All channels are treated alike, so any
+// channel order works. Allegro bitmaps store premultiplied alpha by default, which is what filtering needs.
+
+namespace Battery {
+	namespace ImageFilter {
+
+		enum class ResizeFilter {
+			BOX,			// Averages all covered pixels, fast
+			LANCZOS3		// Sharper, but may ring slightly at hard edges
+		};
+
+		/// <summary>
+		/// Halve the size of an image by averaging 2x2 blocks, as used for mipmaps. The destination is
+		/// max(1, width / 2) by max(1, height / 2) pixels, an odd last row or column is dropped
+		/// </summary>
+		/// <param name="source">- The first pixel of the source</param>
+		/// <param name="sourcePitch">- The distance between two source rows in bytes</param>
+		/// <param name="width">- The width of the source in pixels</param>
+		/// <param name="height">- The height of the source in pixels</param>
+		/// <param name="destination">- The first pixel of the destination</param>
+		/// <param name="destinationPitch">- The distance between two destination rows in bytes</param>
+		/// <param name="pool">- Rows are distributed over the pool, nullptr for the calling thread only</param>
+		void Downsample2x(const uint8_t* source, ptrdiff_t sourcePitch, size_t width, size_t height,
+			uint8_t* destination, ptrdiff_t destinationPitch, ThreadPool* pool = nullptr);
+
+		/// <summary>
+		/// Resize an image to any size with a separable filter. Downscaling widens the filter,
+		/// so every source pixel contributes
+		/// </summary>
+		void Resize(const uint8_t* source, ptrdiff_t sourcePitch, size_t sourceWidth, size_t sourceHeight,
+			uint8_t* destination, ptrdiff_t destinationPitch, size_t destinationWidth, size_t destinationHeight,
+			ResizeFilter filter, ThreadPool* pool = nullptr);
+
+	}
+}
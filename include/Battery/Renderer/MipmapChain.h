@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/SharedTexture.h"
+#include "Battery/Renderer/ImageFilter.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// Prefiltered, successively halved versions of a texture, generated on the CPU. Drawing a large image
+	/// heavily downscaled samples a level close to the size on screen instead, which avoids shimmering and
+	/// is cheaper to sample. See Renderer2D::DrawTexture().
+	/// </summary>
+	class MipmapChain {
+	public:
+		MipmapChain();
+
+		// Level 0 shares the source, every further level halves the size until both sides are at most minSize
+		bool Build(const SharedTexture& source, ImageFilter::ResizeFilter filter = ImageFilter::ResizeFilter::BOX,
+			int minSize = 1);
+		bool Load(const std::string& path, ImageFilter::ResizeFilter filter = ImageFilter::ResizeFilter::BOX,
+			int minSize = 1, int flags = 0);
+		void Clear();
+
+		// The smallest level which is still at least as large as the given size on screen
+		size_t SelectLevel(const glm::vec2& size) const;
+		const SharedTexture& GetLevel(size_t level) const;
+		size_t GetLevelCount() const;
+		bool IsValid() const;
+
+	private:
+		std::vector<SharedTexture> levels;
+	};
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+#include "Battery/Graphics.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+
+	struct StrokeStyle {
+		float thickness = 1.f;
+		float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF;		// Like the line shader, the edge fades out within the thickness
+		Graphics::LINEJOIN join = Graphics::LINEJOIN::ROUND;	// NONE is drawn like BEVEL
+		Graphics::LINECAP cap = Graphics::LINECAP::ROUND;
+		float miterLimit = BATTERY_MITER_LIMIT;				// Longer miters are beveled, in multiples of half the thickness
+	};
+
+	/// <summary>
+	/// Turns polylines into a triangle list with antialiased edges: Every cross section of the stroke has 4 vertices,
+	/// the outer ones are transparent, so the edge fades out over the falloff without any shader. Joins and caps are
+	/// part of the same vertex stream, so any number of polylines can be drawn with one draw call.
+	/// Long polylines are tessellated in parallel, every point is processed independently.
+	/// </summary>
+	class PathTessellator {
+	public:
+		PathTessellator();
+
+		// Appends to vertices and indices, indices refer to the whole vertex array. A closed path connects
+		// the last point to the first one and has no caps
+		void Tessellate(const glm::vec2* points, size_t count, bool closed, const StrokeStyle& style,
+			const glm::vec4& color, std::vector<ALLEGRO_VERTEX>& vertices, std::vector<int>& indices);
+
+	private:
+		struct CrossSection {
+			glm::vec2 point;
+			glm::vec2 plus;				// Offset of the side along the normal, scaled by the distance from the center
+			glm::vec2 minus;
+		};
+
+		size_t CountCrossSections(size_t i) const;
+		void WriteCrossSections(size_t i, CrossSection* output) const;
+		void AddCap(const glm::vec2& point, const glm::vec2& normal, const glm::vec2& outward,
+			std::vector<ALLEGRO_VERTEX>& vertices, std::vector<int>& indices);
+
+		// Scratch buffers, reused between calls
+		std::vector<glm::vec2> points;
+		std::vector<glm::vec2> directions;		// Of the segment starting at each point
+		std::vector<float> lengths;
+		std::vector<size_t> offsets;
+		std::vector<CrossSection> sections;
+
+		bool closed = false;
+		StrokeStyle style;
+		float radius = 0.f;
+		float coreRadius = 0.f;					// Fully opaque up to here
+		float roundStep = 0.f;					// Angle between the vertices of round joins and caps
+		ALLEGRO_COLOR coreColor;
+		ALLEGRO_COLOR edgeColor;
+	};
+
+}
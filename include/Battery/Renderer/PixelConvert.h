@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "clip.h"
+
+// Bulk conversion between 8-bit per channel pixel layouts. Whole rows are converted at once,
+// using SSE2 where available and a scalar fallback otherwise. Colors of the engine are packed the same way.
+
+namespace Battery {
+	namespace PixelConvert {
+
+		// Named by the order of the bytes in memory, e.g. RGBA8 is R, G, B, A
+		enum class PixelLayout {
+			UNKNOWN,
+			RGBA8,
+			BGRA8,
+			RGB8,
+			BGR8
+		};
+
+		/// <summary>
+		/// Identify the memory layout of a clip::image from its bit masks
+		/// </summary>
+		/// <param name="spec">- The spec of the clip image</param>
+		/// <returns>PixelLayout - The layout or UNKNOWN if it is none of the supported ones</returns>
+		PixelLayout GetLayout(const clip::image_spec& spec);
+
+		/// <summary>
+		/// Create the clip::image_spec describing a tightly packed image, e.g. to put converted pixels on the clipboard
+		/// </summary>
+		/// <param name="layout">- The layout of the pixels, any except UNKNOWN</param>
+		/// <param name="width">- The width in pixels</param>
+		/// <param name="height">- The height in pixels</param>
+		/// <exception cref="Battery::Exception - Thrown when the layout is UNKNOWN"></exception>
+		/// <returns>clip::image_spec - The spec with masks and shifts matching the layout</returns>
+		clip::image_spec GetClipSpec(PixelLayout layout, size_t width, size_t height);
+
+		size_t GetBytesPerPixel(PixelLayout layout);
+
+		/// <summary>
+		/// Convert a row of pixels into a 32-bit layout. If 'opaque' is set, the alpha channel is set to 255,
+		/// which is also done when the source has no alpha channel. Source and destination must not overlap
+		/// </summary>
+		/// <param name="source">- The first pixel of the source row</param>
+		/// <param name="sourceLayout">- The layout of the source, any except UNKNOWN</param>
+		/// <param name="destination">- The first pixel of the destination row</param>
+		/// <param name="destinationLayout">- RGBA8 or BGRA8</param>
+		/// <param name="width">- The number of pixels</param>
+		/// <param name="opaque">- Ignore the alpha channel of the source</param>
+		/// <exception cref="Battery::Exception - Thrown when the layouts are not supported"></exception>
+		void ConvertRow(const void* source, PixelLayout sourceLayout, void* destination, PixelLayout destinationLayout,
+			size_t width, bool opaque = false);
+
+		/// <summary>
+		/// Convert an entire image row by row, see ConvertRow(). The pitch is the distance between two rows in bytes
+		/// and may be negative for images which are stored bottom-up, like locked Allegro bitmaps
+		/// </summary>
+		void ConvertImage(const void* source, ptrdiff_t sourcePitch, PixelLayout sourceLayout,
+			void* destination, ptrdiff_t destinationPitch, PixelLayout destinationLayout,
+			size_t width, size_t height, bool opaque = false);
+
+		/// <summary>
+		/// Pack a color in the range 0-255 into RGBA8, e.g. for vertices. The channels are clamped and truncated
+		/// like al_map_rgba() does, without branches
+		/// </summary>
+		/// <param name="color">- The color, alpha in w</param>
+		/// <returns>uint32_t - R in the lowest byte, A in the highest one</returns>
+		uint32_t PackColor(const glm::vec4& color);
+
+		// The fallback of PackColor() without SSE2, the results are the same
+		uint32_t PackColorScalar(const glm::vec4& color);
+
+		glm::vec4 UnpackColor(uint32_t color);
+
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// An append-only time series with level of detail for drawing. When a view contains many more samples than
+	/// pixel columns, Decimate() reduces every column to its first, minimum, maximum and last sample (M4), which
+	/// draws the same pixels as the full polyline. The buckets are cached per zoom level (bucket widths are powers
+	/// of 2) and updated incrementally by Append(), so the cost of drawing follows the screen width, not the data.
+	/// </summary>
+	class PlotSeries {
+	public:
+		PlotSeries();
+
+		// x must not decrease, samples before the last one are rejected
+		bool Append(double x, double y);
+		void Append(const glm::dvec2* samples, size_t count);
+		void Clear();
+
+		// Removes all samples with a smaller x, e.g. to keep a sliding window. The cached buckets are kept
+		void RemoveBefore(double x);
+
+		size_t GetSize() const;
+		const std::vector<glm::dvec2>& GetSamples() const;
+		size_t GetCachedLevels() const;
+
+		/// <summary>
+		/// The points to draw for the x range [xMin, xMax] spread over the given number of pixel columns,
+		/// including the nearest sample on either side so the line leaves the view correctly. Views with few
+		/// samples are returned as they are. The result is valid until the next call.
+		/// </summary>
+		const std::vector<glm::dvec2>& Decimate(double xMin, double xMax, int columns);
+
+		// Decimates for the limits and size of the current plot, call between ImPlot::BeginPlot() and EndPlot()
+		void PlotLine(const char* label);
+
+	private:
+		struct Bucket {
+			int64_t index;				// floor(x / width)
+			size_t firstSample;			// The samples until the next bucket belong to it
+			glm::dvec2 first;
+			glm::dvec2 last;
+			glm::dvec2 min;				// By y
+			glm::dvec2 max;
+		};
+
+		struct Level {
+			std::vector<Bucket> buckets;
+			uint64_t lastUse = 0;
+		};
+
+		Level& GetLevel(int exponent);
+		void AddToLevel(Level& level, int exponent, size_t sample);
+
+		std::vector<glm::dvec2> samples;
+		std::map<int, Level> levels;		// By the exponent of the bucket width
+		std::vector<glm::dvec2> output;
+		uint64_t useCounter = 0;
+	};
+
+}
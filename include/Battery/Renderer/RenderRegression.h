@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+
+	struct RenderRegressionResult {
+		std::string name;
+		bool passed = false;
+		bool goldenWritten = false;		// The golden image was updated, nothing was compared
+		bool goldenMissing = false;		// There is no golden image, the scene failed
+		size_t differentPixels = 0;		// Pixels where any channel differs by more than the tolerance
+		int maxDifference = 0;
+		double cpuTime = 0.0;			// Seconds for drawing and EndScene(), the fastest iteration
+		size_t drawCalls = 0;			// Per iteration, see Renderer2DStats
+		size_t vertices = 0;
+		size_t spriteBatches = 0;		// Textures, atlas pages and text, e.g. at most one per atlas page
+	};
+
+	/// <summary>
+	/// Renders registered scenes into textures, compares them to golden images and measures them. It's meant
+	/// to run in an application created with RenderBackend::SOFTWARE, so it works headless, e.g. in CI:
+	///   regression.AddScene("lines", { 256, 256 }, [] { Renderer2D::DrawLine(...); });
+	///   failed = regression.RunFromCommandLine(args);
+	/// With the OpenGL backend, cpuTime only covers submitting the draw calls.
+	/// </summary>
+	class RenderRegression {
+	public:
+		RenderRegression(const std::string& goldenDirectory, int tolerance = BATTERY_RENDER_REGRESSION_TOLERANCE);
+
+		// The function is called between Renderer2D::BeginScene() and EndScene(), on a transparent target
+		void AddScene(const std::string& name, const glm::ivec2& size, std::function<void()> draw);
+
+		/// <summary>
+		/// Run all scenes whose name contains the filter. Golden images are '<name>.png' in the golden directory,
+		/// they are only written with 'updateGoldens', a missing one fails the scene. Failing scenes write
+		/// '<name>.actual.png' next to it.
+		/// </summary>
+		std::vector<RenderRegressionResult> Run(const std::string& filter = "", size_t iterations = 1,
+			bool updateGoldens = false);
+
+		bool SaveReport(const std::string& path, const std::vector<RenderRegressionResult>& results) const;
+
+		/// <summary>
+		/// Options: --filter &lt;text&gt;, --iterations &lt;n&gt;, --update, --report &lt;file.json&gt;.
+		/// Unknown arguments are ignored, so the application arguments can be passed directly.
+		/// The results are stored in the vector if one is given.
+		/// </summary>
+		/// <returns>int - The number of failed scenes, -1 if the arguments are invalid</returns>
+		int RunFromCommandLine(const std::vector<std::string>& args,
+			std::vector<RenderRegressionResult>* results = nullptr);
+
+	private:
+		struct SceneEntry {
+			std::string name;
+			glm::ivec2 size;
+			std::function<void()> draw;
+		};
+
+		RenderRegressionResult RunScene(const SceneEntry& entry, size_t iterations, bool updateGoldens);
+
+		std::string goldenDirectory;
+		int tolerance = 0;
+		std::vector<SceneEntry> scenes;
+	};
+
+}
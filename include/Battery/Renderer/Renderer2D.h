@@ -5,10 +5,34 @@
 #include "Battery/Core/AllegroWindow.h"
 #include "Battery/Renderer/ShaderProgram.h"
 #include "Battery/Renderer/Texture2D.h"
+#include "Battery/Renderer/TextureAtlas.h"
+#include "Battery/Renderer/MipmapChain.h"
+#include "Battery/Renderer/TiledImage.h"
+#include "Battery/Renderer/SoftwareRasterizer.h"
+#include "Battery/Renderer/PathTessellator.h"
+#include "Battery/Renderer/PlotSeries.h"
+#include "Battery/Renderer/SpatialIndex.h"
+#include "Battery/Renderer/Font.h"
+#include "Battery/Renderer/StreamBuffer.h"
 #include "Battery/DefaultShaders.h"
 
 namespace Battery {
 
+	enum class RenderBackend {
+		OPENGL,			// The shaders on the GPU, needs a display
+		SOFTWARE		// A SoftwareRasterizer on the CPU, works without a display
+	};
+
+	struct Renderer2DStats {
+		size_t drawCalls = 0;		// Including clears, every SDF primitive is one quad
+		size_t vertices = 0;
+		size_t sprites = 0;			// Textured quads, drawn in batches
+		size_t spriteBatches = 0;
+		size_t batchesSaved = 0;	// By sorting the sprites, compared to a batch per change of texture
+		size_t culled = 0;			// Primitives and sprites skipped because they are outside of the target
+		size_t streamedBytes = 0;	// Vertices and indices written to the GPU, see StreamBuffer
+	};
+
 	struct VertexData {
 		glm::vec3 position;
 		glm::vec2 uv;
@@ -32,44 +56,23 @@ namespace Battery {
 
 		Scene(std::reference_wrapper<AllegroWindow> window) {
 			this->window = window;
-			LOG_CORE_TRACE(__FUNCTION__"(): Constructed Battery::Scene, loading shaders");
+			LOG_CORE_TRACE("{}(): Constructed Battery::Scene, loading shaders", __FUNCTION__);
 			LoadShaders();
 		}
 
 		Scene(std::reference_wrapper<AllegroWindow> window, std::reference_wrapper<Battery::Texture2D> texture) {
 			this->window = window;
 			this->texture = texture;
-			LOG_CORE_TRACE(__FUNCTION__"(): Constructed Battery::Scene, loading shaders");
+			LOG_CORE_TRACE("{}(): Constructed Battery::Scene, loading shaders", __FUNCTION__);
 			LoadShaders();
 		}
 
 		~Scene() {
-			LOG_CORE_TRACE(__FUNCTION__"(): Destroying Battery::Scene");
+			LOG_CORE_TRACE("{}(): Destroying Battery::Scene", __FUNCTION__);
 		}
 
 	private:
-		void LoadShaders() {
-
-			lineShader = std::make_unique<ShaderProgram>();
-			circleShader = std::make_unique<ShaderProgram>();
-			arcShader = std::make_unique<ShaderProgram>();
-			rectangleShader = std::make_unique<ShaderProgram>();
-
-			ALLEGRO_DISPLAY* display = window.value().get().allegroDisplayPointer;
-
-			// Load the shader for drawing antialiased lines
-			lineShader->LoadSource(display,
-				BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_LINE);
-
-			circleShader->LoadSource(display,
-				BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_CIRCLE);
-
-			arcShader->LoadSource(display,
-				BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_ARC);
-
-			rectangleShader->LoadSource(display,
-				BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_COLOR_GRADIENT);
-		}
+		void LoadShaders();
 
 	public:
 		// The Renderer2D class is allowed to access
@@ -82,6 +85,7 @@ namespace Battery {
 		std::unique_ptr<ShaderProgram> circleShader;
 		std::unique_ptr<ShaderProgram> arcShader;
 		std::unique_ptr<ShaderProgram> rectangleShader;
+		std::unique_ptr<ShaderProgram> spriteShader;
 
 		std::optional<std::reference_wrapper<AllegroWindow>> window;
 		std::optional<std::reference_wrapper<Battery::Texture2D>> texture;
@@ -90,10 +94,37 @@ namespace Battery {
 	class Renderer2D {
 	public:
 
-		// These 2 functions are called automatically
-		static void Setup();
+		// These 2 functions are called automatically, the size is the one of the window
+		static void Setup(RenderBackend backend = RenderBackend::OPENGL, const glm::ivec2& size = glm::ivec2(0, 0));
 		static void Shutdown();
 
+		static RenderBackend GetBackend();
+		// The window content of the software backend, nullptr with OpenGL. It's complete after EndScene()
+		static SoftwareRasterizer* GetSoftwareRasterizer();
+
+		// Called automatically at the start of every frame, resets the stats
+		static void BeginFrame();
+
+		// Counted the same way for both backends, reset automatically at the start of every frame
+		static Renderer2DStats GetStats();
+		static void ResetStats();
+
+		// Whether anything within the bounds can end up on the target of the current scene. Every draw function
+		// checks this itself, it's for skipping work before drawing, e.g. with a SpatialIndex
+		static bool IsVisible(const glm::vec2& min, const glm::vec2& max);
+
+		// Drawing is limited to the intersection of all pushed rectangles, in whole pixels. Scenes rendering to
+		// a texture start with an empty stack, the one of the window is restored by EndScene()
+		static void PushClipRect(const glm::vec2& min, const glm::vec2& max);
+		static void PopClipRect();
+		// Returns false when nothing is clipped
+		static bool GetClipRect(glm::vec2& min, glm::vec2& max);
+
+		// Sprites, textures and text are drawn by ascending layer (0-255), then depth (0-1), whatever order they
+		// were queued in. Within the same layer and depth they are grouped by texture, only sprites which may
+		// overlap keep their order. Shapes are drawn immediately and flush the queue. Reset by BeginScene()
+		static void SetSortOrder(int layer, float depth = 0.f);
+
 		static void BeginScene(Scene* scene);
 		static void EndScene();
 		static void EndUnfinishedScene();
@@ -111,10 +142,50 @@ namespace Battery {
 		static void DrawCircle(const glm::vec2& center, float radius, float outlineThickness,
 			const glm::vec4& outlineColor, const glm::vec4& fillColor, float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF);
 
+		// Joins and caps are the ones set with Graphics::UseLineJoin() and Graphics::UseLineCap().
+		// The whole polyline is one draw call without overdraw at the joins, see PathTessellator
+		static void DrawPolyline(const std::vector<glm::vec2>& points, float thickness, const glm::vec4& color,
+			float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF);
+		static void DrawPolyline(const glm::vec2* points, size_t count, const glm::vec4& color, const StrokeStyle& style);
+
+		// Like DrawPolyline(), but the last point is joined with the first one
+		static void DrawPath(const std::vector<glm::vec2>& points, float thickness, const glm::vec4& color,
+			float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF);
+		static void DrawPath(const glm::vec2* points, size_t count, const glm::vec4& color, const StrokeStyle& style);
+
+		// Draws the part of the series within [dataMin, dataMax], which is mapped onto point1 to point2,
+		// e.g. pass the bottom left corner as point1 for y pointing up. Decimated to the width in pixels first
+		static void DrawPlotLine(PlotSeries& series, const glm::dvec2& dataMin, const glm::dvec2& dataMax,
+			const glm::vec2& point1, const glm::vec2& point2, float thickness, const glm::vec4& color,
+			float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF);
+
 		// Set outlineThickness or outlineColor alpha to 0 for no line and set fillColor alpha to 0 for no fill
 		static void DrawRectangle(const glm::vec2& point1, const glm::vec2& point2, float outlineThickness, 
 			const glm::vec4& outlineColor, const glm::vec4& fillColor, float falloff = BATTERY_ANTIALIASING_LINE_FALLOFF);
 
+		// Textured quads are queued and drawn in one batch as long as they use the same bitmap,
+		// so sprites from the same TextureAtlas page are batched even when they show different images
+		static void DrawTexture(const glm::vec2& point1, const glm::vec2& point2, const Texture2D& texture,
+			const glm::vec4& tint = glm::vec4(255, 255, 255, 255));
+		// Draws the mipmap level which fits the size of the quad best
+		static void DrawTexture(const glm::vec2& point1, const glm::vec2& point2, const MipmapChain& mipmaps,
+			const glm::vec4& tint = glm::vec4(255, 255, 255, 255));
+		static void DrawSprite(const glm::vec2& point1, const glm::vec2& point2, const TextureAtlas& atlas,
+			const AtlasRegion& region, const glm::vec4& tint = glm::vec4(255, 255, 255, 255));
+		// Draws the visible tiles of the image, an image pixel (x, y) ends up at position + (x, y) * scale
+		static void DrawTiledImage(TiledImage& image, const glm::vec2& position, float scale,
+			const glm::vec4& tint = glm::vec4(255, 255, 255, 255));
+
+		// The text is positioned by its top left corner, lines are separated by '\n'. Glyphs go into the same
+		// sprite batches as textures, everything drawn with one font usually needs a single batch
+		static void DrawString(Font& font, const std::string& text, const glm::vec2& position, float size,
+			const glm::vec4& color);
+
+		// Draws the queued sprites, called automatically before anything else is drawn and at the end of the scene
+		static void FlushSprites();
+		// Call before changing the pixels of a texture which queued sprites may use, e.g. an atlas page
+		static void PrepareTextureUpdate(ALLEGRO_BITMAP* bitmap);
+
 		// Primitive drawing routines
 		static void DrawBackground(const glm::vec4& color);
 		static void DrawPrimitiveLine(const glm::vec2& p1, const glm::vec2& p2, float thickness, const glm::vec4& color);
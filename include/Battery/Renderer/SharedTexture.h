@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Texture2D.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// Reference counted, copy-on-write handle to a Texture2D. Copying a SharedTexture is O(1), the bitmap is
+	/// only cloned when a shared texture is modified through GetMutable() or SetFlags(). Textures loaded with
+	/// Load() come from the AssetCache if it is initialized, so identical files share one bitmap as well.
+	/// </summary>
+	class SharedTexture {
+	public:
+		SharedTexture();
+		SharedTexture(Texture2D&& texture);
+		SharedTexture(std::shared_ptr<const Texture2D> texture);		// Not owned, it is cloned before any modification
+		explicit SharedTexture(const std::string& path, int flags = 0);
+
+		bool Load(const std::string& path, int flags = 0);
+		bool SetFlags(int flags);
+
+		// Read-only access, nullptr if there is no texture
+		const Texture2D* Get() const;
+		const Texture2D* operator->() const;
+
+		// Clones the texture first if it is shared with other handles
+		Texture2D& GetMutable();
+
+		// For drawing only, never draw into the returned bitmap as it may be shared
+		ALLEGRO_BITMAP* GetAllegroBitmap() const;
+		int GetWidth() const;
+		int GetHeight() const;
+
+		bool IsValid() const;
+		bool IsShared() const;
+		long GetUseCount() const;
+
+	private:
+		std::shared_ptr<const Texture2D> texture;
+		bool owned = false;		// If false, the texture belongs to someone else, e.g. the AssetCache
+	};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+
+namespace Battery {
+
+	struct SoftwareRasterizerStats {
+		size_t pendingCommands = 0;		// Recorded since the last flush
+		size_t flushedCommands = 0;		// Rasterized by the last flush
+		size_t binnedCommands = 0;		// Command and tile pairs of the last flush
+		size_t tiles = 0;
+		double flushTime = 0.0;			// Seconds spent in the last flush
+	};
+
+	struct RasterCommand;
+	struct RasterImage;
+
+	/// <summary>
+	/// Draws the primitives of Renderer2D on the CPU into a memory buffer, for rendering without a display or GPU.
+	/// Lines, circles, arcs and rectangles have the same distance based antialiasing as the shaders, colors are
+	/// in the range 0-255 like everywhere in Renderer2D. Draw calls are only recorded, Flush() splits the target
+	/// into tiles and rasterizes them in parallel, every tile applies its commands in the order they were recorded.
+	/// </summary>
+	class SoftwareRasterizer {
+	public:
+		SoftwareRasterizer();
+		SoftwareRasterizer(int width, int height);
+		SoftwareRasterizer(const SoftwareRasterizer& rasterizer) = delete;
+		void operator=(const SoftwareRasterizer& rasterizer) = delete;
+		~SoftwareRasterizer();
+
+		// When the size changes, recorded commands are discarded and the content is cleared to transparent black
+		void Resize(int width, int height);
+		int GetWidth() const;
+		int GetHeight() const;
+
+		// Commands recorded afterwards only change the pixels within [min, max), including Clear()
+		void SetClipRect(const glm::ivec2& min, const glm::ivec2& max);
+		void ResetClipRect();
+
+		void Clear(const glm::vec4& color);
+		void DrawLine(const glm::vec2& p1, const glm::vec2& p2, float thickness, const glm::vec4& color, float falloff);
+		void DrawCircle(const glm::vec2& center, float radius, const glm::vec4& color, float falloff);
+		// Angles in radians within [0, 2pi), counterclockwise on screen
+		void DrawArc(const glm::vec2& center, float radius, float startAngle, float endAngle, float thickness,
+			const glm::vec4& color, float falloff);
+		void DrawRectangle(const glm::vec2& point1, const glm::vec2& point2, const glm::vec4& color);
+		// Untextured triangles with interpolated vertex colors, which are normalized to 0-1 like in Allegro
+		void DrawTriangles(const ALLEGRO_VERTEX* vertices, const int* indices, size_t indexCount);
+
+		// The pixels of the bitmap are copied once until the next flush, source coordinates are in pixels
+		void DrawBitmap(const glm::vec2& point1, const glm::vec2& point2, ALLEGRO_BITMAP* bitmap,
+			const glm::vec2& source1, const glm::vec2& source2, const glm::vec4& tint);
+
+		// The pixels of the bitmap changed, they are copied again when it's drawn next
+		void InvalidateImage(ALLEGRO_BITMAP* bitmap);
+
+		// Rasterizes everything recorded so far
+		void Flush();
+
+		// RGBA, 8 bits per channel, row by row without padding. Only contains what was drawn before the last flush
+		const std::vector<uint32_t>& GetPixels() const;
+		// Takes over size and content of the bitmap, recorded commands are discarded
+		bool CopyFromBitmap(ALLEGRO_BITMAP* bitmap);
+		bool CopyToBitmap(ALLEGRO_BITMAP* bitmap) const;
+		bool Save(const std::string& path) const;
+
+		SoftwareRasterizerStats GetStats() const;
+
+	private:
+		const RasterImage* GetImage(ALLEGRO_BITMAP* bitmap);
+		void RasterizeTile(int tileX, int tileY, const std::vector<uint32_t>& commandIndices, float* buffer);
+		void RasterizeTriangle(size_t triangle, const glm::ivec2& origin, int tileWidth, int tileHeight, float* buffer);
+
+		int width = 0;
+		int height = 0;
+		std::vector<uint32_t> pixels;
+		glm::ivec2 clipMin = { 0, 0 };
+		glm::ivec2 clipMax = { 0, 0 };
+		std::vector<RasterCommand> commands;
+		std::vector<ALLEGRO_VERTEX> triangleVertices;	// Of all triangle commands, binned per triangle
+		std::vector<int> triangleIndices;
+		std::vector<glm::ivec4> triangleBounds;		// Pixels [xy, zw) of every triangle within its clip, set by Flush()
+		std::unordered_map<ALLEGRO_BITMAP*, std::unique_ptr<RasterImage>> images;
+		std::vector<std::unique_ptr<RasterImage>> retiredImages;		// Invalidated, but used by recorded commands
+		SoftwareRasterizerStats stats;
+	};
+
+}
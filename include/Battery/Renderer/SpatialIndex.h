@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// A uniform grid over the bounding boxes of static content, so only the visible part of a large scene has
+	/// to be drawn. Items are numbered in the order they were inserted, queries return them in that order, so
+	/// drawing the result keeps the painter's order:
+	///   for (uint32_t item : index.Query(viewMin, viewMax)) DrawItem(items[item]);
+	/// The grid is rebuilt by the first query after items were inserted.
+	/// </summary>
+	class SpatialIndex {
+	public:
+		SpatialIndex();
+
+		// Returns the item number, which is the number of items inserted before
+		uint32_t Insert(const glm::vec2& min, const glm::vec2& max);
+		void Clear();
+		size_t GetSize() const;
+
+		// Items whose bounds intersect the rectangle, valid until the next query
+		const std::vector<uint32_t>& Query(const glm::vec2& min, const glm::vec2& max);
+
+	private:
+		void Build();
+		glm::ivec2 GetCell(const glm::vec2& point) const;
+
+		std::vector<glm::vec2> itemMin;
+		std::vector<glm::vec2> itemMax;
+		bool dirty = false;
+
+		// Items per cell, the items of cell i are cellItems[cellStart[i], cellStart[i + 1])
+		glm::vec2 origin = { 0, 0 };
+		glm::vec2 cellSize = { 1, 1 };
+		glm::ivec2 cells = { 0, 0 };
+		std::vector<uint32_t> cellStart;
+		std::vector<uint32_t> cellItems;
+		std::vector<uint32_t> largeItems;	// Covering too many cells, they are tested by every query
+
+		std::vector<uint32_t> result;
+		std::vector<uint32_t> visited;		// The query an item was last found by, against duplicates
+		uint32_t queryCounter = 0;
+	};
+
+}
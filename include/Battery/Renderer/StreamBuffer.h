@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// A vertex and an index buffer on the GPU for geometry which changes every frame. Geometry is written
+	/// once into write-only locked ranges and drawn from there, instead of being uploaded by every
+	/// al_draw_indexed_prim() call. Both buffers are used as ring buffers holding the last
+	/// BATTERY_STREAM_BUFFER_FRAMES frames, so a range is only written again when the GPU is done with it.
+	/// They grow when a frame needs more.
+	/// </summary>
+	class StreamBuffer {
+	public:
+		// The declaration must outlive the buffer, nullptr is ALLEGRO_VERTEX
+		StreamBuffer(ALLEGRO_VERTEX_DECL* decl = nullptr, size_t vertexSize = sizeof(ALLEGRO_VERTEX));
+		StreamBuffer(const StreamBuffer& buffer) = delete;
+		void operator=(const StreamBuffer& buffer) = delete;
+		~StreamBuffer();
+
+		// The indices are relative to the first vertex. Returns the position of the first index for Draw(),
+		// or -1 when there are no vertex buffers, e.g. without a display. Draw from memory then
+		int Write(const void* vertices, size_t vertexCount, const int* indices, size_t indexCount);
+		int Write(const void* vertices, size_t vertexCount, const uint16_t* indices, size_t indexCount);
+		void Draw(ALLEGRO_BITMAP* texture, int firstIndex, int indexCount, int type = ALLEGRO_PRIM_TRIANGLE_LIST);
+
+		// Ranges written this many frames ago can be reused, called once per frame
+		void NextFrame();
+		// The buffers belong to the display, they must be released before it is destroyed
+		void Release();
+
+		size_t GetFrameBytes() const;			// Written since NextFrame()
+		size_t GetLastFrameBytes() const;
+		size_t GetCapacityBytes() const;
+
+	private:
+		struct Ring {
+			int capacity = 0;
+			uint64_t position = 0;				// Counting every element ever written, the offset is position % capacity
+			uint64_t frameStarts[BATTERY_STREAM_BUFFER_FRAMES] = {};
+
+			// Returns the offset, or -1 when the range would overwrite one of the frames which may still be in use
+			int Allocate(int count, size_t frame);
+		};
+
+		template<typename T>
+		int WriteGeometry(const void* vertices, size_t vertexCount, const T* indices, size_t indexCount);
+		bool Create(int vertexCapacity, int indexCapacity);
+
+		ALLEGRO_VERTEX_DECL* decl = nullptr;
+		size_t vertexSize = 0;
+		ALLEGRO_VERTEX_BUFFER* vertexBuffer = nullptr;
+		ALLEGRO_INDEX_BUFFER* indexBuffer = nullptr;
+		Ring vertexRing;
+		Ring indexRing;
+		size_t frame = 0;
+		bool unsupported = false;				// Creating the buffers failed, it's not tried again
+
+		size_t frameBytes = 0;
+		size_t lastFrameBytes = 0;
+	};
+
+}
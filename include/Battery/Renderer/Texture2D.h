@@ -3,18 +3,20 @@
 #include "Battery/AllegroDeps.h"
 #include "Battery/Core/AllegroContext.h"
 #include "Battery/Log/Log.h"
+#include "Battery/Renderer/PixelConvert.h"
 #include "clip.h"
 
 #undef LoadBitmap
 
 namespace Battery {
 
+	// Copies clone the bitmap, use SharedTexture where copies should be cheap.
+	// Moves never clone, so containers of textures can grow without copying
 	class Texture2D {
 	public:
 		Texture2D();
 		Texture2D(const Texture2D& texture);
 		Texture2D(const std::string& path, int flags = 0);
-		Texture2D(Texture2D& texture);
 		Texture2D(Texture2D&& texture) noexcept;
 		Texture2D(int width, int height, int flags = 0);
 		Texture2D(const clip::image& image, int flags = 0);
@@ -25,6 +27,8 @@ namespace Battery {
 
 		bool Load(const std::string& path, int flags = 0);
 		bool Load(ALLEGRO_BITMAP* bitmap, int flags = 0);
+		bool LoadPixels(const void* pixels, ptrdiff_t pitch, PixelConvert::PixelLayout layout, int width, int height,
+			int flags = 0);
 		bool SetFlags(int flags);
 		int GetFlags() const;
 		int GetWidth() const;
@@ -39,8 +43,18 @@ namespace Battery {
 		void Unload();
 		bool IsValid() const;
 
+		// How many bitmaps were cloned by any texture, e.g. for checking that copies are avoided
+		static size_t GetCloneCount();
+
 	private:
+		friend class AssetCache;	// Hands out shared textures without cloning the bitmap
+
+		// Takes ownership of the bitmap and registers it with the TextureResidency manager
+		bool Adopt(ALLEGRO_BITMAP* bitmap);
+		static ALLEGRO_BITMAP* Clone(ALLEGRO_BITMAP* bitmap, int flags);
+
 		ALLEGRO_BITMAP* allegroBitmap = nullptr;
+		static std::atomic<size_t> cloneCount;
 	};
 
 }
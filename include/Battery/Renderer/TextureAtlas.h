@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Renderer/Texture2D.h"
+#include "Battery/Renderer/AtlasPacker.h"
+
+namespace Battery {
+
+	// Location of a sub-texture in the atlas. The rectangle is in pixels, which is also what
+	// Allegro expects as UV coordinates
+	struct AtlasRegion {
+		size_t page = 0;
+		AtlasRect rect;
+		uint64_t generation = 0;		// Of the page at the time the region was packed
+	};
+
+	/// <summary>
+	/// Packs many small textures into a few large pages, so that sprites using them can be drawn
+	/// in a single batch, see Renderer2D::DrawSprite(). Sub-textures are identified by a key, usually the path.
+	/// When all pages are full, the least recently used page is cleared entirely. Regions of evicted pages
+	/// become invalid, so look them up with Find() every frame instead of storing them.
+	/// </summary>
+	class TextureAtlas {
+	public:
+		TextureAtlas(int pageSize = BATTERY_TEXTURE_ATLAS_PAGE_SIZE, int padding = BATTERY_TEXTURE_ATLAS_PADDING,
+			size_t maxPages = BATTERY_TEXTURE_ATLAS_MAX_PAGES, int flags = 0);
+		TextureAtlas(const TextureAtlas& atlas) = delete;
+		void operator=(const TextureAtlas& atlas) = delete;
+
+		// Copies the texture into the atlas, or returns the existing region if the key is already known.
+		// Returns nullopt if the texture is invalid or too large for a page
+		std::optional<AtlasRegion> Add(const std::string& key, const Texture2D& texture);
+		std::optional<AtlasRegion> Add(const std::string& key, ALLEGRO_BITMAP* bitmap);
+
+		// Also marks the page of the region as recently used
+		std::optional<AtlasRegion> Find(const std::string& key);
+		bool IsValid(const AtlasRegion& region) const;
+		void Clear();
+
+		ALLEGRO_BITMAP* GetPageBitmap(size_t page) const;
+		size_t GetPageCount() const;
+		size_t GetRegionCount() const;
+		uint64_t GetEvictedCount() const;		// Number of regions which were evicted so far
+		float GetOccupancy() const;				// Averaged over all pages
+
+	private:
+		struct Page {
+			std::unique_ptr<Texture2D> texture;
+			AtlasPacker packer;
+			uint64_t generation = 0;
+			uint64_t lastUsed = 0;
+			std::vector<std::string> keys;
+		};
+
+		void ClearPage(Page& page);
+		void CopyToPage(ALLEGRO_BITMAP* bitmap, Page& page, const AtlasRect& rect);
+
+		int pageSize = 0;
+		int padding = 0;
+		size_t maxPages = 0;
+		int flags = 0;
+		uint64_t useCounter = 0;
+		uint64_t evictedCount = 0;
+
+		std::vector<Page> pages;
+		std::unordered_map<std::string, AtlasRegion> regions;
+	};
+
+}
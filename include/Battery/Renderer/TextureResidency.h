@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+
+namespace Battery {
+
+	struct TextureMemoryStats {
+		size_t budget = 0;					// In bytes
+		size_t residentBytes = 0;			// Video memory used by textures
+		size_t evictedBytes = 0;			// System memory used by evicted textures
+		size_t residentTextures = 0;
+		size_t evictedTextures = 0;
+		uint64_t evictions = 0;
+		uint64_t reloads = 0;
+		uint64_t failedReloads = 0;			// At most one attempt per texture and frame
+	};
+
+	/// <summary>
+	/// Keeps the video memory used by Texture2D objects within a budget. Once per frame, the least recently used
+	/// textures are converted to memory bitmaps until the budget is met again. Textures used during the
+	/// previous frame are never evicted. Evicted textures are converted back transparently the next time
+	/// Texture2D::GetAllegroBitmap() is called, the Allegro bitmap pointer stays the same.
+	/// </summary>
+	class TextureResidency {
+	public:
+
+		// These 2 functions are called automatically
+		static void Setup();
+		static void Shutdown();
+		static bool IsInitialized();
+
+		// Evicts textures until the budget is met, called automatically once per frame before rendering
+		static void Update();
+
+		static void SetBudget(size_t bytes);
+		static TextureMemoryStats GetStats();
+
+		// Used by Texture2D, only video bitmaps are tracked
+		static void Register(ALLEGRO_BITMAP* bitmap);
+		static void Unregister(ALLEGRO_BITMAP* bitmap);
+		static void Touch(ALLEGRO_BITMAP* bitmap);
+	};
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+
+namespace Battery {
+
+	struct TiledImageStats {
+		size_t residentTiles = 0;
+		size_t capacity = 0;			// Tile slots in the cache texture
+		size_t pendingTiles = 0;		// Requested, but not resident yet
+		size_t visibleTiles = 0;		// Quads returned by the last call to CollectVisibleTiles()
+		uint64_t loadedTiles = 0;
+		uint64_t evictedTiles = 0;
+	};
+
+	// A visible tile, the source coordinates are pixels in the cache texture
+	struct TileQuad {
+		glm::vec2 point1;
+		glm::vec2 point2;
+		glm::vec2 source1;
+		glm::vec2 source2;
+	};
+
+	struct TiledImageData;
+
+	/// <summary>
+	/// Displays images far larger than a single texture. On first use, the source is split into a pyramid of
+	/// tiles which is stored in the cache directory, keyed by the content hash of the source. Afterwards, only
+	/// the tiles visible at the current zoom level are read from disk on a background thread and kept in a
+	/// bounded cache texture, so all of them can be drawn in one batch, see Renderer2D::DrawTiledImage().
+	/// Tiles which are not loaded yet are replaced by the corresponding part of a coarser level.
+	/// </summary>
+	class TiledImage {
+	public:
+		TiledImage();
+		TiledImage(const TiledImage& image) = delete;
+		void operator=(const TiledImage& image) = delete;
+		~TiledImage();
+
+		// Building the pyramid needs the whole source decoded in memory once and blocks until it's done
+		bool Open(const std::string& path, const std::string& cacheDirectory);
+		void Close();
+		bool IsOpen() const;
+
+		int GetWidth() const;
+		int GetHeight() const;
+		size_t GetLevelCount() const;
+
+		/// <summary>
+		/// Upload finished tiles, request the missing ones and collect the quads to draw. An image pixel (x, y)
+		/// ends up at position + (x, y) * scale, everything outside the view rectangle is skipped
+		/// </summary>
+		void CollectVisibleTiles(const glm::vec2& position, float scale, const glm::vec2& viewMin, const glm::vec2& viewMax,
+			std::vector<TileQuad>& quads);
+
+		ALLEGRO_BITMAP* GetCacheBitmap() const;
+		TiledImageStats GetStats() const;
+
+	private:
+		std::unique_ptr<TiledImageData> data;
+	};
+
+}
@@ -51,7 +51,7 @@ namespace Battery {
 			ALLEGRO_USTR* ustr = al_ustr_new("");
 			al_ustr_append_chr(ustr, codepoint);
 
-			strncpy_s(buffer, al_cstr(ustr), length);
+			snprintf(buffer, length, "%s", al_cstr(ustr));
 
 			al_ustr_free(ustr);
 		}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/Utils/FileUtils.h"
+
+// Compact binary serialization based on MessagePack (https://msgpack.org).
+// Files are compatible with nlohmann::json::to_msgpack() / from_msgpack(), so existing
+// JSON based state can be converted without changing its structure.
+
+namespace Battery {
+	namespace BinaryUtils {
+
+		enum class BinaryType {
+			INVALID,
+			NIL,
+			BOOL,
+			INTEGER,		// Negative integer
+			UNSIGNED,		// Positive integer
+			FLOAT,
+			STRING,
+			BINARY,
+			ARRAY,
+			MAP,
+			EXTENSION
+		};
+
+		/// <summary>
+		/// A non-owning, read-only view of a single MessagePack value inside a buffer. Nothing is parsed or copied up front:
+		/// strings and binary blobs are returned as views into the buffer, nested values are located on access.
+		/// Accessing a value with the wrong type returns the fallback, accessing missing elements returns an invalid view.
+		/// The view is only valid as long as the underlying buffer is
+		/// </summary>
+		class BinaryView {
+		public:
+			BinaryView();
+			BinaryView(std::string_view buffer);	// Views the first value in the buffer
+
+			BinaryType GetType() const;
+			bool IsValid() const;
+			bool IsNull() const;
+			bool IsArray() const;
+			bool IsMap() const;
+			bool IsString() const;
+			bool IsNumber() const;
+
+			size_t GetSize() const;			// Number of elements of arrays and maps, number of bytes of strings and binaries
+			size_t GetByteSize() const;		// Encoded size of the entire value including nested values
+
+			bool AsBool(bool fallback = false) const;
+			int64_t AsInt(int64_t fallback = 0) const;
+			uint64_t AsUnsigned(uint64_t fallback = 0) const;
+			double AsDouble(double fallback = 0.0) const;
+			float AsFloat(float fallback = 0.f) const;
+			std::string_view AsString(std::string_view fallback = std::string_view()) const;
+			std::string_view AsBinary() const;
+			nlohmann::json ToJson() const;		// Discarded if the value is malformed, too deeply nested or contains binary or extension types
+
+			BinaryView operator[](size_t index) const;				// Array element, linear in the index
+			BinaryView operator[](std::string_view key) const;		// Map value, linear in the size of the map
+
+			// Iteration, return false from the callback to stop. Returns false if the value is not an array or a map
+			bool ForEachElement(const std::function<bool(const BinaryView& element)>& callback) const;
+			bool ForEachField(const std::function<bool(std::string_view key, const BinaryView& value)>& callback) const;
+
+			template<glm::length_t L, typename T, glm::qualifier Q>
+			glm::vec<L, T, Q> AsVec(const glm::vec<L, T, Q>& fallback = glm::vec<L, T, Q>()) const {
+				if (GetType() != BinaryType::ARRAY || GetSize() != L)
+					return fallback;
+
+				glm::vec<L, T, Q> result;
+				BinaryView element = First();
+				for (glm::length_t i = 0; i < L; i++) {
+					if (!element.IsNumber())
+						return fallback;
+					result[i] = element.AsNumber<T>();
+					element = element.Next();
+				}
+				return result;
+			}
+
+			// Matrices are stored column by column as a flat array
+			template<glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+			glm::mat<C, R, T, Q> AsMat(const glm::mat<C, R, T, Q>& fallback = glm::mat<C, R, T, Q>()) const {
+				if (GetType() != BinaryType::ARRAY || GetSize() != C * R)
+					return fallback;
+
+				glm::mat<C, R, T, Q> result;
+				BinaryView element = First();
+				for (glm::length_t c = 0; c < C; c++) {
+					for (glm::length_t r = 0; r < R; r++) {
+						if (!element.IsNumber())
+							return fallback;
+						result[c][r] = element.AsNumber<T>();
+						element = element.Next();
+					}
+				}
+				return result;
+			}
+
+		private:
+			BinaryView(const uint8_t* data, const uint8_t* end);
+
+			template<typename T>
+			T AsNumber() const {
+				if (std::is_floating_point<T>::value)
+					return (T)AsDouble();
+				if (GetType() == BinaryType::UNSIGNED)
+					return (T)AsUnsigned();
+				return (T)AsInt();
+			}
+
+			BinaryView First() const;		// First element of an array or the first key of a map
+			BinaryView Next() const;		// The value directly following this one in the buffer
+
+			const uint8_t* data = nullptr;
+			const uint8_t* end = nullptr;
+		};
+
+		/// <summary>
+		/// A memory mapped MessagePack file, see FileUtils::MappedFile. GetRoot() returns a view of the top-level value,
+		/// which stays valid as long as the file is open
+		/// </summary>
+		class BinaryFile {
+		public:
+			BinaryFile();
+			BinaryFile(const std::string& path);
+
+			bool Open(const std::string& path);
+			void Close();
+			bool IsOpen() const;
+			BinaryView GetRoot() const;
+
+		private:
+			FileUtils::MappedFile file;
+		};
+
+		/// <summary>
+		/// Encode values as MessagePack into an in-memory buffer. Containers are prefixed with their number of elements,
+		/// so the count must be known when the container is started. Maps take 'count' key-value pairs.
+		/// Example: writer.BeginMap(2).Field("name", "test").Key("position").Value(glm::vec2(1, 2));
+		/// </summary>
+		class BinaryWriter {
+		public:
+			BinaryWriter();
+
+			BinaryWriter& BeginArray(size_t count);
+			BinaryWriter& BeginMap(size_t count);
+			BinaryWriter& Key(std::string_view key);
+
+			BinaryWriter& Null();
+			BinaryWriter& Value(bool value);
+			BinaryWriter& Value(float value);
+			BinaryWriter& Value(double value);
+			BinaryWriter& Value(const char* value);
+			BinaryWriter& Value(const std::string& value);
+			BinaryWriter& Value(std::string_view value);
+			BinaryWriter& Value(const nlohmann::json& value);
+			BinaryWriter& Binary(const void* data, size_t size);
+
+			template<typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+			BinaryWriter& Value(T value) {
+				if (std::is_signed<T>::value && (int64_t)value < 0)
+					return WriteInteger((int64_t)value);
+				else
+					return WriteUnsigned((uint64_t)value);
+			}
+
+			template<glm::length_t L, typename T, glm::qualifier Q>
+			BinaryWriter& Value(const glm::vec<L, T, Q>& value) {
+				BeginArray(L);
+				for (glm::length_t i = 0; i < L; i++)
+					Value(value[i]);
+				return *this;
+			}
+
+			template<glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+			BinaryWriter& Value(const glm::mat<C, R, T, Q>& value) {
+				BeginArray(C * R);
+				for (glm::length_t c = 0; c < C; c++)
+					for (glm::length_t r = 0; r < R; r++)
+						Value(value[c][r]);
+				return *this;
+			}
+
+			template<typename T>
+			BinaryWriter& Field(std::string_view key, const T& value) {
+				Key(key);
+				return Value(value);
+			}
+
+			bool IsComplete() const;		// True if all started containers received all of their elements
+			const std::string& GetData() const;
+			void Clear();
+
+			bool Save(const std::string& path) const;
+
+		private:
+			BinaryWriter& WriteInteger(int64_t value);
+			BinaryWriter& WriteUnsigned(uint64_t value);
+			void WriteHeader(uint8_t fixed, uint8_t fixedLimit, uint8_t base8, uint8_t base16, uint8_t base32, uint64_t length);
+			void WriteBigEndian(uint64_t value, size_t bytes);
+			void BeforeValue();
+
+			std::string buffer;
+			std::vector<uint64_t> remaining;
+		};
+
+		/// <summary>
+		/// Write a json object as a MessagePack file. This is a drop-in replacement for writing json.dump()
+		/// with FileUtils::WriteFile(), the file is smaller and much faster to load again
+		/// </summary>
+		/// <param name="path">- The full or relative path of the file, the directory is created if necessary</param>
+		/// <param name="value">- The json value to write</param>
+		/// <returns>bool - if the file was written successfully</returns>
+		bool WriteMsgPackFile(const std::string& path, const nlohmann::json& value);
+
+		/// <summary>
+		/// Load a MessagePack file into a json object. Use BinaryFile instead to read values without building a DOM
+		/// </summary>
+		/// <param name="path">- The full or relative path of the file</param>
+		/// <returns>std::optional&lt;nlohmann::json&gt; - The json value, empty if the file could not be opened or is invalid</returns>
+		std::optional<nlohmann::json> ReadMsgPackFile(const std::string& path);
+
+	}
+}
@@ -38,6 +38,99 @@ namespace Battery {
 			}
 		};
 
+		/// <summary>
+		/// A read-only view of a file, mapped into memory by the operating system. Pages are loaded on demand
+		/// and can be dropped again by the OS, so even very large files can be read without holding them in memory.
+		/// The data stays valid until the MappedFile is closed or destroyed
+		/// </summary>
+		class MappedFile {
+		public:
+			MappedFile();
+			MappedFile(const std::string& path);
+			MappedFile(MappedFile&& other) noexcept;
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			void operator=(const MappedFile&) = delete;
+			MappedFile& operator=(MappedFile&& other) noexcept;
+
+			bool Open(const std::string& path);
+			void Close();
+			bool IsOpen() const;
+
+			const char* GetData() const;
+			size_t GetSize() const;
+
+			std::string_view GetView() const {
+				return std::string_view(GetData(), GetSize());
+			}
+
+		private:
+			const char* data = nullptr;
+			size_t size = 0;
+			bool open = false;
+		};
+
+		enum class DirectoryEntryType {
+			NONE,
+			FILE,
+			DIRECTORY,
+			SYMLINK,
+			OTHER
+		};
+
+		// A single element of a directory listing, all metadata is collected while enumerating
+		struct DirectoryEntry {
+			std::string name;			// Only the filename, e.g. "file.txt"
+			std::string path;			// Parent path and filename, e.g. "C:/some/file.txt"
+			DirectoryEntryType type = DirectoryEntryType::NONE;
+			uint64_t size = 0;			// Size in bytes, 0 for directories
+			std::time_t modifiedTime = 0;
+			size_t depth = 0;			// 0 for direct children of the enumerated directory
+
+			bool IsFile() const {
+				return type == DirectoryEntryType::FILE;
+			}
+
+			bool IsDirectory() const {
+				return type == DirectoryEntryType::DIRECTORY;
+			}
+		};
+
+		// Return false to skip an entry. Skipped directories are not descended into.
+		typedef std::function<bool(const DirectoryEntry& entry)> DirectoryFilter;
+
+		/// <summary>
+		/// Iterate over the content of a directory, usable in a range-based for loop:
+		/// for (auto& entry : DirectoryIterator("C:/some/path", true)) { ... }
+		/// Name, type, size and modification time are read in one pass from the native directory listing,
+		/// no additional file system calls are done per entry. Recursion is depth-first, directories are
+		/// returned before their content. Copies of an iterator share the same position.
+		/// </summary>
+		class DirectoryIterator {
+		public:
+			DirectoryIterator();	// Constructs the end iterator
+			DirectoryIterator(const std::string& path, bool recursive = false, DirectoryFilter filter = nullptr);
+
+			const DirectoryEntry& operator*() const;
+			const DirectoryEntry* operator->() const;
+			DirectoryIterator& operator++();
+			bool operator==(const DirectoryIterator& other) const;
+			bool operator!=(const DirectoryIterator& other) const;
+
+			DirectoryIterator begin() const {
+				return *this;
+			}
+
+			DirectoryIterator end() const {
+				return DirectoryIterator();
+			}
+
+		private:
+			struct State;
+			std::shared_ptr<State> state;
+		};
+
 		/// <summary>
 		/// Check if a given filename exists, can either be a directory or a file
 		/// </summary>
@@ -59,6 +152,13 @@ namespace Battery {
 		/// <returns>bool - is a valid directory or not</returns>
 		bool DirectoryExists(const std::string& path);
 
+		/// <summary>
+		/// Get type, size and modification time of a single file or directory. Symbolic links are followed
+		/// </summary>
+		/// <param name="path">- The full or relative path</param>
+		/// <returns>std::optional&lt;DirectoryEntry&gt; - The information with a depth of 0, empty if the path does not exist</returns>
+		std::optional<DirectoryEntry> GetFileInfo(const std::string& path);
+
 		/// <summary>
 		/// Get the content of a directory. The return is an array of filenames and directory names. Must be checked with
 		/// FileExists() and DirectoryExists() to know whether it's a file or directory
@@ -67,6 +167,29 @@ namespace Battery {
 		/// <returns>std::vector&lt;std::string&gt; - An array with all filenames and directory names</returns>
 		std::vector<std::string> GetDirectoryContent(const std::string& path);
 
+		/// <summary>
+		/// Get the content of a directory including type, size and modification time of every element.
+		/// See DirectoryIterator for details
+		/// </summary>
+		/// <param name="path">- The full or relative path</param>
+		/// <param name="recursive">- If subdirectories should be enumerated as well</param>
+		/// <param name="filter">- Optional filter, return false to skip an entry (and its content)</param>
+		/// <returns>std::vector&lt;DirectoryEntry&gt; - All entries in depth-first order, empty if the directory does not exist</returns>
+		std::vector<DirectoryEntry> EnumerateDirectory(const std::string& path, bool recursive = false, 
+			DirectoryFilter filter = nullptr);
+
+		/// <summary>
+		/// Recursively enumerate a directory, every top-level subdirectory is enumerated on a worker thread.
+		/// The result is in the same order as EnumerateDirectory(path, true, filter) would return. The filter is called
+		/// from multiple threads at once and must be thread-safe
+		/// </summary>
+		/// <param name="path">- The full or relative path</param>
+		/// <param name="filter">- Optional filter, return false to skip an entry (and its content)</param>
+		/// <param name="threadCount">- Maximum number of worker threads, 0 to use the number of hardware threads</param>
+		/// <returns>std::vector&lt;DirectoryEntry&gt; - All entries in depth-first order, empty if the directory does not exist</returns>
+		std::vector<DirectoryEntry> EnumerateDirectoryParallel(const std::string& path, DirectoryFilter filter = nullptr,
+			size_t threadCount = 0);
+
 		/// <summary>
 		/// Create a new directory, needed parent directories are created automatically
 		/// </summary>
@@ -93,6 +216,15 @@ namespace Battery {
 		/// <returns>bool - if successful</returns>
 		bool WriteFile(const std::string& path, const std::string& content);
 
+		/// <summary>
+		/// Write binary data to a file exactly as it is, without any line ending conversion. When the parent directory
+		/// does not exist, it is created with PrepareDirectory()
+		/// </summary>
+		/// <param name="path">- The complete filename and path</param>
+		/// <param name="content">- The bytes to write</param>
+		/// <returns>bool - if successful, an incomplete file is removed again</returns>
+		bool WriteBinaryFile(const std::string& path, std::string_view content);
+
 		/// <summary>
 		/// Delete a file or empty directory from memory
 		/// </summary>
@@ -257,7 +389,8 @@ namespace Battery {
 
 
 		/// <summary>
-		/// Get the filename from a full path, for example: Pass "C:/some/file.txt" and get "file.txt"
+		/// Get the filename from a full path, for example: Pass "C:/some/file.txt" and get "file.txt".
+		/// This and the following functions are based on PathUtils, use it directly to avoid allocating strings.
 		/// </summary>
 		/// <param name="path">- The full or relative path to process</param>
 		/// <returns>std::string - Only the last part of the path</returns>
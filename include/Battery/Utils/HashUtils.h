@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Battery/pch.h"
+
+namespace Battery {
+	namespace HashUtils {
+
+		/// <summary>
+		/// Calculate the 64-bit xxHash (XXH64) of a block of memory. It is a fast non-cryptographic hash,
+		/// suitable for identifying content, but not for security purposes.
+		/// </summary>
+		/// <param name="data">- Pointer to the data</param>
+		/// <param name="size">- Number of bytes to hash</param>
+		/// <param name="seed">- Optional seed, different seeds produce unrelated hashes</param>
+		/// <returns>uint64_t - The hash, identical to the reference XXH64 implementation</returns>
+		uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+		/// <summary>
+		/// Calculate the 64-bit xxHash (XXH64) of a string, see Hash64(const void*, size_t, uint64_t)
+		/// </summary>
+		/// <param name="str">- The string to hash</param>
+		/// <param name="seed">- Optional seed, different seeds produce unrelated hashes</param>
+		/// <returns>uint64_t - The hash</returns>
+		uint64_t Hash64(std::string_view str, uint64_t seed = 0);
+
+		/// <summary>
+		/// Calculate the 64-bit xxHash (XXH64) of the content of a file. The file is memory mapped and not copied.
+		/// </summary>
+		/// <param name="path">- The full or relative path of the file</param>
+		/// <returns>std::optional&lt;uint64_t&gt; - The hash, empty if the file could not be opened</returns>
+		std::optional<uint64_t> HashFile(const std::string& path);
+
+		/// <summary>
+		/// Format a hash as 16 lowercase hexadecimal digits, for example to use it as a filename
+		/// </summary>
+		/// <param name="hash">- The hash to format</param>
+		/// <returns>std::string - The hexadecimal representation</returns>
+		std::string ToHexString(uint64_t hash);
+
+	}
+}
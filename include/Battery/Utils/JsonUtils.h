@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Battery/pch.h"
+#include "Battery/AllegroDeps.h"
+#include "Battery/Core/Config.h"
+
+namespace Battery {
+	namespace JsonUtils {
+
+		// Base class for SAX event handlers, override the callbacks of nlohmann::json_sax
+		typedef nlohmann::json_sax<nlohmann::json> SaxHandler;
+
+		/// <summary>
+		/// Parse a JSON file event by event without building a DOM. The file is memory mapped, so memory usage
+		/// does not depend on the file size. Parsing stops when a callback of the handler returns false
+		/// </summary>
+		/// <param name="path">- The full or relative path of the file</param>
+		/// <param name="handler">- The SAX handler receiving all events</param>
+		/// <exception cref="Battery::Exception - Thrown when the handler is nullptr"></exception>
+		/// <returns>bool - false if the file could not be opened, is invalid or parsing was stopped</returns>
+		bool ParseFileSax(const std::string& path, SaxHandler* handler);
+
+		/// <summary>
+		/// Parse a JSON string event by event without building a DOM. See ParseFileSax()
+		/// </summary>
+		/// <param name="json">- The JSON text, it is not copied</param>
+		/// <param name="handler">- The SAX handler receiving all events</param>
+		/// <exception cref="Battery::Exception - Thrown when the handler is nullptr"></exception>
+		/// <returns>bool - false if the text is invalid or parsing was stopped</returns>
+		bool ParseSax(std::string_view json, SaxHandler* handler);
+
+		/// <summary>
+		/// Parse a file consisting of one large top-level array and call the callback with every element, one after another.
+		/// Only a single element is held in memory at a time, which makes this suitable for huge record dumps.
+		/// Return false from the callback to stop early
+		/// </summary>
+		/// <param name="path">- The full or relative path of the file</param>
+		/// <param name="callback">- Called with every complete element of the top-level array</param>
+		/// <returns>bool - false if the file could not be opened, is invalid or the top-level value is not an array</returns>
+		bool ForEachArrayElement(const std::string& path, std::function<bool(nlohmann::json& element)> callback);
+
+		/// <summary>
+		/// Write a JSON document incrementally to a file, without building it in memory first.
+		/// Output is buffered and flushed in blocks of BATTERY_JSON_WRITER_BUFFER_SIZE bytes. The output is compact
+		/// and numbers are formatted exactly like nlohmann::json::dump() does.
+		/// Example: writer.BeginObject().Field("name", "test").Key("values").BeginArray().Value(1).EndArray().EndObject();
+		/// </summary>
+		class JsonWriter {
+		public:
+			JsonWriter();
+			JsonWriter(const std::string& path);
+			~JsonWriter();
+
+			JsonWriter(const JsonWriter&) = delete;
+			void operator=(const JsonWriter&) = delete;
+
+			bool Open(const std::string& path);
+			bool Close();		// Returns false if any write failed or the document is incomplete
+			bool IsOpen() const;
+			bool HasFailed() const;
+			uint64_t GetBytesWritten() const;
+
+			JsonWriter& BeginObject();
+			JsonWriter& EndObject();
+			JsonWriter& BeginArray();
+			JsonWriter& EndArray();
+			JsonWriter& Key(std::string_view key);
+
+			JsonWriter& Null();
+			JsonWriter& Value(bool value);
+			JsonWriter& Value(double value);
+			JsonWriter& Value(const char* value);
+			JsonWriter& Value(const std::string& value);
+			JsonWriter& Value(std::string_view value);
+			JsonWriter& Value(const nlohmann::json& value);
+
+			template<typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+			JsonWriter& Value(T value) {
+				if (std::is_signed<T>::value)
+					return WriteInteger((int64_t)value);
+				else
+					return WriteUnsigned((uint64_t)value);
+			}
+
+			template<typename T>
+			JsonWriter& Field(std::string_view key, const T& value) {
+				Key(key);
+				return Value(value);
+			}
+
+		private:
+			struct Scope {
+				bool isObject = false;
+				bool empty = true;
+				bool keyWritten = false;
+			};
+
+			JsonWriter& WriteInteger(int64_t value);
+			JsonWriter& WriteUnsigned(uint64_t value);
+			void BeforeValue();
+			void Write(std::string_view str);
+			void WriteString(std::string_view str);
+			void Flush();
+
+			ALLEGRO_FILE* file = nullptr;
+			std::string buffer;
+			std::vector<Scope> scopes;
+			bool rootWritten = false;
+			bool failed = false;
+			uint64_t bytesWritten = 0;
+		};
+
+	}
+}
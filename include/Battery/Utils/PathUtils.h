@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Battery/pch.h"
+
+// Pure string based path manipulation. Nothing here depends on Allegro, so all functions
+// can be used before the engine is initialized. Both '/' and '\' are accepted as separators,
+// returned views point into the given path and no heap memory is allocated unless a std::string is returned.
+
+namespace Battery {
+	namespace PathUtils {
+
+		inline bool IsSeparator(char c) {
+			return c == '/' || c == '\\';
+		}
+
+		/// <summary>
+		/// Iterates over every component of a path, for example "C:/some//file.txt" yields "C:", "some" and "file.txt".
+		/// Empty components from leading, trailing or repeated separators are skipped.
+		/// Usage: for (std::string_view component : PathUtils::Components(path)) { ... }
+		/// </summary>
+		class Components {
+		public:
+			class Iterator {
+			public:
+				Iterator();
+				Iterator(std::string_view path, size_t position);
+
+				std::string_view operator*() const;
+				Iterator& operator++();
+				bool operator==(const Iterator& other) const;
+				bool operator!=(const Iterator& other) const;
+
+			private:
+				void FindEnd();
+
+				std::string_view path;
+				size_t begin = 0;
+				size_t end = 0;
+			};
+
+			Components(std::string_view path);
+
+			Iterator begin() const;
+			Iterator end() const;
+			size_t size() const;
+
+		private:
+			std::string_view path;
+		};
+
+		/// <summary>
+		/// Get the last part of a path, for example: Pass "C:/some/file.txt" and get "file.txt".
+		/// Returns "" if the path ends with a separator.
+		/// </summary>
+		/// <param name="path">- The full or relative path to process</param>
+		/// <returns>std::string_view - A view into the path</returns>
+		std::string_view GetFilename(std::string_view path);
+
+		/// <summary>
+		/// Get the filename without its extension, for example: Pass "C:/some/multiple.dots.txt" and get "multiple.dots".
+		/// </summary>
+		/// <param name="path">- The full or relative path to process</param>
+		/// <returns>std::string_view - A view into the path</returns>
+		std::string_view GetStem(std::string_view path);
+
+		/// <summary>
+		/// Get the extension of the filename including the dot, for example: Pass "C:/some/multiple.dots.txt" and get ".txt".
+		/// Returns "" if the filename does not contain a dot.
+		/// </summary>
+		/// <param name="path">- The full or relative path to process</param>
+		/// <returns>std::string_view - A view into the path</returns>
+		std::string_view GetExtension(std::string_view path);
+
+		/// <summary>
+		/// Get everything up to and including the last separator, for example: Pass "C:/some/file.txt" and get "C:/some/".
+		/// Returns "" if the path does not contain a separator.
+		/// </summary>
+		/// <param name="path">- The full or relative path to process</param>
+		/// <returns>std::string_view - A view into the path</returns>
+		std::string_view GetParent(std::string_view path);
+
+		/// <summary>
+		/// Check if a path is absolute, meaning it starts with a separator or a drive letter like "C:"
+		/// </summary>
+		/// <param name="path">- The path to check</param>
+		/// <returns>bool - If the path is absolute</returns>
+		bool IsAbsolute(std::string_view path);
+
+		/// <summary>
+		/// Check if a path has the given extension, ignoring upper and lower case. The extension can be given with or without the dot.
+		/// </summary>
+		/// <param name="path">- The path to check</param>
+		/// <param name="extension">- The extension to compare to, for example ".png" or "png"</param>
+		/// <returns>bool - If the extensions are equal</returns>
+		bool HasExtension(std::string_view path, std::string_view extension);
+
+		/// <summary>
+		/// Append a path to another one, inserting a single '/' between them. If 'path' is absolute, it replaces 'base'.
+		/// The result is written to 'result', whose capacity is reused when called repeatedly.
+		/// </summary>
+		/// <param name="result">- The string receiving the joined path, previous content is overwritten</param>
+		/// <param name="base">- The leading part</param>
+		/// <param name="path">- The trailing part</param>
+		void JoinTo(std::string& result, std::string_view base, std::string_view path);
+
+		/// <summary>
+		/// Lexically normalize a path: Convert every separator to '/', collapse repeated separators and resolve "." and ".." components.
+		/// Leading ".." of relative paths are kept, a trailing separator is kept. The filesystem is not accessed.
+		/// For example: "C:\\some\\.\\dir/../file.txt" becomes "C:/some/file.txt"
+		/// The result is written to 'result', whose capacity is reused when called repeatedly.
+		/// </summary>
+		/// <param name="result">- The string receiving the normalized path, previous content is overwritten</param>
+		/// <param name="path">- The path to normalize</param>
+		void NormalizeTo(std::string& result, std::string_view path);
+
+		// Convenience overloads of JoinTo() and NormalizeTo() returning a new string
+		std::string Join(std::string_view base, std::string_view path);
+		std::string Normalize(std::string_view path);
+
+	}
+}
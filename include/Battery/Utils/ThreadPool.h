@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Battery/pch.h"
+
+namespace Battery {
+
+	/// <summary>
+	/// A fixed set of worker threads for splitting loops across cores. ParallelFor() blocks until the whole range
+	/// is done, the calling thread helps out. Calls from inside a ParallelFor() run on the calling thread only.
+	/// </summary>
+	class ThreadPool {
+	public:
+		ThreadPool(size_t threadCount = 0);			// 0 uses all but one hardware thread
+		ThreadPool(const ThreadPool& pool) = delete;
+		void operator=(const ThreadPool& pool) = delete;
+		~ThreadPool();
+
+		// Calls the function with consecutive subranges [begin, end) which together cover [0, count),
+		// the function must not throw
+		void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function);
+
+		size_t GetThreadCount() const;				// Worker threads, not counting the caller
+
+		// Shared by the engine, created on first use
+		static ThreadPool& GetShared();
+
+	private:
+		struct Job;
+
+		void WorkerThread();
+		void RunJob(Job& job);
+
+		std::mutex mutex;
+		std::mutex callMutex;						// Only one ParallelFor() at a time
+		std::condition_variable condition;
+		std::condition_variable finished;
+		std::shared_ptr<Job> currentJob;
+		std::vector<std::thread> workers;
+		bool stopping = false;
+	};
+
+}
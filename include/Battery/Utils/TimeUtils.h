@@ -54,20 +54,20 @@ namespace Battery {
 				for (size_t i = 0; i < BATTERY_PROFILING_MAX_SCOPED_NUMBER; i++) {
 					memset(names[i], 0, BATTERY_PROFILING_SCOPED_STRING_LENGTH);
 				}
-				memset(times, 0, BATTERY_PROFILING_MAX_SCOPED_NUMBER);
+				memset(times, 0, sizeof(times));
 				nextIndex = 0;
 			}
 
 			void AddResult(const char* name, double value) {
 
 				if (nextIndex >= BATTERY_PROFILING_MAX_SCOPED_NUMBER) {
-					LOG_CORE_ERROR(__FUNCTION__"(): Can't add another profiler result: The result buffer is full! "
+					LOG_CORE_ERROR(std::string(__FUNCTION__) + "(): Can't add another profiler result: The result buffer is full! "
 						"Up to " + std::to_string(BATTERY_PROFILING_MAX_SCOPED_NUMBER) + " results are supported!");
 					return;
 				}
 
 				times[nextIndex] = value;
-				strncpy_s(names[nextIndex], name, BATTERY_PROFILING_SCOPED_STRING_LENGTH);
+				snprintf(names[nextIndex], BATTERY_PROFILING_SCOPED_STRING_LENGTH, "%s", name);
 				nextIndex++;
 			}
 		};
@@ -81,7 +81,7 @@ namespace Battery {
 			char names[BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER][BATTERY_PROFILING_TIMEPOINT_STRING_LENGTH];
 
 			TimestampProfiler() {
-				memset(timestamps, 0, BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER);
+				memset(timestamps, 0, sizeof(timestamps));
 				for (size_t i = 0; i < BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER; i++) {
 					memset(names[i], 0, BATTERY_PROFILING_TIMEPOINT_STRING_LENGTH);
 				}
@@ -112,13 +112,13 @@ namespace Battery {
 			void AddTimestamp(const char* name) {
 
 				if (nextIndex >= BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER) {
-					LOG_CORE_ERROR(__FUNCTION__"(): Can't add another timepoint: The profiler timepoint buffer is full! "
+					LOG_CORE_ERROR(std::string(__FUNCTION__) + "(): Can't add another timepoint: The profiler timepoint buffer is full! "
 						"Up to " + std::to_string(BATTERY_PROFILING_MAX_TIMEPOINT_NUMBER) + " timepoints are supported!");
 					return;
 				}
 
 				timestamps[nextIndex] = GetRuntime();
-				strncpy_s(names[nextIndex], name, BATTERY_PROFILING_TIMEPOINT_STRING_LENGTH);
+				snprintf(names[nextIndex], BATTERY_PROFILING_TIMEPOINT_STRING_LENGTH, "%s", name);
 				nextIndex++;
 			}
 		};
@@ -208,7 +208,7 @@ namespace Battery {
 			{
 				// Start the timer
 				startTime = GetRuntime();
-				strncpy_s(this->name, name.c_str(), BATTERY_PROFILING_SCOPED_STRING_LENGTH);
+				snprintf(this->name, BATTERY_PROFILING_SCOPED_STRING_LENGTH, "%s", name.c_str());
 			}
 
 			ScopedTimer(const char* name, ProfileResults* buffer) :
@@ -216,7 +216,7 @@ namespace Battery {
 			{
 				// Start the timer
 				startTime = GetRuntime();
-				strncpy_s(this->name, name, BATTERY_PROFILING_SCOPED_STRING_LENGTH);
+				snprintf(this->name, BATTERY_PROFILING_SCOPED_STRING_LENGTH, "%s", name);
 			}
 
 			~ScopedTimer() {
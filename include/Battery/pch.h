@@ -2,17 +2,31 @@
 
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <numeric>
+#include <limits>
 #include <optional>
 #include <iomanip>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstddef>
 #include <thread>
+#include <functional>
+#include <memory>
+#include <ctime>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #include "glm/glm.hpp"
 
@@ -181,3 +181,90 @@ project (projectName .. "-Release")
     -- Organize the files in the Visual Studio project view
     --makeVPaths(_SCRIPT_DIR .. "/include")
     --makeVPaths(_SCRIPT_DIR .. "/src")
+
+
+-- Test and benchmark application, it runs headless with the software renderer (see tests/TestApplication.cpp).
+-- It builds the framework itself, so it can be generated for Linux as well, e.g. 'premake5 gmake2'
+project (projectName .. "-Tests")
+    kind "ConsoleApp"
+    language "C++"
+	cppdialect "C++17"
+    location "build/Tests"
+    targetname (projectName .. "Tests")
+    targetdir (_SCRIPT_DIR .. "/bin")
+    debugdir (_SCRIPT_DIR .. "/bin")
+    debugargs { "--dir", _SCRIPT_DIR .. "/tests" }
+
+    defines { "NDEBUG" }
+    runtime "Release"
+    optimize "On"
+    architecture "x86_64"
+    
+    includedirs ({ 
+        _SCRIPT_DIR .. "/include", 
+        _SCRIPT_DIR .. "/modules", 
+        _SCRIPT_DIR .. "/modules/imgui",
+        _SCRIPT_DIR .. "/modules/imgui/backends",
+        _SCRIPT_DIR .. "/modules/implot",
+        _SCRIPT_DIR .. "/modules/spdlog/include",
+        _SCRIPT_DIR .. "/modules/serial/include",
+        _SCRIPT_DIR .. "/modules/clip",
+        _SCRIPT_DIR .. "/tests"
+    })
+    
+    -- Main source files and the tests
+    files ({ _SCRIPT_DIR .. "/include/**", _SCRIPT_DIR .. "/src/**", _SCRIPT_DIR .. "/tests/**.h", _SCRIPT_DIR .. "/tests/**.cpp" })
+
+    -- Serial library
+    files ({ _SCRIPT_DIR .. "/modules/serial/src/serial.cc" })
+
+    -- Clip library
+    files ({ _SCRIPT_DIR .. "/modules/clip/clip.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/clip/image.cpp" })
+
+    -- ImGui/ImPlot library
+    files ({ _SCRIPT_DIR .. "/modules/imgui/imgui.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/imgui/imgui_demo.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/imgui/imgui_draw.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/imgui/imgui_tables.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/imgui/imgui_widgets.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/imgui/backends/imgui_impl_allegro5.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/implot/implot.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/implot/implot_demo.cpp" })
+    files ({ _SCRIPT_DIR .. "/modules/implot/implot_items.cpp" })
+
+    -- Precompiled headers
+    pchheader "Battery/pch.h"
+    pchsource "src/pch.cpp"
+    filter { "files:include/glm/detail/glm.cpp or files:modules/**" }
+        flags { 'NoPCH' }
+    filter {}
+
+    -- Windows: The static Allegro package, like the framework projects
+    filter { "system:windows" }
+        staticruntime "on"
+        defines { "ALLEGRO_STATICLINK" }
+        includedirs ({ _SCRIPT_DIR .. "/packages/Allegro.5.2.7/build/native/include" })
+        libdirs ({ 
+            _SCRIPT_DIR .. "/packages/Allegro.5.2.7/build/native/v142/x64/lib",
+            _SCRIPT_DIR .. "/packages/AllegroDeps.1.12.0/build/native/v142/x64/deps/lib"
+        })
+        links ({ "allegro_monolith-static", "freetype", "jpeg", "libpng16", "webp", "zlib", "opengl32", "winmm", "setupapi", "shlwapi" })
+        files ({ _SCRIPT_DIR .. "/modules/serial/src/impl/win.cc" })
+        files ({ _SCRIPT_DIR .. "/modules/serial/src/impl/list_ports/list_ports_win.cc" })
+        files ({ _SCRIPT_DIR .. "/modules/clip/clip_win.cpp" })
+    filter { "system:windows", "files:modules/clip/clip_win.cpp" }
+        disablewarnings { "4018", "4267" }
+    filter { "system:windows", "files:modules/serial/src/impl/win.cc" }
+        disablewarnings { "4244" }
+    filter { "system:windows", "files:modules/serial/src/serial.cc" }
+        disablewarnings { "4101" }
+
+    -- Linux: Allegro 5.2 from the system packages (e.g. liballegro5-dev)
+    filter { "system:linux" }
+        links ({ "allegro", "allegro_font", "allegro_ttf", "allegro_primitives", "allegro_image", "allegro_dialog",
+            "allegro_memfile", "xcb", "GL", "pthread" })
+        files ({ _SCRIPT_DIR .. "/modules/serial/src/impl/unix.cc" })
+        files ({ _SCRIPT_DIR .. "/modules/serial/src/impl/list_ports/list_ports_linux.cc" })
+        files ({ _SCRIPT_DIR .. "/modules/clip/clip_x11.cpp" })
+    filter {}
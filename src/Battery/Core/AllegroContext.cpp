@@ -15,7 +15,7 @@ namespace Battery {
 		}
 	}
 
-	bool AllegroContext::Initialize(const std::string& applicationName) {
+	bool AllegroContext::Initialize(const std::string& applicationName, bool headless) {
 
 		if (IsInitialized()) {
 			LOG_CORE_WARN("The Allegro context is already initialized!");
@@ -59,6 +59,11 @@ namespace Battery {
 			return false;
 		}
 
+		if (headless) {
+			LOG_CORE_TRACE("Allegro context created without keyboard and mouse");
+			return true;
+		}
+
 		if (!al_install_keyboard()) {
 			LOG_CORE_CRITICAL("Failed to install the Allegro keyboard module!");
 			ShowErrorMessageBox("Failed to install the Allegro keyboard module!");
@@ -12,14 +12,14 @@
 
 #define CHECK_ALLEGRO_INIT() \
 	if (!Battery::AllegroContext::GetInstance()->IsInitialized()) {	\
-		throw Battery::Exception(__FUNCTION__ "(): Allegro Context is not initialized!");	\
+		throw Battery::Exception(std::string(__FUNCTION__) + "(): Allegro Context is not initialized!");	\
 	}
 
 namespace Battery {
 
 	AllegroWindow::AllegroWindow(int w, int h) {
-		width = max(w, BATTERY_MIN_WINDOW_WIDTH);
-		height = max(h, BATTERY_MIN_WINDOW_HEIGHT);
+		width = std::max(w, BATTERY_MIN_WINDOW_WIDTH);
+		height = std::max(h, BATTERY_MIN_WINDOW_HEIGHT);
 	}
 
 	AllegroWindow::~AllegroWindow() {
@@ -100,7 +100,7 @@ namespace Battery {
 
 		// Limit window size
 		if (!al_set_window_constraints(allegroDisplayPointer, BATTERY_MIN_WINDOW_WIDTH, BATTERY_MIN_WINDOW_HEIGHT, 0, 0)) {
-			LOG_CORE_WARN(__FUNCTION__ "(): Window constraints could not be set!");
+			LOG_CORE_WARN("{}(): Window constraints could not be set!", __FUNCTION__);
 		}
 		al_apply_window_constraints(allegroDisplayPointer, true);
 		
@@ -133,9 +133,18 @@ namespace Battery {
 		}
 	}
 
+	bool AllegroWindow::WaitForEvent(double timeout) {
+		CHECK_ALLEGRO_INIT();
+
+		if (allegroEventQueue == nullptr)
+			return false;
+
+		return al_wait_for_event_timed(allegroEventQueue, nullptr, (float)std::max(timeout, 0.0));
+	}
+
 	void AllegroWindow::HandleEvents() {
 		CHECK_ALLEGRO_INIT();
-		PROFILE_CORE_SCOPE(__FUNCTION__"()");
+		PROFILE_CORE_SCOPE(std::string(__FUNCTION__) + "()");
 
 		if (eventCallback != nullptr && allegroEventQueue != nullptr) {
 
@@ -172,9 +181,14 @@ namespace Battery {
 			al_acknowledge_resize(allegroDisplayPointer);
 		}
 
+		if (event->GetType() == Battery::EventType::WindowFocus) {
+			focused = true;
+		}
+
 		// Clear keyboard buffer when window loses focus
 		if (event->GetType() == Battery::EventType::WindowLostFocus) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Window lost focus: Clearing keyboard state");
+			focused = false;
+			LOG_CORE_TRACE("{}(): Window lost focus: Clearing keyboard state", __FUNCTION__);
 			al_clear_keyboard_state(allegroDisplayPointer);
 		}
 
@@ -182,7 +196,7 @@ namespace Battery {
 			eventCallback(event);
 		}
 		else {
-			LOG_CORE_TRACE(__FUNCTION__"(): OnEvent callback can't be called: Function pointer is nullptr!");
+			LOG_CORE_TRACE("{}(): OnEvent callback can't be called: Function pointer is nullptr!", __FUNCTION__);
 		}
 	}
 
@@ -200,11 +214,15 @@ namespace Battery {
 
 	int AllegroWindow::GetWidth() {
 		CHECK_ALLEGRO_INIT();
+		if (!valid)
+			return width;
 		return al_get_display_width(allegroDisplayPointer);
 	}
 
 	int AllegroWindow::GetHeight() {
 		CHECK_ALLEGRO_INIT();
+		if (!valid)
+			return height;
 		return al_get_display_height(allegroDisplayPointer);
 	}
 
@@ -216,7 +234,7 @@ namespace Battery {
 	void AllegroWindow::SetSize(const glm::vec2 size) {
 		CHECK_ALLEGRO_INIT();
 		al_resize_display(allegroDisplayPointer, 
-			max(size.x, BATTERY_MIN_WINDOW_WIDTH), max(size.y, BATTERY_MIN_WINDOW_HEIGHT));
+			std::max(size.x, (float)BATTERY_MIN_WINDOW_WIDTH), std::max(size.y, (float)BATTERY_MIN_WINDOW_HEIGHT));
 	}
 
 	void AllegroWindow::SetTitle(const std::string title) {
@@ -268,45 +286,74 @@ namespace Battery {
 		return mouse.buttons & 0x04;
 	}
 
+#ifdef _WIN32
 	HWND AllegroWindow::GetWinHandle() {
 		CHECK_ALLEGRO_INIT();
 		return al_get_win_window_handle(allegroDisplayPointer);
 	}
+#endif
 
 	bool AllegroWindow::IsFocused() {
 		CHECK_ALLEGRO_INIT();
+#ifdef _WIN32
 		return GetForegroundWindow() == GetWinHandle();
+#else
+		return focused;
+#endif
 	}
 
 	bool AllegroWindow::Focus() {
 		CHECK_ALLEGRO_INIT();
+#ifdef _WIN32
 		return SetForegroundWindow(GetWinHandle());
+#else
+		LOG_CORE_WARN("{}(): The window can only be focused on Windows", __FUNCTION__);
+		return false;
+#endif
 	}
 
 	bool AllegroWindow::Hide() {
 		CHECK_ALLEGRO_INIT();
+#ifdef _WIN32
 		return ShowWindow(GetWinHandle(), SW_HIDE);
+#else
+		LOG_CORE_WARN("{}(): The window can only be hidden on Windows", __FUNCTION__);
+		return false;
+#endif
 	}
 
 	bool AllegroWindow::Show() {
 		CHECK_ALLEGRO_INIT();
+#ifdef _WIN32
 		return ShowWindow(GetWinHandle(), SW_SHOW);
+#else
+		LOG_CORE_WARN("{}(): The window can only be shown on Windows", __FUNCTION__);
+		return false;
+#endif
 	}
 
 	void AllegroWindow::HideFromTaskbar() {
+#ifdef _WIN32
 		long style = GetWindowLong(GetWinHandle(), GWL_STYLE);
 		style |= WS_VISIBLE;
 		ShowWindow(GetWinHandle(), SW_HIDE);
 		SetWindowLong(GetWinHandle(), GWL_STYLE, style);
 		ShowWindow(GetWinHandle(), SW_SHOW);
 		Focus();
+#else
+		LOG_CORE_WARN("{}(): The taskbar entry can only be changed on Windows", __FUNCTION__);
+#endif
 	}
 
 	void AllegroWindow::ShowInTaskbar() {
+#ifdef _WIN32
 		long style = GetWindowLong(GetWinHandle(), GWL_STYLE);
 		style &= ~(WS_VISIBLE);
 		SetWindowLong(GetWinHandle(), GWL_STYLE, style);
 		ShowWindow(GetWinHandle(), SW_SHOW);
+#else
+		LOG_CORE_WARN("{}(): The taskbar entry can only be changed on Windows", __FUNCTION__);
+#endif
 	}
 
 	void AllegroWindow::SetFrameless(bool frameless) {
@@ -428,6 +475,7 @@ namespace Battery {
 	bool AllegroWindow::__setWindowsIconID(int iconID) {
 		CHECK_ALLEGRO_INIT();
 
+#ifdef _WIN32
 		// Load the embedded icon to the Allegro window so no external 
 		// icon resource is needed
 		HICON icon = LoadIcon(GetModuleHandle(NULL), MAKEINTRESOURCE(iconID));
@@ -440,6 +488,10 @@ namespace Battery {
 		SetClassLongPtr(winhandle, GCLP_HICONSM, (LONG_PTR)icon);
 
 		return true;
+#else
+		LOG_CORE_WARN("{}(): Executables only have embedded icons on Windows", __FUNCTION__);
+		return false;
+#endif
 	}
 
 }
@@ -2,6 +2,9 @@
 #include "Battery/pch.h"
 #include "Battery/Core/Application.h"
 #include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Renderer/AsyncTextureLoader.h"
+#include "Battery/Renderer/TextureResidency.h"
 #include "Battery/Utils/TimeUtils.h"
 
 namespace Battery {
@@ -14,8 +17,10 @@ namespace Battery {
 	}
 
 
-	Application::Application(int width, int height, const std::string applicationFolderName) : window(width, height) {
+	Application::Application(int width, int height, const std::string applicationFolderName,
+			RenderBackend renderBackend) : window(width, height) {
 		this->applicationFolderName = applicationFolderName;
+		this->renderBackend = renderBackend;
 	}
 
 	Application::~Application() {
@@ -31,6 +36,9 @@ namespace Battery {
 
 
 	bool Application::GetKey(int allegroKeycode) {
+		if (!al_is_keyboard_installed())
+			return false;
+
 		ALLEGRO_KEYBOARD_STATE keyboard;
 		al_get_keyboard_state(&keyboard);
 		return al_key_down(&keyboard, allegroKeycode);
@@ -58,18 +66,31 @@ namespace Battery {
 
 	void Application::Run(int argc, const char** argv) {
 
+		bool headless = renderBackend == RenderBackend::SOFTWARE;
+
 		// Initialize the Allegro framework
-		if (!AllegroContext::GetInstance()->Initialize(applicationFolderName)) {
+		if (!AllegroContext::GetInstance()->Initialize(applicationFolderName, headless)) {
 			LOG_CORE_WARN("The Allegro context failed to initialize, closing application...");
+			exitCode = EXIT_FAILURE;
 			return;
 		}
 
-		// Create Allegro window
-		window.Create(windowFlags);
+		// Create Allegro window, the software backend renders without one.
+		// Dirty rectangles need a back buffer which keeps its content after flipping
+		if (!headless) {
+			if (dirtyRectMode)
+				al_set_new_display_option(ALLEGRO_SWAP_METHOD, 1, ALLEGRO_SUGGEST);
+
+			window.Create(windowFlags);
+			backbufferPreserved = al_get_display_option(window.allegroDisplayPointer, ALLEGRO_SWAP_METHOD) == 1;
+		}
 		window.SetEventCallback(std::bind(&Application::_onEvent, this, std::placeholders::_1));
 
 		// Load 2D renderer
-		Renderer2D::Setup();
+		Renderer2D::Setup(renderBackend, window.GetSize());
+		TextureResidency::Setup();
+		AssetCache::Setup();
+		AsyncTextureLoader::Setup();
 
 		// Parse command line arguments
 		LOG_CORE_TRACE("Command line arguments:");
@@ -117,12 +138,20 @@ namespace Battery {
 			ShowErrorMessageBox(std::string("Application::OnShutdown() threw Battery::Exception: ") + e.what());
 		}
 
-		// Unload 2D renderer
+		// Unload texture loader, asset cache, residency manager and 2D renderer
+		LOG_CORE_TRACE("Shutting down asynchronous texture loader");
+		AsyncTextureLoader::Shutdown();
+		LOG_CORE_TRACE("Shutting down asset cache");
+		AssetCache::Shutdown();
+		LOG_CORE_TRACE("Shutting down texture residency manager");
+		TextureResidency::Shutdown();
 		LOG_CORE_TRACE("Shutting down 2D Renderer");
 		Renderer2D::Shutdown();
 
 		// Destroy Allegro window
-		window.Destroy();
+		if (!headless) {
+			window.Destroy();
+		}
 
 		// Clear layer stack
 		LOG_CORE_TRACE("Clearing any left over layers from layer stack");
@@ -152,23 +181,64 @@ namespace Battery {
 
 		// Handle events
 		window.HandleEvents();
-		PROFILE_TIMESTAMP(__FUNCTION__"() (and Handled events)");
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "() (and Handled events)");
 	}
 
 	void Application::_postUpdate() {
 		framecount++;
-		PROFILE_TIMESTAMP(__FUNCTION__"()");
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "()");
 	}
 
 	void Application::_preRender() {
+		// Upload textures which finished loading in the background
+		AsyncTextureLoader::Update();
+
+		// Keep the texture memory within the budget
+		TextureResidency::Update();
+
+		// Only the invalidated region is drawn again, the rest of the last frame stays
+		Renderer2D::BeginFrame();
+		if (dirtyRectMode) {
+			glm::ivec2 size = window.GetSize();
+			frameClipMin = { 0, 0 };
+			frameClipMax = size;
+			if (!invalidatedAll && backbufferPreserved) {
+				frameClipMin = glm::clamp(glm::ivec2(glm::floor(invalidMin)), glm::ivec2(0), size);
+				frameClipMax = glm::clamp(glm::ivec2(glm::ceil(invalidMax)), frameClipMin, size);
+			}
+			invalidated = false;
+			invalidatedAll = false;
+
+			if (renderBackend == RenderBackend::OPENGL)
+				al_set_target_backbuffer(window.allegroDisplayPointer);
+			Renderer2D::PushClipRect(frameClipMin, frameClipMax);
+		}
+		else if (lazyRendering) {
+			invalidated = false;
+			invalidatedAll = false;
+		}
+
 		// Paint the background by default
 		Renderer2D::DrawBackground(BATTERY_DEFAULT_BACKGROUND_COLOR);
-		PROFILE_TIMESTAMP(__FUNCTION__"()");
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "()");
 	}
 
 	void Application::_postRender() {
 		Renderer2D::EndUnfinishedScene();
-		PROFILE_TIMESTAMP(__FUNCTION__"()");
+
+		if (dirtyRectMode) {
+			if (renderBackend == RenderBackend::OPENGL)
+				al_set_target_backbuffer(window.allegroDisplayPointer);
+			Renderer2D::PopClipRect();
+
+			// A discarded frame is not shown, the next one has to draw its region
+			if (frameDiscarded)
+				Invalidate(frameClipMin, frameClipMax);
+		}
+		else if (lazyRendering && frameDiscarded) {
+			InvalidateAll();
+		}
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "()");
 	}
 
 	void Application::_mainLoop() {
@@ -181,6 +251,11 @@ namespace Battery {
 
 		while (!shouldClose) {
 
+			// Sleep on the event queue while there is nothing to draw
+			if (lazyRendering) {
+				_waitForRedraw();
+			}
+
 			PROFILE_TIMESTAMP_START("Mainloop start");
 			LOG_CORE_TRACE("Main loop started");
 
@@ -192,8 +267,26 @@ namespace Battery {
 				_postUpdate();
 			}
 			
-			// Render everything
-			{
+			// Requested redraws which are due now
+			if (lazyRendering) {
+				if (redrawTime <= TimeUtils::GetRuntime()) {
+					redrawTime = INFINITY;
+					InvalidateAll();
+				}
+				if (redrawFrames > 0) {
+					redrawFrames--;
+					InvalidateAll();
+				}
+
+				// Uploading textures which finished loading needs a frame
+				if (AsyncTextureLoader::IsInitialized() && AsyncTextureLoader::GetStats().decoded > 0) {
+					InvalidateAll();
+				}
+			}
+
+			// Render everything, in dirty rectangle and lazy rendering mode only if anything changed
+			bool render = (!dirtyRectMode && !lazyRendering) || invalidated;
+			if (render) {
 				PROFILE_CORE_SCOPE("Mainloop render rountines");
 				_preRender();
 				_renderApp();
@@ -220,12 +313,18 @@ namespace Battery {
 				nextFrame = now + desiredFrametime;					// not be 100% accurate
 			}
 
-			// Show rendered image
-			if (!frameDiscarded) {
+			// Show rendered image, the software backend keeps it in Renderer2D::GetSoftwareRasterizer()
+			if (render && !frameDiscarded && renderBackend == RenderBackend::OPENGL) {
 				PROFILE_CORE_SCOPE("Mainloop flipping frame buffers");
 				LOG_CORE_TRACE("Flipping displays");
 				al_set_current_opengl_context(window.allegroDisplayPointer);
-				al_flip_display();
+
+				// Only the drawn region if the driver supports it, otherwise it's a normal flip
+				glm::ivec2 size = frameClipMax - frameClipMin;
+				if (!dirtyRectMode || size == window.GetSize())
+					al_flip_display();
+				else if (size.x > 0 && size.y > 0)
+					al_update_display_region(frameClipMin.x, frameClipMin.y, size.x, size.y);
 				PROFILE_TIMESTAMP("Flipped display buffers");
 			}
 
@@ -242,7 +341,7 @@ namespace Battery {
 		OnUpdate();
 
 		if (frameDiscarded) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Skipping further update routines, frame was discarded");
+			LOG_CORE_TRACE("{}(): Skipping further update routines, frame was discarded", __FUNCTION__);
 			return;
 		}
 
@@ -251,13 +350,13 @@ namespace Battery {
 			LOG_CORE_TRACE("Layer '{}' OnUpdate()", layer->GetDebugName().c_str());
 			layer->OnUpdate();
 		}
-		PROFILE_TIMESTAMP(__FUNCTION__"()");
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "()");
 	}
 
 	void Application::_renderApp() {
 
 		if (frameDiscarded) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Skipping main render routine, frame was discarded");
+			LOG_CORE_TRACE("{}(): Skipping main render routine, frame was discarded", __FUNCTION__);
 			return;
 		}
 
@@ -266,7 +365,7 @@ namespace Battery {
 		OnRender();
 
 		if (frameDiscarded) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Skipping further render routines, frame was discarded");
+			LOG_CORE_TRACE("{}(): Skipping further render routines, frame was discarded", __FUNCTION__);
 			return;
 		}
 
@@ -275,11 +374,21 @@ namespace Battery {
 			LOG_CORE_TRACE("Layer '{}' OnRender()", layer->GetDebugName().c_str());
 			layer->OnRender();
 		}
-		PROFILE_TIMESTAMP(__FUNCTION__"()");
+		PROFILE_TIMESTAMP(std::string(__FUNCTION__) + "()");
 	}
 
 	void Application::_onEvent(Event* e) {
 
+		// The back buffer is recreated with the window
+		if (dirtyRectMode && e->GetType() == EventType::WindowResize) {
+			InvalidateAll();
+		}
+
+		// Without dirty rectangles, nobody reports what an event changed
+		if (lazyRendering && !dirtyRectMode) {
+			InvalidateAll();
+		}
+
 		// Give the event to the base application
 		LOG_CORE_TRACE("Application::OnEvent()");
 		OnEvent(e);
@@ -302,15 +411,42 @@ namespace Battery {
 		}
 	}
 
+	void Application::_waitForRedraw() {
+
+		if (invalidated || redrawFrames > 0)
+			return;
+
+		double now = TimeUtils::GetRuntime();
+		double timeout = std::min<double>(BATTERY_LAZY_RENDERING_MAX_WAIT, redrawTime - now);
+
+		// Textures loading in the background are polled every frame
+		if (AsyncTextureLoader::IsInitialized()) {
+			AsyncTextureLoaderStats stats = AsyncTextureLoader::GetStats();
+			if (stats.decoded > 0)
+				return;
+			if (stats.queued > 0)
+				timeout = std::min(timeout, 1.0 / desiredFramerate);
+		}
+
+		if (timeout <= 0.0)
+			return;
+
+		PROFILE_CORE_SCOPE("Mainloop waiting for events");
+		if (renderBackend == RenderBackend::SOFTWARE)
+			TimeUtils::Sleep(timeout);
+		else
+			window.WaitForEvent(timeout);
+	}
+
 	void Application::SetFramerate(double f) {
 		desiredFramerate = f;
 	}
 
-	void Application::SetWindowFlag(enum class WindowFlags flag) {
+	void Application::SetWindowFlag(WindowFlags flag) {
 		this->windowFlags |= (int)flag;
 	}
 
-	void Application::ClearWindowFlag(enum class WindowFlags flag) {
+	void Application::ClearWindowFlag(WindowFlags flag) {
 		this->windowFlags &= ~(int)flag;
 	}
 
@@ -326,14 +462,64 @@ namespace Battery {
 		layers.ClearStack();
 	}
 
-	void Application::CloseApplication() {
+	void Application::CloseApplication(int exitCode) {
+		this->exitCode = exitCode;
 		shouldClose = true;
 	}
 
+	int Application::GetExitCode() const {
+		return exitCode;
+	}
+
 	void Application::DiscardFrame() {
 		frameDiscarded = true;
 	}
 
+	void Application::SetDirtyRectMode(bool enabled) {
+		dirtyRectMode = enabled;
+		InvalidateAll();
+	}
+
+	bool Application::GetDirtyRectMode() const {
+		return dirtyRectMode;
+	}
+
+	void Application::Invalidate(const glm::vec2& min, const glm::vec2& max) {
+		glm::vec2 regionMin = glm::min(min, max);
+		glm::vec2 regionMax = glm::max(min, max);
+
+		// The regions are merged into their bounding box, so the application renders once per frame
+		invalidMin = invalidated ? glm::min(invalidMin, regionMin) : regionMin;
+		invalidMax = invalidated ? glm::max(invalidMax, regionMax) : regionMax;
+		invalidated = true;
+	}
+
+	void Application::InvalidateAll() {
+		invalidated = true;
+		invalidatedAll = true;
+	}
+
+	bool Application::IsInvalidated() const {
+		return invalidated;
+	}
+
+	void Application::SetLazyRendering(bool enabled) {
+		lazyRendering = enabled;
+		InvalidateAll();
+	}
+
+	bool Application::GetLazyRendering() const {
+		return lazyRendering;
+	}
+
+	void Application::RequestRedraw(int frames) {
+		redrawFrames = std::max(redrawFrames, frames);
+	}
+
+	void Application::RequestRedrawAfter(double seconds) {
+		redrawTime = std::min(redrawTime, TimeUtils::GetRuntime() + std::max(seconds, 0.0));
+	}
+
 	Application* Application::GetApplicationPointer() {
 		return applicationPointer;
 	}
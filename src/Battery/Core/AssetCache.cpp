@@ -0,0 +1,431 @@
+
+#include "Battery/pch.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/HashUtils.h"
+#include "Battery/Utils/BinaryUtils.h"
+#include "Battery/Log/Log.h"
+
+#undef LoadBitmap
+
+#define CHECK_INIT() \
+	if (data == nullptr) { \
+		throw Battery::Exception(std::string(__FUNCTION__) + "(): The asset cache is not initialized!"); \
+	}
+
+namespace Battery {
+
+	// Last known state of a source file, used to skip hashing unchanged files
+	struct SourceInfo {
+		std::time_t modifiedTime = 0;
+		uint64_t size = 0;
+		uint64_t hash = 0;
+	};
+
+	// Layout of a decoded texture on disk: This header, followed by the pixels in RGBA order, row by row
+	struct CachedTextureHeader {
+		char magic[4] = { 'B', 'T', 'X', 'C' };
+		uint32_t version = BATTERY_ASSET_CACHE_VERSION;
+		uint32_t pixelFlags = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// The bitmap flags which change the decoded pixels, textures which differ in these are cached separately.
+	// All other flags only affect how the bitmap is created and can be applied when loading from the cache
+	static constexpr int CACHED_PIXEL_FLAGS = ALLEGRO_NO_PREMULTIPLIED_ALPHA;
+
+	struct AssetCacheData {
+		std::mutex mutex;
+		std::unordered_map<std::string, SourceInfo> sources;
+		std::map<std::pair<uint64_t, int>, std::weak_ptr<const Texture2D>> textures;	// Keyed by content hash and flags
+		std::unordered_map<uint64_t, std::weak_ptr<const std::string>> files;
+		std::string diskCacheDirectory;
+		bool indexChanged = false;
+		AssetCacheStats stats;
+	};
+
+	static AssetCacheData* data = nullptr;
+
+
+
+
+
+	// All of the following helpers expect the mutex to be locked
+
+	// Returns the content hash of a source file. The file is only read if it changed since it was last hashed,
+	// in that case it is left mapped in 'file' so that it can be decoded without reading it again
+	static std::optional<uint64_t> ResolveHash(const std::string& path, FileUtils::MappedFile& file) {
+
+		auto info = FileUtils::GetFileInfo(path);
+		if (!info || !info->IsFile())
+			return std::nullopt;
+
+		auto it = data->sources.find(path);
+		if (it != data->sources.end() && it->second.modifiedTime == info->modifiedTime && it->second.size == info->size)
+			return it->second.hash;
+
+		if (!file.Open(path))
+			return std::nullopt;
+
+		SourceInfo source;
+		source.modifiedTime = info->modifiedTime;
+		source.size = info->size;
+		source.hash = HashUtils::Hash64(file.GetData(), file.GetSize());
+
+		data->sources[path] = source;
+		data->indexChanged = true;
+		data->stats.bytesHashed += file.GetSize();
+
+		return source.hash;
+	}
+
+	static std::shared_ptr<const Texture2D> FindTexture(uint64_t hash, int flags) {
+		auto it = data->textures.find(std::make_pair(hash, flags));
+		if (it == data->textures.end())
+			return nullptr;
+
+		auto texture = it->second.lock();
+		if (!texture)
+			data->textures.erase(it);
+
+		return texture;
+	}
+
+	static std::string GetCachedTexturePath(uint64_t hash, int flags) {
+		std::string name = HashUtils::ToHexString(hash) + "-" + std::to_string(flags & CACHED_PIXEL_FLAGS);
+		return PathUtils::Join(data->diskCacheDirectory, name + BATTERY_ASSET_CACHE_EXTENSION);
+	}
+
+	static ALLEGRO_BITMAP* LoadCachedTexture(uint64_t hash, int flags) {
+
+		FileUtils::MappedFile file(GetCachedTexturePath(hash, flags));
+		if (!file.IsOpen() || file.GetSize() < sizeof(CachedTextureHeader))
+			return nullptr;
+
+		CachedTextureHeader header;
+		memcpy(&header, file.GetData(), sizeof(header));
+
+		if (memcmp(header.magic, CachedTextureHeader().magic, sizeof(header.magic)) != 0 ||
+			file.GetSize() != sizeof(header) + (uint64_t)header.width * header.height * 4)
+		{
+			LOG_CORE_WARN("{}(): Ignoring invalid cache file for hash {}", __FUNCTION__, HashUtils::ToHexString(hash));
+			return nullptr;
+		}
+
+		// Written by another version or with other pixels, it's decoded again and overwritten
+		if (header.version != BATTERY_ASSET_CACHE_VERSION || header.pixelFlags != (uint32_t)(flags & CACHED_PIXEL_FLAGS)) {
+			LOG_CORE_TRACE("{}(): Ignoring outdated cache file for hash {}", __FUNCTION__, HashUtils::ToHexString(hash));
+			return nullptr;
+		}
+
+		al_set_new_bitmap_flags(flags);
+		ALLEGRO_BITMAP* bitmap = al_create_bitmap(header.width, header.height);
+		if (bitmap == nullptr)
+			return nullptr;
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+		if (region == nullptr) {
+			al_destroy_bitmap(bitmap);
+			return nullptr;
+		}
+
+		// The pitch is negative when the bitmap is stored upside down
+		const char* pixels = file.GetData() + sizeof(header);
+		size_t rowSize = (size_t)header.width * 4;
+		for (uint32_t y = 0; y < header.height; y++)
+			memcpy((uint8_t*)region->data + (ptrdiff_t)y * region->pitch, pixels + y * rowSize, rowSize);
+
+		al_unlock_bitmap(bitmap);
+		return bitmap;
+	}
+
+	static void StoreCachedTexture(uint64_t hash, ALLEGRO_BITMAP* bitmap, int flags) {
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+		if (region == nullptr)
+			return;
+
+		CachedTextureHeader header;
+		header.pixelFlags = flags & CACHED_PIXEL_FLAGS;
+		header.width = al_get_bitmap_width(bitmap);
+		header.height = al_get_bitmap_height(bitmap);
+
+		size_t rowSize = (size_t)header.width * 4;
+		std::string content(sizeof(header) + rowSize * header.height, 0);
+		memcpy(&content[0], &header, sizeof(header));
+
+		for (uint32_t y = 0; y < header.height; y++)
+			memcpy(&content[sizeof(header) + y * rowSize], (uint8_t*)region->data + (ptrdiff_t)y * region->pitch, rowSize);
+
+		al_unlock_bitmap(bitmap);
+
+		if (!FileUtils::WriteBinaryFile(GetCachedTexturePath(hash, flags), content)) {
+			LOG_CORE_WARN("{}(): Failed to write cache file for hash {}", __FUNCTION__, HashUtils::ToHexString(hash));
+		}
+	}
+
+	// Decodes the image directly from the mapped source file, the extension selects the image format
+	static ALLEGRO_BITMAP* DecodeTexture(const std::string& path, FileUtils::MappedFile& file, int flags) {
+
+		if (!file.IsOpen() && !file.Open(path))
+			return nullptr;
+
+		if (file.GetSize() == 0)
+			return nullptr;
+
+		ALLEGRO_FILE* memfile = al_open_memfile((void*)file.GetData(), file.GetSize(), "r");
+		if (memfile == nullptr)
+			return nullptr;
+
+		std::string extension(PathUtils::GetExtension(path));
+
+		al_set_new_bitmap_flags(flags);
+		ALLEGRO_BITMAP* bitmap = al_load_bitmap_f(memfile, extension.empty() ? nullptr : extension.c_str());
+		al_fclose(memfile);
+
+		return bitmap;
+	}
+
+	// Returns a new bitmap, from the disk cache if possible or decoded from the source otherwise
+	static ALLEGRO_BITMAP* CreateBitmap(const std::string& path, uint64_t hash, FileUtils::MappedFile& file, int flags) {
+
+		if (!data->diskCacheDirectory.empty()) {
+			ALLEGRO_BITMAP* bitmap = LoadCachedTexture(hash, flags);
+			if (bitmap != nullptr) {
+				data->stats.diskHits++;
+				return bitmap;
+			}
+		}
+
+		ALLEGRO_BITMAP* bitmap = DecodeTexture(path, file, flags);
+		if (bitmap == nullptr) {
+			LOG_CORE_ERROR("Failed to load Allegro bitmap: '" + path + "'");
+			return nullptr;
+		}
+
+		data->stats.misses++;
+
+		if (!data->diskCacheDirectory.empty())
+			StoreCachedTexture(hash, bitmap, flags);
+
+		return bitmap;
+	}
+
+	static void LoadIndex() {
+
+		BinaryUtils::BinaryFile index(PathUtils::Join(data->diskCacheDirectory, BATTERY_ASSET_CACHE_INDEX_FILE));
+		if (!index.IsOpen())
+			return;
+
+		index.GetRoot().ForEachField([](std::string_view path, const BinaryUtils::BinaryView& value) {
+			if (!value.IsArray() || value.GetSize() != 3)
+				return true;
+
+			SourceInfo source;
+			source.modifiedTime = (std::time_t)value[0].AsInt();
+			source.size = value[1].AsUnsigned();
+			source.hash = value[2].AsUnsigned();
+			data->sources.emplace(std::string(path), source);	// Entries of this session are newer, don't overwrite them
+			return true;
+		});
+	}
+
+	static bool SaveIndex() {
+
+		BinaryUtils::BinaryWriter writer;
+		writer.BeginMap(data->sources.size());
+
+		for (auto& [path, source] : data->sources) {
+			writer.Key(path).BeginArray(3);
+			writer.Value((int64_t)source.modifiedTime).Value(source.size).Value(source.hash);
+		}
+
+		if (!writer.Save(PathUtils::Join(data->diskCacheDirectory, BATTERY_ASSET_CACHE_INDEX_FILE)))
+			return false;
+
+		data->indexChanged = false;
+		return true;
+	}
+
+
+
+
+
+	void AssetCache::Setup() {
+		if (data == nullptr) {
+			data = new AssetCacheData();
+		}
+		else {
+			LOG_CORE_CRITICAL("Can't setup AssetCache: Already initialized!");
+		}
+	}
+
+	void AssetCache::Shutdown() {
+		if (data != nullptr) {
+			if (!data->diskCacheDirectory.empty() && data->indexChanged)
+				SaveIndex();
+
+			delete data;
+			data = nullptr;
+		}
+		else {
+			LOG_CORE_CRITICAL("Can't shutdown AssetCache: Not initialized!");
+		}
+	}
+
+	bool AssetCache::IsInitialized() {
+		return data != nullptr;
+	}
+
+	std::shared_ptr<const Texture2D> AssetCache::LoadTexture(const std::string& path, int flags) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		FileUtils::MappedFile file;
+		auto hash = ResolveHash(path, file);
+		if (!hash) {
+			LOG_CORE_ERROR("{}(): Can't load texture '{}': The file does not exist", __FUNCTION__, path);
+			return nullptr;
+		}
+
+		if (auto texture = FindTexture(*hash, flags)) {
+			data->stats.memoryHits++;
+			return texture;
+		}
+
+		ALLEGRO_BITMAP* bitmap = CreateBitmap(path, *hash, file, flags);
+		if (bitmap == nullptr)
+			return nullptr;
+
+		auto texture = std::make_shared<Texture2D>();
+		texture->Adopt(bitmap);
+		data->textures[std::make_pair(*hash, flags)] = texture;
+
+		return texture;
+	}
+
+	std::shared_ptr<const std::string> AssetCache::LoadFile(const std::string& path) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		FileUtils::MappedFile file;
+		auto hash = ResolveHash(path, file);
+		if (!hash) {
+			LOG_CORE_ERROR("{}(): Can't load file '{}': The file does not exist", __FUNCTION__, path);
+			return nullptr;
+		}
+
+		auto it = data->files.find(*hash);
+		if (it != data->files.end()) {
+			if (auto content = it->second.lock()) {
+				data->stats.memoryHits++;
+				return content;
+			}
+			data->files.erase(it);
+		}
+
+		if (!file.IsOpen() && !file.Open(path)) {
+			LOG_CORE_ERROR("{}(): Can't load file '{}': The file could not be opened", __FUNCTION__, path);
+			return nullptr;
+		}
+
+		auto content = std::make_shared<const std::string>(file.GetData(), file.GetSize());
+		data->files[*hash] = content;
+		data->stats.misses++;
+
+		return content;
+	}
+
+	ALLEGRO_BITMAP* AssetCache::LoadBitmap(const std::string& path, int flags) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		FileUtils::MappedFile file;
+		auto hash = ResolveHash(path, file);
+		if (!hash) {
+			LOG_CORE_ERROR("Failed to load Allegro bitmap: '" + path + "'");
+			return nullptr;
+		}
+
+		// Cloning a loaded texture is much cheaper than decoding the file again. The bitmap is used directly
+		// instead of through GetAllegroBitmap(), an evicted texture is cloned from system memory and stays evicted
+		if (auto texture = FindTexture(*hash, flags)) {
+			data->stats.memoryHits++;
+			al_set_new_bitmap_flags(flags);
+			return al_clone_bitmap(texture->allegroBitmap);
+		}
+
+		return CreateBitmap(path, *hash, file, flags);
+	}
+
+	void AssetCache::SetDiskCacheDirectory(const std::string& directory) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		if (!data->diskCacheDirectory.empty() && data->indexChanged)
+			SaveIndex();
+
+		data->diskCacheDirectory = directory;
+
+		if (!directory.empty()) {
+			if (!FileUtils::MakeDirectory(directory)) {
+				LOG_CORE_ERROR("{}(): Can't create cache directory '{}', disk cache is disabled", __FUNCTION__, directory);
+				data->diskCacheDirectory = "";
+				return;
+			}
+			LoadIndex();
+		}
+	}
+
+	bool AssetCache::SaveDiskCacheIndex() {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		if (data->diskCacheDirectory.empty())
+			return false;
+
+		return SaveIndex();
+	}
+
+	std::optional<uint64_t> AssetCache::GetContentHash(const std::string& path) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		FileUtils::MappedFile file;
+		return ResolveHash(path, file);
+	}
+
+	AssetCacheStats AssetCache::GetStats() {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		AssetCacheStats stats = data->stats;
+
+		for (auto it = data->textures.begin(); it != data->textures.end();) {
+			if (it->second.expired()) {
+				it = data->textures.erase(it);
+			}
+			else {
+				stats.loadedTextures++;
+				++it;
+			}
+		}
+
+		for (auto it = data->files.begin(); it != data->files.end();) {
+			if (it->second.expired()) {
+				it = data->files.erase(it);
+			}
+			else {
+				stats.loadedFiles++;
+				++it;
+			}
+		}
+
+		return stats;
+	}
+
+}
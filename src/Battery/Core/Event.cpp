@@ -12,17 +12,17 @@ namespace Battery {
 
 	}
 
-	void Event::Load(enum class EventType type, ALLEGRO_EVENT* allegroEvent) {
+	void Event::Load(EventType type, ALLEGRO_EVENT* allegroEvent) {
 		eventType = type;
 		event = allegroEvent;
 		handled = false;
 
 		if (event == nullptr) {
-			LOG_CORE_WARN(__FUNCTION__"(): The supplied Allegro Event pointer is nullptr");
+			LOG_CORE_WARN("{}(): The supplied Allegro Event pointer is nullptr", __FUNCTION__);
 		}
 	}
 
-	enum class EventType Event::GetType() {
+	EventType Event::GetType() {
 		return eventType;
 	}
 
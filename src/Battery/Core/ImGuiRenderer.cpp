@@ -0,0 +1,152 @@
+
+#include "Battery/pch.h"
+#include "Battery/Core/ImGuiRenderer.h"
+#include "Battery/DefaultShaders.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	// ImGui packs its colors with IM_COL32(), R in the lowest byte like PixelConvert::PackColor()
+	static const ALLEGRO_VERTEX_ELEMENT IMGUI_VERTEX_ELEMENTS[] = {
+		{ ALLEGRO_PRIM_POSITION, ALLEGRO_PRIM_FLOAT_2, offsetof(ImDrawVert, pos) },
+		{ ALLEGRO_PRIM_TEX_COORD, ALLEGRO_PRIM_FLOAT_2, offsetof(ImDrawVert, uv) },
+		{ ALLEGRO_PRIM_USER_ATTR, ALLEGRO_PRIM_NORMALIZED_UBYTE_4, offsetof(ImDrawVert, col) },
+		{ 0, 0, 0 }
+	};
+
+	static_assert(sizeof(ImDrawIdx) == sizeof(uint16_t) || sizeof(ImDrawIdx) == sizeof(int),
+		"ImDrawIdx must be 16 or 32 bits");
+
+	ImGuiRenderer::ImGuiRenderer() {
+	}
+
+	ImGuiRenderer::~ImGuiRenderer() {
+		Destroy();
+	}
+
+	bool ImGuiRenderer::Create(ALLEGRO_DISPLAY* display) {
+
+		Destroy();
+
+		if (!shader.LoadSource(display, BATTERY_SHADER_SOURCE_VERTEX_SPRITE, BATTERY_SHADER_SOURCE_FRAGMENT_SPRITE)) {
+			LOG_CORE_WARN("{}(): Can't load the shader, ImGui is drawn by the Allegro backend", __FUNCTION__);
+			return false;
+		}
+
+		decl = al_create_vertex_decl(IMGUI_VERTEX_ELEMENTS, sizeof(ImDrawVert));
+		stream = std::make_unique<StreamBuffer>(decl, sizeof(ImDrawVert));
+		return true;
+	}
+
+	void ImGuiRenderer::Destroy() {
+		stream.reset();
+		if (decl != nullptr) {
+			al_destroy_vertex_decl(decl);
+			decl = nullptr;
+		}
+		shader.Unload();
+	}
+
+	void ImGuiRenderer::Render(ImDrawData* drawData) {
+
+		if (drawData == nullptr || drawData->DisplaySize.x <= 0.f || drawData->DisplaySize.y <= 0.f)
+			return;
+
+		if (stream == nullptr) {
+			ImGui_ImplAllegro5_RenderDrawData(drawData);
+			return;
+		}
+
+		stream->NextFrame();
+		stats = ImGuiRendererStats();
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_TRANSFORM | ALLEGRO_STATE_PROJECTION_TRANSFORM | ALLEGRO_STATE_BLENDER);
+		int clipX, clipY, clipWidth, clipHeight;
+		al_get_clipping_rectangle(&clipX, &clipY, &clipWidth, &clipHeight);
+
+		SetupRenderState(drawData);
+		ImVec2 offset = drawData->DisplayPos;
+
+		for (int n = 0; n < drawData->CmdListsCount; n++) {
+			const ImDrawList* list = drawData->CmdLists[n];
+			if (list->VtxBuffer.Size == 0 || list->IdxBuffer.Size == 0)
+				continue;
+
+			// The whole list in one go, the indices are rebased while being copied
+			const ImDrawIdx* indices = list->IdxBuffer.Data;
+			int firstIndex;
+			if constexpr (sizeof(ImDrawIdx) == sizeof(uint16_t)) {
+				firstIndex = stream->Write(list->VtxBuffer.Data, list->VtxBuffer.Size, (const uint16_t*)indices,
+					list->IdxBuffer.Size);
+			}
+			else {
+				firstIndex = stream->Write(list->VtxBuffer.Data, list->VtxBuffer.Size, (const int*)indices,
+					list->IdxBuffer.Size);
+			}
+			stats.vertices += list->VtxBuffer.Size;
+
+			for (const ImDrawCmd& command : list->CmdBuffer) {
+				if (command.UserCallback != nullptr) {
+					if (command.UserCallback == ImDrawCallback_ResetRenderState)
+						SetupRenderState(drawData);
+					else
+						command.UserCallback(list, &command);
+					continue;
+				}
+
+				// Within the clipping rectangle of the target, e.g. the dirty region of the frame
+				glm::vec2 min = glm::max(glm::vec2(command.ClipRect.x - offset.x, command.ClipRect.y - offset.y),
+					glm::vec2(clipX, clipY));
+				glm::vec2 max = glm::min(glm::vec2(command.ClipRect.z - offset.x, command.ClipRect.w - offset.y),
+					glm::vec2(clipX + clipWidth, clipY + clipHeight));
+				if (max.x <= min.x || max.y <= min.y || command.ElemCount == 0)
+					continue;
+				al_set_clipping_rectangle((int)min.x, (int)min.y, (int)(max.x - min.x), (int)(max.y - min.y));
+
+				ALLEGRO_BITMAP* texture = (ALLEGRO_BITMAP*)command.TextureId;
+				if (firstIndex >= 0) {
+					stream->Draw(texture, firstIndex + (int)command.IdxOffset, (int)command.ElemCount);
+				}
+				else {
+					// Without vertex buffers the vertices are still used as they are, only the indices are converted
+					fallbackIndices.assign(indices + command.IdxOffset, indices + command.IdxOffset + command.ElemCount);
+					al_draw_indexed_prim(list->VtxBuffer.Data, decl, texture, fallbackIndices.data(),
+						(int)command.ElemCount, ALLEGRO_PRIM_TRIANGLE_LIST);
+				}
+				stats.drawCalls++;
+			}
+		}
+
+		stats.streamedBytes = stream->GetFrameBytes();
+
+		shader.Release();
+		al_set_clipping_rectangle(clipX, clipY, clipWidth, clipHeight);
+		al_restore_state(&state);
+	}
+
+	ImGuiRendererStats ImGuiRenderer::GetStats() const {
+		return stats;
+	}
+
+	void ImGuiRenderer::SetupRenderState(ImDrawData* drawData) {
+
+		// Like the Allegro backend: straight alpha and an orthographic projection over the display
+		al_set_separate_blender(ALLEGRO_ADD, ALLEGRO_ALPHA, ALLEGRO_INVERSE_ALPHA, ALLEGRO_ADD, ALLEGRO_ONE,
+			ALLEGRO_INVERSE_ALPHA);
+
+		float left = drawData->DisplayPos.x;
+		float right = drawData->DisplayPos.x + drawData->DisplaySize.x;
+		float top = drawData->DisplayPos.y;
+		float bottom = drawData->DisplayPos.y + drawData->DisplaySize.y;
+
+		ALLEGRO_TRANSFORM transform;
+		al_identity_transform(&transform);
+		al_use_transform(&transform);
+		al_orthographic_transform(&transform, left, top, 1.f, right, bottom, -1.f);
+		al_use_projection_transform(&transform);
+
+		shader.Use();
+	}
+
+}
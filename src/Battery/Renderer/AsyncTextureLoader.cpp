@@ -0,0 +1,267 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/AsyncTextureLoader.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Battery/Log/Log.h"
+
+#define CHECK_INIT() \
+	if (data == nullptr) { \
+		throw Battery::Exception(std::string(__FUNCTION__) + "(): The asynchronous texture loader is not initialized!"); \
+	}
+
+namespace Battery {
+
+	struct AsyncTextureRequest {
+		std::string path;
+		int flags = 0;
+		std::atomic<TextureLoadState> state = TextureLoadState::QUEUED;
+		ALLEGRO_BITMAP* decoded = nullptr;				// Memory bitmap, only valid while DECODED
+		std::shared_ptr<const Texture2D> texture;		// Only accessed on the main thread
+	};
+
+	struct AsyncTextureLoaderData {
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::shared_ptr<AsyncTextureRequest>> decodeQueue;
+		std::deque<std::shared_ptr<AsyncTextureRequest>> uploadQueue;
+		std::vector<std::thread> workers;
+		bool stopping = false;
+		double uploadBudget = BATTERY_TEXTURE_UPLOAD_BUDGET;
+		std::unique_ptr<Texture2D> placeholder;
+		AsyncTextureLoaderStats stats;
+	};
+
+	static AsyncTextureLoaderData* data = nullptr;
+
+
+
+
+
+	TextureHandle::TextureHandle() {
+	}
+
+	TextureHandle::TextureHandle(std::shared_ptr<AsyncTextureRequest> request) : request(std::move(request)) {
+	}
+
+	bool TextureHandle::IsValid() const {
+		return request != nullptr;
+	}
+
+	bool TextureHandle::IsResident() const {
+		return request != nullptr && request->state == TextureLoadState::RESIDENT;
+	}
+
+	bool TextureHandle::HasFailed() const {
+		return request != nullptr && request->state == TextureLoadState::FAILED;
+	}
+
+	TextureLoadState TextureHandle::GetState() const {
+		if (request == nullptr)
+			return TextureLoadState::FAILED;
+		return request->state;
+	}
+
+	const Texture2D& TextureHandle::Get() const {
+		if (IsResident())
+			return *request->texture;
+
+		CHECK_INIT();
+		return *data->placeholder;
+	}
+
+	std::shared_ptr<const Texture2D> TextureHandle::GetTexture() const {
+		if (!IsResident())
+			return nullptr;
+		return request->texture;
+	}
+
+
+
+
+
+	static void WorkerThread() {
+
+		while (true) {
+			std::shared_ptr<AsyncTextureRequest> request;
+			{
+				std::unique_lock<std::mutex> lock(data->mutex);
+				data->condition.wait(lock, [] { return data->stopping || !data->decodeQueue.empty(); });
+				if (data->stopping)
+					return;
+
+				request = std::move(data->decodeQueue.front());
+				data->decodeQueue.pop_front();
+			}
+
+			// All handles were dropped, nobody is waiting for this texture anymore
+			if (request.use_count() == 1)
+				continue;
+
+			// Only decode here, the memory bitmap is uploaded by the main thread. The bitmap flags are thread local
+			// in Allegro, al_load_bitmap_flags() only takes loader flags like ALLEGRO_NO_PREMULTIPLIED_ALPHA
+			al_set_new_bitmap_flags((request->flags & ~ALLEGRO_VIDEO_BITMAP) | ALLEGRO_MEMORY_BITMAP);
+			ALLEGRO_BITMAP* bitmap = al_load_bitmap_flags(request->path.c_str(), request->flags & ALLEGRO_NO_PREMULTIPLIED_ALPHA);
+
+			std::lock_guard<std::mutex> lock(data->mutex);
+			if (bitmap == nullptr) {
+				LOG_CORE_ERROR("{}(): Failed to load texture asynchronously: '{}'", __FUNCTION__, request->path);
+				request->state = TextureLoadState::FAILED;
+				data->stats.totalFailed++;
+				continue;
+			}
+
+			request->decoded = bitmap;
+			request->state = TextureLoadState::DECODED;
+			data->uploadQueue.push_back(std::move(request));
+		}
+	}
+
+	void AsyncTextureLoader::Setup(size_t threadCount) {
+
+		if (data != nullptr) {
+			LOG_CORE_CRITICAL("{}(): Can't setup asynchronous texture loader, it is already initialized!", __FUNCTION__);
+			return;
+		}
+
+		if (threadCount == 0) {
+			size_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		data = new AsyncTextureLoaderData();
+
+		// Fully transparent, so nothing pops up while loading
+		data->placeholder = std::make_unique<Texture2D>(1, 1);
+		ALLEGRO_BITMAP* target = al_get_target_bitmap();
+		al_set_target_bitmap(data->placeholder->GetAllegroBitmap());
+		al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+		al_set_target_bitmap(target);
+
+		for (size_t i = 0; i < threadCount; i++) {
+			data->workers.emplace_back(WorkerThread);
+		}
+
+		LOG_CORE_TRACE("Asynchronous texture loader started with {} worker threads", threadCount);
+	}
+
+	void AsyncTextureLoader::Shutdown() {
+
+		if (data == nullptr) {
+			LOG_CORE_CRITICAL("{}(): Can't shut down asynchronous texture loader, it is not initialized!", __FUNCTION__);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+			data->stopping = true;
+		}
+		data->condition.notify_all();
+
+		for (std::thread& worker : data->workers) {
+			worker.join();
+		}
+
+		// Cancel everything which did not make it to the GPU
+		for (auto& request : data->decodeQueue) {
+			request->state = TextureLoadState::FAILED;
+		}
+		for (auto& request : data->uploadQueue) {
+			al_destroy_bitmap(request->decoded);
+			request->decoded = nullptr;
+			request->state = TextureLoadState::FAILED;
+		}
+
+		delete data;
+		data = nullptr;
+	}
+
+	bool AsyncTextureLoader::IsInitialized() {
+		return data != nullptr;
+	}
+
+	TextureHandle AsyncTextureLoader::Load(const std::string& path, int flags) {
+		CHECK_INIT();
+
+		auto request = std::make_shared<AsyncTextureRequest>();
+		request->path = path;
+		request->flags = flags;
+
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+			data->decodeQueue.push_back(request);
+		}
+		data->condition.notify_one();
+
+		return TextureHandle(std::move(request));
+	}
+
+	void AsyncTextureLoader::Update() {
+		CHECK_INIT();
+		PROFILE_CORE_SCOPE("AsyncTextureLoader::Update() uploading textures");
+
+		double start = TimeUtils::GetRuntime();
+		size_t uploaded = 0;
+		size_t failed = 0;
+
+		while (true) {
+			std::shared_ptr<AsyncTextureRequest> request;
+			{
+				std::lock_guard<std::mutex> lock(data->mutex);
+				if (data->uploadQueue.empty())
+					break;
+				if (uploaded > 0 && TimeUtils::GetRuntime() - start >= data->uploadBudget)
+					break;
+
+				request = std::move(data->uploadQueue.front());
+				data->uploadQueue.pop_front();
+			}
+
+			// Dropped while waiting for the upload
+			if (request.use_count() == 1) {
+				al_destroy_bitmap(request->decoded);
+				continue;
+			}
+
+			auto texture = std::make_shared<Texture2D>();
+			bool success = texture->Load(request->decoded, request->flags);
+			al_destroy_bitmap(request->decoded);
+			request->decoded = nullptr;
+
+			if (success) {
+				request->texture = std::move(texture);
+				request->state = TextureLoadState::RESIDENT;
+			}
+			else {
+				LOG_CORE_ERROR("{}(): Failed to upload texture: '{}'", __FUNCTION__, request->path);
+				request->state = TextureLoadState::FAILED;
+				failed++;
+			}
+			uploaded++;
+		}
+
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stats.uploadedLastFrame = uploaded - failed;
+		data->stats.uploadTimeLastFrame = TimeUtils::GetRuntime() - start;
+		data->stats.totalUploaded += uploaded - failed;
+		data->stats.totalFailed += failed;
+	}
+
+	void AsyncTextureLoader::SetUploadBudget(double seconds) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->uploadBudget = seconds;
+	}
+
+	AsyncTextureLoaderStats AsyncTextureLoader::GetStats() {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		AsyncTextureLoaderStats stats = data->stats;
+		stats.queued = data->decodeQueue.size();
+		stats.decoded = data->uploadQueue.size();
+		return stats;
+	}
+
+}
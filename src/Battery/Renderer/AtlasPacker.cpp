@@ -0,0 +1,136 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/AtlasPacker.h"
+
+namespace Battery {
+
+	AtlasPacker::AtlasPacker(int width, int height, int padding) : width(width), height(height), padding(padding) {
+		Clear();
+	}
+
+	std::optional<AtlasRect> AtlasPacker::Insert(int width, int height) {
+
+		if (width <= 0 || height <= 0)
+			return std::nullopt;
+
+		int paddedWidth = width + 2 * padding;
+		int paddedHeight = height + 2 * padding;
+
+		// Choose the position with the lowest resulting top edge, ties go to the narrowest node
+		size_t bestIndex = skyline.size();
+		int bestY = 0;
+		int bestTop = std::numeric_limits<int>::max();
+		int bestWidth = std::numeric_limits<int>::max();
+
+		for (size_t i = 0; i < skyline.size(); i++) {
+			int y;
+			if (!Fits(i, paddedWidth, paddedHeight, y))
+				continue;
+
+			int top = y + paddedHeight;
+			if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth)) {
+				bestIndex = i;
+				bestY = y;
+				bestTop = top;
+				bestWidth = skyline[i].width;
+			}
+		}
+
+		if (bestIndex == skyline.size())
+			return std::nullopt;
+
+		int x = skyline[bestIndex].x;
+		AddLevel(bestIndex, x, bestY, paddedWidth, paddedHeight);
+
+		rectCount++;
+		usedArea += (uint64_t)paddedWidth * paddedHeight;
+
+		AtlasRect rect;
+		rect.x = x + padding;
+		rect.y = bestY + padding;
+		rect.width = width;
+		rect.height = height;
+		return rect;
+	}
+
+	void AtlasPacker::Clear() {
+		skyline.clear();
+		skyline.push_back({ 0, 0, width });
+		rectCount = 0;
+		usedArea = 0;
+	}
+
+	int AtlasPacker::GetWidth() const {
+		return width;
+	}
+
+	int AtlasPacker::GetHeight() const {
+		return height;
+	}
+
+	int AtlasPacker::GetPadding() const {
+		return padding;
+	}
+
+	size_t AtlasPacker::GetRectCount() const {
+		return rectCount;
+	}
+
+	float AtlasPacker::GetOccupancy() const {
+		if (width <= 0 || height <= 0)
+			return 0.f;
+		return (float)((double)usedArea / ((double)width * height));
+	}
+
+	// Places the rectangle at the left edge of the node, resting on the highest node it spans
+	bool AtlasPacker::Fits(size_t index, int width, int height, int& y) const {
+
+		if (skyline[index].x + width > this->width)
+			return false;
+
+		y = skyline[index].y;
+		int remaining = width;
+
+		// The skyline always covers the full width, so this can't run past the last node
+		for (size_t i = index; remaining > 0; i++) {
+			y = std::max(y, skyline[i].y);
+			if (y + height > this->height)
+				return false;
+			remaining -= skyline[i].width;
+		}
+
+		return true;
+	}
+
+	void AtlasPacker::AddLevel(size_t index, int x, int y, int width, int height) {
+
+		skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+		// Cut away what the new node covers from the following nodes
+		for (size_t i = index + 1; i < skyline.size();) {
+			int overlap = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+			if (overlap <= 0)
+				break;
+
+			skyline[i].x += overlap;
+			skyline[i].width -= overlap;
+
+			if (skyline[i].width > 0)
+				break;
+
+			skyline.erase(skyline.begin() + i);
+		}
+
+		// Merge neighbours on the same level
+		for (size_t i = 0; i + 1 < skyline.size();) {
+			if (skyline[i].y == skyline[i + 1].y) {
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+}
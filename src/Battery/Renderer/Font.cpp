@@ -0,0 +1,249 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Font.h"
+#include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	Font::Font() : atlas(BATTERY_FONT_ATLAS_PAGE_SIZE, BATTERY_TEXTURE_ATLAS_PADDING, BATTERY_FONT_ATLAS_MAX_PAGES,
+			ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR) {
+	}
+
+	Font::Font(const std::string& path) : Font() {
+		Load(path);
+	}
+
+	Font::~Font() {
+		Unload();
+	}
+
+	bool Font::Load(const std::string& path) {
+
+		Unload();
+		this->path = path;
+
+		// Fail now instead of on first use
+		if (GetFace(BATTERY_DEFAULT_FONT_SIZE) == nullptr) {
+			Unload();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Font::Unload() {
+		for (auto& [pixelSize, face] : faces) {
+			al_destroy_font(face.font);
+		}
+		faces.clear();
+		atlas.Clear();
+		path.clear();
+		runCount = 0;
+	}
+
+	bool Font::IsLoaded() const {
+		return !faces.empty();
+	}
+
+	const TextRun& Font::Shape(const std::string& text, int pixelSize) {
+
+		Face* face = GetFace(std::max(pixelSize, 1));
+		if (face == nullptr)
+			return emptyRun;
+
+		auto it = face->runs.find(text);
+		if (it != face->runs.end() && IsValid(it->second)) {
+			it->second.lastUse = ++useCounter;
+			it->second.evictedCount = atlas.GetEvictedCount();
+			return it->second;
+		}
+
+		if (it == face->runs.end()) {
+			if (runCount >= BATTERY_FONT_MAX_CACHED_RUNS)
+				TrimRuns();
+			it = face->runs.emplace(text, TextRun()).first;
+			runCount++;
+		}
+
+		TextRun& run = it->second;
+		run.glyphs.clear();
+		run.size = { 0, 0 };
+		run.lastUse = ++useCounter;
+		run.evictedCount = atlas.GetEvictedCount();
+		run.boundsMin = glm::vec2(INFINITY);
+		run.boundsMax = glm::vec2(-INFINITY);
+
+		// The advance between two glyphs includes their kerning
+		float lineHeight = (float)al_get_font_line_height(face->font);
+		glm::vec2 pen = { 0, 0 };
+		int32_t previous = ALLEGRO_NO_KERNING;
+
+		auto endLine = [&]() {
+			if (previous != ALLEGRO_NO_KERNING)
+				pen.x += al_get_glyph_advance(face->font, previous, ALLEGRO_NO_KERNING);
+			run.size.x = std::max(run.size.x, pen.x);
+			previous = ALLEGRO_NO_KERNING;
+		};
+
+		ALLEGRO_USTR_INFO info;
+		const ALLEGRO_USTR* string = al_ref_buffer(&info, text.data(), text.size());
+		int position = 0;
+
+		while (true) {
+			int32_t codepoint = al_ustr_get_next(string, &position);
+			if (codepoint == -1)
+				break;
+			if (codepoint < 0)					// Invalid UTF-8
+				codepoint = 0xFFFD;
+
+			if (codepoint == '\n') {
+				endLine();
+				pen = { 0, pen.y + lineHeight };
+				continue;
+			}
+
+			if (previous != ALLEGRO_NO_KERNING)
+				pen.x += al_get_glyph_advance(face->font, previous, codepoint);
+			previous = codepoint;
+
+			const Glyph& glyph = GetGlyph(*face, pixelSize, codepoint);
+			if (glyph.empty)
+				continue;
+
+			glm::vec2 point1 = pen + glyph.offset;
+			glm::vec2 point2 = point1 + glm::vec2(glyph.region.rect.width, glyph.region.rect.height);
+			run.glyphs.push_back({ point1, point2, glyph.region });
+			run.boundsMin = glm::min(run.boundsMin, point1);
+			run.boundsMax = glm::max(run.boundsMax, point2);
+		}
+
+		endLine();
+		run.size.y = pen.y + lineHeight;
+		if (run.glyphs.empty()) {
+			run.boundsMin = { 0, 0 };
+			run.boundsMax = { 0, 0 };
+		}
+
+		return run;
+	}
+
+	glm::vec2 Font::Measure(const std::string& text, float size) {
+		int pixelSize = std::max((int)std::round(size), 1);
+		return Shape(text, pixelSize).size * (size / pixelSize);
+	}
+
+	const TextureAtlas& Font::GetAtlas() const {
+		return atlas;
+	}
+
+	size_t Font::GetCachedRuns() const {
+		return runCount;
+	}
+
+	uint64_t Font::GetRasterizedGlyphs() const {
+		return rasterizedGlyphs;
+	}
+
+	Font::Face* Font::GetFace(int pixelSize) {
+
+		auto it = faces.find(pixelSize);
+		if (it != faces.end())
+			return &it->second;
+
+		if (path.empty())
+			return nullptr;
+
+		// Straight alpha like the other textures of the engine, Allegro premultiplies glyphs by default
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+		al_set_new_bitmap_flags(al_get_new_bitmap_flags() | ALLEGRO_NO_PREMULTIPLIED_ALPHA);
+		ALLEGRO_FONT* font = al_load_ttf_font(path.c_str(), pixelSize, 0);
+		al_restore_state(&state);
+
+		if (font == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't load font '{}' at size {}", __FUNCTION__, path, pixelSize);
+			return nullptr;
+		}
+
+		Face& face = faces[pixelSize];
+		face.font = font;
+		return &face;
+	}
+
+	const Font::Glyph& Font::GetGlyph(Face& face, int pixelSize, int32_t codepoint) {
+
+		Glyph& glyph = face.glyphs[codepoint];
+		if (glyph.empty || atlas.IsValid(glyph.region))
+			return glyph;
+
+		ALLEGRO_GLYPH source;
+		if (!al_get_glyph(face.font, ALLEGRO_NO_KERNING, codepoint, &source) || source.bitmap == nullptr ||
+				source.w <= 0 || source.h <= 0) {
+			glyph.empty = true;
+			return glyph;
+		}
+
+		// Queued sprites still use the current content of the pages
+		for (size_t page = 0; page < atlas.GetPageCount(); page++) {
+			Renderer2D::PrepareTextureUpdate(atlas.GetPageBitmap(page));
+		}
+
+		ALLEGRO_BITMAP* pixels = al_create_sub_bitmap(source.bitmap, source.x, source.y, source.w, source.h);
+		auto region = atlas.Add(std::to_string(pixelSize) + ":" + std::to_string(codepoint), pixels);
+		al_destroy_bitmap(pixels);
+
+		if (!region) {
+			LOG_CORE_WARN("{}(): Glyph {} of size {} does not fit into the font atlas", __FUNCTION__, codepoint, pixelSize);
+			glyph.empty = true;
+			return glyph;
+		}
+
+		glyph.region = *region;
+		glyph.offset = { source.offset_x, source.offset_y };
+		rasterizedGlyphs++;
+		return glyph;
+	}
+
+	bool Font::IsValid(const TextRun& run) const {
+
+		if (run.evictedCount == atlas.GetEvictedCount())
+			return true;
+
+		for (const GlyphQuad& glyph : run.glyphs) {
+			if (!atlas.IsValid(glyph.region))
+				return false;
+		}
+		return true;
+	}
+
+	void Font::TrimRuns() {
+
+		// Keep the more recently used half
+		std::vector<uint64_t> uses;
+		uses.reserve(runCount);
+		for (auto& [pixelSize, face] : faces) {
+			for (auto& [text, run] : face.runs) {
+				uses.push_back(run.lastUse);
+			}
+		}
+
+		auto median = uses.begin() + uses.size() / 2;
+		std::nth_element(uses.begin(), median, uses.end());
+		uint64_t oldest = median != uses.end() ? *median : 0;
+
+		runCount = 0;
+		for (auto& [pixelSize, face] : faces) {
+			for (auto it = face.runs.begin(); it != face.runs.end();) {
+				if (it->second.lastUse < oldest) {
+					it = face.runs.erase(it);
+				}
+				else {
+					it++;
+					runCount++;
+				}
+			}
+		}
+	}
+
+}
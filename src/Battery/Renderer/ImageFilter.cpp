@@ -0,0 +1,235 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/ImageFilter.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BATTERY_IMAGEFILTER_SSE2
+#endif
+
+namespace Battery {
+	namespace ImageFilter {
+
+		static void ForEachRow(size_t rows, ThreadPool* pool, const std::function<void(size_t begin, size_t end)>& function) {
+			if (pool != nullptr)
+				pool->ParallelFor(rows, function);
+			else
+				function(0, rows);
+		}
+
+		// Averages two source rows into one destination row of half the width
+		static void DownsampleRow(const uint8_t* row0, const uint8_t* row1, uint8_t* destination, size_t width) {
+
+			size_t x = 0;
+
+#ifdef BATTERY_IMAGEFILTER_SSE2
+			// 4 source pixels of both rows into 2 destination pixels, in 16-bit precision
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+			for (; x + 2 <= width; x += 2) {
+				__m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+				__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+				__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+				// Add neighbouring pixels, the sums end up in the lower halves
+				left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+				right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), rounding);
+				__m128i result = _mm_packus_epi16(_mm_srli_epi16(sum, 2), zero);
+				_mm_storel_epi64((__m128i*)(destination + x * 4), result);
+			}
+#endif
+
+			for (; x < width; x++) {
+				const uint8_t* a = row0 + x * 8;
+				const uint8_t* b = row1 + x * 8;
+				for (size_t c = 0; c < 4; c++) {
+					destination[x * 4 + c] = (uint8_t)((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+				}
+			}
+		}
+
+		void Downsample2x(const uint8_t* source, ptrdiff_t sourcePitch, size_t width, size_t height,
+			uint8_t* destination, ptrdiff_t destinationPitch, ThreadPool* pool) {
+
+			size_t destinationWidth = std::max<size_t>(width / 2, 1);
+			size_t destinationHeight = std::max<size_t>(height / 2, 1);
+
+			// A source of width or height 1 is averaged with itself in that direction
+			ptrdiff_t rowStep = height > 1 ? sourcePitch : 0;
+
+			if (width == 1) {
+				for (size_t y = 0; y < destinationHeight; y++) {
+					const uint8_t* row0 = source + (ptrdiff_t)(y * 2) * sourcePitch;
+					const uint8_t* row1 = row0 + rowStep;
+					for (size_t c = 0; c < 4; c++) {
+						destination[(ptrdiff_t)y * destinationPitch + c] = (uint8_t)((row0[c] + row1[c] + 1) >> 1);
+					}
+				}
+				return;
+			}
+
+			ForEachRow(destinationHeight, pool, [&](size_t begin, size_t end) {
+				for (size_t y = begin; y < end; y++) {
+					const uint8_t* row0 = source + (ptrdiff_t)(y * 2) * sourcePitch;
+					DownsampleRow(row0, row0 + rowStep, destination + (ptrdiff_t)y * destinationPitch, destinationWidth);
+				}
+			});
+		}
+
+
+
+
+
+		static float Sinc(float x) {
+			if (x == 0.f)
+				return 1.f;
+			x *= (float)M_PI;
+			return std::sin(x) / x;
+		}
+
+		static float GetRadius(ResizeFilter filter) {
+			return filter == ResizeFilter::LANCZOS3 ? 3.f : 0.5f;
+		}
+
+		static float Kernel(ResizeFilter filter, float x) {
+			x = std::abs(x);
+			if (filter == ResizeFilter::LANCZOS3)
+				return x < 3.f ? Sinc(x) * Sinc(x / 3.f) : 0.f;
+			return x <= 0.5f ? 1.f : 0.f;
+		}
+
+		// The source pixels and normalized weights contributing to each destination pixel along one axis
+		struct Contributions {
+			size_t taps = 0;				// Per destination pixel, unused taps have a weight of 0
+			std::vector<int> indices;
+			std::vector<float> weights;
+		};
+
+		static Contributions ComputeContributions(size_t sourceSize, size_t destinationSize, ResizeFilter filter) {
+
+			float scale = (float)sourceSize / destinationSize;
+			float stretch = std::max(scale, 1.f);			// Widen the filter when downscaling
+			float support = GetRadius(filter) * stretch;
+
+			Contributions result;
+			result.taps = (size_t)std::ceil(support * 2) + 1;
+			result.indices.resize(destinationSize * result.taps, 0);
+			result.weights.resize(destinationSize * result.taps, 0.f);
+
+			for (size_t i = 0; i < destinationSize; i++) {
+				float center = (i + 0.5f) * scale;
+				int first = (int)std::floor(center - support);
+
+				int* indices = &result.indices[i * result.taps];
+				float* weights = &result.weights[i * result.taps];
+				float sum = 0.f;
+
+				for (size_t t = 0; t < result.taps; t++) {
+					int index = first + (int)t;
+					float weight = Kernel(filter, (index + 0.5f - center) / stretch);
+					indices[t] = std::clamp(index, 0, (int)sourceSize - 1);
+					weights[t] = weight;
+					sum += weight;
+				}
+
+				if (sum != 0.f) {
+					for (size_t t = 0; t < result.taps; t++) {
+						weights[t] /= sum;
+					}
+				}
+			}
+
+			return result;
+		}
+
+		void Resize(const uint8_t* source, ptrdiff_t sourcePitch, size_t sourceWidth, size_t sourceHeight,
+			uint8_t* destination, ptrdiff_t destinationPitch, size_t destinationWidth, size_t destinationHeight,
+			ResizeFilter filter, ThreadPool* pool) {
+
+			if (sourceWidth == 0 || sourceHeight == 0 || destinationWidth == 0 || destinationHeight == 0)
+				return;
+
+			Contributions horizontal = ComputeContributions(sourceWidth, destinationWidth, filter);
+			Contributions vertical = ComputeContributions(sourceHeight, destinationHeight, filter);
+
+			// First pass: Every source row is resized horizontally into a float buffer
+			std::vector<float> temp(sourceHeight * destinationWidth * 4);
+			ForEachRow(sourceHeight, pool, [&](size_t begin, size_t end) {
+				for (size_t y = begin; y < end; y++) {
+					const uint8_t* row = source + (ptrdiff_t)y * sourcePitch;
+					float* out = &temp[y * destinationWidth * 4];
+
+					for (size_t x = 0; x < destinationWidth; x++) {
+						const int* indices = &horizontal.indices[x * horizontal.taps];
+						const float* weights = &horizontal.weights[x * horizontal.taps];
+
+#ifdef BATTERY_IMAGEFILTER_SSE2
+						// All 4 channels of a pixel at once
+						const __m128i zero = _mm_setzero_si128();
+						__m128 pixel = _mm_setzero_ps();
+						for (size_t t = 0; t < horizontal.taps; t++) {
+							int32_t value;
+							memcpy(&value, row + indices[t] * 4, 4);
+							__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+							pixel = _mm_add_ps(pixel, _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(weights[t])));
+						}
+						_mm_storeu_ps(out + x * 4, pixel);
+#else
+						float pixel[4] = { 0.f, 0.f, 0.f, 0.f };
+						for (size_t t = 0; t < horizontal.taps; t++) {
+							const uint8_t* p = row + indices[t] * 4;
+							for (size_t c = 0; c < 4; c++) {
+								pixel[c] += p[c] * weights[t];
+							}
+						}
+
+						for (size_t c = 0; c < 4; c++) {
+							out[x * 4 + c] = pixel[c];
+						}
+#endif
+					}
+				}
+			});
+
+			// Second pass: Vertically from the float buffer into the destination
+			ForEachRow(destinationHeight, pool, [&](size_t begin, size_t end) {
+				std::vector<float> accumulator(destinationWidth * 4);
+
+				for (size_t y = begin; y < end; y++) {
+					const int* indices = &vertical.indices[y * vertical.taps];
+					const float* weights = &vertical.weights[y * vertical.taps];
+					std::fill(accumulator.begin(), accumulator.end(), 0.f);
+
+					for (size_t t = 0; t < vertical.taps; t++) {
+						const float* row = &temp[indices[t] * destinationWidth * 4];
+						float weight = weights[t];
+						if (weight == 0.f)
+							continue;
+
+						size_t i = 0;
+#ifdef BATTERY_IMAGEFILTER_SSE2
+						__m128 factor = _mm_set1_ps(weight);
+						for (; i + 4 <= accumulator.size(); i += 4) {
+							__m128 sum = _mm_add_ps(_mm_loadu_ps(&accumulator[i]), _mm_mul_ps(_mm_loadu_ps(row + i), factor));
+							_mm_storeu_ps(&accumulator[i], sum);
+						}
+#endif
+						for (; i < accumulator.size(); i++) {
+							accumulator[i] += row[i] * weight;
+						}
+					}
+
+					uint8_t* out = destination + (ptrdiff_t)y * destinationPitch;
+					for (size_t i = 0; i < accumulator.size(); i++) {
+						out[i] = (uint8_t)std::clamp(accumulator[i] + 0.5f, 0.f, 255.f);
+					}
+				}
+			});
+		}
+
+	}
+}
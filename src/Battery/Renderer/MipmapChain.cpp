@@ -0,0 +1,110 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/MipmapChain.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	MipmapChain::MipmapChain() {
+	}
+
+	bool MipmapChain::Build(const SharedTexture& source, ImageFilter::ResizeFilter filter, int minSize) {
+		PROFILE_CORE_SCOPE("MipmapChain::Build()");
+
+		Clear();
+		if (!source.IsValid()) {
+			LOG_CORE_ERROR("{}(): Can't build mipmaps: The source texture is not valid!", __FUNCTION__);
+			return false;
+		}
+
+		auto image = source->GetClipImage();
+		if (!image) {
+			LOG_CORE_ERROR("{}(): Can't build mipmaps: The source pixels could not be read!", __FUNCTION__);
+			return false;
+		}
+
+		levels.push_back(source);
+
+		int flags = source->GetFlags();
+		size_t width = image->second.width;
+		size_t height = image->second.height;
+		size_t limit = (size_t)std::max(minSize, 1);
+		std::vector<uint32_t> current = std::move(image->first);
+		std::vector<uint32_t> next;
+
+		while ((width > limit || height > limit) && (width > 1 || height > 1)) {
+			size_t nextWidth = std::max<size_t>(width / 2, 1);
+			size_t nextHeight = std::max<size_t>(height / 2, 1);
+			next.resize(nextWidth * nextHeight);
+
+			const uint8_t* pixels = (const uint8_t*)current.data();
+			if (filter == ImageFilter::ResizeFilter::BOX) {
+				ImageFilter::Downsample2x(pixels, width * 4, width, height, (uint8_t*)next.data(), nextWidth * 4,
+					&ThreadPool::GetShared());
+			}
+			else {
+				ImageFilter::Resize(pixels, width * 4, width, height, (uint8_t*)next.data(), nextWidth * 4,
+					nextWidth, nextHeight, filter, &ThreadPool::GetShared());
+			}
+
+			Texture2D level;
+			if (!level.LoadPixels(next.data(), nextWidth * 4, PixelConvert::PixelLayout::RGBA8,
+					(int)nextWidth, (int)nextHeight, flags)) {
+				LOG_CORE_ERROR("{}(): Can't build mipmaps: Level {} could not be created!", __FUNCTION__, levels.size());
+				Clear();
+				return false;
+			}
+			levels.emplace_back(std::move(level));
+
+			std::swap(current, next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+
+		return true;
+	}
+
+	bool MipmapChain::Load(const std::string& path, ImageFilter::ResizeFilter filter, int minSize, int flags) {
+		SharedTexture source;
+		if (!source.Load(path, flags)) {
+			Clear();
+			return false;
+		}
+		return Build(source, filter, minSize);
+	}
+
+	void MipmapChain::Clear() {
+		levels.clear();
+	}
+
+	size_t MipmapChain::SelectLevel(const glm::vec2& size) const {
+
+		// Both axes must still be covered, so the image never gets blurrier than necessary. The actual
+		// level sizes are compared, halving odd sizes drops a pixel and makes a level smaller than 1/2^n
+		float width = std::max(std::abs(size.x), 1.f);
+		float height = std::max(std::abs(size.y), 1.f);
+
+		size_t level = 0;
+		while (level + 1 < levels.size() && levels[level + 1].GetWidth() >= width && levels[level + 1].GetHeight() >= height) {
+			level++;
+		}
+		return level;
+	}
+
+	const SharedTexture& MipmapChain::GetLevel(size_t level) const {
+		if (level >= levels.size())
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): Mipmap level " + std::to_string(level) + " does not exist!");
+		return levels[level];
+	}
+
+	size_t MipmapChain::GetLevelCount() const {
+		return levels.size();
+	}
+
+	bool MipmapChain::IsValid() const {
+		return !levels.empty();
+	}
+
+}
@@ -0,0 +1,290 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/PathTessellator.h"
+#include "Battery/Utils/ThreadPool.h"
+
+namespace Battery {
+
+	// Colors are in the range 0-255 like everywhere in Renderer2D, alpha is scaled by the coverage
+	static ALLEGRO_COLOR MakeColor(const glm::vec4& color, float coverage) {
+		glm::vec4 c = glm::clamp(color, 0.f, 255.f) / 255.f;
+		return { c.r, c.g, c.b, c.a * coverage };
+	}
+
+	static glm::vec2 GetNormal(const glm::vec2& direction) {
+		return { -direction.y, direction.x };
+	}
+
+	static glm::vec2 Rotate(const glm::vec2& vector, float angle) {
+		float c = std::cos(angle);
+		float s = std::sin(angle);
+		return { vector.x * c - vector.y * s, vector.x * s + vector.y * c };
+	}
+
+	// Every pair of consecutive cross sections is connected by 3 quads: outer fringe, core and outer fringe
+	static void WriteConnection(int* output, int a, int b) {
+		for (int k = 0; k < 3; k++) {
+			int quad[6] = { a + k, a + k + 1, b + k + 1, a + k, b + k + 1, b + k };
+			std::copy(quad, quad + 6, output + k * 6);
+		}
+	}
+
+	// Small polylines are not worth waking up the workers
+	static void Run(size_t points, size_t count, const std::function<void(size_t begin, size_t end)>& function) {
+		if (points >= BATTERY_PARALLEL_TESSELLATION_POINTS)
+			ThreadPool::GetShared().ParallelFor(count, function);
+		else
+			function(0, count);
+	}
+
+
+
+
+
+	PathTessellator::PathTessellator() {
+	}
+
+	void PathTessellator::Tessellate(const glm::vec2* input, size_t count, bool closed, const StrokeStyle& style,
+			const glm::vec4& color, std::vector<ALLEGRO_VERTEX>& vertices, std::vector<int>& indices) {
+
+		// Repeated points have no direction
+		points.clear();
+		points.reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			if (points.empty() || input[i] != points.back())
+				points.push_back(input[i]);
+		}
+		if (closed && points.size() > 1 && points.front() == points.back())
+			points.pop_back();
+
+		this->closed = closed && points.size() >= 3;
+		this->style = style;
+		size_t n = points.size();
+
+		if (n < 2 || style.thickness <= 0.f)
+			return;
+
+		float falloff = std::max(style.falloff, 0.f);
+		radius = style.thickness / 2.f;
+		coreRadius = std::max(radius - falloff, 0.f);
+		coreColor = MakeColor(color, falloff > 0.f ? std::min(radius / falloff, 1.f) : 1.f);
+		edgeColor = MakeColor(color, coreRadius < radius ? 0.f : 1.f);
+
+		// Round joins and caps deviate from the circle by at most a quarter pixel
+		roundStep = radius > 0.25f ? 2.f * std::acos(1.f - 0.25f / radius) : (float)M_PI / 2.f;
+		roundStep = std::clamp(roundStep, 0.05f, (float)M_PI / 2.f);
+
+		// Plain loops over the segments and points, which don't depend on each other
+		size_t segments = this->closed ? n : n - 1;
+		directions.resize(n);
+		lengths.resize(n);
+		Run(n, segments, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				glm::vec2 delta = points[(i + 1) % n] - points[i];
+				lengths[i] = glm::length(delta);
+				directions[i] = delta / lengths[i];
+			}
+		});
+
+		offsets.resize(n + 1);
+		offsets[0] = 0;
+		Run(n, n, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				offsets[i + 1] = CountCrossSections(i);
+			}
+		});
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		sections.resize(offsets[n]);
+		Run(n, n, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				WriteCrossSections(i, &sections[offsets[i]]);
+			}
+		});
+
+		// Every cross section becomes 4 vertices: outer and core on the plus side, then core and outer on the minus side
+		size_t firstVertex = vertices.size();
+		size_t firstIndex = indices.size();
+		size_t connections = this->closed ? sections.size() : sections.size() - 1;
+		vertices.resize(firstVertex + sections.size() * 4);
+		indices.resize(firstIndex + connections * 18);
+
+		Run(n, sections.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const CrossSection& section = sections[i];
+				glm::vec2 positions[4] = {
+					section.point + section.plus * radius, section.point + section.plus * coreRadius,
+					section.point + section.minus * coreRadius, section.point + section.minus * radius
+				};
+
+				ALLEGRO_VERTEX* output = &vertices[firstVertex + i * 4];
+				for (int k = 0; k < 4; k++) {
+					output[k] = { positions[k].x, positions[k].y, 0, 0, 0, (k == 0 || k == 3) ? edgeColor : coreColor };
+				}
+			}
+		});
+
+		Run(n, connections, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				int a = (int)(firstVertex + i * 4);
+				int b = (int)(firstVertex + ((i + 1) % sections.size()) * 4);
+				WriteConnection(&indices[firstIndex + i * 18], a, b);
+			}
+		});
+
+		if (!this->closed) {
+			glm::vec2 first = directions[0];
+			glm::vec2 last = directions[n - 2];
+			AddCap(points[0], GetNormal(first), -first, vertices, indices);
+			AddCap(points[n - 1], GetNormal(last), last, vertices, indices);
+		}
+	}
+
+	size_t PathTessellator::CountCrossSections(size_t i) const {
+
+		size_t n = points.size();
+		if (!closed && (i == 0 || i == n - 1))
+			return 1;
+
+		glm::vec2 in = directions[(i + n - 1) % n];
+		glm::vec2 out = directions[i];
+		float cosine = glm::dot(in, out);
+		float cross = in.x * out.y - in.y * out.x;
+
+		if (std::abs(cross) < 1e-6f && cosine > 0.f)		// Straight
+			return 1;
+
+		switch (style.join) {
+
+		case Graphics::LINEJOIN::MITER: {
+			if (cosine < -0.999f)
+				return 2;
+			glm::vec2 normal = GetNormal(in);
+			glm::vec2 miter = glm::normalize(normal + GetNormal(out));
+			return 1.f / glm::dot(miter, normal) <= style.miterLimit ? 1 : 2;
+		}
+
+		case Graphics::LINEJOIN::ROUND: {
+			float angle = std::acos(std::clamp(cosine, -1.f, 1.f));
+			return (size_t)std::max(std::ceil(angle / roundStep), 1.f) + 1;
+		}
+
+		default:
+			return 2;
+		}
+	}
+
+	void PathTessellator::WriteCrossSections(size_t i, CrossSection* output) const {
+
+		size_t n = points.size();
+		size_t count = CountCrossSections(i);
+		glm::vec2 point = points[i];
+
+		if (!closed && (i == 0 || i == n - 1)) {
+			glm::vec2 normal = GetNormal(directions[i == 0 ? 0 : n - 2]);
+			output[0] = { point, normal, -normal };
+			return;
+		}
+
+		glm::vec2 in = directions[(i + n - 1) % n];
+		glm::vec2 out = directions[i];
+		glm::vec2 normalIn = GetNormal(in);
+		glm::vec2 normalOut = GetNormal(out);
+		float cosine = std::clamp(glm::dot(in, out), -1.f, 1.f);
+		float cross = in.x * out.y - in.y * out.x;
+		float outerSign = cross > 0.f ? -1.f : 1.f;			// The outer side of the turn, along the normal or against it
+
+		// The inner side meets at the miter point, but not beyond the neighbouring segments
+		glm::vec2 inner = { 0, 0 };
+		glm::vec2 miter = normalIn;
+		float miterScale = 1.f;
+		if (cosine > -0.999f) {
+			miter = glm::normalize(normalIn + normalOut);
+			miterScale = 1.f / glm::dot(miter, normalIn);
+			float shortest = std::min(lengths[(i + n - 1) % n], lengths[i]);
+			float limit = std::sqrt(1.f + (shortest / radius) * (shortest / radius));
+			inner = -outerSign * miter * std::min(miterScale, limit);
+		}
+
+		auto write = [&](size_t k, const glm::vec2& outer) {
+			if (outerSign > 0.f)
+				output[k] = { point, outer, inner };
+			else
+				output[k] = { point, inner, outer };
+		};
+
+		if (count == 1) {				// Straight or miter
+			write(0, outerSign * miter * miterScale);
+			return;
+		}
+
+		// Bevels are an arc with a single step
+		float angle = -outerSign * std::acos(cosine);
+		for (size_t k = 0; k < count; k++) {
+			write(k, outerSign * Rotate(normalIn, angle * k / (count - 1)));
+		}
+	}
+
+	void PathTessellator::AddCap(const glm::vec2& point, const glm::vec2& normal, const glm::vec2& outward,
+			std::vector<ALLEGRO_VERTEX>& vertices, std::vector<int>& indices) {
+
+		// The outline of the cap from one side of the line to the other, as core and outer offsets
+		std::pair<glm::vec2, glm::vec2> ring[64];
+		size_t ringSize = 0;
+		auto add = [&](const glm::vec2& direction) {
+			ring[ringSize++] = { direction * coreRadius, direction * radius };
+		};
+
+		float falloff = radius - coreRadius;
+
+		switch (style.cap) {
+
+		case Graphics::LINECAP::ROUND: {
+			size_t steps = std::min((size_t)std::max(std::ceil((float)M_PI / roundStep), 1.f), (size_t)63);
+			for (size_t k = 0; k <= steps; k++) {
+				float angle = (float)M_PI * k / steps;
+				add(normal * std::cos(angle) + outward * std::sin(angle));
+			}
+			break;
+		}
+
+		case Graphics::LINECAP::SQUARE:
+			add(normal);
+			add(normal + outward);
+			add(-normal + outward);
+			add(-normal);
+			break;
+
+		case Graphics::LINECAP::TRIANGLE:
+			add(normal);
+			add(outward);
+			add(-normal);
+			break;
+
+		default:						// The edge at the end of the line fades out over the falloff as well
+			add(normal);
+			ring[ringSize++] = { normal * coreRadius, normal * radius + outward * falloff };
+			ring[ringSize++] = { -normal * coreRadius, -normal * radius + outward * falloff };
+			add(-normal);
+			break;
+		}
+
+		// A fan around the center for the core and quads for the fringe
+		int center = (int)vertices.size();
+		vertices.push_back({ point.x, point.y, 0, 0, 0, coreColor });
+		for (size_t k = 0; k < ringSize; k++) {
+			glm::vec2 core = point + ring[k].first;
+			glm::vec2 outer = point + ring[k].second;
+			vertices.push_back({ core.x, core.y, 0, 0, 0, coreColor });
+			vertices.push_back({ outer.x, outer.y, 0, 0, 0, edgeColor });
+		}
+
+		for (size_t k = 0; k + 1 < ringSize; k++) {
+			int core = center + 1 + (int)k * 2;
+			int next = core + 2;
+			int triangles[9] = { center, core, next, core, core + 1, next + 1, core, next + 1, next };
+			indices.insert(indices.end(), triangles, triangles + 9);
+		}
+	}
+
+}
@@ -0,0 +1,199 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/PixelConvert.h"
+#include "Battery/Core/Exception.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BATTERY_PIXELCONVERT_SSE2
+#endif
+
+namespace Battery {
+	namespace PixelConvert {
+
+		PixelLayout GetLayout(const clip::image_spec& spec) {
+
+			bool rgb = spec.red_mask == 0x000000FF && spec.green_mask == 0x0000FF00 && spec.blue_mask == 0x00FF0000;
+			bool bgr = spec.red_mask == 0x00FF0000 && spec.green_mask == 0x0000FF00 && spec.blue_mask == 0x000000FF;
+
+			if (spec.bits_per_pixel == 32 && (spec.alpha_mask == 0xFF000000 || spec.alpha_mask == 0)) {
+				if (rgb) return PixelLayout::RGBA8;
+				if (bgr) return PixelLayout::BGRA8;
+			}
+			else if (spec.bits_per_pixel == 24 && spec.alpha_mask == 0) {
+				if (rgb) return PixelLayout::RGB8;
+				if (bgr) return PixelLayout::BGR8;
+			}
+
+			return PixelLayout::UNKNOWN;
+		}
+
+		clip::image_spec GetClipSpec(PixelLayout layout, size_t width, size_t height) {
+
+			size_t bytesPerPixel = GetBytesPerPixel(layout);
+			if (bytesPerPixel == 0)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Can't create clip::image_spec for an unknown pixel layout!");
+
+			bool redFirst = (layout == PixelLayout::RGBA8 || layout == PixelLayout::RGB8);
+
+			clip::image_spec spec;
+			spec.width = (unsigned long)width;
+			spec.height = (unsigned long)height;
+			spec.bits_per_pixel = (unsigned long)bytesPerPixel * 8;
+			spec.bytes_per_row = (unsigned long)(width * bytesPerPixel);
+			spec.red_mask = redFirst ? 0x000000FF : 0x00FF0000;
+			spec.green_mask = 0x0000FF00;
+			spec.blue_mask = redFirst ? 0x00FF0000 : 0x000000FF;
+			spec.alpha_mask = bytesPerPixel == 4 ? 0xFF000000 : 0;
+			spec.red_shift = redFirst ? 0 : 16;
+			spec.green_shift = 8;
+			spec.blue_shift = redFirst ? 16 : 0;
+			spec.alpha_shift = bytesPerPixel == 4 ? 24 : 0;
+
+			return spec;
+		}
+
+		size_t GetBytesPerPixel(PixelLayout layout) {
+			switch (layout) {
+			case PixelLayout::RGBA8:
+			case PixelLayout::BGRA8:
+				return 4;
+			case PixelLayout::RGB8:
+			case PixelLayout::BGR8:
+				return 3;
+			default:
+				return 0;
+			}
+		}
+
+		static bool Is32Bit(PixelLayout layout) {
+			return layout == PixelLayout::RGBA8 || layout == PixelLayout::BGRA8;
+		}
+
+		static bool IsRedFirst(PixelLayout layout) {
+			return layout == PixelLayout::RGBA8 || layout == PixelLayout::RGB8;
+		}
+
+		// 32 bit to 32 bit with the same channel order, only the alpha channel may be forced
+		static void CopyRow32(const uint8_t* source, uint8_t* destination, size_t width, bool opaque) {
+
+			if (!opaque) {
+				memcpy(destination, source, width * 4);
+				return;
+			}
+
+			size_t x = 0;
+#ifdef BATTERY_PIXELCONVERT_SSE2
+			const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+			for (; x + 4 <= width; x += 4) {
+				__m128i pixels = _mm_loadu_si128((const __m128i*)(source + x * 4));
+				_mm_storeu_si128((__m128i*)(destination + x * 4), _mm_or_si128(pixels, alpha));
+			}
+#endif
+			for (; x < width; x++) {
+				uint32_t pixel;
+				memcpy(&pixel, source + x * 4, 4);
+				pixel |= 0xFF000000;
+				memcpy(destination + x * 4, &pixel, 4);
+			}
+		}
+
+		// 32 bit to 32 bit, swapping the first and the third byte of every pixel (RGBA <-> BGRA)
+		static void SwapRow32(const uint8_t* source, uint8_t* destination, size_t width, bool opaque) {
+
+			uint32_t alpha = opaque ? 0xFF000000 : 0;
+			size_t x = 0;
+
+#ifdef BATTERY_PIXELCONVERT_SSE2
+			const __m128i greenAlphaMask = _mm_set1_epi32((int)0xFF00FF00);
+			const __m128i alphaMask = _mm_set1_epi32((int)alpha);
+			for (; x + 4 <= width; x += 4) {
+				__m128i pixels = _mm_loadu_si128((const __m128i*)(source + x * 4));
+				__m128i greenAlpha = _mm_and_si128(pixels, greenAlphaMask);
+				__m128i redBlue = _mm_andnot_si128(greenAlphaMask, pixels);
+				__m128i swapped = _mm_or_si128(_mm_srli_epi32(redBlue, 16), _mm_slli_epi32(redBlue, 16));
+				_mm_storeu_si128((__m128i*)(destination + x * 4), _mm_or_si128(_mm_or_si128(greenAlpha, swapped), alphaMask));
+			}
+#endif
+			for (; x < width; x++) {
+				uint32_t pixel;
+				memcpy(&pixel, source + x * 4, 4);
+				pixel = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16) | alpha;
+				memcpy(destination + x * 4, &pixel, 4);
+			}
+		}
+
+		// 24 bit to 32 bit, optionally swapping the first and the third byte. The alpha channel is always opaque
+		static void ExpandRow24(const uint8_t* source, uint8_t* destination, size_t width, bool swap) {
+
+			size_t first = swap ? 2 : 0;
+			size_t third = swap ? 0 : 2;
+
+			for (size_t x = 0; x < width; x++) {
+				const uint8_t* pixel = source + x * 3;
+				uint32_t value = (uint32_t)pixel[first] | (uint32_t)pixel[1] << 8 | (uint32_t)pixel[third] << 16 | 0xFF000000;
+				memcpy(destination + x * 4, &value, 4);
+			}
+		}
+
+		void ConvertRow(const void* source, PixelLayout sourceLayout, void* destination, PixelLayout destinationLayout,
+			size_t width, bool opaque) {
+
+			if (sourceLayout == PixelLayout::UNKNOWN || !Is32Bit(destinationLayout))
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Unsupported pixel layout conversion!");
+
+			const uint8_t* src = (const uint8_t*)source;
+			uint8_t* dst = (uint8_t*)destination;
+			bool swap = IsRedFirst(sourceLayout) != IsRedFirst(destinationLayout);
+
+			if (!Is32Bit(sourceLayout))
+				ExpandRow24(src, dst, width, swap);
+			else if (swap)
+				SwapRow32(src, dst, width, opaque);
+			else
+				CopyRow32(src, dst, width, opaque);
+		}
+
+		void ConvertImage(const void* source, ptrdiff_t sourcePitch, PixelLayout sourceLayout,
+			void* destination, ptrdiff_t destinationPitch, PixelLayout destinationLayout,
+			size_t width, size_t height, bool opaque) {
+
+			const uint8_t* src = (const uint8_t*)source;
+			uint8_t* dst = (uint8_t*)destination;
+
+			for (size_t y = 0; y < height; y++) {
+				ConvertRow(src, sourceLayout, dst, destinationLayout, width, opaque);
+				src += sourcePitch;
+				dst += destinationPitch;
+			}
+		}
+
+		uint32_t PackColor(const glm::vec4& color) {
+#ifdef BATTERY_PIXELCONVERT_SSE2
+			__m128 value = _mm_set_ps(color.a, color.b, color.g, color.r);
+			value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.f));	// NaN becomes 0
+			__m128i channels = _mm_cvttps_epi32(value);
+			channels = _mm_packs_epi32(channels, channels);
+			channels = _mm_packus_epi16(channels, channels);
+			return (uint32_t)_mm_cvtsi128_si32(channels);
+#else
+			return PackColorScalar(color);
+#endif
+		}
+
+		uint32_t PackColorScalar(const glm::vec4& color) {
+			uint32_t packed = 0;
+			for (int i = 0; i < 4; i++) {
+				// std::max() returns its first argument when the comparison fails, so NaN becomes 0 like with SSE2
+				float channel = std::min(std::max(0.f, color[i]), 255.f);
+				packed |= (uint32_t)channel << (i * 8);
+			}
+			return packed;
+		}
+
+		glm::vec4 UnpackColor(uint32_t color) {
+			return { color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24 };
+		}
+
+	}
+}
@@ -0,0 +1,232 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/PlotSeries.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	PlotSeries::PlotSeries() {
+	}
+
+	bool PlotSeries::Append(double x, double y) {
+
+		if (!std::isfinite(x) || !std::isfinite(y)) {
+			LOG_CORE_WARN("{}(): Rejected sample ({}, {}): Samples must be finite", __FUNCTION__, x, y);
+			return false;
+		}
+
+		if (!samples.empty() && x < samples.back().x) {
+			LOG_CORE_WARN("{}(): Rejected sample ({}, {}): x is smaller than the last one", __FUNCTION__, x, y);
+			return false;
+		}
+
+		samples.push_back({ x, y });
+		for (auto& [exponent, level] : levels) {
+			AddToLevel(level, exponent, samples.size() - 1);
+		}
+
+		return true;
+	}
+
+	void PlotSeries::Append(const glm::dvec2* samples, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			Append(samples[i].x, samples[i].y);
+		}
+	}
+
+	void PlotSeries::Clear() {
+		samples.clear();
+		levels.clear();
+		output.clear();
+	}
+
+	void PlotSeries::RemoveBefore(double x) {
+
+		auto compare = [](const glm::dvec2& sample, double x) { return sample.x < x; };
+		size_t count = std::lower_bound(samples.begin(), samples.end(), x, compare) - samples.begin();
+		if (count == 0)
+			return;
+
+		if (count == samples.size()) {
+			Clear();
+			return;
+		}
+
+		samples.erase(samples.begin(), samples.begin() + count);
+
+		for (auto& [exponent, level] : levels) {
+			auto kept = std::lower_bound(level.buckets.begin(), level.buckets.end(), count,
+				[](const Bucket& bucket, size_t sample) { return bucket.firstSample < sample; });
+			level.buckets.erase(level.buckets.begin(), kept);
+			for (Bucket& bucket : level.buckets) {
+				bucket.firstSample -= count;
+			}
+
+			// The bucket which lost only some of its samples is built again from the remaining ones
+			size_t remaining = level.buckets.empty() ? samples.size() : level.buckets.front().firstSample;
+			if (remaining > 0) {
+				Level head;
+				for (size_t i = 0; i < remaining; i++) {
+					AddToLevel(head, exponent, i);
+				}
+				level.buckets.insert(level.buckets.begin(), head.buckets.begin(), head.buckets.end());
+			}
+		}
+	}
+
+	size_t PlotSeries::GetSize() const {
+		return samples.size();
+	}
+
+	const std::vector<glm::dvec2>& PlotSeries::GetSamples() const {
+		return samples;
+	}
+
+	size_t PlotSeries::GetCachedLevels() const {
+		return levels.size();
+	}
+
+	const std::vector<glm::dvec2>& PlotSeries::Decimate(double xMin, double xMax, int columns) {
+
+		output.clear();
+		if (samples.empty() || columns <= 0 || !(xMax > xMin))
+			return output;
+
+		// The samples within the view and one on either side
+		auto compare = [](const glm::dvec2& sample, double x) { return sample.x < x; };
+		size_t begin = std::lower_bound(samples.begin(), samples.end(), xMin, compare) - samples.begin();
+		size_t end = std::lower_bound(samples.begin() + begin, samples.end(), std::nextafter(xMax, INFINITY), compare)
+			- samples.begin();
+		size_t first = begin > 0 ? begin - 1 : 0;
+		size_t last = std::min(end + 1, samples.size());
+
+		if (last - first <= (size_t)columns * 4) {
+			output.assign(samples.begin() + first, samples.begin() + last);
+			return output;
+		}
+
+		// The cached buckets are finer than a column and don't line up with it, they are merged per column
+		double columnWidth = (xMax - xMin) / columns;
+		int exponent = (int)std::floor(std::log2(columnWidth / BATTERY_PLOT_SERIES_BUCKETS_PER_COLUMN));
+		double width = std::ldexp(1.0, exponent);
+		Level& level = GetLevel(exponent);
+
+		auto compareIndex = [](const Bucket& bucket, int64_t index) { return bucket.index < index; };
+		auto bucket = std::lower_bound(level.buckets.begin(), level.buckets.end(),
+			(int64_t)std::floor(xMin / width), compareIndex);
+		auto bucketsEnd = std::lower_bound(bucket, level.buckets.end(),
+			(int64_t)std::floor(xMax / width) + 1, compareIndex);
+
+		// Buckets on the border of the view can contain the neighbouring samples, x must keep increasing
+		auto add = [&](const glm::dvec2& point) {
+			if (output.empty() || (point.x >= output.back().x && point != output.back()))
+				output.push_back(point);
+		};
+
+		auto addColumn = [&](const Bucket& column) {
+			bool minFirst = column.min.x <= column.max.x;
+			add(column.first);
+			add(minFirst ? column.min : column.max);
+			add(minFirst ? column.max : column.min);
+			add(column.last);
+		};
+
+		if (first < begin)
+			add(samples[first]);
+
+		Bucket column = {};
+		bool hasColumn = false;
+		auto merge = [&](int64_t index, const Bucket& part) {
+			if (!hasColumn || index != column.index) {
+				if (hasColumn)
+					addColumn(column);
+				column = part;
+				column.index = index;
+				hasColumn = true;
+				return;
+			}
+
+			column.last = part.last;
+			if (part.min.y < column.min.y)
+				column.min = part.min;
+			if (part.max.y > column.max.y)
+				column.max = part.max;
+		};
+
+		// Only the few buckets crossing a column border need their samples, so the result is exact
+		for (; bucket != bucketsEnd; ++bucket) {
+			double start = bucket->index * width;
+			int64_t index = (int64_t)std::floor((start - xMin) / columnWidth);
+
+			if ((int64_t)std::floor((start + width - xMin) / columnWidth) == index) {
+				merge(index, *bucket);
+				continue;
+			}
+
+			size_t sampleEnd = bucket + 1 != level.buckets.end() ? (bucket + 1)->firstSample : samples.size();
+			for (size_t i = bucket->firstSample; i < sampleEnd; i++) {
+				const glm::dvec2& sample = samples[i];
+				merge((int64_t)std::floor((sample.x - xMin) / columnWidth), { 0, i, sample, sample, sample, sample });
+			}
+		}
+		if (hasColumn)
+			addColumn(column);
+
+		if (end < last)
+			add(samples[end]);
+
+		return output;
+	}
+
+	void PlotSeries::PlotLine(const char* label) {
+
+		ImPlotLimits limits = ImPlot::GetPlotLimits();
+		int columns = std::max((int)ImPlot::GetPlotSize().x, 1);
+
+		const std::vector<glm::dvec2>& points = Decimate(limits.X.Min, limits.X.Max, columns);
+		if (!points.empty())
+			ImPlot::PlotLine(label, &points[0].x, &points[0].y, (int)points.size(), 0, (int)sizeof(glm::dvec2));
+	}
+
+	PlotSeries::Level& PlotSeries::GetLevel(int exponent) {
+
+		auto it = levels.find(exponent);
+		if (it == levels.end()) {
+
+			// Zooming through many levels should not keep all of them, the least recently used one goes
+			if (levels.size() >= BATTERY_PLOT_SERIES_MAX_LEVELS) {
+				auto oldest = std::min_element(levels.begin(), levels.end(), [](auto& a, auto& b) {
+					return a.second.lastUse < b.second.lastUse;
+				});
+				levels.erase(oldest);
+			}
+
+			it = levels.emplace(exponent, Level()).first;
+			for (size_t i = 0; i < samples.size(); i++) {
+				AddToLevel(it->second, exponent, i);
+			}
+		}
+
+		it->second.lastUse = ++useCounter;
+		return it->second;
+	}
+
+	void PlotSeries::AddToLevel(Level& level, int exponent, size_t sampleIndex) {
+
+		const glm::dvec2& sample = samples[sampleIndex];
+		int64_t index = (int64_t)std::floor(std::ldexp(sample.x, -exponent));
+
+		if (level.buckets.empty() || level.buckets.back().index != index) {
+			level.buckets.push_back({ index, sampleIndex, sample, sample, sample, sample });
+			return;
+		}
+
+		Bucket& bucket = level.buckets.back();
+		bucket.last = sample;
+		if (sample.y < bucket.min.y)
+			bucket.min = sample;
+		if (sample.y > bucket.max.y)
+			bucket.max = sample;
+	}
+
+}
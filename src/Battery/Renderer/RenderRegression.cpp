@@ -0,0 +1,247 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/RenderRegression.h"
+#include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Core/Application.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/JsonUtils.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	// RGBA, 8 bits per channel
+	static std::vector<uint32_t> ReadPixels(ALLEGRO_BITMAP* bitmap) {
+
+		std::vector<uint32_t> pixels;
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+		if (region == nullptr)
+			return pixels;
+
+		int width = al_get_bitmap_width(bitmap);
+		int height = al_get_bitmap_height(bitmap);
+		pixels.resize((size_t)width * height);
+
+		for (int y = 0; y < height; y++) {
+			memcpy(&pixels[(size_t)y * width], (const uint8_t*)region->data + (ptrdiff_t)y * region->pitch, (size_t)width * 4);
+		}
+		al_unlock_bitmap(bitmap);
+
+		return pixels;
+	}
+
+	// The golden images are compared as stored, so they must not be premultiplied when loading
+	static ALLEGRO_BITMAP* LoadGolden(const std::string& path) {
+		return al_load_bitmap_flags(path.c_str(), ALLEGRO_MEMORY_BITMAP | ALLEGRO_NO_PREMULTIPLIED_ALPHA);
+	}
+
+
+
+
+
+	RenderRegression::RenderRegression(const std::string& goldenDirectory, int tolerance) {
+		this->goldenDirectory = goldenDirectory;
+		this->tolerance = std::clamp(tolerance, 0, 255);
+	}
+
+	void RenderRegression::AddScene(const std::string& name, const glm::ivec2& size, std::function<void()> draw) {
+		scenes.push_back({ name, size, std::move(draw) });
+	}
+
+	std::vector<RenderRegressionResult> RenderRegression::Run(const std::string& filter, size_t iterations,
+			bool updateGoldens) {
+
+		std::vector<RenderRegressionResult> results;
+
+		if (GetApplication() == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't run the render regression: There is no application!", __FUNCTION__);
+			return results;
+		}
+
+		if (!FileUtils::PrepareDirectory(goldenDirectory)) {
+			LOG_CORE_ERROR("{}(): Can't run the render regression: Directory '{}' can't be created!", __FUNCTION__,
+				goldenDirectory);
+			return results;
+		}
+
+		for (const SceneEntry& entry : scenes) {
+			if (entry.name.find(filter) != std::string::npos) {
+				results.push_back(RunScene(entry, std::max<size_t>(iterations, 1), updateGoldens));
+			}
+		}
+
+		LOG_CORE_INFO("Render regression: {} of {} scenes passed",
+			std::count_if(results.begin(), results.end(), [](auto& result) { return result.passed; }), results.size());
+
+		return results;
+	}
+
+	RenderRegressionResult RenderRegression::RunScene(const SceneEntry& entry, size_t iterations, bool updateGoldens) {
+
+		RenderRegressionResult result;
+		result.name = entry.name;
+		result.cpuTime = std::numeric_limits<double>::max();
+
+		Texture2D target(entry.size.x, entry.size.y);
+		if (!target.IsValid()) {
+			LOG_CORE_ERROR("{}(): Scene '{}': The target texture could not be created!", __FUNCTION__, entry.name);
+			result.cpuTime = 0.0;
+			return result;
+		}
+
+		Scene scene(GetApplication()->window, target);
+
+		for (size_t i = 0; i < iterations; i++) {
+			Renderer2D::BeginScene(&scene);
+			Renderer2D::DrawBackground({ 0, 0, 0, 0 });
+			Renderer2D::ResetStats();
+
+			double start = TimeUtils::GetRuntime();
+			entry.draw();
+			Renderer2D::EndScene();
+			result.cpuTime = std::min(result.cpuTime, TimeUtils::GetRuntime() - start);
+
+			Renderer2DStats stats = Renderer2D::GetStats();
+			result.drawCalls = stats.drawCalls;
+			result.vertices = stats.vertices;
+			result.spriteBatches = stats.spriteBatches;
+		}
+
+		std::string goldenPath = PathUtils::Join(goldenDirectory, entry.name + ".png");
+		std::string actualPath = PathUtils::Join(goldenDirectory, entry.name + ".actual.png");
+
+		if (updateGoldens) {
+			result.goldenWritten = al_save_bitmap(goldenPath.c_str(), target.GetAllegroBitmap());
+			result.passed = result.goldenWritten;
+			if (result.passed) {
+				LOG_CORE_INFO("Scene '{}': Wrote the golden image '{}'", entry.name, goldenPath);
+			}
+			else {
+				LOG_CORE_ERROR("{}(): Scene '{}': The golden image could not be written!", __FUNCTION__, entry.name);
+			}
+			return result;
+		}
+
+		// A deleted or never committed golden image must not let the scene pass
+		if (!FileUtils::FileExists(goldenPath)) {
+			result.goldenMissing = true;
+			LOG_CORE_ERROR("Scene '{}' FAILED: Missing golden image '{}', write it with --update", entry.name, goldenPath);
+			al_save_bitmap(actualPath.c_str(), target.GetAllegroBitmap());
+			return result;
+		}
+
+		ALLEGRO_BITMAP* golden = LoadGolden(goldenPath);
+		if (golden == nullptr) {
+			LOG_CORE_ERROR("{}(): Scene '{}': The golden image could not be loaded!", __FUNCTION__, entry.name);
+			return result;
+		}
+
+		if (al_get_bitmap_width(golden) != entry.size.x || al_get_bitmap_height(golden) != entry.size.y) {
+			LOG_CORE_ERROR("Scene '{}' FAILED: The golden image is {}x{} instead of {}x{}", entry.name,
+				al_get_bitmap_width(golden), al_get_bitmap_height(golden), entry.size.x, entry.size.y);
+			al_destroy_bitmap(golden);
+			al_save_bitmap(actualPath.c_str(), target.GetAllegroBitmap());
+			return result;
+		}
+
+		std::vector<uint32_t> expected = ReadPixels(golden);
+		std::vector<uint32_t> actual = ReadPixels(target.GetAllegroBitmap());
+		al_destroy_bitmap(golden);
+
+		if (expected.size() != actual.size()) {
+			LOG_CORE_ERROR("{}(): Scene '{}': The pixels could not be read!", __FUNCTION__, entry.name);
+			return result;
+		}
+
+		for (size_t i = 0; i < actual.size(); i++) {
+			int difference = 0;
+			for (int c = 0; c < 32; c += 8) {
+				difference = std::max(difference, std::abs((int)((actual[i] >> c) & 0xFF) - (int)((expected[i] >> c) & 0xFF)));
+			}
+			result.maxDifference = std::max(result.maxDifference, difference);
+			if (difference > tolerance)
+				result.differentPixels++;
+		}
+
+		result.passed = result.differentPixels == 0;
+
+		if (result.passed) {
+			LOG_CORE_INFO("Scene '{}' passed: {:.3f} ms, {} draw calls, {} vertices, {} sprite batches", entry.name,
+				result.cpuTime * 1000.0, result.drawCalls, result.vertices, result.spriteBatches);
+			FileUtils::RemoveFile(actualPath);
+		}
+		else {
+			LOG_CORE_ERROR("Scene '{}' FAILED: {} pixels differ by up to {}, see '{}'", entry.name,
+				result.differentPixels, result.maxDifference, actualPath);
+			al_save_bitmap(actualPath.c_str(), target.GetAllegroBitmap());
+		}
+
+		return result;
+	}
+
+	bool RenderRegression::SaveReport(const std::string& path, const std::vector<RenderRegressionResult>& results) const {
+
+		JsonUtils::JsonWriter writer;
+		if (!writer.Open(path)) {
+			LOG_CORE_ERROR("{}(): Can't write the report to '{}'", __FUNCTION__, path);
+			return false;
+		}
+
+		writer.BeginObject().Field("tolerance", tolerance).Key("scenes").BeginArray();
+		for (const RenderRegressionResult& result : results) {
+			writer.BeginObject();
+			writer.Field("name", result.name).Field("passed", result.passed).Field("goldenWritten", result.goldenWritten);
+			writer.Field("goldenMissing", result.goldenMissing);
+			writer.Field("differentPixels", result.differentPixels).Field("maxDifference", result.maxDifference);
+			writer.Field("cpuTime", result.cpuTime).Field("drawCalls", result.drawCalls).Field("vertices", result.vertices);
+			writer.Field("spriteBatches", result.spriteBatches);
+			writer.EndObject();
+		}
+		writer.EndArray().EndObject();
+
+		return writer.Close();
+	}
+
+	int RenderRegression::RunFromCommandLine(const std::vector<std::string>& args,
+			std::vector<RenderRegressionResult>* results) {
+
+		std::string filter;
+		std::string reportPath;
+		size_t iterations = 1;
+		bool update = false;
+
+		for (size_t i = 0; i < args.size(); i++) {
+			bool hasValue = i + 1 < args.size();
+
+			if (args[i] == "--update") {
+				update = true;
+			}
+			else if (args[i] == "--filter" && hasValue) {
+				filter = args[++i];
+			}
+			else if (args[i] == "--report" && hasValue) {
+				reportPath = args[++i];
+			}
+			else if (args[i] == "--iterations" && hasValue) {
+				try {
+					iterations = std::stoul(args[++i]);
+				}
+				catch (...) {
+					LOG_CORE_ERROR("{}(): Invalid number of iterations '{}'", __FUNCTION__, args[i]);
+					return -1;
+				}
+			}
+		}
+
+		std::vector<RenderRegressionResult> sceneResults = Run(filter, iterations, update);
+		if (results != nullptr)
+			*results = sceneResults;
+
+		if (!reportPath.empty() && !SaveReport(reportPath, sceneResults))
+			return -1;
+
+		return (int)std::count_if(sceneResults.begin(), sceneResults.end(), [](auto& result) { return !result.passed; });
+	}
+
+}
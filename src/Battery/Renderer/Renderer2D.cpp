@@ -1,6 +1,7 @@
 
 #include "Battery/pch.h"
 #include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Renderer/PixelConvert.h"
 #include "Battery/Core/Exception.h"
 #include "Battery/Core/AllegroContext.h"
 #include "Battery/Log/Log.h"
@@ -9,7 +10,7 @@
 #ifdef BATTERY_DEBUG
 #define CHECK_INIT() \
 	if (data == nullptr) { \
-		LOG_CORE_ERROR(__FUNCTION__ "(): Renderer is not initialized!"); \
+		LOG_CORE_ERROR("{}(): Renderer is not initialized!", __FUNCTION__); \
 		return;	\
 	}
 #else
@@ -54,8 +55,25 @@ namespace Battery {
 		glm::vec4 color;
 	};
 
+	// Queued sprites take 20 bytes per vertex instead of the 36 of ALLEGRO_VERTEX
+	struct SpriteVertex {
+		float x;
+		float y;
+		float u;			// In pixels of the texture
+		float v;
+		uint32_t color;		// RGBA8, see PixelConvert::PackColor()
+	};
+
+	static const ALLEGRO_VERTEX_ELEMENT SPRITE_VERTEX_ELEMENTS[] = {
+		{ ALLEGRO_PRIM_POSITION, ALLEGRO_PRIM_FLOAT_2, offsetof(SpriteVertex, x) },
+		{ ALLEGRO_PRIM_TEX_COORD_PIXEL, ALLEGRO_PRIM_FLOAT_2, offsetof(SpriteVertex, u) },
+		{ ALLEGRO_PRIM_USER_ATTR, ALLEGRO_PRIM_NORMALIZED_UBYTE_4, offsetof(SpriteVertex, color) },
+		{ 0, 0, 0 }
+	};
+
 	struct Renderer2DData {
 		Scene* currentScene = nullptr;	// This is a Scene reference, do not delete
+		RenderBackend backend = RenderBackend::OPENGL;
 
 		std::vector<LineData> lineBuffer;
 		bool linesActive = false;
@@ -67,18 +85,157 @@ namespace Battery {
 		std::vector<QuadData> quadBuffer;
 		int quadTextureID = -1;
 		bool quadsActive = false;
+
+		std::vector<SpriteVertex> spriteVertices;			// 4 per sprite
+		std::vector<uint64_t> spriteKeys;					// Layer, depth and texture slot, FlushSprites() adds the step
+		std::vector<ALLEGRO_BITMAP*> spriteTextures;		// By slot
+		std::unordered_map<ALLEGRO_BITMAP*, uint16_t> spriteTextureSlots;
+		ALLEGRO_BITMAP* spriteTexture = nullptr;			// The most recent one
+		uint16_t spriteTextureSlot = 0;
+		uint64_t sortOrder = 0;								// Layer and depth bits of the next sprites
+
+		// Only used by FlushSprites()
+		std::vector<int> spriteIndices;
+		std::vector<uint32_t> sortedSprites;
+		std::vector<uint64_t> sortTempKeys;
+		std::vector<uint32_t> sortTempSprites;
+		std::vector<TileQuad> tileQuads;
+
+		PathTessellator tessellator;
+		std::vector<ALLEGRO_VERTEX> pathVertices;
+		std::vector<int> pathIndices;
+		std::vector<glm::vec2> plotPoints;
+
+		// Only used by the OpenGL backend
+		std::unique_ptr<StreamBuffer> stream;
+		ALLEGRO_VERTEX_DECL* spriteDecl = nullptr;			// Created with the first sprites, it needs a display
+		std::unique_ptr<StreamBuffer> spriteStream;
+
+		// Only used by the software backend
+		std::unique_ptr<SoftwareRasterizer> framebuffer;
+		std::unique_ptr<SoftwareRasterizer> offscreen;		// For scenes rendering to a texture
+		SoftwareRasterizer* rasterizer = nullptr;			// The current target
+
+		Renderer2DStats stats;
+		glm::vec2 viewMin = { 0, 0 };						// The target of the current scene
+		glm::vec2 viewMax = { 0, 0 };
+
+		std::vector<std::pair<glm::ivec2, glm::ivec2>> clipStack;	// Every entry is within the previous one
+		std::vector<std::pair<glm::ivec2, glm::ivec2>> windowClipStack;	// Put aside while rendering to a texture
 	};
 
 	static Renderer2DData* data = nullptr;
 
+	// Sprites are drawn in the order of their keys: layer, depth, step and texture slot from the most significant
+	// bits on. The step separates overlapping sprites with different textures, which must keep their order
+	static constexpr int SPRITE_KEY_LAYER_SHIFT = 56;
+	static constexpr int SPRITE_KEY_DEPTH_SHIFT = 40;
+	static constexpr int SPRITE_KEY_STEP_SHIFT = 16;
+	static constexpr uint64_t SPRITE_KEY_MAX_STEP = 0xFFFFFF;
+	static constexpr size_t SPRITE_MAX_TEXTURES = 0xFFFF;
+	static constexpr int SPRITE_STEP_GRID = 32;				// Cells per side for finding overlapping sprites
+
+	static void CountDrawCall(size_t vertices) {
+		data->stats.drawCalls++;
+		data->stats.vertices += vertices;
+	}
+
+	// Geometry goes through the stream buffer, or is uploaded by the draw call when there is none
+	static void DrawIndexed(const ALLEGRO_VERTEX* vertices, size_t vertexCount, ALLEGRO_BITMAP* texture,
+			const int* indices, size_t indexCount) {
+
+		int first = data->stream->Write(vertices, vertexCount, indices, indexCount);
+		if (first < 0) {
+			al_draw_indexed_prim(vertices, NULL, texture, indices, (int)indexCount, ALLEGRO_PRIM_TRIANGLE_LIST);
+			return;
+		}
+
+		data->stream->Draw(texture, first, (int)indexCount);
+		data->stats.streamedBytes += vertexCount * sizeof(ALLEGRO_VERTEX) + indexCount * sizeof(int);
+	}
+
+	// Primitives outside of the target are skipped before they are tessellated or submitted
+	static bool Cull(const glm::vec2& min, const glm::vec2& max) {
+		if (Renderer2D::IsVisible(min, max))
+			return false;
+
+		data->stats.culled++;
+		return true;
+	}
+
+	// Clipping is a state of the target, it has to be set again whenever the target or the stack changes
+	static void ApplyClipRect() {
+		if (data->backend == RenderBackend::SOFTWARE) {
+			if (data->clipStack.empty())
+				data->rasterizer->ResetClipRect();
+			else
+				data->rasterizer->SetClipRect(data->clipStack.back().first, data->clipStack.back().second);
+			return;
+		}
+
+		if (al_get_target_bitmap() == nullptr)
+			return;
+
+		if (data->clipStack.empty()) {
+			al_reset_clipping_rectangle();
+		}
+		else {
+			glm::ivec2 min = data->clipStack.back().first;
+			glm::ivec2 size = data->clipStack.back().second - min;
+			al_set_clipping_rectangle(min.x, min.y, size.x, size.y);
+		}
+	}
+
+
+
+
+
 
+	void Scene::LoadShaders() {
 
+		// The software backend does not use shaders and has no display to load them on
+		if (Renderer2D::GetBackend() == RenderBackend::SOFTWARE)
+			return;
+
+		lineShader = std::make_unique<ShaderProgram>();
+		circleShader = std::make_unique<ShaderProgram>();
+		arcShader = std::make_unique<ShaderProgram>();
+		rectangleShader = std::make_unique<ShaderProgram>();
+		spriteShader = std::make_unique<ShaderProgram>();
+
+		ALLEGRO_DISPLAY* display = window.value().get().allegroDisplayPointer;
+
+		// Load the shader for drawing antialiased lines
+		lineShader->LoadSource(display,
+			BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_LINE);
+
+		circleShader->LoadSource(display,
+			BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_CIRCLE);
 
+		arcShader->LoadSource(display,
+			BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_ARC);
 
+		rectangleShader->LoadSource(display,
+			BATTERY_SHADER_SOURCE_VERTEX_SIMPLE, BATTERY_SHADER_SOURCE_FRAGMENT_COLOR_GRADIENT);
 
-	void Renderer2D::Setup() {
+		spriteShader->LoadSource(display,
+			BATTERY_SHADER_SOURCE_VERTEX_SPRITE, BATTERY_SHADER_SOURCE_FRAGMENT_SPRITE);
+	}
+
+	void Renderer2D::Setup(RenderBackend backend, const glm::ivec2& size) {
 		if (data == nullptr) {
 			data = new Renderer2DData();
+			data->backend = backend;
+
+			if (backend == RenderBackend::SOFTWARE) {
+				data->framebuffer = std::make_unique<SoftwareRasterizer>(size.x, size.y);
+				data->offscreen = std::make_unique<SoftwareRasterizer>();
+				data->rasterizer = data->framebuffer.get();
+				LOG_CORE_INFO("Renderer2D uses the software backend");
+			}
+			else {
+				data->stream = std::make_unique<StreamBuffer>();
+			}
 		}
 		else {
 			LOG_CORE_CRITICAL("Can't setup Renderer2D: Already initialized!");
@@ -87,6 +244,9 @@ namespace Battery {
 
 	void Renderer2D::Shutdown() {
 		if (data != nullptr) {
+			data->spriteStream.reset();
+			if (data->spriteDecl != nullptr)
+				al_destroy_vertex_decl(data->spriteDecl);
 			delete data;
 			data = nullptr;
 		}
@@ -95,30 +255,132 @@ namespace Battery {
 		}
 	}
 
+	RenderBackend Renderer2D::GetBackend() {
+		return data != nullptr ? data->backend : RenderBackend::OPENGL;
+	}
+
+	SoftwareRasterizer* Renderer2D::GetSoftwareRasterizer() {
+		return data != nullptr ? data->framebuffer.get() : nullptr;
+	}
+
+	void Renderer2D::BeginFrame() {
+		CHECK_INIT();
+		ResetStats();
+		if (data->stream)
+			data->stream->NextFrame();
+		if (data->spriteStream)
+			data->spriteStream->NextFrame();
+	}
+
+	Renderer2DStats Renderer2D::GetStats() {
+		return data != nullptr ? data->stats : Renderer2DStats();
+	}
+
+	void Renderer2D::ResetStats() {
+		CHECK_INIT();
+		data->stats = Renderer2DStats();
+	}
+
+	void Renderer2D::SetSortOrder(int layer, float depth) {
+		CHECK_INIT();
+		uint64_t layerBits = (uint64_t)std::clamp(layer, 0, 255);
+		uint64_t depthBits = (uint64_t)(std::clamp(depth, 0.f, 1.f) * 0xFFFF + 0.5f);
+		data->sortOrder = layerBits << SPRITE_KEY_LAYER_SHIFT | depthBits << SPRITE_KEY_DEPTH_SHIFT;
+	}
+
+	bool Renderer2D::IsVisible(const glm::vec2& min, const glm::vec2& max) {
+		if (data == nullptr)
+			return true;
+
+		glm::vec2 viewMin = glm::vec2(-INFINITY);
+		glm::vec2 viewMax = glm::vec2(INFINITY);
+		if (data->currentScene != nullptr) {
+			viewMin = data->viewMin;
+			viewMax = data->viewMax;
+		}
+		if (!data->clipStack.empty()) {
+			viewMin = glm::max(viewMin, glm::vec2(data->clipStack.back().first));
+			viewMax = glm::min(viewMax, glm::vec2(data->clipStack.back().second));
+		}
+
+		return min.x <= viewMax.x && max.x >= viewMin.x && min.y <= viewMax.y && max.y >= viewMin.y;
+	}
+
+	void Renderer2D::PushClipRect(const glm::vec2& min, const glm::vec2& max) {
+		CHECK_INIT();
+
+		// Whole pixels, partially covered ones belong to the rectangle
+		glm::ivec2 clipMin = glm::ivec2(glm::floor(glm::min(min, max)));
+		glm::ivec2 clipMax = glm::ivec2(glm::ceil(glm::max(min, max)));
+		if (!data->clipStack.empty()) {
+			clipMin = glm::max(clipMin, data->clipStack.back().first);
+			clipMax = glm::max(glm::min(clipMax, data->clipStack.back().second), clipMin);
+		}
+
+		FlushSprites();
+		data->clipStack.push_back({ clipMin, clipMax });
+		ApplyClipRect();
+	}
+
+	void Renderer2D::PopClipRect() {
+		CHECK_INIT();
+
+		if (data->clipStack.empty()) {
+			LOG_CORE_ERROR("{}(): Can't pop clip rectangle: The stack is empty!", __FUNCTION__);
+			return;
+		}
+
+		FlushSprites();
+		data->clipStack.pop_back();
+		ApplyClipRect();
+	}
+
+	bool Renderer2D::GetClipRect(glm::vec2& min, glm::vec2& max) {
+		if (data == nullptr || data->clipStack.empty())
+			return false;
+
+		min = data->clipStack.back().first;
+		max = data->clipStack.back().second;
+		return true;
+	}
+
 	void Renderer2D::BeginScene(Scene* scene) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		// Some sanity checks
 		if (data->currentScene != nullptr) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't begin scene, another scene is still active!");
+			LOG_CORE_ERROR("{}(): Can't begin scene, another scene is still active!", __FUNCTION__);
 			return;
 		}
 
 		if (scene == nullptr) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't load scene: Supplied scene pointer is null!");
+			LOG_CORE_ERROR("{}(): Can't load scene: Supplied scene pointer is null!", __FUNCTION__);
 			return;
 		}
 
 		if (!scene->window.has_value()) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't load scene: AllegroWindow pointer has no value!");
+			LOG_CORE_ERROR("{}(): Can't load scene: AllegroWindow pointer has no value!", __FUNCTION__);
 			return;
 		}
 
 		// Change pointer to the new scene
 		data->currentScene = scene;
-
-		if (scene->texture.has_value()) {	// Render to texture
+		data->sortOrder = 0;
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			if (scene->texture.has_value()) {	// Start with the current content of the texture, like on the GPU
+				data->rasterizer = data->offscreen.get();
+				if (!data->rasterizer->CopyFromBitmap(scene->texture.value().get().GetAllegroBitmap())) {
+					LOG_CORE_ERROR("{}(): The content of the scene texture could not be read!", __FUNCTION__);
+				}
+			}
+			else {
+				data->rasterizer = data->framebuffer.get();
+				data->rasterizer->Resize(scene->window.value().get().GetWidth(), scene->window.value().get().GetHeight());
+			}
+		}
+		else if (scene->texture.has_value()) {	// Render to texture
 			// Initialize the canvas for the scene
 			al_set_target_bitmap(scene->texture.value().get().GetAllegroBitmap());
 		}
@@ -126,17 +388,53 @@ namespace Battery {
 			// Initialize the canvas for the scene
 			al_set_target_backbuffer(scene->window.value().get().allegroDisplayPointer);
 		}
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			data->viewMax = { data->rasterizer->GetWidth(), data->rasterizer->GetHeight() };
+		}
+		else {
+			ALLEGRO_BITMAP* target = al_get_target_bitmap();
+			data->viewMax = { al_get_bitmap_width(target), al_get_bitmap_height(target) };
+		}
+
+		// The clip rectangles of the window don't apply to textures
+		if (scene->texture.has_value()) {
+			std::swap(data->clipStack, data->windowClipStack);
+			data->clipStack.clear();
+		}
+		ApplyClipRect();
 	}
 
 	void Renderer2D::EndScene() {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (data->currentScene == nullptr) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't end scene: No scene is currently active!");
+			LOG_CORE_ERROR("{}(): Can't end scene: No scene is currently active!", __FUNCTION__);
 			return;
 		}
 
+		FlushSprites();
+
+		if (data->currentScene->texture.has_value()) {
+			if (!data->clipStack.empty()) {
+				LOG_CORE_WARN("{}(): {} clip rectangles were not popped before the end of the scene", __FUNCTION__,
+					data->clipStack.size());
+				data->clipStack.clear();
+				ApplyClipRect();
+			}
+			std::swap(data->clipStack, data->windowClipStack);
+		}
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			data->rasterizer->Flush();
+
+			if (data->currentScene->texture.has_value()) {
+				data->rasterizer->CopyToBitmap(data->currentScene->texture.value().get().GetAllegroBitmap());
+			}
+			data->rasterizer = data->framebuffer.get();
+		}
+
 		// Let go of the reference to the scene object
 		data->currentScene = nullptr;
 	}
@@ -145,7 +443,7 @@ namespace Battery {
 		CHECK_INIT();
 
 		if (data->currentScene != nullptr) {
-			LOG_CORE_WARN(__FUNCTION__ "(): The most recent scene is still active, make sure to call Renderer2D::EndScene()!");
+			LOG_CORE_WARN("{}(): The most recent scene is still active, make sure to call Renderer2D::EndScene()!", __FUNCTION__);
 			EndScene();
 		}
 	}
@@ -159,10 +457,23 @@ namespace Battery {
 	void Renderer2D::DrawQuad(const VertexData& v1, const VertexData& v2, const VertexData& v3, const VertexData& v4, 
 			ShaderProgram* shaderProgram, int textureID) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "(): Rendering a quad now!");
+		LOG_CORE_TRACE("{}(): Rendering a quad now!", __FUNCTION__);
+
+		glm::vec2 corners[4] = { glm::vec2(v1.position), glm::vec2(v2.position), glm::vec2(v3.position),
+			glm::vec2(v4.position) };
+		if (Cull(glm::min(glm::min(corners[0], corners[1]), glm::min(corners[2], corners[3])),
+				glm::max(glm::max(corners[0], corners[1]), glm::max(corners[2], corners[3]))))
+			return;
+
+		FlushSprites();
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			LOG_CORE_WARN("{}(): Can't render quad: Shaders are not supported by the software backend!", __FUNCTION__);
+			return;
+		}
 
 		if (!shaderProgram->IsLoaded()) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't render quad: The supplied shader is not loaded!");
+			LOG_CORE_ERROR("{}(): Can't render quad: The supplied shader is not loaded!", __FUNCTION__);
 			return;
 		}
 
@@ -179,32 +490,44 @@ namespace Battery {
 			texture = data->currentScene->textures[textureID].GetAllegroBitmap();
 
 			if (texture == nullptr) {
-				LOG_WARN(__FUNCTION__ "(): The specified texture is not valid");
+				LOG_WARN("{}(): The specified texture is not valid", __FUNCTION__);
 			}
 		}
 		else {
 			if (textureID != -1) {
-				LOG_WARN(__FUNCTION__ "(): Invalid texture ID specified!");
+				LOG_WARN("{}(): Invalid texture ID specified!", __FUNCTION__);
 			}
 		}
 
 		// Render the quad
-		al_draw_indexed_prim(vertices, NULL, texture, indices, 6, ALLEGRO_PRIM_TRIANGLE_LIST);
+		DrawIndexed(vertices, 4, texture, indices, 6);
+		CountDrawCall(4);
 		data->quadShader->Release();
 	}
 
 	void Renderer2D::DrawLine(const glm::vec2& p1, const glm::vec2& p2, float thickness, const glm::vec4& color, float falloff) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "(): Drawing line");
+		LOG_CORE_TRACE("{}(): Drawing line", __FUNCTION__);
 
-		thickness = max(thickness, 0.f);
-		falloff = max(falloff, 0.f);
+		thickness = std::max(thickness, 0.f);
+		falloff = std::max(falloff, 0.f);
 
 		glm::vec2 atob = glm::normalize(p2 - p1);
 		glm::vec2 anorm = glm::vec2(atob.y, -atob.x);
 
 		float r = thickness / 2;
 
+		if (Cull(glm::min(p1, p2) - r, glm::max(p1, p2) + r))
+			return;
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			if (color.w != 0.f) {
+				data->rasterizer->DrawLine(p1, p2, thickness, color, falloff);
+				CountDrawCall(4);
+			}
+			return;
+		}
+
 		data->currentScene->lineShader->Use();
 		data->currentScene->lineShader->SetUniformFloat("line_p1", p1);
 		data->currentScene->lineShader->SetUniformFloat("line_p2", p2);
@@ -217,20 +540,22 @@ namespace Battery {
 		VertexData v4 = VertexData(glm::vec3(p2 + atob * r + anorm * r, 0), color);
 
 		// Line
-		if (color.w != 0.f)
+		if (color.w != 0.f) {
 			DrawQuad(v1, v2, v3, v4, data->currentScene->lineShader.get());
-		else
+		}
+		else {
 			LOG_CORE_TRACE("Line color alpha is 0: Skipping line");
+		}
 	}
 
 	void Renderer2D::DrawArc(const glm::vec2& center, float radius, float startAngle, float endAngle, float thickness,
 		const glm::vec4& color, float falloff) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "(): Rendering arc");
+		LOG_CORE_TRACE("{}(): Rendering arc", __FUNCTION__);
 
-		thickness = max(thickness, 0.f);
-		falloff = max(falloff, 0.f);
-		radius = max(radius, 0.f);
+		thickness = std::max(thickness, 0.f);
+		falloff = std::max(falloff, 0.f);
+		radius = std::max(radius, 0.f);
 		startAngle = glm::radians(startAngle - 360.f * floor(startAngle / 360.f));
 		endAngle = glm::radians(endAngle - 360.f * floor(endAngle / 360.f));
 
@@ -239,9 +564,20 @@ namespace Battery {
 		glm::vec2 toTop = glm::vec2(0, 1) * radius + glm::vec2(0, margin);
 		glm::vec2 toRight = glm::vec2(1, 0) * radius + glm::vec2(margin, 0);
 
+		if (Cull(center - glm::vec2(radius + margin), center + glm::vec2(radius + margin)))
+			return;
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			if (color.w != 0.f) {
+				data->rasterizer->DrawArc(center, radius, startAngle, endAngle, thickness, color, falloff);
+				CountDrawCall(4);
+			}
+			return;
+		}
+
 		if (!data->currentScene->arcShader->IsLoaded()) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't render circle: Circle shader is not loaded!"
-				" Make sure a valid scene is active!");
+			LOG_CORE_ERROR("{}(): Can't render circle: Circle shader is not loaded!"
+				" Make sure a valid scene is active!", __FUNCTION__);
 			return;
 		}
 
@@ -259,26 +595,42 @@ namespace Battery {
 		VertexData v4 = VertexData(glm::vec3(center - toRight - toTop, 0), color);
 
 		// Arc
-		if (color.w != 0.f)
+		if (color.w != 0.f) {
 			DrawQuad(v1, v2, v3, v4, data->currentScene->arcShader.get());
-		else
+		}
+		else {
 			LOG_CORE_TRACE("Arc color alpha is 0: Skipping arc");
+		}
 	}
 
 	void Renderer2D::DrawCircle(const glm::vec2& center, float radius, float outlineThickness,
 		const glm::vec4& outlineColor, const glm::vec4& fillColor, float falloff) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "(): Rendering circle");
+		LOG_CORE_TRACE("{}(): Rendering circle", __FUNCTION__);
 
-		radius = max(radius, 0.f);
-		falloff = max(falloff, 0.f);
+		radius = std::max(radius, 0.f);
+		falloff = std::max(falloff, 0.f);
 
 		glm::vec2 toTop = glm::vec2(0, 1) * radius;
 		glm::vec2 toRight = glm::vec2(1, 0) * radius;
 
+		glm::vec2 margin = glm::vec2(radius + std::max(outlineThickness, 0.f) / 2.f);
+		if (Cull(center - margin, center + margin))
+			return;
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			if (fillColor.w != 0.f) {
+				data->rasterizer->DrawCircle(center, radius, fillColor, falloff);
+				CountDrawCall(4);
+			}
+			if (outlineColor.w != 0.f)
+				DrawArc(center, radius, 0, 360, outlineThickness, outlineColor, falloff);
+			return;
+		}
+
 		if (!data->currentScene->circleShader->IsLoaded()) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't render circle: Circle shader is not loaded!"
-				" Make sure a valid scene is active!");
+			LOG_CORE_ERROR("{}(): Can't render circle: Circle shader is not loaded!"
+				" Make sure a valid scene is active!", __FUNCTION__);
 			return;
 		}
 
@@ -293,26 +645,34 @@ namespace Battery {
 		VertexData v4 = VertexData(glm::vec3(center - toRight - toTop, 0), fillColor);
 
 		// Fill
-		if (fillColor.w != 0.f)
+		if (fillColor.w != 0.f) {
 			DrawQuad(v1, v2, v3, v4, data->currentScene->circleShader.get());
-		else
+		}
+		else {
 			LOG_CORE_TRACE("Circle fillColor alpha is 0: Skipping fill");
+		}
 
 		// Outline
-		if (outlineColor.w != 0.f)
+		if (outlineColor.w != 0.f) {
 			DrawArc(center, radius, 0, 360, outlineThickness, outlineColor, falloff);
-		else
+		}
+		else {
 			LOG_CORE_TRACE("Circle outlineColor alpha is 0: Skipping outline");
+		}
 	}
 
 	void Renderer2D::DrawRectangle(const glm::vec2& point1, const glm::vec2& point2, float outlineThickness,
 			const glm::vec4& outlineColor, const glm::vec4& fillColor, float falloff) {
 		CHECK_INIT();
-		LOG_CORE_TRACE(__FUNCTION__ "(): Rendering rectangle");
+		LOG_CORE_TRACE("{}(): Rendering rectangle", __FUNCTION__);
+
+		glm::vec2 margin = glm::vec2(std::max(outlineThickness, 0.f) / 2.f);
+		if (Cull(glm::min(point1, point2) - margin, glm::max(point1, point2) + margin))
+			return;
 
-		if (!data->currentScene->rectangleShader->IsLoaded()) {
-			LOG_CORE_ERROR(__FUNCTION__ "(): Can't render rectangle: Rectangle shader is not loaded!"
-				" Make sure a valid scene is active!");
+		if (data->backend == RenderBackend::OPENGL && !data->currentScene->rectangleShader->IsLoaded()) {
+			LOG_CORE_ERROR("{}(): Can't render rectangle: Rectangle shader is not loaded!"
+				" Make sure a valid scene is active!", __FUNCTION__);
 			return;
 		}
 
@@ -322,23 +682,475 @@ namespace Battery {
 		VertexData v4 = VertexData(glm::vec3(point1.x, point2.y, 0), fillColor);
 
 		// Fill
-		if (fillColor.w != 0.f)
+		if (fillColor.w != 0.f && data->backend == RenderBackend::SOFTWARE) {
+			data->rasterizer->DrawRectangle(point1, point2, fillColor);
+			CountDrawCall(4);
+		}
+		else if (fillColor.w != 0.f) {
 			DrawQuad(v1, v2, v3, v4, data->currentScene->rectangleShader.get());
-		else
+		}
+		else {
 			LOG_CORE_TRACE("Rectangle fillColor alpha is 0: Skipping fill");
+		}
 
 		// Outline
 		if (outlineColor.w != 0.f) {
-			DrawLine({ point1.x, point1.y }, { point2.x, point1.y }, outlineThickness, outlineColor, falloff);
-			DrawLine({ point2.x, point1.y }, { point2.x, point2.y }, outlineThickness, outlineColor, falloff);
-			DrawLine({ point2.x, point2.y }, { point1.x, point2.y }, outlineThickness, outlineColor, falloff);
-			DrawLine({ point1.x, point2.y }, { point1.x, point1.y }, outlineThickness, outlineColor, falloff);
+			glm::vec2 corners[4] = { point1, { point2.x, point1.y }, point2, { point1.x, point2.y } };
+			StrokeStyle style;
+			style.thickness = outlineThickness;
+			style.falloff = falloff;
+			style.join = Graphics::LINEJOIN::MITER;
+			DrawPath(corners, 4, outlineColor, style);
 		}
 		else {
 			LOG_CORE_TRACE("Rectangle outlineColor alpha is 0: Skipping outline");
 		}
 	}
 
+	static StrokeStyle GetCurrentStrokeStyle(float thickness, float falloff) {
+		StrokeStyle style;
+		style.thickness = thickness;
+		style.falloff = falloff;
+		style.join = Graphics::GetLineJoin();
+		style.cap = Graphics::GetLineCap();
+		return style;
+	}
+
+	static void DrawStroke(const glm::vec2* points, size_t count, bool closed, const glm::vec4& color,
+			const StrokeStyle& style) {
+
+		if (data->currentScene == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't draw path: No scene is active!", __FUNCTION__);
+			return;
+		}
+
+		if (color.w == 0.f || points == nullptr || count == 0)
+			return;
+
+		glm::vec2 min = points[0];
+		glm::vec2 max = points[0];
+		for (size_t i = 1; i < count; i++) {
+			min = glm::min(min, points[i]);
+			max = glm::max(max, points[i]);
+		}
+
+		// Miters can reach further than half the thickness
+		float margin = style.thickness / 2.f * std::max(style.miterLimit, 1.5f);
+		if (Cull(min - margin, max + margin))
+			return;
+
+		Renderer2D::FlushSprites();
+
+		data->pathVertices.clear();
+		data->pathIndices.clear();
+		data->tessellator.Tessellate(points, count, closed, style, color, data->pathVertices, data->pathIndices);
+		if (data->pathIndices.empty())
+			return;
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			data->rasterizer->DrawTriangles(data->pathVertices.data(), data->pathIndices.data(), data->pathIndices.size());
+		}
+		else {
+			al_use_shader(NULL);
+			DrawIndexed(data->pathVertices.data(), data->pathVertices.size(), NULL, data->pathIndices.data(),
+				data->pathIndices.size());
+		}
+
+		CountDrawCall(data->pathVertices.size());
+	}
+
+	void Renderer2D::DrawPolyline(const std::vector<glm::vec2>& points, float thickness, const glm::vec4& color,
+			float falloff) {
+		CHECK_INIT();
+		DrawStroke(points.data(), points.size(), false, color, GetCurrentStrokeStyle(thickness, falloff));
+	}
+
+	void Renderer2D::DrawPolyline(const glm::vec2* points, size_t count, const glm::vec4& color,
+			const StrokeStyle& style) {
+		CHECK_INIT();
+		DrawStroke(points, count, false, color, style);
+	}
+
+	void Renderer2D::DrawPath(const std::vector<glm::vec2>& points, float thickness, const glm::vec4& color,
+			float falloff) {
+		CHECK_INIT();
+		DrawStroke(points.data(), points.size(), true, color, GetCurrentStrokeStyle(thickness, falloff));
+	}
+
+	void Renderer2D::DrawPath(const glm::vec2* points, size_t count, const glm::vec4& color, const StrokeStyle& style) {
+		CHECK_INIT();
+		DrawStroke(points, count, true, color, style);
+	}
+
+	void Renderer2D::DrawPlotLine(PlotSeries& series, const glm::dvec2& dataMin, const glm::dvec2& dataMax,
+			const glm::vec2& point1, const glm::vec2& point2, float thickness, const glm::vec4& color, float falloff) {
+		CHECK_INIT();
+
+		if (dataMax.x <= dataMin.x || dataMax.y == dataMin.y) {
+			LOG_CORE_WARN("{}(): Can't draw plot line: The data range is empty!", __FUNCTION__);
+			return;
+		}
+
+		int columns = (int)std::ceil(std::abs(point2.x - point1.x));
+		const std::vector<glm::dvec2>& samples = series.Decimate(dataMin.x, dataMax.x, columns);
+
+		glm::dvec2 scale = glm::dvec2(point2 - point1) / (dataMax - dataMin);
+		data->plotPoints.resize(samples.size());
+		for (size_t i = 0; i < samples.size(); i++) {
+			data->plotPoints[i] = glm::dvec2(point1) + (samples[i] - dataMin) * scale;
+		}
+
+		DrawStroke(data->plotPoints.data(), data->plotPoints.size(), false, color,
+			GetCurrentStrokeStyle(thickness, falloff));
+	}
+
+	// Source coordinates are in pixels, like Allegro expects them
+	static void QueueSprite(ALLEGRO_BITMAP* texture, const glm::vec2& point1, const glm::vec2& point2,
+			const glm::vec2& source1, const glm::vec2& source2, uint32_t color) {
+
+		if (Cull(glm::min(point1, point2), glm::max(point1, point2)))
+			return;
+
+		// Sprites of all textures are queued, FlushSprites() sorts them into batches
+		if (texture != data->spriteTexture || data->spriteTextures.empty()) {
+			auto it = data->spriteTextureSlots.find(texture);
+			if (it == data->spriteTextureSlots.end()) {
+				if (data->spriteTextures.size() >= SPRITE_MAX_TEXTURES)
+					Renderer2D::FlushSprites();
+				it = data->spriteTextureSlots.emplace(texture, (uint16_t)data->spriteTextures.size()).first;
+				data->spriteTextures.push_back(texture);
+			}
+			data->spriteTexture = texture;
+			data->spriteTextureSlot = it->second;
+		}
+
+		data->spriteVertices.push_back({ point1.x, point1.y, source1.x, source1.y, color });
+		data->spriteVertices.push_back({ point2.x, point1.y, source2.x, source1.y, color });
+		data->spriteVertices.push_back({ point2.x, point2.y, source2.x, source2.y, color });
+		data->spriteVertices.push_back({ point1.x, point2.y, source1.x, source2.y, color });
+		data->spriteKeys.push_back(data->sortOrder | data->spriteTextureSlot);
+	}
+
+	// Every sprite gets the lowest step which keeps it behind all earlier sprites it may overlap: the same step
+	// for the same texture, a higher one otherwise. A coarse grid over the target finds the candidates, sprites
+	// sharing a cell count as overlapping. Per cell, it keeps the highest step and the highest one of another texture
+	static void AssignSpriteSteps() {
+
+		struct Cell {
+			int64_t step = -1;
+			int64_t otherStep = -1;
+			uint16_t texture = 0;
+		};
+		Cell cells[SPRITE_STEP_GRID * SPRITE_STEP_GRID];
+
+		glm::vec2 viewSize = glm::max(data->viewMax - data->viewMin, glm::vec2(1.f));
+		glm::vec2 cellSize = viewSize / (float)SPRITE_STEP_GRID;
+
+		for (size_t i = 0; i < data->spriteKeys.size(); i++) {
+			const SpriteVertex& first = data->spriteVertices[i * 4];
+			const SpriteVertex& last = data->spriteVertices[i * 4 + 2];
+			glm::vec2 min = (glm::min(glm::vec2(first.x, first.y), glm::vec2(last.x, last.y)) - data->viewMin) / cellSize;
+			glm::vec2 max = (glm::max(glm::vec2(first.x, first.y), glm::vec2(last.x, last.y)) - data->viewMin) / cellSize;
+			glm::ivec2 cellMin = glm::clamp(glm::ivec2(glm::floor(min)), glm::ivec2(0), glm::ivec2(SPRITE_STEP_GRID - 1));
+			glm::ivec2 cellMax = glm::clamp(glm::ivec2(glm::floor(max)), glm::ivec2(0), glm::ivec2(SPRITE_STEP_GRID - 1));
+			uint16_t texture = (uint16_t)(data->spriteKeys[i] & 0xFFFF);
+
+			int64_t step = 0;
+			for (int y = cellMin.y; y <= cellMax.y; y++) {
+				for (int x = cellMin.x; x <= cellMax.x; x++) {
+					const Cell& cell = cells[y * SPRITE_STEP_GRID + x];
+					if (cell.step >= 0)
+						step = std::max(step, cell.texture == texture ? std::max(cell.step, cell.otherStep + 1) : cell.step + 1);
+				}
+			}
+			step = std::min<int64_t>(step, SPRITE_KEY_MAX_STEP);
+
+			for (int y = cellMin.y; y <= cellMax.y; y++) {
+				for (int x = cellMin.x; x <= cellMax.x; x++) {
+					Cell& cell = cells[y * SPRITE_STEP_GRID + x];
+					if (cell.step >= 0 && cell.texture != texture)
+						cell.otherStep = cell.step;
+					cell.step = step;
+					cell.texture = texture;
+				}
+			}
+
+			data->spriteKeys[i] |= (uint64_t)step << SPRITE_KEY_STEP_SHIFT;
+		}
+	}
+
+	// Stable LSD radix sort of the sprite numbers by their keys, bytes which are the same in all keys are skipped
+	static void SortSprites() {
+
+		size_t count = data->spriteKeys.size();
+		std::vector<uint64_t>& keys = data->spriteKeys;
+		std::vector<uint32_t>& sprites = data->sortedSprites;
+		sprites.resize(count);
+		std::iota(sprites.begin(), sprites.end(), 0);
+
+		uint64_t varying = 0;
+		for (uint64_t key : keys) {
+			varying |= key ^ keys[0];
+		}
+
+		data->sortTempKeys.resize(count);
+		data->sortTempSprites.resize(count);
+
+		for (int shift = 0; shift < 64; shift += 8) {
+			if (((varying >> shift) & 0xFF) == 0)
+				continue;
+
+			size_t offsets[256] = {};
+			for (uint64_t key : keys) {
+				offsets[(key >> shift) & 0xFF]++;
+			}
+			size_t sum = 0;
+			for (size_t& offset : offsets) {
+				size_t bucket = offset;
+				offset = sum;
+				sum += bucket;
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				size_t destination = offsets[(keys[i] >> shift) & 0xFF]++;
+				data->sortTempKeys[destination] = keys[i];
+				data->sortTempSprites[destination] = sprites[i];
+			}
+			keys.swap(data->sortTempKeys);
+			sprites.swap(data->sortTempSprites);
+		}
+	}
+
+	void Renderer2D::DrawTexture(const glm::vec2& point1, const glm::vec2& point2, const Texture2D& texture,
+			const glm::vec4& tint) {
+		CHECK_INIT();
+
+		ALLEGRO_BITMAP* bitmap = texture.GetAllegroBitmap();
+		if (bitmap == nullptr) {
+			LOG_CORE_WARN("{}(): Can't draw texture: The texture is not valid!", __FUNCTION__);
+			return;
+		}
+
+		if (data->currentScene == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't draw texture: No scene is active!", __FUNCTION__);
+			return;
+		}
+
+		glm::vec2 size = { al_get_bitmap_width(bitmap), al_get_bitmap_height(bitmap) };
+		QueueSprite(bitmap, point1, point2, { 0, 0 }, size, PixelConvert::PackColor(tint));
+	}
+
+	void Renderer2D::DrawTexture(const glm::vec2& point1, const glm::vec2& point2, const MipmapChain& mipmaps,
+			const glm::vec4& tint) {
+		CHECK_INIT();
+
+		if (!mipmaps.IsValid()) {
+			LOG_CORE_WARN("{}(): Can't draw texture: The mipmap chain is empty!", __FUNCTION__);
+			return;
+		}
+
+		const Texture2D* level = mipmaps.GetLevel(mipmaps.SelectLevel(point2 - point1)).Get();
+		DrawTexture(point1, point2, *level, tint);
+	}
+
+	void Renderer2D::DrawSprite(const glm::vec2& point1, const glm::vec2& point2, const TextureAtlas& atlas,
+			const AtlasRegion& region, const glm::vec4& tint) {
+		CHECK_INIT();
+
+		if (!atlas.IsValid(region)) {
+			LOG_CORE_WARN("{}(): Can't draw sprite: The atlas region was evicted!", __FUNCTION__);
+			return;
+		}
+
+		if (data->currentScene == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't draw sprite: No scene is active!", __FUNCTION__);
+			return;
+		}
+
+		glm::vec2 source1 = { region.rect.x, region.rect.y };
+		glm::vec2 source2 = source1 + glm::vec2(region.rect.width, region.rect.height);
+		QueueSprite(atlas.GetPageBitmap(region.page), point1, point2, source1, source2, PixelConvert::PackColor(tint));
+	}
+
+	void Renderer2D::DrawTiledImage(TiledImage& image, const glm::vec2& position, float scale, const glm::vec4& tint) {
+		CHECK_INIT();
+
+		if (!image.IsOpen()) {
+			LOG_CORE_WARN("{}(): Can't draw tiled image: The image is not open!", __FUNCTION__);
+			return;
+		}
+
+		if (data->currentScene == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't draw tiled image: No scene is active!", __FUNCTION__);
+			return;
+		}
+
+		// Tiles are uploaded into the cache texture, which must not happen while it's still referenced by queued sprites
+		PrepareTextureUpdate(image.GetCacheBitmap());
+
+		glm::vec2 viewSize;
+		if (data->backend == RenderBackend::SOFTWARE) {
+			viewSize = { data->rasterizer->GetWidth(), data->rasterizer->GetHeight() };
+		}
+		else {
+			ALLEGRO_BITMAP* target = al_get_target_bitmap();
+			viewSize = { al_get_bitmap_width(target), al_get_bitmap_height(target) };
+		}
+
+		data->tileQuads.clear();
+		image.CollectVisibleTiles(position, scale, { 0, 0 }, viewSize, data->tileQuads);
+
+		ALLEGRO_BITMAP* cache = image.GetCacheBitmap();
+		uint32_t packedTint = PixelConvert::PackColor(tint);
+		for (const TileQuad& quad : data->tileQuads) {
+			QueueSprite(cache, quad.point1, quad.point2, quad.source1, quad.source2, packedTint);
+		}
+	}
+
+	void Renderer2D::DrawString(Font& font, const std::string& text, const glm::vec2& position, float size,
+			const glm::vec4& color) {
+		CHECK_INIT();
+
+		if (!font.IsLoaded()) {
+			LOG_CORE_WARN("{}(): Can't draw text: The font is not loaded!", __FUNCTION__);
+			return;
+		}
+
+		if (data->currentScene == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't draw text: No scene is active!", __FUNCTION__);
+			return;
+		}
+
+		// Glyphs at their rasterized size are only sharp on whole pixels
+		int pixelSize = std::max((int)std::round(size), 1);
+		float scale = size / pixelSize;
+		glm::vec2 origin = scale == 1.f ? glm::round(position) : position;
+
+		const TextRun& run = font.Shape(text, pixelSize);
+		if (run.glyphs.empty() || Cull(origin + run.boundsMin * scale, origin + run.boundsMax * scale))
+			return;
+
+		const TextureAtlas& atlas = font.GetAtlas();
+		uint32_t packedColor = PixelConvert::PackColor(color);
+		for (const GlyphQuad& glyph : run.glyphs) {
+			glm::vec2 source1 = { glyph.region.rect.x, glyph.region.rect.y };
+			glm::vec2 source2 = source1 + glm::vec2(glyph.region.rect.width, glyph.region.rect.height);
+			QueueSprite(atlas.GetPageBitmap(glyph.region.page), origin + glyph.point1 * scale, origin + glyph.point2 * scale,
+				source1, source2, packedColor);
+		}
+	}
+
+	void Renderer2D::FlushSprites() {
+		CHECK_INIT();
+
+		if (data->spriteKeys.empty())
+			return;
+
+		size_t count = data->spriteKeys.size();
+		LOG_CORE_TRACE("{}(): Drawing {} sprites with {} textures", __FUNCTION__, count, data->spriteTextures.size());
+
+		// Drawn in submission order, every change of the texture would be a batch
+		size_t unsortedBatches = 1;
+		for (size_t i = 1; i < count; i++) {
+			if ((data->spriteKeys[i] & 0xFFFF) != (data->spriteKeys[i - 1] & 0xFFFF))
+				unsortedBatches++;
+		}
+
+		// A single texture only needs sorting when layers or depths were set
+		if (data->spriteTextures.size() > 1)
+			AssignSpriteSteps();
+		SortSprites();
+
+		// Every run of sprites with the same texture is one batch
+		data->spriteIndices.resize(count * 6);
+		for (size_t i = 0; i < count; i++) {
+			int first = (int)data->sortedSprites[i] * 4;
+			int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+			std::copy(quad, quad + 6, &data->spriteIndices[i * 6]);
+		}
+
+		// All batches are written at once, they only differ in the range of indices
+		int firstIndex = -1;
+		bool draw = true;
+		if (data->backend != RenderBackend::SOFTWARE) {
+			if (data->spriteDecl == nullptr) {
+				data->spriteDecl = al_create_vertex_decl(SPRITE_VERTEX_ELEMENTS, sizeof(SpriteVertex));
+				data->spriteStream = std::make_unique<StreamBuffer>(data->spriteDecl, sizeof(SpriteVertex));
+			}
+
+			// The color is a user attribute, only the sprite shader reads it
+			if (data->currentScene != nullptr && data->currentScene->spriteShader->IsLoaded()) {
+				data->currentScene->spriteShader->Use();
+				firstIndex = data->spriteStream->Write(data->spriteVertices.data(), data->spriteVertices.size(),
+					data->spriteIndices.data(), data->spriteIndices.size());
+				if (firstIndex >= 0)
+					data->stats.streamedBytes += data->spriteVertices.size() * sizeof(SpriteVertex) +
+						data->spriteIndices.size() * sizeof(int);
+			}
+			else {
+				LOG_CORE_ERROR("{}(): Can't draw sprites: The sprite shader is not loaded!"
+					" Make sure a valid scene is active!", __FUNCTION__);
+				draw = false;
+			}
+		}
+
+		size_t batches = 0;
+		for (size_t begin = 0; draw && begin < count;) {
+			uint64_t slot = data->spriteKeys[begin] & 0xFFFF;
+			size_t end = begin + 1;
+			while (end < count && (data->spriteKeys[end] & 0xFFFF) == slot)
+				end++;
+
+			ALLEGRO_BITMAP* texture = data->spriteTextures[slot];
+			if (data->backend == RenderBackend::SOFTWARE) {
+				for (size_t i = begin; i < end; i++) {
+					const SpriteVertex& first = data->spriteVertices[(size_t)data->sortedSprites[i] * 4];
+					const SpriteVertex& last = data->spriteVertices[(size_t)data->sortedSprites[i] * 4 + 2];
+					data->rasterizer->DrawBitmap({ first.x, first.y }, { last.x, last.y }, texture,
+						{ first.u, first.v }, { last.u, last.v }, PixelConvert::UnpackColor(first.color));
+				}
+			}
+			else if (firstIndex >= 0) {
+				data->spriteStream->Draw(texture, firstIndex + (int)begin * 6, (int)(end - begin) * 6);
+			}
+			else {
+				al_draw_indexed_prim(data->spriteVertices.data(), data->spriteDecl, texture,
+					&data->spriteIndices[begin * 6], (int)((end - begin) * 6), ALLEGRO_PRIM_TRIANGLE_LIST);
+			}
+
+			CountDrawCall((end - begin) * 4);
+			batches++;
+			begin = end;
+		}
+
+		if (draw) {
+			data->stats.sprites += count;
+			data->stats.spriteBatches += batches;
+			// Layers and depths can need more batches than the submission order, that is nothing saved
+			if (unsortedBatches > batches)
+				data->stats.batchesSaved += unsortedBatches - batches;
+		}
+
+		data->spriteVertices.clear();
+		data->spriteKeys.clear();
+		data->spriteTextures.clear();
+		data->spriteTextureSlots.clear();
+		data->spriteTexture = nullptr;
+	}
+
+	void Renderer2D::PrepareTextureUpdate(ALLEGRO_BITMAP* bitmap) {
+		if (data == nullptr)
+			return;
+
+		FlushSprites();
+
+		// The software backend reads the pixels once per flush
+		if (data->backend == RenderBackend::SOFTWARE) {
+			data->framebuffer->InvalidateImage(bitmap);
+			data->offscreen->InvalidateImage(bitmap);
+		}
+	}
+
 
 
 
@@ -348,11 +1160,33 @@ namespace Battery {
 
 	void Renderer2D::DrawBackground(const glm::vec4& color) {
 		CHECK_INIT();
+		FlushSprites();
+
+		CountDrawCall(0);
+
+		if (data->backend == RenderBackend::SOFTWARE) {
+			data->rasterizer->Clear(color);
+			return;
+		}
+
 		al_clear_to_color(ConvertAllegroColor(color));
 	}
 
 	void Renderer2D::DrawPrimitiveLine(const glm::vec2& p1, const glm::vec2& p2, float thickness, const glm::vec4& color) {
 		CHECK_INIT();
+
+		float r = std::max(thickness, 1.f) / 2.f;
+		if (Cull(glm::min(p1, p2) - r, glm::max(p1, p2) + r))
+			return;
+
+		FlushSprites();
+		CountDrawCall(thickness > 0.f ? 4 : 2);
+
+		if (data->backend == RenderBackend::SOFTWARE) {		// A thickness of 0 is a hairline for Allegro
+			data->rasterizer->DrawLine(p1, p2, thickness > 0.f ? thickness : 1.f, color, 0.f);
+			return;
+		}
+
 		al_draw_line(p1.x, p1.y, p2.x, p2.y, ConvertAllegroColor(color), thickness);
 	}
 
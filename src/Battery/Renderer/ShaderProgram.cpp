@@ -31,7 +31,7 @@ namespace Battery {
 
 
 	bool ShaderProgram::Load(ALLEGRO_DISPLAY* display, const std::string& vertexShader, const std::string& fragmentShader) {
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		this->display = display;
 
@@ -97,7 +97,7 @@ namespace Battery {
 	}
 
 	bool ShaderProgram::LoadSource(ALLEGRO_DISPLAY* display, const std::string& vertexShader, const std::string& fragmentShader) {
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (display == nullptr)
 			throw Battery::Exception("The Allegro display pointer is NULL!");
@@ -156,7 +156,7 @@ namespace Battery {
 	}
 
 	void ShaderProgram::Unload() {
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (loaded) {
 
@@ -176,14 +176,14 @@ namespace Battery {
 
 	void ShaderProgram::Use() {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 		al_use_shader(shader);
 	}
 
 	void ShaderProgram::Release() {
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 		al_use_shader(NULL);
 	}
 
@@ -197,9 +197,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformSampler(const char* name, ALLEGRO_BITMAP* texture, int ID) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 		if (!al_set_shader_sampler(name, texture, ID)) {
 			LOG_CORE_WARN("WARNING: The Shader Sampler uniform '{}' was not set correctly or is not being used!", name);
 			return false;
@@ -210,9 +210,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformMatrix(const char* name, glm::mat4 matrix) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		ALLEGRO_TRANSFORM m;
 		for (int x = 0; x < 4; x++)
@@ -229,9 +229,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformInt(const char* name, int n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_int(name, n)) {
 			LOG_CORE_WARN("WARNING: The Shader Integer uniform '{}' was not set correctly or is not being used!", name);
@@ -243,9 +243,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformInt(const char* name, glm::ivec2 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_int_vector(name, 2, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Integer uniform '{}' was not set correctly or is not being used!", name);
@@ -257,9 +257,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformInt(const char* name, glm::ivec3 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_int_vector(name, 3, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Integer uniform '{}' was not set correctly or is not being used!", name);
@@ -271,9 +271,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformInt(const char* name, glm::ivec4 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_int_vector(name, 4, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Integer uniform '{}' was not set correctly or is not being used!", name);
@@ -285,9 +285,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformFloat(const char* name, float n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_float(name, n)) {
 			LOG_CORE_WARN("WARNING: The Shader Float uniform '{}' was not set correctly or is not being used!", name);
@@ -299,9 +299,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformFloat(const char* name, glm::vec2 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_float_vector(name, 2, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Float uniform '{}' was not set correctly or is not being used!", name);
@@ -313,9 +313,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformFloat(const char* name, glm::vec3 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_float_vector(name, 3, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Float uniform '{}' was not set correctly or is not being used!", name);
@@ -327,9 +327,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformFloat(const char* name, glm::vec4 n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_float_vector(name, 4, &n[0], 1)) {
 			LOG_CORE_WARN("WARNING: The Shader Float uniform '{}' was not set correctly or is not being used!", name);
@@ -341,9 +341,9 @@ namespace Battery {
 
 	bool ShaderProgram::SetUniformBool(const char* name, bool n) {
 		if (!loaded)
-			throw Battery::Exception(__FUNCTION__"(): ShaderProgram was not loaded!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): ShaderProgram was not loaded!");
 
-		LOG_CORE_TRACE(__FUNCTION__ "()");
+		LOG_CORE_TRACE("{}()", __FUNCTION__);
 
 		if (!al_set_shader_bool(name, n)) {
 			LOG_CORE_WARN("WARNING: The Shader Bool uniform '{}' was not set correctly or is not being used!", name);
@@ -0,0 +1,117 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/SharedTexture.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	SharedTexture::SharedTexture() {
+	}
+
+	SharedTexture::SharedTexture(Texture2D&& texture) {
+		this->texture = std::make_shared<Texture2D>(std::move(texture));
+		owned = true;
+	}
+
+	SharedTexture::SharedTexture(std::shared_ptr<const Texture2D> texture) : texture(std::move(texture)) {
+	}
+
+	SharedTexture::SharedTexture(const std::string& path, int flags) {
+		Load(path, flags);
+	}
+
+	bool SharedTexture::Load(const std::string& path, int flags) {
+
+		// The old texture is simply released, other handles keep it alive
+		if (AssetCache::IsInitialized()) {
+			texture = AssetCache::LoadTexture(path, flags);
+			owned = false;
+			return texture != nullptr;
+		}
+
+		auto loaded = std::make_shared<Texture2D>();
+		if (!loaded->Load(path, flags)) {
+			texture = nullptr;
+			return false;
+		}
+
+		texture = std::move(loaded);
+		owned = true;
+		return true;
+	}
+
+	bool SharedTexture::SetFlags(int flags) {
+
+		if (!IsValid())
+			return false;
+
+		if (owned && texture.use_count() == 1)
+			return GetMutable().SetFlags(flags);
+
+		// Shared, clone directly with the new flags instead of cloning twice
+		auto copy = std::make_shared<Texture2D>();
+		if (!copy->Load(texture->GetAllegroBitmap(), flags)) {
+			LOG_CORE_ERROR("{}(): Failed to clone texture with new flags", __FUNCTION__);
+			return false;
+		}
+
+		texture = std::move(copy);
+		owned = true;
+		return true;
+	}
+
+	const Texture2D* SharedTexture::Get() const {
+		return texture.get();
+	}
+
+	const Texture2D* SharedTexture::operator->() const {
+		return texture.get();
+	}
+
+	Texture2D& SharedTexture::GetMutable() {
+
+		if (!texture) {
+			texture = std::make_shared<Texture2D>();
+			owned = true;
+		}
+		else if (!owned || texture.use_count() > 1) {
+			texture = std::make_shared<Texture2D>(*texture);
+			owned = true;
+		}
+
+		// Only textures which were created as non-const by this class end up here
+		return const_cast<Texture2D&>(*texture);
+	}
+
+	ALLEGRO_BITMAP* SharedTexture::GetAllegroBitmap() const {
+		if (!texture)
+			return nullptr;
+		return texture->GetAllegroBitmap();
+	}
+
+	int SharedTexture::GetWidth() const {
+		if (!texture)
+			return 0;
+		return texture->GetWidth();
+	}
+
+	int SharedTexture::GetHeight() const {
+		if (!texture)
+			return 0;
+		return texture->GetHeight();
+	}
+
+	bool SharedTexture::IsValid() const {
+		return texture != nullptr && texture->IsValid();
+	}
+
+	bool SharedTexture::IsShared() const {
+		return texture != nullptr && (!owned || texture.use_count() > 1);
+	}
+
+	long SharedTexture::GetUseCount() const {
+		return texture.use_count();
+	}
+
+}
@@ -0,0 +1,864 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/SoftwareRasterizer.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Utils/ThreadPool.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Battery/Log/Log.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BATTERY_RASTERIZER_SSE2
+#endif
+
+namespace Battery {
+
+	static constexpr int TILE_SIZE = BATTERY_SOFTWARE_RENDERER_TILE_SIZE;
+	static_assert(TILE_SIZE % 4 == 0, "The tile size of the software renderer must be a multiple of 4");
+
+	enum class RasterCommandType {
+		CLEAR,
+		LINE,
+		CIRCLE,
+		ARC,
+		RECTANGLE,
+		BITMAP,
+		TRIANGLES
+	};
+
+	// Bins refer to single triangles instead of their command, so a long polyline only costs where it is
+	static constexpr uint32_t TRIANGLE_BIT = 0x80000000;
+
+	struct RasterImage {
+		int width = 0;
+		int height = 0;
+		std::vector<uint32_t> pixels;
+	};
+
+	struct RasterCommand {
+		RasterCommandType type = RasterCommandType::CLEAR;
+		glm::ivec2 min = { 0, 0 };		// Affected pixels [min, max)
+		glm::ivec2 max = { 0, 0 };
+		glm::vec4 color = { 0, 0, 0, 0 };	// Normalized to 0-1
+		glm::vec2 p1 = { 0, 0 };
+		glm::vec2 p2 = { 0, 0 };
+		float radius = 0.f;
+		float halfThickness = 0.f;
+		float falloff = 0.f;
+		float startAngle = 0.f;
+		float endAngle = 0.f;
+		const RasterImage* image = nullptr;
+		glm::vec2 source1 = { 0, 0 };
+		glm::vec2 source2 = { 0, 0 };
+		size_t firstTriangle = 0;
+		size_t triangleCount = 0;
+	};
+
+	// The tile is kept as 4 planes of floats (red, green, blue, alpha) while its commands are applied
+	static float* GetPlane(float* buffer, int channel) {
+		return buffer + (size_t)channel * TILE_SIZE * TILE_SIZE;
+	}
+
+	// Like the shaders: Fully opaque up to (b - falloff), linear to 0 at the distance b
+	static float GetCoverage(float distance, float b, float falloff) {
+		if (falloff <= 0.f)
+			return distance <= b ? 1.f : 0.f;
+		return std::clamp((b - distance) / falloff, 0.f, 1.f);
+	}
+
+	// Blends a flat color over the pixels [x0, x1) of a row, the alpha of every pixel is coverage * alphaScale.
+	// Without coverage, alphaScale is used directly. The blend mode is the one of the window,
+	// (ALLEGRO_ADD, ALLEGRO_ALPHA, ALLEGRO_INVERSE_ALPHA), which is applied to alpha as well
+	static void BlendSpan(float* buffer, int y, int x0, int x1, const glm::vec4& color, const float* coverage,
+			float alphaScale) {
+
+		size_t row = (size_t)y * TILE_SIZE;
+		float* red = GetPlane(buffer, 0) + row;
+		float* green = GetPlane(buffer, 1) + row;
+		float* blue = GetPlane(buffer, 2) + row;
+		float* alpha = GetPlane(buffer, 3) + row;
+		int x = x0;
+
+#ifdef BATTERY_RASTERIZER_SSE2
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 scale = _mm_set1_ps(alphaScale);
+		const __m128 r = _mm_set1_ps(color.r);
+		const __m128 g = _mm_set1_ps(color.g);
+		const __m128 b = _mm_set1_ps(color.b);
+
+		for (; x + 4 <= x1; x += 4) {
+			__m128 a = coverage ? _mm_mul_ps(_mm_loadu_ps(coverage + x), scale) : scale;
+			__m128 inverse = _mm_sub_ps(one, a);
+			_mm_storeu_ps(red + x, _mm_add_ps(_mm_mul_ps(r, a), _mm_mul_ps(_mm_loadu_ps(red + x), inverse)));
+			_mm_storeu_ps(green + x, _mm_add_ps(_mm_mul_ps(g, a), _mm_mul_ps(_mm_loadu_ps(green + x), inverse)));
+			_mm_storeu_ps(blue + x, _mm_add_ps(_mm_mul_ps(b, a), _mm_mul_ps(_mm_loadu_ps(blue + x), inverse)));
+			_mm_storeu_ps(alpha + x, _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(_mm_loadu_ps(alpha + x), inverse)));
+		}
+#endif
+
+		for (; x < x1; x++) {
+			float a = coverage ? coverage[x] * alphaScale : alphaScale;
+			red[x] = color.r * a + red[x] * (1.f - a);
+			green[x] = color.g * a + green[x] * (1.f - a);
+			blue[x] = color.b * a + blue[x] * (1.f - a);
+			alpha[x] = a * a + alpha[x] * (1.f - a);
+		}
+	}
+
+#ifdef BATTERY_RASTERIZER_SSE2
+	static __m128 GetCoverage4(__m128 distance, float b, float falloff) {
+		if (falloff <= 0.f)
+			return _mm_and_ps(_mm_cmple_ps(distance, _mm_set1_ps(b)), _mm_set1_ps(1.f));
+
+		__m128 value = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(b), distance), _mm_set1_ps(1.f / falloff));
+		return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	}
+#endif
+
+	// Coverage of count pixels starting at pixel center (px, py), count is a multiple of 4
+	static void LineCoverage(const RasterCommand& command, float px, float py, int count, float* coverage) {
+
+		glm::vec2 ab = command.p2 - command.p1;
+		float lengthSquared = glm::dot(ab, ab);
+		float inverseLength = lengthSquared != 0.f ? 1.f / lengthSquared : 0.f;
+		float apy = py - command.p1.y;
+
+#ifdef BATTERY_RASTERIZER_SSE2
+		// The distance to the closest point on the segment, 4 pixels at once
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 abx = _mm_set1_ps(ab.x);
+		const __m128 aby = _mm_set1_ps(ab.y);
+		const __m128 dy = _mm_set1_ps(apy);
+		const __m128 projectedY = _mm_set1_ps(apy * ab.y);
+		__m128 apx = _mm_add_ps(_mm_set1_ps(px - command.p1.x), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+
+		for (int i = 0; i < count; i += 4) {
+			__m128 h = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(apx, abx), projectedY), _mm_set1_ps(inverseLength));
+			h = _mm_min_ps(_mm_max_ps(h, zero), one);
+			__m128 x = _mm_sub_ps(apx, _mm_mul_ps(abx, h));
+			__m128 y = _mm_sub_ps(dy, _mm_mul_ps(aby, h));
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+			_mm_storeu_ps(coverage + i, GetCoverage4(distance, command.halfThickness, command.falloff));
+			apx = _mm_add_ps(apx, _mm_set1_ps(4.f));
+		}
+#else
+		for (int i = 0; i < count; i++) {
+			glm::vec2 ap = { px + i - command.p1.x, apy };
+			float h = std::clamp(glm::dot(ap, ab) * inverseLength, 0.f, 1.f);
+			coverage[i] = GetCoverage(glm::length(ap - ab * h), command.halfThickness, command.falloff);
+		}
+#endif
+	}
+
+	static void CircleCoverage(const RasterCommand& command, float px, float py, int count, float* coverage) {
+
+		float dy = py - command.p1.y;
+
+#ifdef BATTERY_RASTERIZER_SSE2
+		const __m128 dySquared = _mm_set1_ps(dy * dy);
+		__m128 dx = _mm_add_ps(_mm_set1_ps(px - command.p1.x), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+
+		for (int i = 0; i < count; i += 4) {
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), dySquared));
+			_mm_storeu_ps(coverage + i, GetCoverage4(distance, command.radius, command.falloff));
+			dx = _mm_add_ps(dx, _mm_set1_ps(4.f));
+		}
+#else
+		for (int i = 0; i < count; i++) {
+			float dx = px + i - command.p1.x;
+			coverage[i] = GetCoverage(std::sqrt(dx * dx + dy * dy), command.radius, command.falloff);
+		}
+#endif
+	}
+
+	// The angle test needs atan2 per pixel, which is evaluated scalar
+	static float ArcCoverage(const RasterCommand& command, const glm::vec2& point) {
+
+		glm::vec2 centerToPoint = point - command.p1;
+		float angle = std::atan2(centerToPoint.y, -centerToPoint.x) + (float)M_PI;
+		float start = command.startAngle;
+		float end = command.endAngle;
+
+		bool inside = start < end ? (angle >= start && angle <= end) : (angle <= end || angle >= start);
+		float distance;
+
+		if (inside) {
+			distance = std::abs(command.radius - glm::length(centerToPoint));
+		}
+		else {
+			glm::vec2 p1 = command.p1 + glm::vec2(std::cos(start), -std::sin(start)) * command.radius;
+			glm::vec2 p2 = command.p1 + glm::vec2(std::cos(end), -std::sin(end)) * command.radius;
+			distance = std::min(glm::distance(point, p1), glm::distance(point, p2));
+		}
+
+		return GetCoverage(distance, command.halfThickness, command.falloff);
+	}
+
+	// The horizontal range of a row which can be covered at all, so long diagonal lines don't cost their bounding box
+	static bool GetRowSpan(const RasterCommand& command, float py, float& minX, float& maxX) {
+
+		if (command.type == RasterCommandType::LINE) {
+			float r = command.halfThickness;
+			glm::vec2 ab = command.p2 - command.p1;
+
+			// The part of the segment within [py - r, py + r], widened by r
+			float t0 = 0.f;
+			float t1 = 1.f;
+			if (ab.y != 0.f) {
+				t0 = (py - r - command.p1.y) / ab.y;
+				t1 = (py + r - command.p1.y) / ab.y;
+				if (t0 > t1)
+					std::swap(t0, t1);
+				t0 = std::max(t0, 0.f);
+				t1 = std::min(t1, 1.f);
+				if (t0 > t1)
+					return false;
+			}
+
+			float x0 = command.p1.x + ab.x * t0;
+			float x1 = command.p1.x + ab.x * t1;
+			minX = std::min(x0, x1) - r;
+			maxX = std::max(x0, x1) + r;
+			return true;
+		}
+
+		// Circles and arcs
+		float r = command.radius + command.halfThickness;
+		float dy = py - command.p1.y;
+		if (std::abs(dy) > r)
+			return false;
+
+		float halfWidth = std::sqrt(r * r - dy * dy);
+		minX = command.p1.x - halfWidth;
+		maxX = command.p1.x + halfWidth;
+		return true;
+	}
+
+	static void BlendBitmap(float* buffer, int y, int x0, int x1, const glm::vec2& pixel, const RasterCommand& command) {
+
+		const RasterImage& image = *command.image;
+		glm::vec2 size = command.p2 - command.p1;
+		glm::vec2 sourceSize = command.source2 - command.source1;
+
+		size_t row = (size_t)y * TILE_SIZE;
+		float* red = GetPlane(buffer, 0) + row;
+		float* green = GetPlane(buffer, 1) + row;
+		float* blue = GetPlane(buffer, 2) + row;
+		float* alpha = GetPlane(buffer, 3) + row;
+
+		// Nearest neighbour sampling at the pixel centers
+		float v = command.source1.y + (pixel.y - command.p1.y) / size.y * sourceSize.y;
+		int texelY = std::clamp((int)std::floor(v), 0, image.height - 1);
+		const uint32_t* texels = &image.pixels[(size_t)texelY * image.width];
+
+		for (int x = x0; x < x1; x++) {
+			float u = command.source1.x + (pixel.x + (x - x0) - command.p1.x) / size.x * sourceSize.x;
+			uint32_t texel = texels[std::clamp((int)std::floor(u), 0, image.width - 1)];
+
+			float a = (texel >> 24) / 255.f * command.color.a;
+			red[x] = (texel & 0xFF) / 255.f * command.color.r * a + red[x] * (1.f - a);
+			green[x] = ((texel >> 8) & 0xFF) / 255.f * command.color.g * a + green[x] * (1.f - a);
+			blue[x] = ((texel >> 16) & 0xFF) / 255.f * command.color.b * a + blue[x] * (1.f - a);
+			alpha[x] = a * a + alpha[x] * (1.f - a);
+		}
+	}
+
+
+
+
+
+	// Positive when c is on the left of a to b, on screen with y pointing down
+	static float EdgeFunction(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) {
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	// Pixels whose centers lie within [min, max], or [min, max) for filled quads like on the GPU,
+	// limited to the clip rectangle [clipMin, clipMax)
+	static bool SetBounds(RasterCommand& command, const glm::vec2& min, const glm::vec2& max,
+			const glm::ivec2& clipMin, const glm::ivec2& clipMax, bool exclusive = false) {
+		command.min.x = std::max((int)std::ceil(min.x - 0.5f), clipMin.x);
+		command.min.y = std::max((int)std::ceil(min.y - 0.5f), clipMin.y);
+		if (exclusive) {
+			command.max.x = std::min((int)std::ceil(max.x - 0.5f), clipMax.x);
+			command.max.y = std::min((int)std::ceil(max.y - 0.5f), clipMax.y);
+		}
+		else {
+			command.max.x = std::min((int)std::floor(max.x - 0.5f) + 1, clipMax.x);
+			command.max.y = std::min((int)std::floor(max.y - 0.5f) + 1, clipMax.y);
+		}
+		return command.min.x < command.max.x && command.min.y < command.max.y;
+	}
+
+	static bool CoversTile(const RasterCommand& command, int tileX, int tileY, int width, int height) {
+		glm::ivec2 min = { tileX * TILE_SIZE, tileY * TILE_SIZE };
+		glm::ivec2 max = glm::min(min + TILE_SIZE, glm::ivec2(width, height));
+		return command.min.x <= min.x && command.min.y <= min.y && command.max.x >= max.x && command.max.y >= max.y;
+	}
+
+	static bool GetTriangleBounds(const ALLEGRO_VERTEX* vertices, const int* indices, const glm::ivec2& clipMin,
+			const glm::ivec2& clipMax, RasterCommand& bounds) {
+		glm::vec2 min = { vertices[indices[0]].x, vertices[indices[0]].y };
+		glm::vec2 max = min;
+		for (int k = 1; k < 3; k++) {
+			glm::vec2 point = { vertices[indices[k]].x, vertices[indices[k]].y };
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+		return SetBounds(bounds, min, max, clipMin, clipMax, false);
+	}
+
+
+
+
+
+	SoftwareRasterizer::SoftwareRasterizer() {
+	}
+
+	SoftwareRasterizer::SoftwareRasterizer(int width, int height) {
+		Resize(width, height);
+	}
+
+	SoftwareRasterizer::~SoftwareRasterizer() {
+	}
+
+	void SoftwareRasterizer::Resize(int width, int height) {
+
+		width = std::max(width, 0);
+		height = std::max(height, 0);
+
+		if (width == this->width && height == this->height)
+			return;
+
+		commands.clear();
+		images.clear();
+		retiredImages.clear();
+		triangleVertices.clear();
+		triangleIndices.clear();
+		this->width = width;
+		this->height = height;
+		pixels.assign((size_t)width * height, 0);
+		ResetClipRect();
+	}
+
+	int SoftwareRasterizer::GetWidth() const {
+		return width;
+	}
+
+	int SoftwareRasterizer::GetHeight() const {
+		return height;
+	}
+
+	void SoftwareRasterizer::SetClipRect(const glm::ivec2& min, const glm::ivec2& max) {
+		clipMin = glm::clamp(min, glm::ivec2(0), glm::ivec2(width, height));
+		clipMax = glm::clamp(max, clipMin, glm::ivec2(width, height));
+	}
+
+	void SoftwareRasterizer::ResetClipRect() {
+		clipMin = { 0, 0 };
+		clipMax = { width, height };
+	}
+
+	void SoftwareRasterizer::Clear(const glm::vec4& color) {
+		RasterCommand command;
+		command.type = RasterCommandType::CLEAR;
+		command.min = clipMin;
+		command.max = clipMax;
+		command.color = glm::clamp(color, 0.f, 255.f) / 255.f;
+		if (clipMin.x < clipMax.x && clipMin.y < clipMax.y)
+			commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawLine(const glm::vec2& p1, const glm::vec2& p2, float thickness, const glm::vec4& color,
+			float falloff) {
+
+		RasterCommand command;
+		command.type = RasterCommandType::LINE;
+		command.color = glm::clamp(color, 0.f, 255.f) / 255.f;
+		command.p1 = p1;
+		command.p2 = p2;
+		command.halfThickness = std::max(thickness, 0.f) / 2.f;
+		command.falloff = std::max(falloff, 0.f);
+
+		glm::vec2 margin = glm::vec2(command.halfThickness);
+		if (SetBounds(command, glm::min(p1, p2) - margin, glm::max(p1, p2) + margin, clipMin, clipMax))
+			commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawCircle(const glm::vec2& center, float radius, const glm::vec4& color, float falloff) {
+
+		RasterCommand command;
+		command.type = RasterCommandType::CIRCLE;
+		command.color = glm::clamp(color, 0.f, 255.f) / 255.f;
+		command.p1 = center;
+		command.radius = std::max(radius, 0.f);
+		command.falloff = std::max(falloff, 0.f);
+
+		glm::vec2 margin = glm::vec2(command.radius);
+		if (SetBounds(command, center - margin, center + margin, clipMin, clipMax))
+			commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawArc(const glm::vec2& center, float radius, float startAngle, float endAngle,
+			float thickness, const glm::vec4& color, float falloff) {
+
+		RasterCommand command;
+		command.type = RasterCommandType::ARC;
+		command.color = glm::clamp(color, 0.f, 255.f) / 255.f;
+		command.p1 = center;
+		command.halfThickness = std::max(thickness, 0.f) / 2.f;
+		command.radius = std::max(radius, 0.f);
+		command.falloff = std::max(falloff, 0.f);
+		command.startAngle = startAngle;
+		command.endAngle = endAngle;
+
+		glm::vec2 margin = glm::vec2(command.radius + command.halfThickness);
+		if (SetBounds(command, center - margin, center + margin, clipMin, clipMax))
+			commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawRectangle(const glm::vec2& point1, const glm::vec2& point2, const glm::vec4& color) {
+
+		RasterCommand command;
+		command.type = RasterCommandType::RECTANGLE;
+		command.color = glm::clamp(color, 0.f, 255.f) / 255.f;
+
+		if (SetBounds(command, glm::min(point1, point2), glm::max(point1, point2), clipMin, clipMax, true))
+			commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawTriangles(const ALLEGRO_VERTEX* vertices, const int* indices, size_t indexCount) {
+
+		RasterCommand command;
+		command.type = RasterCommandType::TRIANGLES;
+		command.firstTriangle = triangleIndices.size() / 3;
+		command.triangleCount = indexCount / 3;
+		command.min = clipMin;				// The triangles are clipped to it when they are binned
+		command.max = clipMax;
+
+		if (command.triangleCount == 0 || clipMin.x >= clipMax.x || clipMin.y >= clipMax.y)
+			return;
+
+		// The vertices are copied, indices are made relative to the copy
+		int offset = (int)triangleVertices.size();
+		int maxIndex = 0;
+		for (size_t i = 0; i < command.triangleCount * 3; i++) {
+			maxIndex = std::max(maxIndex, indices[i]);
+			triangleIndices.push_back(indices[i] + offset);
+		}
+		triangleVertices.insert(triangleVertices.end(), vertices, vertices + maxIndex + 1);
+
+		commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::DrawBitmap(const glm::vec2& point1, const glm::vec2& point2, ALLEGRO_BITMAP* bitmap,
+			const glm::vec2& source1, const glm::vec2& source2, const glm::vec4& tint) {
+
+		if (point1.x == point2.x || point1.y == point2.y)
+			return;
+
+		RasterCommand command;
+		command.type = RasterCommandType::BITMAP;
+		command.color = glm::clamp(tint, 0.f, 255.f) / 255.f;
+		command.p1 = point1;
+		command.p2 = point2;
+		command.source1 = source1;
+		command.source2 = source2;
+
+		if (!SetBounds(command, glm::min(point1, point2), glm::max(point1, point2), clipMin, clipMax, true))
+			return;
+
+		command.image = GetImage(bitmap);
+		if (command.image == nullptr) {
+			LOG_CORE_WARN("{}(): Can't draw bitmap: The pixels could not be read!", __FUNCTION__);
+			return;
+		}
+
+		commands.push_back(command);
+	}
+
+	void SoftwareRasterizer::Flush() {
+		PROFILE_CORE_SCOPE("SoftwareRasterizer::Flush()");
+
+		double start = TimeUtils::GetRuntime();
+		int columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+		int rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+		// Sort the commands into the tiles they touch, everything before a clear is irrelevant
+		if (columns == 0 || rows == 0) {
+			commands.clear();
+			images.clear();
+			retiredImages.clear();
+			triangleVertices.clear();
+			triangleIndices.clear();
+			triangleBounds.clear();
+			return;
+		}
+
+		std::vector<std::vector<uint32_t>> bins((size_t)columns * rows);
+		size_t binned = 0;
+		triangleBounds.resize(triangleIndices.size() / 3);
+
+		for (size_t i = 0; i < commands.size(); i++) {
+			const RasterCommand& command = commands[i];
+
+			if (command.type == RasterCommandType::TRIANGLES) {
+				for (size_t t = command.firstTriangle; t < command.firstTriangle + command.triangleCount; t++) {
+					RasterCommand bounds;
+					bool visible = GetTriangleBounds(&triangleVertices[0], &triangleIndices[t * 3], command.min, command.max,
+						bounds);
+					triangleBounds[t] = glm::ivec4(bounds.min, bounds.max);
+					if (!visible)
+						continue;
+					for (int y = bounds.min.y / TILE_SIZE; y <= (bounds.max.y - 1) / TILE_SIZE; y++) {
+						for (int x = bounds.min.x / TILE_SIZE; x <= (bounds.max.x - 1) / TILE_SIZE; x++) {
+							bins[(size_t)y * columns + x].push_back(TRIANGLE_BIT | (uint32_t)t);
+							binned++;
+						}
+					}
+				}
+				continue;
+			}
+
+			int lastColumn = (command.max.x - 1) / TILE_SIZE;
+			int lastRow = (command.max.y - 1) / TILE_SIZE;
+
+			for (int y = command.min.y / TILE_SIZE; y <= lastRow; y++) {
+				for (int x = command.min.x / TILE_SIZE; x <= lastColumn; x++) {
+					std::vector<uint32_t>& bin = bins[(size_t)y * columns + x];
+					if (command.type == RasterCommandType::CLEAR && CoversTile(command, x, y, width, height)) {
+						binned -= bin.size();
+						bin.clear();
+					}
+					bin.push_back((uint32_t)i);
+					binned++;
+				}
+			}
+		}
+
+		ThreadPool::GetShared().ParallelFor(bins.size(), [&](size_t begin, size_t end) {
+			std::vector<float> buffer((size_t)TILE_SIZE * TILE_SIZE * 4);
+			for (size_t i = begin; i < end; i++) {
+				if (!bins[i].empty())
+					RasterizeTile((int)(i % columns), (int)(i / columns), bins[i], buffer.data());
+			}
+		});
+
+		stats.flushedCommands = commands.size();
+		stats.binnedCommands = binned;
+		stats.tiles = bins.size();
+		stats.flushTime = TimeUtils::GetRuntime() - start;
+
+		commands.clear();
+		images.clear();
+		retiredImages.clear();
+		triangleVertices.clear();
+		triangleIndices.clear();
+		triangleBounds.clear();
+	}
+
+	void SoftwareRasterizer::RasterizeTile(int tileX, int tileY, const std::vector<uint32_t>& commandIndices,
+			float* buffer) {
+
+		glm::ivec2 origin = { tileX * TILE_SIZE, tileY * TILE_SIZE };
+		int tileWidth = std::min(TILE_SIZE, width - origin.x);
+		int tileHeight = std::min(TILE_SIZE, height - origin.y);
+
+		// A tile starting with a clear of all of its pixels does not need the previous content
+		bool startsWithClear = !(commandIndices[0] & TRIANGLE_BIT) &&
+			commands[commandIndices[0]].type == RasterCommandType::CLEAR &&
+			CoversTile(commands[commandIndices[0]], tileX, tileY, width, height);
+		if (!startsWithClear) {
+			for (int y = 0; y < tileHeight; y++) {
+				const uint32_t* source = &pixels[(size_t)(origin.y + y) * width + origin.x];
+				for (int x = 0; x < tileWidth; x++) {
+					size_t index = (size_t)y * TILE_SIZE + x;
+					GetPlane(buffer, 0)[index] = (source[x] & 0xFF) / 255.f;
+					GetPlane(buffer, 1)[index] = ((source[x] >> 8) & 0xFF) / 255.f;
+					GetPlane(buffer, 2)[index] = ((source[x] >> 16) & 0xFF) / 255.f;
+					GetPlane(buffer, 3)[index] = (source[x] >> 24) / 255.f;
+				}
+			}
+		}
+
+		float coverage[TILE_SIZE];
+
+		for (uint32_t commandIndex : commandIndices) {
+			if (commandIndex & TRIANGLE_BIT) {
+				RasterizeTriangle(commandIndex & ~TRIANGLE_BIT, origin, tileWidth, tileHeight, buffer);
+				continue;
+			}
+
+			const RasterCommand& command = commands[commandIndex];
+
+			// The part of the command within this tile, in tile coordinates
+			int x0 = std::max(command.min.x - origin.x, 0);
+			int y0 = std::max(command.min.y - origin.y, 0);
+			int x1 = std::min(command.max.x - origin.x, tileWidth);
+			int y1 = std::min(command.max.y - origin.y, tileHeight);
+
+			bool hasRowSpan = command.type == RasterCommandType::LINE || command.type == RasterCommandType::CIRCLE ||
+				command.type == RasterCommandType::ARC;
+
+			for (int y = y0; y < y1; y++) {
+				int spanX0 = x0;
+				int spanX1 = x1;
+
+				if (hasRowSpan) {
+					float minX, maxX;
+					if (!GetRowSpan(command, origin.y + y + 0.5f, minX, maxX))
+						continue;
+					spanX0 = std::max(spanX0, (int)std::floor(minX) - origin.x);
+					spanX1 = std::min(spanX1, (int)std::ceil(maxX) + 1 - origin.x);
+					if (spanX0 >= spanX1)
+						continue;
+				}
+
+				// Coverage is evaluated in groups of 4 pixels, pixels outside of the span get none
+				int groupX0 = spanX0 & ~3;
+				int groupX1 = (spanX1 + 3) & ~3;
+				glm::vec2 pixel = glm::vec2(origin.x + spanX0, origin.y + y) + glm::vec2(0.5f);
+				float groupX = (float)(origin.x + groupX0) + 0.5f;
+
+				switch (command.type) {
+
+				case RasterCommandType::CLEAR:
+					for (int c = 0; c < 4; c++) {
+						std::fill_n(GetPlane(buffer, c) + (size_t)y * TILE_SIZE + spanX0, spanX1 - spanX0, command.color[c]);
+					}
+					break;
+
+				case RasterCommandType::RECTANGLE:
+					BlendSpan(buffer, y, spanX0, spanX1, command.color, nullptr, command.color.a);
+					break;
+
+				// Like in the shaders, the alpha of lines, circles and arcs only depends on the distance
+				case RasterCommandType::LINE:
+				case RasterCommandType::CIRCLE:
+					if (command.type == RasterCommandType::LINE)
+						LineCoverage(command, groupX, pixel.y, groupX1 - groupX0, coverage + groupX0);
+					else
+						CircleCoverage(command, groupX, pixel.y, groupX1 - groupX0, coverage + groupX0);
+
+					std::fill(coverage + groupX0, coverage + spanX0, 0.f);
+					std::fill(coverage + spanX1, coverage + groupX1, 0.f);
+					BlendSpan(buffer, y, groupX0, groupX1, command.color, coverage, 1.f);
+					break;
+
+				case RasterCommandType::ARC:
+					for (int x = spanX0; x < spanX1; x++) {
+						coverage[x] = ArcCoverage(command, { pixel.x + (x - spanX0), pixel.y });
+					}
+					BlendSpan(buffer, y, spanX0, spanX1, command.color, coverage, 1.f);
+					break;
+
+				case RasterCommandType::BITMAP:
+					BlendBitmap(buffer, y, spanX0, spanX1, pixel, command);
+					break;
+
+				case RasterCommandType::TRIANGLES:		// Binned per triangle
+					break;
+				}
+			}
+		}
+
+		for (int y = 0; y < tileHeight; y++) {
+			uint32_t* destination = &pixels[(size_t)(origin.y + y) * width + origin.x];
+			for (int x = 0; x < tileWidth; x++) {
+				size_t index = (size_t)y * TILE_SIZE + x;
+				uint32_t value = 0;
+				for (int c = 0; c < 4; c++) {
+					float channel = std::clamp(GetPlane(buffer, c)[index], 0.f, 1.f);
+					value |= (uint32_t)(channel * 255.f + 0.5f) << (c * 8);
+				}
+				destination[x] = value;
+			}
+		}
+	}
+
+	// Pixel centers inside the triangle are covered, pixels on an edge belong to only one of two adjacent triangles
+	void SoftwareRasterizer::RasterizeTriangle(size_t triangle, const glm::ivec2& origin, int tileWidth, int tileHeight,
+			float* buffer) {
+
+		const int* indices = &triangleIndices[triangle * 3];
+		glm::vec2 p[3];
+		glm::vec4 c[3];
+		for (int k = 0; k < 3; k++) {
+			const ALLEGRO_VERTEX& vertex = triangleVertices[indices[k]];
+			p[k] = { vertex.x, vertex.y };
+			c[k] = { vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a };
+		}
+
+		float area = EdgeFunction(p[0], p[1], p[2]);
+		if (area == 0.f)
+			return;
+		if (area < 0.f) {
+			std::swap(p[1], p[2]);
+			std::swap(c[1], c[2]);
+			area = -area;
+		}
+
+		const glm::ivec4& bounds = triangleBounds[triangle];
+		int x0 = std::max(bounds.x - origin.x, 0);
+		int y0 = std::max(bounds.y - origin.y, 0);
+		int x1 = std::min(bounds.z - origin.x, tileWidth);
+		int y1 = std::min(bounds.w - origin.y, tileHeight);
+
+		// Edge k is opposite of vertex k, its weight is the barycentric coordinate of that vertex
+		glm::vec2 edgeStart[3] = { p[1], p[2], p[0] };
+		glm::vec2 edgeEnd[3] = { p[2], p[0], p[1] };
+		bool includesEdge[3];
+		for (int k = 0; k < 3; k++) {
+			glm::vec2 delta = edgeEnd[k] - edgeStart[k];
+			includesEdge[k] = delta.y > 0.f || (delta.y == 0.f && delta.x < 0.f);
+		}
+
+		float inverseArea = 1.f / area;
+
+		for (int y = y0; y < y1; y++) {
+			size_t row = (size_t)y * TILE_SIZE;
+			float* red = GetPlane(buffer, 0) + row;
+			float* green = GetPlane(buffer, 1) + row;
+			float* blue = GetPlane(buffer, 2) + row;
+			float* alpha = GetPlane(buffer, 3) + row;
+
+			for (int x = x0; x < x1; x++) {
+				glm::vec2 pixel = glm::vec2(origin.x + x, origin.y + y) + glm::vec2(0.5f);
+
+				float weights[3];
+				bool inside = true;
+				for (int k = 0; k < 3 && inside; k++) {
+					weights[k] = EdgeFunction(edgeStart[k], edgeEnd[k], pixel);
+					inside = weights[k] > 0.f || (weights[k] == 0.f && includesEdge[k]);
+				}
+				if (!inside)
+					continue;
+
+				glm::vec4 color = (c[0] * weights[0] + c[1] * weights[1] + c[2] * weights[2]) * inverseArea;
+				float a = std::clamp(color.a, 0.f, 1.f);
+				red[x] = color.r * a + red[x] * (1.f - a);
+				green[x] = color.g * a + green[x] * (1.f - a);
+				blue[x] = color.b * a + blue[x] * (1.f - a);
+				alpha[x] = a * a + alpha[x] * (1.f - a);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::InvalidateImage(ALLEGRO_BITMAP* bitmap) {
+
+		// Recorded commands still point to the old copy
+		auto it = images.find(bitmap);
+		if (it != images.end()) {
+			retiredImages.push_back(std::move(it->second));
+			images.erase(it);
+		}
+	}
+
+	const RasterImage* SoftwareRasterizer::GetImage(ALLEGRO_BITMAP* bitmap) {
+
+		if (bitmap == nullptr)
+			return nullptr;
+
+		auto it = images.find(bitmap);
+		if (it != images.end())
+			return it->second.get();
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+		if (region == nullptr)
+			return nullptr;
+
+		auto image = std::make_unique<RasterImage>();
+		image->width = al_get_bitmap_width(bitmap);
+		image->height = al_get_bitmap_height(bitmap);
+		image->pixels.resize((size_t)image->width * image->height);
+
+		for (int y = 0; y < image->height; y++) {
+			memcpy(&image->pixels[(size_t)y * image->width], (const uint8_t*)region->data + (ptrdiff_t)y * region->pitch,
+				(size_t)image->width * 4);
+		}
+		al_unlock_bitmap(bitmap);
+
+		if (image->pixels.empty())
+			return nullptr;
+
+		return images.emplace(bitmap, std::move(image)).first->second.get();
+	}
+
+	const std::vector<uint32_t>& SoftwareRasterizer::GetPixels() const {
+		return pixels;
+	}
+
+	bool SoftwareRasterizer::CopyFromBitmap(ALLEGRO_BITMAP* bitmap) {
+
+		if (bitmap == nullptr)
+			return false;
+
+		Resize(al_get_bitmap_width(bitmap), al_get_bitmap_height(bitmap));
+		commands.clear();
+		images.clear();
+		retiredImages.clear();
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+		if (region == nullptr)
+			return false;
+
+		for (int y = 0; y < height; y++) {
+			memcpy(&pixels[(size_t)y * width], (const uint8_t*)region->data + (ptrdiff_t)y * region->pitch, (size_t)width * 4);
+		}
+		al_unlock_bitmap(bitmap);
+
+		return true;
+	}
+
+	bool SoftwareRasterizer::CopyToBitmap(ALLEGRO_BITMAP* bitmap) const {
+
+		if (bitmap == nullptr || al_get_bitmap_width(bitmap) != width || al_get_bitmap_height(bitmap) != height) {
+			LOG_CORE_ERROR("{}(): Can't copy the pixels: The bitmap does not have the same size!", __FUNCTION__);
+			return false;
+		}
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+		if (region == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't copy the pixels: The bitmap could not be locked!", __FUNCTION__);
+			return false;
+		}
+
+		for (int y = 0; y < height; y++) {
+			memcpy((uint8_t*)region->data + (ptrdiff_t)y * region->pitch, &pixels[(size_t)y * width], (size_t)width * 4);
+		}
+		al_unlock_bitmap(bitmap);
+
+		return true;
+	}
+
+	bool SoftwareRasterizer::Save(const std::string& path) const {
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+		al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+		al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+		ALLEGRO_BITMAP* bitmap = al_create_bitmap(width, height);
+		al_restore_state(&state);
+
+		if (bitmap == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't save '{}': The bitmap could not be created!", __FUNCTION__, path);
+			return false;
+		}
+
+		bool success = CopyToBitmap(bitmap) && al_save_bitmap(path.c_str(), bitmap);
+		al_destroy_bitmap(bitmap);
+
+		if (!success) {
+			LOG_CORE_ERROR("{}(): Failed to save '{}'", __FUNCTION__, path);
+		}
+
+		return success;
+	}
+
+	SoftwareRasterizerStats SoftwareRasterizer::GetStats() const {
+		SoftwareRasterizerStats result = stats;
+		result.pendingCommands = commands.size();
+		return result;
+	}
+
+}
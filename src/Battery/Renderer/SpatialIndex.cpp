@@ -0,0 +1,164 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/SpatialIndex.h"
+
+namespace Battery {
+
+	static bool Intersects(const glm::vec2& minA, const glm::vec2& maxA, const glm::vec2& minB, const glm::vec2& maxB) {
+		return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y;
+	}
+
+	SpatialIndex::SpatialIndex() {
+	}
+
+	uint32_t SpatialIndex::Insert(const glm::vec2& min, const glm::vec2& max) {
+		itemMin.push_back(glm::min(min, max));
+		itemMax.push_back(glm::max(min, max));
+		dirty = true;
+		return (uint32_t)(itemMin.size() - 1);
+	}
+
+	void SpatialIndex::Clear() {
+		itemMin.clear();
+		itemMax.clear();
+		cellStart.clear();
+		cellItems.clear();
+		largeItems.clear();
+		visited.clear();
+		cells = { 0, 0 };
+		dirty = false;
+	}
+
+	size_t SpatialIndex::GetSize() const {
+		return itemMin.size();
+	}
+
+	glm::ivec2 SpatialIndex::GetCell(const glm::vec2& point) const {
+		glm::vec2 cell = glm::floor((point - origin) / cellSize);
+		cell = glm::clamp(cell, glm::vec2(0.f), glm::vec2(cells - 1));
+		return glm::ivec2(cell);
+	}
+
+	void SpatialIndex::Build() {
+		dirty = false;
+		cellStart.clear();
+		cellItems.clear();
+		largeItems.clear();
+		visited.assign(itemMin.size(), 0);
+		queryCounter = 0;
+
+		if (itemMin.empty()) {
+			cells = { 0, 0 };
+			return;
+		}
+
+		// Square cells, as many as needed for a few items per cell
+		glm::vec2 worldMin = itemMin[0];
+		glm::vec2 worldMax = itemMax[0];
+		for (size_t i = 1; i < itemMin.size(); i++) {
+			worldMin = glm::min(worldMin, itemMin[i]);
+			worldMax = glm::max(worldMax, itemMax[i]);
+		}
+
+		glm::vec2 extent = glm::max(worldMax - worldMin, glm::vec2(1e-6f));
+		float cellCount = std::clamp((float)itemMin.size() / BATTERY_SPATIAL_INDEX_ITEMS_PER_CELL, 1.f,
+			(float)BATTERY_SPATIAL_INDEX_MAX_CELLS);
+		float side = std::sqrt(extent.x * extent.y / cellCount);
+		cells.x = std::clamp((int)std::ceil(extent.x / side), 1, BATTERY_SPATIAL_INDEX_MAX_CELLS);
+		cells.y = std::clamp((int)std::ceil(extent.y / side), 1, BATTERY_SPATIAL_INDEX_MAX_CELLS / cells.x);
+		origin = worldMin;
+		cellSize = extent / glm::vec2(cells);
+
+		// Counting sort into the cells, items stay in ascending order within every cell
+		cellStart.assign((size_t)cells.x * cells.y + 1, 0);
+		for (int pass = 0; pass < 2; pass++) {
+			for (uint32_t item = 0; item < (uint32_t)itemMin.size(); item++) {
+				glm::ivec2 first = GetCell(itemMin[item]);
+				glm::ivec2 last = GetCell(itemMax[item]);
+
+				if ((size_t)(last.x - first.x + 1) * (last.y - first.y + 1) > BATTERY_SPATIAL_INDEX_LARGE_ITEM_CELLS) {
+					if (pass == 0)
+						largeItems.push_back(item);
+					continue;
+				}
+
+				for (int y = first.y; y <= last.y; y++) {
+					for (int x = first.x; x <= last.x; x++) {
+						size_t cell = (size_t)y * cells.x + x;
+						if (pass == 0)
+							cellStart[cell + 1]++;
+						else
+							cellItems[cellStart[cell]++] = item;
+					}
+				}
+			}
+
+			if (pass == 0) {
+				std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+				cellItems.resize(cellStart.back());
+			}
+		}
+
+		// The second pass moved every start to the end of its cell
+		std::copy_backward(cellStart.begin(), cellStart.end() - 1, cellStart.end());
+		cellStart[0] = 0;
+	}
+
+	const std::vector<uint32_t>& SpatialIndex::Query(const glm::vec2& queryMin, const glm::vec2& queryMax) {
+
+		if (dirty)
+			Build();
+
+		result.clear();
+		glm::vec2 min = glm::min(queryMin, queryMax);
+		glm::vec2 max = glm::max(queryMin, queryMax);
+
+		if (itemMin.empty())
+			return result;
+
+		glm::ivec2 first = GetCell(min);
+		glm::ivec2 last = GetCell(max);
+
+		// When most of the scene is visible, testing every item in order is faster than collecting and sorting
+		size_t candidates = largeItems.size();
+		for (int y = first.y; y <= last.y; y++) {
+			candidates += cellStart[(size_t)y * cells.x + last.x + 1] - cellStart[(size_t)y * cells.x + first.x];
+		}
+
+		if (candidates > itemMin.size() / 2) {
+			for (uint32_t item = 0; item < (uint32_t)itemMin.size(); item++) {
+				if (Intersects(itemMin[item], itemMax[item], min, max))
+					result.push_back(item);
+			}
+			return result;
+		}
+
+		if (++queryCounter == 0) {
+			std::fill(visited.begin(), visited.end(), 0);
+			queryCounter = 1;
+		}
+
+		for (int y = first.y; y <= last.y; y++) {
+			const uint32_t* items = cellItems.data();
+			size_t begin = cellStart[(size_t)y * cells.x + first.x];
+			size_t end = cellStart[(size_t)y * cells.x + last.x + 1];
+
+			for (size_t i = begin; i < end; i++) {
+				uint32_t item = items[i];
+				if (visited[item] != queryCounter && Intersects(itemMin[item], itemMax[item], min, max)) {
+					visited[item] = queryCounter;
+					result.push_back(item);
+				}
+			}
+		}
+
+		for (uint32_t item : largeItems) {
+			if (Intersects(itemMin[item], itemMax[item], min, max))
+				result.push_back(item);
+		}
+
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+}
@@ -0,0 +1,163 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/StreamBuffer.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	static constexpr size_t MAX_COUNT = std::numeric_limits<int>::max() / BATTERY_STREAM_BUFFER_FRAMES;
+
+	int StreamBuffer::Ring::Allocate(int count, size_t frame) {
+
+		if (count > capacity)
+			return -1;
+
+		// A range never wraps around, the rest of the buffer is skipped instead
+		uint64_t start = position;
+		int offset = (int)(start % capacity);
+		if (offset + count > capacity) {
+			start += capacity - offset;
+			offset = 0;
+		}
+
+		uint64_t oldestFrame = frameStarts[(frame + 1) % BATTERY_STREAM_BUFFER_FRAMES];
+		if (start + count > oldestFrame + capacity)
+			return -1;
+
+		position = start + count;
+		return offset;
+	}
+
+	StreamBuffer::StreamBuffer(ALLEGRO_VERTEX_DECL* decl, size_t vertexSize) : decl(decl), vertexSize(vertexSize) {
+	}
+
+	StreamBuffer::~StreamBuffer() {
+		Release();
+	}
+
+	int StreamBuffer::Write(const void* vertices, size_t vertexCount, const int* indices, size_t indexCount) {
+		return WriteGeometry(vertices, vertexCount, indices, indexCount);
+	}
+
+	int StreamBuffer::Write(const void* vertices, size_t vertexCount, const uint16_t* indices, size_t indexCount) {
+		return WriteGeometry(vertices, vertexCount, indices, indexCount);
+	}
+
+	// The buffer always holds 32-bit indices, they are rebased to the first vertex while being copied
+	template<typename T>
+	int StreamBuffer::WriteGeometry(const void* vertices, size_t vertexCount, const T* indices, size_t indexCount) {
+
+		if (unsupported || vertexCount == 0 || indexCount == 0 || vertexCount > MAX_COUNT || indexCount > MAX_COUNT)
+			return -1;
+
+		if (vertexBuffer == nullptr) {
+			if (al_get_current_display() == nullptr)
+				return -1;
+			if (!Create(BATTERY_STREAM_BUFFER_VERTICES, BATTERY_STREAM_BUFFER_INDICES))
+				return -1;
+		}
+
+		int vertexOffset = vertexRing.Allocate((int)vertexCount, frame);
+		int indexOffset = indexRing.Allocate((int)indexCount, frame);
+
+		// The frames in flight need more space, the old buffers are freed by the driver when it is done with them
+		if (vertexOffset < 0 || indexOffset < 0) {
+			int vertexCapacity = vertexRing.capacity;
+			int indexCapacity = indexRing.capacity;
+			if (vertexOffset < 0)
+				vertexCapacity = (int)std::min<int64_t>(std::max<int64_t>((int64_t)vertexCapacity * 2,
+					(int64_t)vertexCount * BATTERY_STREAM_BUFFER_FRAMES), std::numeric_limits<int>::max());
+			if (indexOffset < 0)
+				indexCapacity = (int)std::min<int64_t>(std::max<int64_t>((int64_t)indexCapacity * 2,
+					(int64_t)indexCount * BATTERY_STREAM_BUFFER_FRAMES), std::numeric_limits<int>::max());
+
+			LOG_CORE_TRACE("{}(): Growing the stream buffer to {} vertices and {} indices", __FUNCTION__,
+				vertexCapacity, indexCapacity);
+			if (!Create(vertexCapacity, indexCapacity))
+				return -1;
+
+			vertexOffset = vertexRing.Allocate((int)vertexCount, frame);
+			indexOffset = indexRing.Allocate((int)indexCount, frame);
+		}
+
+		void* vertexDestination = al_lock_vertex_buffer(vertexBuffer, vertexOffset, (int)vertexCount,
+			ALLEGRO_LOCK_WRITEONLY);
+		if (vertexDestination == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't lock the vertex buffer", __FUNCTION__);
+			return -1;
+		}
+		memcpy(vertexDestination, vertices, vertexCount * vertexSize);
+		al_unlock_vertex_buffer(vertexBuffer);
+
+		int* indexDestination = (int*)al_lock_index_buffer(indexBuffer, indexOffset, (int)indexCount,
+			ALLEGRO_LOCK_WRITEONLY);
+		if (indexDestination == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't lock the index buffer", __FUNCTION__);
+			return -1;
+		}
+		for (size_t i = 0; i < indexCount; i++) {
+			indexDestination[i] = (int)indices[i] + vertexOffset;
+		}
+		al_unlock_index_buffer(indexBuffer);
+
+		frameBytes += vertexCount * vertexSize + indexCount * sizeof(int);
+		return indexOffset;
+	}
+
+	void StreamBuffer::Draw(ALLEGRO_BITMAP* texture, int firstIndex, int indexCount, int type) {
+		al_draw_indexed_buffer(vertexBuffer, texture, indexBuffer, firstIndex, firstIndex + indexCount, type);
+	}
+
+	void StreamBuffer::NextFrame() {
+		frame++;
+		vertexRing.frameStarts[frame % BATTERY_STREAM_BUFFER_FRAMES] = vertexRing.position;
+		indexRing.frameStarts[frame % BATTERY_STREAM_BUFFER_FRAMES] = indexRing.position;
+		lastFrameBytes = frameBytes;
+		frameBytes = 0;
+	}
+
+	void StreamBuffer::Release() {
+		if (vertexBuffer != nullptr) {
+			al_destroy_vertex_buffer(vertexBuffer);
+			vertexBuffer = nullptr;
+		}
+		if (indexBuffer != nullptr) {
+			al_destroy_index_buffer(indexBuffer);
+			indexBuffer = nullptr;
+		}
+		vertexRing = Ring();
+		indexRing = Ring();
+	}
+
+	size_t StreamBuffer::GetFrameBytes() const {
+		return frameBytes;
+	}
+
+	size_t StreamBuffer::GetLastFrameBytes() const {
+		return lastFrameBytes;
+	}
+
+	size_t StreamBuffer::GetCapacityBytes() const {
+		return (size_t)vertexRing.capacity * vertexSize + (size_t)indexRing.capacity * sizeof(int);
+	}
+
+	bool StreamBuffer::Create(int vertexCapacity, int indexCapacity) {
+
+		Release();
+
+		vertexBuffer = al_create_vertex_buffer(decl, nullptr, vertexCapacity, ALLEGRO_PRIM_BUFFER_STREAM);
+		indexBuffer = al_create_index_buffer((int)sizeof(int), nullptr, indexCapacity, ALLEGRO_PRIM_BUFFER_STREAM);
+
+		if (vertexBuffer == nullptr || indexBuffer == nullptr) {
+			LOG_CORE_WARN("{}(): Vertex buffers are not supported, geometry is uploaded by every draw call", __FUNCTION__);
+			Release();
+			unsupported = true;
+			return false;
+		}
+
+		vertexRing.capacity = vertexCapacity;
+		indexRing.capacity = indexCapacity;
+		return true;
+	}
+
+}
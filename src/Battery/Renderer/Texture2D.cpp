@@ -2,18 +2,46 @@
 
 #include "Battery/pch.h"
 #include "Battery/Renderer/Texture2D.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Renderer/PixelConvert.h"
+#include "Battery/Renderer/TextureResidency.h"
 #include "Battery/Graphics.h"
 
 #undef LoadBitmap
 
 namespace Battery {
 
+	std::atomic<size_t> Texture2D::cloneCount = 0;
+
+	// Lock a bitmap in a 32-bit layout PixelConvert can handle. The native format is preferred
+	// so Allegro does not need to convert the pixels again, both layouts assume a little endian platform
+	static ALLEGRO_LOCKED_REGION* LockBitmap(ALLEGRO_BITMAP* bitmap, int mode, PixelConvert::PixelLayout& layout) {
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ANY_32_WITH_ALPHA, mode);
+		if (region != nullptr) {
+			switch (region->format) {
+			case ALLEGRO_PIXEL_FORMAT_ABGR_8888:
+			case ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE:
+				layout = PixelConvert::PixelLayout::RGBA8;
+				return region;
+			case ALLEGRO_PIXEL_FORMAT_ARGB_8888:
+				layout = PixelConvert::PixelLayout::BGRA8;
+				return region;
+			default:
+				al_unlock_bitmap(bitmap);
+				break;
+			}
+		}
+
+		layout = PixelConvert::PixelLayout::RGBA8;
+		return al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, mode);
+	}
+
 	Texture2D::Texture2D() {}
 
 	Texture2D::Texture2D(const Texture2D& texture) {
 		if (texture.allegroBitmap != nullptr) {
-			al_set_new_bitmap_flags(texture.GetFlags());
-			allegroBitmap = al_clone_bitmap(texture.allegroBitmap);
+			Adopt(Clone(texture.allegroBitmap, texture.GetFlags()));
 		}
 	}
 
@@ -21,12 +49,6 @@ namespace Battery {
 		Load(path, flags);
 	}
 
-	Texture2D::Texture2D(Texture2D& texture) {
-		if (texture.allegroBitmap != nullptr) {
-			allegroBitmap = al_clone_bitmap(texture.allegroBitmap);
-		}
-	}
-
 	Texture2D::Texture2D(Texture2D&& texture) noexcept {
 		if (texture.allegroBitmap != nullptr) {
 			allegroBitmap = texture.allegroBitmap;
@@ -42,11 +64,26 @@ namespace Battery {
 		const clip::image_spec& spec = image.spec();
 
 		if (!CreateBitmap(spec.width, spec.height, flags))
-			throw Battery::Exception(__FUNCTION__"(): Can't load image: Allegro Bitmap could not be created!");
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): Can't load image: Allegro Bitmap could not be created!");
 
-		LOG_CORE_TRACE(__FUNCTION__"(): Loading Battery::Texture2D from clip::image now!");
+		LOG_CORE_TRACE("{}(): Loading Battery::Texture2D from clip::image now!", __FUNCTION__);
 
-		// Now load the image data
+		// Common layouts are converted in bulk, directly into the locked bitmap
+		PixelConvert::PixelLayout layout = PixelConvert::GetLayout(spec);
+		if (layout != PixelConvert::PixelLayout::UNKNOWN) {
+			PixelConvert::PixelLayout bitmapLayout;
+			ALLEGRO_LOCKED_REGION* region = LockBitmap(allegroBitmap, ALLEGRO_LOCK_WRITEONLY, bitmapLayout);
+			if (region == nullptr)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Can't load image: Allegro Bitmap could not be locked!");
+
+			PixelConvert::ConvertImage(image.data(), spec.bytes_per_row, layout, region->data, region->pitch, bitmapLayout,
+				spec.width, spec.height, spec.alpha_mask == 0);
+
+			al_unlock_bitmap(allegroBitmap);
+			return;
+		}
+
+		// Any other layout is converted pixel by pixel
 		ALLEGRO_BITMAP* oldBuffer = al_get_target_bitmap();
 		al_set_target_bitmap(allegroBitmap);
 		al_lock_bitmap(allegroBitmap, al_get_bitmap_format(allegroBitmap), ALLEGRO_LOCK_WRITEONLY);
@@ -95,22 +132,31 @@ namespace Battery {
 
 	Texture2D::~Texture2D() {
 		if (!AllegroContext::GetInstance()->IsInitialized()) {
-			LOG_CORE_CRITICAL(__FUNCTION__"(): Can't destroy texture: The Allegro Context is not loaded anymore!"
-				" Make sure to unload or destroy the Texture2D object before Allegro is shut down!");
+			LOG_CORE_CRITICAL("{}(): Can't destroy texture: The Allegro Context is not loaded anymore!"
+				" Make sure to unload or destroy the Texture2D object before Allegro is shut down!", __FUNCTION__);
 		}
 
-		if (allegroBitmap != nullptr)
+		if (allegroBitmap != nullptr) {
+			if (TextureResidency::IsInitialized())
+				TextureResidency::Unregister(allegroBitmap);
 			al_destroy_bitmap(allegroBitmap);
+		}
 	}
 
 	void Texture2D::operator=(const Texture2D& texture) {
+		if (&texture == this)
+			return;
+
 		Unload();
 		if (texture.allegroBitmap != nullptr) {
-			allegroBitmap = al_clone_bitmap(texture.allegroBitmap);
+			Adopt(Clone(texture.allegroBitmap, texture.GetFlags()));
 		}
 	}
 
 	void Texture2D::operator=(Texture2D&& texture) {
+		if (&texture == this)
+			return;
+
 		Unload();
 		if (texture.allegroBitmap != nullptr) {
 			allegroBitmap = texture.allegroBitmap;
@@ -125,15 +171,17 @@ namespace Battery {
 
 		// If it's valid, unload first
 		if (allegroBitmap != nullptr) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Bitmap is already loaded, overwriting previous...");
+			LOG_CORE_TRACE("{}(): Bitmap is already loaded, overwriting previous...", __FUNCTION__);
 			Unload();
 		}
 
-		// Now load the new texture
-		al_set_new_bitmap_flags(flags);
-		allegroBitmap = al_load_bitmap(path.c_str());
+		// Now load the new texture, the asset cache avoids decoding the same content again
+		if (AssetCache::IsInitialized()) {
+			return Adopt(AssetCache::LoadBitmap(path, flags));
+		}
 
-		if (allegroBitmap == nullptr) {
+		al_set_new_bitmap_flags(flags);
+		if (!Adopt(al_load_bitmap(path.c_str()))) {
 			LOG_CORE_ERROR("Failed to load Allegro bitmap: '" + path + "'");
 			return false;
 		}
@@ -145,22 +193,38 @@ namespace Battery {
 
 		// If it's valid, unload first
 		if (allegroBitmap != nullptr) {
-			LOG_CORE_TRACE(__FUNCTION__"(): Bitmap is already loaded, overwriting previous...");
+			LOG_CORE_TRACE("{}(): Bitmap is already loaded, overwriting previous...", __FUNCTION__);
 			Unload();
 		}
 
 		// Now clone the new image
-		al_set_new_bitmap_flags(flags);
-		allegroBitmap = al_clone_bitmap(bitmap);
-		return allegroBitmap != nullptr;
+		return Adopt(Clone(bitmap, flags));
+	}
+
+	bool Texture2D::LoadPixels(const void* pixels, ptrdiff_t pitch, PixelConvert::PixelLayout layout, int width, int height,
+			int flags) {
+
+		if (!CreateBitmap(width, height, flags)) {
+			LOG_CORE_ERROR("{}(): Can't load pixels: Allegro Bitmap could not be created!", __FUNCTION__);
+			return false;
+		}
+
+		PixelConvert::PixelLayout bitmapLayout;
+		ALLEGRO_LOCKED_REGION* region = LockBitmap(allegroBitmap, ALLEGRO_LOCK_WRITEONLY, bitmapLayout);
+		if (region == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't load pixels: Allegro Bitmap could not be locked!", __FUNCTION__);
+			Unload();
+			return false;
+		}
+
+		PixelConvert::ConvertImage(pixels, pitch, layout, region->data, region->pitch, bitmapLayout, width, height);
+		al_unlock_bitmap(allegroBitmap);
+
+		return true;
 	}
 
 	bool Texture2D::SetFlags(int flags) {
-		al_set_new_bitmap_flags(flags);
-		ALLEGRO_BITMAP* temp = al_clone_bitmap(allegroBitmap);
-		al_destroy_bitmap(allegroBitmap);
-		allegroBitmap = temp;
-		return allegroBitmap != nullptr;
+		return Adopt(Clone(allegroBitmap, flags));
 	}
 
 	int Texture2D::GetFlags() const {
@@ -205,7 +269,7 @@ namespace Battery {
 		if (!IsValid())
 			return std::nullopt;
 
-		LOG_CORE_TRACE(__FUNCTION__"(): Generating clip::image now!");
+		LOG_CORE_TRACE("{}(): Generating clip::image now!", __FUNCTION__);
 
 		uint64_t width = al_get_bitmap_width(allegroBitmap);
 		uint64_t height = al_get_bitmap_height(allegroBitmap);
@@ -213,44 +277,26 @@ namespace Battery {
 		// Create an image with 8-bit RGBA values (32 bit per pixel)
 		std::vector<uint32_t> data(width * height, 0);
 
-		// Now load the image data
-		ALLEGRO_BITMAP* oldBuffer = al_get_target_bitmap();
-		al_set_target_bitmap(allegroBitmap);
-		al_lock_bitmap(allegroBitmap, al_get_bitmap_format(allegroBitmap), ALLEGRO_LOCK_READONLY);
-
-		for (int y = 0; y < height; y++) {
-			for (int x = 0; x < width; x++) {
-
-				glm::vec4 color = Graphics::ConvertAllegroColor(al_get_pixel(allegroBitmap, x, y));
-				data[y * width + x] = (uint32_t)color.a << 24 | 
-									  (uint32_t)color.b << 16 | 
-									  (uint32_t)color.g << 8 | 
-									  (uint32_t)color.r;
-			}
+		// Now read the image data in bulk, rows are swizzled into RGBA order if the bitmap is stored differently
+		PixelConvert::PixelLayout bitmapLayout;
+		ALLEGRO_LOCKED_REGION* region = LockBitmap(allegroBitmap, ALLEGRO_LOCK_READONLY, bitmapLayout);
+		if (region == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't generate clip::image: Allegro Bitmap could not be locked!", __FUNCTION__);
+			return std::nullopt;
 		}
 
+		PixelConvert::ConvertImage(region->data, region->pitch, bitmapLayout, data.data(), width * 4,
+			PixelConvert::PixelLayout::RGBA8, width, height);
+
 		al_unlock_bitmap(allegroBitmap);
-		al_set_target_bitmap(oldBuffer);
 
-		// Now setup the image specs
-		clip::image_spec spec;
-		spec.width = width;
-		spec.height = height;
-		spec.bits_per_pixel = 32;
-		spec.bytes_per_row = width * 4;
-		spec.red_mask = 0x000000FF;
-		spec.green_mask = 0x0000FF00;
-		spec.blue_mask = 0x00FF0000;
-		spec.alpha_mask = 0xFF000000;
-		spec.red_shift = 0;
-		spec.green_shift = 8;
-		spec.blue_shift = 16;
-		spec.alpha_shift = 24;
+		clip::image_spec spec = PixelConvert::GetClipSpec(PixelConvert::PixelLayout::RGBA8, width, height);
 
 		return std::make_optional<std::pair<std::vector<uint32_t>, clip::image_spec>>(std::make_pair(std::move(data), spec));
 	}
 
 	bool Texture2D::LoadEmbeddedResource(int id) {
+#ifdef _WIN32
 		HMODULE hMod = GetModuleHandle(NULL);
 		HRSRC hRes = FindResource(hMod, MAKEINTRESOURCE(id), L"PNG");
 		HGLOBAL hGlobal = LoadResource(hMod, hRes);
@@ -269,6 +315,10 @@ namespace Battery {
 		al_destroy_bitmap(bmp);
 
 		return success;
+#else
+		LOG_CORE_ERROR("{}(): Can't load resource {}: Executables only have embedded resources on Windows", __FUNCTION__, id);
+		return false;
+#endif
 	}
 
 
@@ -278,6 +328,10 @@ namespace Battery {
 
 
 	ALLEGRO_BITMAP* Texture2D::GetAllegroBitmap() const {
+		// Brings the texture back into video memory if it was evicted
+		if (allegroBitmap != nullptr && TextureResidency::IsInitialized())
+			TextureResidency::Touch(allegroBitmap);
+
 		return allegroBitmap;
 	}
 
@@ -285,21 +339,43 @@ namespace Battery {
 		Unload();
 
 		al_set_new_bitmap_flags(flags);
-		allegroBitmap = al_create_bitmap(width, height);
-
-		return allegroBitmap != nullptr;
+		return Adopt(al_create_bitmap(width, height));
 	}
 
 	void Texture2D::Unload() {
 		if (!AllegroContext::GetInstance()->IsInitialized()) {
-			throw Battery::Exception(__FUNCTION__"(): Can't destroy texture: The Allegro Context is not loaded anymore!"
+			throw Battery::Exception(std::string(__FUNCTION__) + "(): Can't destroy texture: The Allegro Context is not loaded anymore!"
 				" Make sure to unload or destroy the Texture2D object before Allegro is shut down!");
 		}
 
+		if (allegroBitmap != nullptr && TextureResidency::IsInitialized())
+			TextureResidency::Unregister(allegroBitmap);
+
 		al_destroy_bitmap(allegroBitmap);
 		allegroBitmap = nullptr;
 	}
 
+	size_t Texture2D::GetCloneCount() {
+		return cloneCount.load();
+	}
+
+	ALLEGRO_BITMAP* Texture2D::Clone(ALLEGRO_BITMAP* bitmap, int flags) {
+		cloneCount++;
+		al_set_new_bitmap_flags(flags);
+		return al_clone_bitmap(bitmap);
+	}
+
+	bool Texture2D::Adopt(ALLEGRO_BITMAP* bitmap) {
+		if (allegroBitmap != nullptr)
+			Unload();
+
+		allegroBitmap = bitmap;
+		if (allegroBitmap != nullptr && TextureResidency::IsInitialized())
+			TextureResidency::Register(allegroBitmap);
+
+		return allegroBitmap != nullptr;
+	}
+
 	bool Texture2D::IsValid() const {
 		return allegroBitmap;
 	}
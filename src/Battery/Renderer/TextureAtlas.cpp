@@ -0,0 +1,175 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/TextureAtlas.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	TextureAtlas::TextureAtlas(int pageSize, int padding, size_t maxPages, int flags)
+		: pageSize(pageSize), padding(padding), maxPages(std::max<size_t>(maxPages, 1)), flags(flags) {
+	}
+
+	std::optional<AtlasRegion> TextureAtlas::Add(const std::string& key, const Texture2D& texture) {
+		return Add(key, texture.GetAllegroBitmap());
+	}
+
+	std::optional<AtlasRegion> TextureAtlas::Add(const std::string& key, ALLEGRO_BITMAP* bitmap) {
+
+		auto existing = Find(key);
+		if (existing)
+			return existing;
+
+		if (bitmap == nullptr) {
+			LOG_CORE_ERROR("{}(): Can't add '{}' to the texture atlas: The texture is not valid!", __FUNCTION__, key);
+			return std::nullopt;
+		}
+
+		int width = al_get_bitmap_width(bitmap);
+		int height = al_get_bitmap_height(bitmap);
+		if (width + 2 * padding > pageSize || height + 2 * padding > pageSize) {
+			LOG_CORE_WARN("{}(): Can't add '{}' to the texture atlas: {}x{} is too large for a page", __FUNCTION__, key, width, height);
+			return std::nullopt;
+		}
+
+		// First try all existing pages
+		Page* target = nullptr;
+		std::optional<AtlasRect> rect;
+		for (Page& page : pages) {
+			rect = page.packer.Insert(width, height);
+			if (rect) {
+				target = &page;
+				break;
+			}
+		}
+
+		// Then a new page, or the least recently used one
+		if (!target) {
+			if (pages.size() < maxPages) {
+				Page page{ std::make_unique<Texture2D>(pageSize, pageSize, flags), AtlasPacker(pageSize, pageSize, padding), 0, 0, {} };
+				if (!page.texture->IsValid()) {
+					LOG_CORE_ERROR("{}(): Can't create a new texture atlas page!", __FUNCTION__);
+					return std::nullopt;
+				}
+				pages.push_back(std::move(page));
+				target = &pages.back();
+				ClearPage(*target);
+			}
+			else {
+				target = &*std::min_element(pages.begin(), pages.end(),
+					[](const Page& a, const Page& b) { return a.lastUsed < b.lastUsed; });
+				LOG_CORE_TRACE("{}(): Texture atlas is full, evicting {} regions", __FUNCTION__, target->keys.size());
+				evictedCount += target->keys.size();
+				ClearPage(*target);
+			}
+			rect = target->packer.Insert(width, height);
+		}
+
+		CopyToPage(bitmap, *target, *rect);
+
+		AtlasRegion region;
+		region.page = target - pages.data();
+		region.rect = *rect;
+		region.generation = target->generation;
+
+		regions[key] = region;
+		target->keys.push_back(key);
+		target->lastUsed = ++useCounter;
+
+		return region;
+	}
+
+	std::optional<AtlasRegion> TextureAtlas::Find(const std::string& key) {
+
+		auto it = regions.find(key);
+		if (it == regions.end())
+			return std::nullopt;
+
+		pages[it->second.page].lastUsed = ++useCounter;
+		return it->second;
+	}
+
+	bool TextureAtlas::IsValid(const AtlasRegion& region) const {
+		return region.page < pages.size() && pages[region.page].generation == region.generation;
+	}
+
+	void TextureAtlas::Clear() {
+		pages.clear();
+		regions.clear();
+	}
+
+	ALLEGRO_BITMAP* TextureAtlas::GetPageBitmap(size_t page) const {
+		if (page >= pages.size())
+			return nullptr;
+		return pages[page].texture->GetAllegroBitmap();
+	}
+
+	size_t TextureAtlas::GetPageCount() const {
+		return pages.size();
+	}
+
+	size_t TextureAtlas::GetRegionCount() const {
+		return regions.size();
+	}
+
+	uint64_t TextureAtlas::GetEvictedCount() const {
+		return evictedCount;
+	}
+
+	float TextureAtlas::GetOccupancy() const {
+		if (pages.empty())
+			return 0.f;
+
+		float sum = 0.f;
+		for (const Page& page : pages) {
+			sum += page.packer.GetOccupancy();
+		}
+		return sum / pages.size();
+	}
+
+	void TextureAtlas::ClearPage(Page& page) {
+
+		for (const std::string& key : page.keys) {
+			regions.erase(key);
+		}
+		page.keys.clear();
+		page.packer.Clear();
+		page.generation++;
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+		al_set_target_bitmap(page.texture->GetAllegroBitmap());
+		al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+		al_restore_state(&state);
+	}
+
+	void TextureAtlas::CopyToPage(ALLEGRO_BITMAP* bitmap, Page& page, const AtlasRect& rect) {
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP | ALLEGRO_STATE_BLENDER);
+		al_set_target_bitmap(page.texture->GetAllegroBitmap());
+		al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);		// Copy the pixels including alpha
+
+		float x = (float)rect.x;
+		float y = (float)rect.y;
+		float w = (float)rect.width;
+		float h = (float)rect.height;
+		float p = (float)padding;
+
+		al_draw_bitmap(bitmap, x, y, 0);
+
+		// Extrude the edge pixels into the padding, so that filtering never picks up a neighbour
+		if (padding > 0) {
+			al_draw_scaled_bitmap(bitmap, 0, 0, w, 1, x, y - p, w, p, 0);				// Top
+			al_draw_scaled_bitmap(bitmap, 0, h - 1, w, 1, x, y + h, w, p, 0);			// Bottom
+			al_draw_scaled_bitmap(bitmap, 0, 0, 1, h, x - p, y, p, h, 0);				// Left
+			al_draw_scaled_bitmap(bitmap, w - 1, 0, 1, h, x + w, y, p, h, 0);			// Right
+			al_draw_scaled_bitmap(bitmap, 0, 0, 1, 1, x - p, y - p, p, p, 0);			// Corners
+			al_draw_scaled_bitmap(bitmap, w - 1, 0, 1, 1, x + w, y - p, p, p, 0);
+			al_draw_scaled_bitmap(bitmap, 0, h - 1, 1, 1, x - p, y + h, p, p, 0);
+			al_draw_scaled_bitmap(bitmap, w - 1, h - 1, 1, 1, x + w, y + h, p, p, 0);
+		}
+
+		al_restore_state(&state);
+	}
+
+}
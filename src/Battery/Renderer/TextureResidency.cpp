@@ -0,0 +1,211 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/TextureResidency.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Battery/Log/Log.h"
+
+#define CHECK_INIT() \
+	if (data == nullptr) { \
+		throw Battery::Exception(std::string(__FUNCTION__) + "(): The texture residency manager is not initialized!"); \
+	}
+
+namespace Battery {
+
+	struct ResidencyEntry {
+		int flags = 0;				// Original flags and format, restored when reloading
+		int format = 0;
+		size_t bytes = 0;
+		uint64_t lastUsed = 0;		// Frame number
+		uint64_t failedFrame = 0;	// Frame of the last failed reload
+		bool evicted = false;
+		bool reloadFailed = false;
+	};
+
+	struct TextureResidencyData {
+		std::mutex mutex;
+		std::unordered_map<ALLEGRO_BITMAP*, ResidencyEntry> textures;
+		uint64_t frame = 0;
+		TextureMemoryStats stats;
+	};
+
+	static TextureResidencyData* data = nullptr;
+
+
+
+
+
+	// Converts the bitmap in place, it keeps its pointer and content
+	static bool ConvertBitmap(ALLEGRO_BITMAP* bitmap, int flags, int format) {
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+		al_set_new_bitmap_flags(flags);
+		al_set_new_bitmap_format(format);
+		al_convert_bitmap(bitmap);
+		al_restore_state(&state);
+
+		return (al_get_bitmap_flags(bitmap) & ALLEGRO_MEMORY_BITMAP) == (flags & ALLEGRO_MEMORY_BITMAP);
+	}
+
+	void TextureResidency::Setup() {
+
+		if (data != nullptr) {
+			LOG_CORE_CRITICAL("{}(): Can't setup texture residency manager, it is already initialized!", __FUNCTION__);
+			return;
+		}
+
+		data = new TextureResidencyData();
+		data->stats.budget = BATTERY_TEXTURE_MEMORY_BUDGET;
+	}
+
+	void TextureResidency::Shutdown() {
+
+		if (data == nullptr) {
+			LOG_CORE_CRITICAL("{}(): Can't shut down texture residency manager, it is not initialized!", __FUNCTION__);
+			return;
+		}
+
+		delete data;
+		data = nullptr;
+	}
+
+	bool TextureResidency::IsInitialized() {
+		return data != nullptr;
+	}
+
+	void TextureResidency::Update() {
+		CHECK_INIT();
+		PROFILE_CORE_SCOPE("TextureResidency::Update() evicting textures");
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		data->frame++;
+		if (data->stats.residentBytes <= data->stats.budget)
+			return;
+
+		// Least recently used first, but nothing that was used in the previous frame or is being drawn to
+		ALLEGRO_BITMAP* target = al_get_target_bitmap();
+		std::vector<std::pair<uint64_t, ALLEGRO_BITMAP*>> candidates;
+		for (auto& [bitmap, entry] : data->textures) {
+			if (!entry.evicted && entry.lastUsed + 1 < data->frame && bitmap != target)
+				candidates.emplace_back(entry.lastUsed, bitmap);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (auto& [lastUsed, bitmap] : candidates) {
+			if (data->stats.residentBytes <= data->stats.budget)
+				break;
+
+			ResidencyEntry& entry = data->textures[bitmap];
+			int flags = (entry.flags & ~(ALLEGRO_VIDEO_BITMAP | ALLEGRO_CONVERT_BITMAP)) | ALLEGRO_MEMORY_BITMAP;
+			if (!ConvertBitmap(bitmap, flags, entry.format)) {
+				LOG_CORE_WARN("{}(): Failed to evict texture of {} bytes", __FUNCTION__, entry.bytes);
+				continue;
+			}
+
+			entry.evicted = true;
+			data->stats.residentBytes -= entry.bytes;
+			data->stats.evictedBytes += entry.bytes;
+			data->stats.evictions++;
+		}
+	}
+
+	void TextureResidency::SetBudget(size_t bytes) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stats.budget = bytes;
+	}
+
+	TextureMemoryStats TextureResidency::GetStats() {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		TextureMemoryStats stats = data->stats;
+		stats.residentTextures = 0;
+		stats.evictedTextures = 0;
+		for (auto& [bitmap, entry] : data->textures) {
+			if (entry.evicted)
+				stats.evictedTextures++;
+			else
+				stats.residentTextures++;
+		}
+
+		return stats;
+	}
+
+	void TextureResidency::Register(ALLEGRO_BITMAP* bitmap) {
+		CHECK_INIT();
+
+		if (bitmap == nullptr || al_is_sub_bitmap(bitmap))
+			return;
+
+		int flags = al_get_bitmap_flags(bitmap);
+		if (flags & ALLEGRO_MEMORY_BITMAP)
+			return;
+
+		ResidencyEntry entry;
+		entry.flags = flags;
+		entry.format = al_get_bitmap_format(bitmap);
+		entry.bytes = (size_t)al_get_bitmap_width(bitmap) * al_get_bitmap_height(bitmap) * al_get_pixel_size(entry.format);
+
+		std::lock_guard<std::mutex> lock(data->mutex);
+		entry.lastUsed = data->frame;
+		if (data->textures.try_emplace(bitmap, entry).second)
+			data->stats.residentBytes += entry.bytes;
+	}
+
+	void TextureResidency::Unregister(ALLEGRO_BITMAP* bitmap) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		auto it = data->textures.find(bitmap);
+		if (it == data->textures.end())
+			return;
+
+		if (it->second.evicted)
+			data->stats.evictedBytes -= it->second.bytes;
+		else
+			data->stats.residentBytes -= it->second.bytes;
+
+		data->textures.erase(it);
+	}
+
+	void TextureResidency::Touch(ALLEGRO_BITMAP* bitmap) {
+		CHECK_INIT();
+		std::lock_guard<std::mutex> lock(data->mutex);
+
+		auto it = data->textures.find(bitmap);
+		if (it == data->textures.end())
+			return;
+
+		ResidencyEntry& entry = it->second;
+		entry.lastUsed = data->frame;
+
+		if (!entry.evicted)
+			return;
+
+		// A failed reload is retried once per frame at most, not on every draw call
+		if (entry.reloadFailed && entry.failedFrame == data->frame)
+			return;
+
+		// Still usable as a memory bitmap if this fails, only slower
+		if (!ConvertBitmap(bitmap, entry.flags, entry.format)) {
+			if (!entry.reloadFailed) {
+				LOG_CORE_WARN("{}(): Failed to reload evicted texture of {} bytes, using it from system memory",
+					__FUNCTION__, entry.bytes);
+			}
+			entry.reloadFailed = true;
+			entry.failedFrame = data->frame;
+			data->stats.failedReloads++;
+			return;
+		}
+
+		entry.evicted = false;
+		entry.reloadFailed = false;
+		data->stats.evictedBytes -= entry.bytes;
+		data->stats.residentBytes += entry.bytes;
+		data->stats.reloads++;
+	}
+
+}
@@ -0,0 +1,565 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/TiledImage.h"
+#include "Battery/Renderer/Texture2D.h"
+#include "Battery/Renderer/ImageFilter.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Core/Config.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/HashUtils.h"
+#include "Battery/Utils/BinaryUtils.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+
+	static constexpr uint64_t NO_TILE = ~(uint64_t)0;
+
+	// On disk, every level is one file containing all of its tiles row by row. Each tile is stored with a border
+	// of one pixel taken from its neighbours, so that linear filtering in the cache texture has no seams
+	struct TiledImageLevel {
+		int width = 0;
+		int height = 0;
+		int columns = 0;
+		int rows = 0;
+		FileUtils::MappedFile file;
+	};
+
+	struct TileSlot {
+		uint64_t key = NO_TILE;
+		uint64_t lastUsed = 0;
+		bool pinned = false;		// The single tile of the top level, it's the last fallback
+	};
+
+	struct LoadedTile {
+		uint64_t key = NO_TILE;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct TiledImageData {
+		int width = 0;
+		int height = 0;
+		int tileSize = 0;
+		int slotSize = 0;			// Tile size including the border
+		std::vector<TiledImageLevel> levels;
+
+		std::unique_ptr<Texture2D> cache;
+		int slotsPerRow = 0;
+		std::vector<TileSlot> slots;
+		std::unordered_map<uint64_t, size_t> resident;		// Tile key -> slot
+		uint64_t frame = 0;
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<uint64_t> queue;
+		std::unordered_set<uint64_t> pending;		// Queued, being read or waiting for the upload
+		std::vector<LoadedTile> loaded;
+		std::thread worker;
+		bool stopping = false;
+
+		TiledImageStats stats;
+	};
+
+	static uint64_t MakeKey(size_t level, int x, int y) {
+		return (uint64_t)level << 48 | (uint64_t)y << 24 | (uint64_t)x;
+	}
+
+	static void SplitKey(uint64_t key, size_t& level, int& x, int& y) {
+		level = (size_t)(key >> 48);
+		y = (int)((key >> 24) & 0xFFFFFF);
+		x = (int)(key & 0xFFFFFF);
+	}
+
+	static std::string GetLevelPath(const std::string& directory, size_t level) {
+		return PathUtils::Join(directory, "level" + std::to_string(level) + ".tiles");
+	}
+
+	static size_t GetTileBytes(const TiledImageData& data) {
+		return (size_t)data.slotSize * data.slotSize * 4;
+	}
+
+
+
+
+
+	// Copies a square of the image, pixels outside of it repeat the nearest edge pixel
+	static void CopyTile(const uint8_t* pixels, ptrdiff_t pitch, int width, int height, int left, int top, int size,
+			uint8_t* tile) {
+
+		for (int row = 0; row < size; row++) {
+			const uint8_t* source = pixels + (ptrdiff_t)std::clamp(top + row, 0, height - 1) * pitch;
+			uint8_t* destination = tile + (size_t)row * size * 4;
+
+			int x = 0;
+			for (; x < size && left + x < 0; x++) {
+				memcpy(destination + x * 4, source, 4);
+			}
+
+			int inside = std::min(size - x, width - (left + x));
+			if (inside > 0) {
+				memcpy(destination + x * 4, source + (ptrdiff_t)(left + x) * 4, (size_t)inside * 4);
+				x += inside;
+			}
+
+			for (; x < size; x++) {
+				memcpy(destination + x * 4, source + (ptrdiff_t)(width - 1) * 4, 4);
+			}
+		}
+	}
+
+	static bool WriteLevel(const std::string& path, const uint8_t* pixels, ptrdiff_t pitch, int width, int height, int tileSize) {
+
+		ALLEGRO_FILE* file = al_fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		int slotSize = tileSize + 2;
+		int columns = (width + tileSize - 1) / tileSize;
+		int rows = (height + tileSize - 1) / tileSize;
+		std::vector<uint8_t> tile((size_t)slotSize * slotSize * 4);
+		bool failed = false;
+
+		for (int y = 0; y < rows && !failed; y++) {
+			for (int x = 0; x < columns && !failed; x++) {
+				CopyTile(pixels, pitch, width, height, x * tileSize - 1, y * tileSize - 1, slotSize, tile.data());
+				failed = al_fwrite(file, tile.data(), tile.size()) != tile.size();
+			}
+		}
+
+		if (!al_fclose(file) || failed) {
+			FileUtils::RemoveFile(path);
+			return false;
+		}
+
+		return true;
+	}
+
+	// Every level halves the previous one, until a single tile is left
+	static bool BuildPyramid(const std::string& path, const std::string& directory, int tileSize) {
+
+		ALLEGRO_STATE state;
+		al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+		al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+		ALLEGRO_BITMAP* bitmap = al_load_bitmap(path.c_str());
+		al_restore_state(&state);
+
+		if (bitmap == nullptr) {
+			LOG_CORE_ERROR("{}(): Failed to load image '{}'", __FUNCTION__, path);
+			return false;
+		}
+
+		ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+		if (region == nullptr) {
+			LOG_CORE_ERROR("{}(): Failed to lock image '{}'", __FUNCTION__, path);
+			al_destroy_bitmap(bitmap);
+			return false;
+		}
+
+		FileUtils::PrepareDirectory(directory);
+
+		// The first level is read directly from the locked bitmap
+		int imageWidth = al_get_bitmap_width(bitmap);
+		int imageHeight = al_get_bitmap_height(bitmap);
+		int width = imageWidth;
+		int height = imageHeight;
+		const uint8_t* pixels = (const uint8_t*)region->data;
+		ptrdiff_t pitch = region->pitch;
+		std::vector<uint8_t> current;
+		std::vector<uint8_t> next;
+		size_t level = 0;
+		bool success = true;
+
+		while (true) {
+			if (!WriteLevel(GetLevelPath(directory, level), pixels, pitch, width, height, tileSize)) {
+				LOG_CORE_ERROR("{}(): Failed to write level {} of the tile pyramid", __FUNCTION__, level);
+				success = false;
+				break;
+			}
+
+			if (width <= tileSize && height <= tileSize)
+				break;
+
+			int nextWidth = std::max(width / 2, 1);
+			int nextHeight = std::max(height / 2, 1);
+			next.resize((size_t)nextWidth * nextHeight * 4);
+			ImageFilter::Downsample2x(pixels, pitch, width, height, next.data(), (ptrdiff_t)nextWidth * 4,
+				&ThreadPool::GetShared());
+
+			if (bitmap != nullptr) {
+				al_unlock_bitmap(bitmap);
+				al_destroy_bitmap(bitmap);
+				bitmap = nullptr;
+			}
+
+			std::swap(current, next);
+			pixels = current.data();
+			pitch = (ptrdiff_t)nextWidth * 4;
+			width = nextWidth;
+			height = nextHeight;
+			level++;
+		}
+
+		if (bitmap != nullptr) {
+			al_unlock_bitmap(bitmap);
+			al_destroy_bitmap(bitmap);
+		}
+
+		if (!success)
+			return false;
+
+		// The info file is written last, so it only exists for complete pyramids
+		BinaryUtils::BinaryWriter writer;
+		writer.BeginMap(4);
+		writer.Field("width", imageWidth).Field("height", imageHeight);
+		writer.Field("tileSize", tileSize).Field("levels", level + 1);
+
+		if (!writer.Save(PathUtils::Join(directory, BATTERY_TILED_IMAGE_INFO_FILE))) {
+			LOG_CORE_ERROR("{}(): Failed to write the info file of the tile pyramid", __FUNCTION__);
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool ReadInfo(const std::string& directory, TiledImageData& data) {
+
+		BinaryUtils::BinaryFile file(PathUtils::Join(directory, BATTERY_TILED_IMAGE_INFO_FILE));
+		if (!file.IsOpen())
+			return false;
+
+		BinaryUtils::BinaryView info = file.GetRoot();
+		data.width = (int)info["width"].AsInt();
+		data.height = (int)info["height"].AsInt();
+		data.tileSize = (int)info["tileSize"].AsInt();
+		data.slotSize = data.tileSize + 2;
+		size_t levelCount = (size_t)info["levels"].AsUnsigned();
+
+		if (data.width <= 0 || data.height <= 0 || data.tileSize <= 0 || levelCount == 0)
+			return false;
+
+		data.levels = std::vector<TiledImageLevel>(levelCount);
+		int width = data.width;
+		int height = data.height;
+
+		for (size_t i = 0; i < levelCount; i++) {
+			TiledImageLevel& level = data.levels[i];
+			level.width = width;
+			level.height = height;
+			level.columns = (width + data.tileSize - 1) / data.tileSize;
+			level.rows = (height + data.tileSize - 1) / data.tileSize;
+
+			size_t expectedSize = (size_t)level.columns * level.rows * GetTileBytes(data);
+			if (!level.file.Open(GetLevelPath(directory, i)) || level.file.GetSize() != expectedSize)
+				return false;
+
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+
+		return true;
+	}
+
+	// Reads the requested tiles from the mapped level files, the first access of a page is what hits the disk
+	static void LoaderThread(TiledImageData* data) {
+
+		while (true) {
+			uint64_t key;
+			{
+				std::unique_lock<std::mutex> lock(data->mutex);
+				data->condition.wait(lock, [&] { return data->stopping || !data->queue.empty(); });
+				if (data->stopping)
+					return;
+
+				key = data->queue.front();
+				data->queue.pop_front();
+			}
+
+			size_t level;
+			int x, y;
+			SplitKey(key, level, x, y);
+
+			const TiledImageLevel& info = data->levels[level];
+			size_t tileBytes = GetTileBytes(*data);
+			const char* source = info.file.GetData() + ((size_t)y * info.columns + x) * tileBytes;
+
+			LoadedTile tile;
+			tile.key = key;
+			tile.pixels.assign(source, source + tileBytes);
+
+			std::lock_guard<std::mutex> lock(data->mutex);
+			data->loaded.push_back(std::move(tile));
+		}
+	}
+
+	static glm::vec2 GetSlotOrigin(const TiledImageData& data, size_t slot) {
+		return glm::vec2((int)(slot % data.slotsPerRow) * data.slotSize, (int)(slot / data.slotsPerRow) * data.slotSize);
+	}
+
+	// A free slot or the least recently used one which is not needed in this frame
+	static size_t AcquireSlot(TiledImageData& data) {
+
+		size_t best = data.slots.size();
+		for (size_t i = 0; i < data.slots.size(); i++) {
+			const TileSlot& slot = data.slots[i];
+			if (slot.key == NO_TILE)
+				return i;
+			if (slot.pinned || slot.lastUsed == data.frame)
+				continue;
+			if (best == data.slots.size() || slot.lastUsed < data.slots[best].lastUsed)
+				best = i;
+		}
+
+		if (best != data.slots.size()) {
+			data.resident.erase(data.slots[best].key);
+			data.slots[best].key = NO_TILE;
+			data.stats.evictedTiles++;
+		}
+
+		return best;
+	}
+
+	static void UploadTiles(TiledImageData& data) {
+
+		std::vector<LoadedTile> tiles;
+		{
+			std::lock_guard<std::mutex> lock(data.mutex);
+			size_t count = std::min<size_t>(data.loaded.size(), BATTERY_TILE_UPLOADS_PER_FRAME);
+			std::move(data.loaded.begin(), data.loaded.begin() + count, std::back_inserter(tiles));
+			data.loaded.erase(data.loaded.begin(), data.loaded.begin() + count);
+		}
+
+		if (tiles.empty())
+			return;
+
+		ALLEGRO_BITMAP* bitmap = data.cache->GetAllegroBitmap();
+		size_t rowBytes = (size_t)data.slotSize * 4;
+
+		for (LoadedTile& tile : tiles) {
+			size_t slot = AcquireSlot(data);
+
+			if (slot != data.slots.size()) {
+				glm::vec2 origin = GetSlotOrigin(data, slot);
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap_region(bitmap, (int)origin.x, (int)origin.y,
+					data.slotSize, data.slotSize, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+
+				if (region != nullptr) {
+					for (int row = 0; row < data.slotSize; row++) {
+						memcpy((uint8_t*)region->data + (ptrdiff_t)row * region->pitch, tile.pixels.data() + row * rowBytes, rowBytes);
+					}
+					al_unlock_bitmap(bitmap);
+
+					size_t level;
+					int x, y;
+					SplitKey(tile.key, level, x, y);
+
+					data.slots[slot].key = tile.key;
+					data.slots[slot].lastUsed = data.frame;
+					data.slots[slot].pinned = (level == data.levels.size() - 1);
+					data.resident[tile.key] = slot;
+					data.stats.loadedTiles++;
+				}
+				else {
+					LOG_CORE_ERROR("{}(): Failed to lock the tile cache texture", __FUNCTION__);
+				}
+			}
+
+			// If it could not be uploaded, it's requested again when it's still visible
+			std::lock_guard<std::mutex> lock(data.mutex);
+			data.pending.erase(tile.key);
+		}
+	}
+
+
+
+
+
+	TiledImage::TiledImage() {
+	}
+
+	TiledImage::~TiledImage() {
+		Close();
+	}
+
+	bool TiledImage::Open(const std::string& path, const std::string& cacheDirectory) {
+
+		Close();
+
+		auto hash = AssetCache::IsInitialized() ? AssetCache::GetContentHash(path) : HashUtils::HashFile(path);
+		if (!hash) {
+			LOG_CORE_ERROR("{}(): Can't open tiled image '{}': The file does not exist", __FUNCTION__, path);
+			return false;
+		}
+
+		int tileSize = BATTERY_TILE_SIZE;
+		std::string directory = PathUtils::Join(cacheDirectory, HashUtils::ToHexString(*hash) + "_" + std::to_string(tileSize));
+
+		auto newData = std::make_unique<TiledImageData>();
+		if (!ReadInfo(directory, *newData)) {
+			LOG_CORE_INFO("Building the tile pyramid of '{}', this may take a while", path);
+
+			newData = std::make_unique<TiledImageData>();
+			if (!BuildPyramid(path, directory, tileSize) || !ReadInfo(directory, *newData)) {
+				LOG_CORE_ERROR("{}(): Can't open tiled image '{}': The tile pyramid could not be built", __FUNCTION__, path);
+				return false;
+			}
+		}
+
+		newData->cache = std::make_unique<Texture2D>(BATTERY_TILE_CACHE_SIZE, BATTERY_TILE_CACHE_SIZE,
+			ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
+		if (!newData->cache->IsValid()) {
+			LOG_CORE_ERROR("{}(): Can't open tiled image '{}': The tile cache texture could not be created", __FUNCTION__, path);
+			return false;
+		}
+
+		newData->slotsPerRow = BATTERY_TILE_CACHE_SIZE / newData->slotSize;
+		newData->slots.resize((size_t)newData->slotsPerRow * newData->slotsPerRow);
+
+		data = std::move(newData);
+		data->worker = std::thread(LoaderThread, data.get());
+
+		return true;
+	}
+
+	void TiledImage::Close() {
+
+		if (!data)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+			data->stopping = true;
+		}
+		data->condition.notify_all();
+
+		if (data->worker.joinable())
+			data->worker.join();
+
+		data.reset();
+	}
+
+	bool TiledImage::IsOpen() const {
+		return data != nullptr;
+	}
+
+	int TiledImage::GetWidth() const {
+		return data ? data->width : 0;
+	}
+
+	int TiledImage::GetHeight() const {
+		return data ? data->height : 0;
+	}
+
+	size_t TiledImage::GetLevelCount() const {
+		return data ? data->levels.size() : 0;
+	}
+
+	void TiledImage::CollectVisibleTiles(const glm::vec2& position, float scale, const glm::vec2& viewMin,
+			const glm::vec2& viewMax, std::vector<TileQuad>& quads) {
+
+		if (!data)
+			return;
+
+		data->frame++;
+		UploadTiles(*data);
+
+		size_t firstQuad = quads.size();
+		size_t topLevel = data->levels.size() - 1;
+		std::vector<uint64_t> missing;
+
+		// The top level is always requested first, so that there is something to fall back to
+		if (data->resident.find(MakeKey(topLevel, 0, 0)) == data->resident.end())
+			missing.push_back(MakeKey(topLevel, 0, 0));
+
+		// The visible part of the image in image pixels
+		glm::vec2 imageSize = { data->width, data->height };
+		glm::vec2 imageMin = glm::max((viewMin - position) / scale, glm::vec2(0.f));
+		glm::vec2 imageMax = glm::min((viewMax - position) / scale, imageSize);
+
+		if (scale > 0.f && imageMin.x < imageMax.x && imageMin.y < imageMax.y) {
+
+			size_t level = scale >= 1.f ? 0 : std::min((size_t)std::floor(std::log2(1.f / scale)), topLevel);
+			const TiledImageLevel& info = data->levels[level];
+			glm::vec2 factor = imageSize / glm::vec2(info.width, info.height);		// Image pixels per level pixel
+			float tileSize = (float)data->tileSize;
+
+			int firstColumn = (int)(imageMin.x / factor.x / tileSize);
+			int firstRow = (int)(imageMin.y / factor.y / tileSize);
+			int lastColumn = std::min((int)std::ceil(imageMax.x / factor.x / tileSize), info.columns);
+			int lastRow = std::min((int)std::ceil(imageMax.y / factor.y / tileSize), info.rows);
+
+			for (int y = firstRow; y < lastRow; y++) {
+				for (int x = firstColumn; x < lastColumn; x++) {
+
+					glm::vec2 tileMin = glm::vec2(x, y) * tileSize * factor;
+					glm::vec2 tileMax = glm::min(glm::vec2(x + 1, y + 1) * tileSize * factor, imageSize);
+
+					// Draw the tile itself or the part of the closest coarser tile which is resident
+					for (size_t parent = level; parent <= topLevel; parent++) {
+						int shift = (int)(parent - level);
+						uint64_t key = MakeKey(parent, x >> shift, y >> shift);
+
+						auto it = data->resident.find(key);
+						if (it == data->resident.end()) {
+							if (parent == level)
+								missing.push_back(key);
+							continue;
+						}
+
+						const TiledImageLevel& parentInfo = data->levels[parent];
+						glm::vec2 parentFactor = imageSize / glm::vec2(parentInfo.width, parentInfo.height);
+						glm::vec2 tileOrigin = glm::vec2(x >> shift, y >> shift) * tileSize;
+						glm::vec2 source1 = glm::clamp(tileMin / parentFactor - tileOrigin, glm::vec2(0.f), glm::vec2(tileSize));
+						glm::vec2 source2 = glm::clamp(tileMax / parentFactor - tileOrigin, glm::vec2(0.f), glm::vec2(tileSize));
+
+						// Skip the border of the slot
+						glm::vec2 slotOrigin = GetSlotOrigin(*data, it->second) + glm::vec2(1.f);
+						data->slots[it->second].lastUsed = data->frame;
+
+						TileQuad quad;
+						quad.point1 = position + tileMin * scale;
+						quad.point2 = position + tileMax * scale;
+						quad.source1 = slotOrigin + source1;
+						quad.source2 = slotOrigin + source2;
+						quads.push_back(quad);
+						break;
+					}
+				}
+			}
+		}
+
+		// Only what is visible now stays queued
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+			for (uint64_t key : data->queue) {
+				data->pending.erase(key);
+			}
+			data->queue.clear();
+
+			for (uint64_t key : missing) {
+				if (data->pending.insert(key).second)
+					data->queue.push_back(key);
+			}
+		}
+		data->condition.notify_one();
+
+		data->stats.visibleTiles = quads.size() - firstQuad;
+	}
+
+	ALLEGRO_BITMAP* TiledImage::GetCacheBitmap() const {
+		return data ? data->cache->GetAllegroBitmap() : nullptr;
+	}
+
+	TiledImageStats TiledImage::GetStats() const {
+
+		if (!data)
+			return TiledImageStats();
+
+		std::lock_guard<std::mutex> lock(data->mutex);
+		TiledImageStats stats = data->stats;
+		stats.residentTiles = data->resident.size();
+		stats.capacity = data->slots.size();
+		stats.pendingTiles = data->pending.size();
+		return stats;
+	}
+
+}
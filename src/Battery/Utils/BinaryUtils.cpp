@@ -0,0 +1,703 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/BinaryUtils.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+	namespace BinaryUtils {
+
+		struct Header {
+			BinaryType type = BinaryType::INVALID;
+			size_t headerSize = 0;		// Including the payload of scalar values
+			uint64_t length = 0;		// Bytes of strings, binaries and extensions, elements of arrays and maps
+		};
+
+		static uint64_t ReadBigEndian(const uint8_t* data, size_t bytes) {
+			uint64_t value = 0;
+			for (size_t i = 0; i < bytes; i++)
+				value = (value << 8) | data[i];
+			return value;
+		}
+
+		static bool ReadHeader(const uint8_t* data, const uint8_t* end, Header& header) {
+
+			if (data == nullptr || data >= end)
+				return false;
+
+			uint8_t byte = data[0];
+			size_t lengthBytes = 0;
+			header.headerSize = 1;
+			header.length = 0;
+
+			if (byte <= 0x7F) {
+				header.type = BinaryType::UNSIGNED;
+			}
+			else if (byte <= 0x8F) {
+				header.type = BinaryType::MAP;
+				header.length = byte & 0x0F;
+			}
+			else if (byte <= 0x9F) {
+				header.type = BinaryType::ARRAY;
+				header.length = byte & 0x0F;
+			}
+			else if (byte <= 0xBF) {
+				header.type = BinaryType::STRING;
+				header.length = byte & 0x1F;
+			}
+			else if (byte >= 0xE0) {
+				header.type = BinaryType::INTEGER;
+			}
+			else {
+				switch (byte) {
+				case 0xC0: header.type = BinaryType::NIL; break;
+				case 0xC2: case 0xC3: header.type = BinaryType::BOOL; break;
+				case 0xC4: header.type = BinaryType::BINARY; lengthBytes = 1; break;
+				case 0xC5: header.type = BinaryType::BINARY; lengthBytes = 2; break;
+				case 0xC6: header.type = BinaryType::BINARY; lengthBytes = 4; break;
+				case 0xC7: header.type = BinaryType::EXTENSION; lengthBytes = 1; header.headerSize = 2; break;
+				case 0xC8: header.type = BinaryType::EXTENSION; lengthBytes = 2; header.headerSize = 2; break;
+				case 0xC9: header.type = BinaryType::EXTENSION; lengthBytes = 4; header.headerSize = 2; break;
+				case 0xCA: header.type = BinaryType::FLOAT; header.headerSize = 5; break;
+				case 0xCB: header.type = BinaryType::FLOAT; header.headerSize = 9; break;
+				case 0xCC: header.type = BinaryType::UNSIGNED; header.headerSize = 2; break;
+				case 0xCD: header.type = BinaryType::UNSIGNED; header.headerSize = 3; break;
+				case 0xCE: header.type = BinaryType::UNSIGNED; header.headerSize = 5; break;
+				case 0xCF: header.type = BinaryType::UNSIGNED; header.headerSize = 9; break;
+				case 0xD0: header.type = BinaryType::INTEGER; header.headerSize = 2; break;
+				case 0xD1: header.type = BinaryType::INTEGER; header.headerSize = 3; break;
+				case 0xD2: header.type = BinaryType::INTEGER; header.headerSize = 5; break;
+				case 0xD3: header.type = BinaryType::INTEGER; header.headerSize = 9; break;
+				case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+					header.type = BinaryType::EXTENSION;
+					header.headerSize = 2;
+					header.length = (uint64_t)1 << (byte - 0xD4);
+					break;
+				case 0xD9: header.type = BinaryType::STRING; lengthBytes = 1; break;
+				case 0xDA: header.type = BinaryType::STRING; lengthBytes = 2; break;
+				case 0xDB: header.type = BinaryType::STRING; lengthBytes = 4; break;
+				case 0xDC: header.type = BinaryType::ARRAY; lengthBytes = 2; break;
+				case 0xDD: header.type = BinaryType::ARRAY; lengthBytes = 4; break;
+				case 0xDE: header.type = BinaryType::MAP; lengthBytes = 2; break;
+				case 0xDF: header.type = BinaryType::MAP; lengthBytes = 4; break;
+				default: return false;		// 0xC1 is never used
+				}
+			}
+
+			if (lengthBytes > 0) {
+				if ((size_t)(end - data) < 1 + lengthBytes)
+					return false;
+				header.length = ReadBigEndian(data + 1, lengthBytes);
+				header.headerSize += lengthBytes;
+			}
+
+			return (size_t)(end - data) >= header.headerSize;
+		}
+
+		// Returns the encoded size of the value at 'data' including all nested values, 0 if it is malformed
+		static size_t GetValueSize(const uint8_t* data, const uint8_t* end) {
+
+			const uint8_t* current = data;
+			uint64_t pending = 1;
+			Header header;
+
+			while (pending > 0) {
+				if (!ReadHeader(current, end, header))
+					return 0;
+
+				current += header.headerSize;
+				pending--;
+
+				switch (header.type) {
+				case BinaryType::STRING:
+				case BinaryType::BINARY:
+				case BinaryType::EXTENSION:
+					if ((uint64_t)(end - current) < header.length)
+						return 0;
+					current += header.length;
+					break;
+				case BinaryType::ARRAY:
+					pending += header.length;
+					break;
+				case BinaryType::MAP:
+					pending += header.length * 2;
+					break;
+				default:
+					break;
+				}
+			}
+
+			return current - data;
+		}
+
+		// Builds a json value from the MessagePack value at 'data', returns a pointer past the value or nullptr if it is malformed.
+		// This is considerably faster than nlohmann::json::from_msgpack(), which reads the input byte by byte.
+		// The nesting is limited, so malicious input can't overflow the stack
+		static const uint8_t* ReadJson(const uint8_t* data, const uint8_t* end, nlohmann::json& value, size_t depth = 0) {
+
+			if (depth > BATTERY_BINARY_MAX_DEPTH)
+				return nullptr;
+
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return nullptr;
+
+			BinaryView view(std::string_view((const char*)data, end - data));
+			const uint8_t* current = data + header.headerSize;
+
+			switch (header.type) {
+			case BinaryType::NIL:
+				value = nullptr;
+				return current;
+
+			case BinaryType::BOOL:
+				value = view.AsBool();
+				return current;
+
+			case BinaryType::INTEGER:
+				value = view.AsInt();
+				return current;
+
+			case BinaryType::UNSIGNED:
+				value = view.AsUnsigned();
+				return current;
+
+			case BinaryType::FLOAT:
+				value = view.AsDouble();
+				return current;
+
+			case BinaryType::STRING:
+				if ((uint64_t)(end - current) < header.length)
+					return nullptr;
+				value = std::string((const char*)current, (size_t)header.length);
+				return current + header.length;
+
+			case BinaryType::ARRAY: {
+				value = nlohmann::json::array();
+				auto& array = value.get_ref<nlohmann::json::array_t&>();
+				array.reserve((size_t)std::min<uint64_t>(header.length, end - current));	// Every element takes at least one byte
+				for (uint64_t i = 0; i < header.length && current != nullptr; i++) {
+					array.emplace_back();
+					current = ReadJson(current, end, array.back(), depth + 1);
+				}
+				return current;
+			}
+
+			case BinaryType::MAP: {
+				value = nlohmann::json::object();
+				auto& object = value.get_ref<nlohmann::json::object_t&>();
+				for (uint64_t i = 0; i < header.length && current != nullptr; i++) {
+					std::string_view key = BinaryView(std::string_view((const char*)current, end - current)).AsString();
+					Header keyHeader;
+					if (!ReadHeader(current, end, keyHeader) || keyHeader.type != BinaryType::STRING || key.size() != keyHeader.length)
+						return nullptr;
+					current = ReadJson(current + keyHeader.headerSize + keyHeader.length, end, object[std::string(key)], depth + 1);
+				}
+				return current;
+			}
+
+			default:
+				return nullptr;		// Binary and extension types can't be represented in json
+			}
+		}
+
+
+
+
+
+		BinaryView::BinaryView() {
+		}
+
+		BinaryView::BinaryView(std::string_view buffer) {
+			data = (const uint8_t*)buffer.data();
+			end = data + buffer.size();
+		}
+
+		BinaryView::BinaryView(const uint8_t* data, const uint8_t* end) : data(data), end(end) {
+		}
+
+		BinaryType BinaryView::GetType() const {
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return BinaryType::INVALID;
+			return header.type;
+		}
+
+		bool BinaryView::IsValid() const {
+			return GetType() != BinaryType::INVALID;
+		}
+
+		bool BinaryView::IsNull() const {
+			return GetType() == BinaryType::NIL;
+		}
+
+		bool BinaryView::IsArray() const {
+			return GetType() == BinaryType::ARRAY;
+		}
+
+		bool BinaryView::IsMap() const {
+			return GetType() == BinaryType::MAP;
+		}
+
+		bool BinaryView::IsString() const {
+			return GetType() == BinaryType::STRING;
+		}
+
+		bool BinaryView::IsNumber() const {
+			BinaryType type = GetType();
+			return type == BinaryType::INTEGER || type == BinaryType::UNSIGNED || type == BinaryType::FLOAT;
+		}
+
+		size_t BinaryView::GetSize() const {
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return 0;
+			return (size_t)header.length;
+		}
+
+		size_t BinaryView::GetByteSize() const {
+			return GetValueSize(data, end);
+		}
+
+		bool BinaryView::AsBool(bool fallback) const {
+			if (GetType() != BinaryType::BOOL)
+				return fallback;
+			return data[0] == 0xC3;
+		}
+
+		int64_t BinaryView::AsInt(int64_t fallback) const {
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return fallback;
+
+			if (header.type == BinaryType::UNSIGNED) {
+				uint64_t value = AsUnsigned();
+				return value <= (uint64_t)std::numeric_limits<int64_t>::max() ? (int64_t)value : fallback;
+			}
+
+			if (header.type != BinaryType::INTEGER)
+				return fallback;
+
+			if (data[0] >= 0xE0)
+				return (int8_t)data[0];
+
+			size_t bits = (header.headerSize - 1) * 8;
+			uint64_t value = ReadBigEndian(data + 1, header.headerSize - 1);
+			return (int64_t)(value << (64 - bits)) >> (64 - bits);		// Sign extension
+		}
+
+		uint64_t BinaryView::AsUnsigned(uint64_t fallback) const {
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return fallback;
+
+			if (header.type == BinaryType::INTEGER) {
+				int64_t value = AsInt();
+				return value >= 0 ? (uint64_t)value : fallback;
+			}
+
+			if (header.type != BinaryType::UNSIGNED)
+				return fallback;
+
+			if (data[0] <= 0x7F)
+				return data[0];
+
+			return ReadBigEndian(data + 1, header.headerSize - 1);
+		}
+
+		double BinaryView::AsDouble(double fallback) const {
+			switch (GetType()) {
+			case BinaryType::INTEGER:
+				return (double)AsInt();
+			case BinaryType::UNSIGNED:
+				return (double)AsUnsigned();
+			case BinaryType::FLOAT:
+				break;
+			default:
+				return fallback;
+			}
+
+			if (data[0] == 0xCA) {
+				uint32_t bits = (uint32_t)ReadBigEndian(data + 1, 4);
+				float value;
+				memcpy(&value, &bits, sizeof(value));
+				return value;
+			}
+
+			uint64_t bits = ReadBigEndian(data + 1, 8);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		float BinaryView::AsFloat(float fallback) const {
+			return (float)AsDouble(fallback);
+		}
+
+		std::string_view BinaryView::AsString(std::string_view fallback) const {
+			Header header;
+			if (!ReadHeader(data, end, header) || header.type != BinaryType::STRING)
+				return fallback;
+
+			if ((uint64_t)(end - data - header.headerSize) < header.length)
+				return fallback;
+
+			return std::string_view((const char*)data + header.headerSize, (size_t)header.length);
+		}
+
+		std::string_view BinaryView::AsBinary() const {
+			Header header;
+			if (!ReadHeader(data, end, header) || header.type != BinaryType::BINARY)
+				return std::string_view();
+
+			if ((uint64_t)(end - data - header.headerSize) < header.length)
+				return std::string_view();
+
+			return std::string_view((const char*)data + header.headerSize, (size_t)header.length);
+		}
+
+		nlohmann::json BinaryView::ToJson() const {
+			nlohmann::json value;
+			if (ReadJson(data, end, value) == nullptr)
+				return nlohmann::json(nlohmann::json::value_t::discarded);
+
+			return value;
+		}
+
+		BinaryView BinaryView::operator[](size_t index) const {
+			if (GetType() != BinaryType::ARRAY || index >= GetSize())
+				return BinaryView();
+
+			BinaryView element = First();
+			for (size_t i = 0; i < index; i++)
+				element = element.Next();
+
+			return element;
+		}
+
+		BinaryView BinaryView::operator[](std::string_view key) const {
+			if (GetType() != BinaryType::MAP)
+				return BinaryView();
+
+			size_t size = GetSize();
+			BinaryView element = First();
+			for (size_t i = 0; i < size && element.IsValid(); i++) {
+				BinaryView value = element.Next();
+				if (element.IsString() && element.AsString() == key)
+					return value;
+				element = value.Next();
+			}
+
+			return BinaryView();
+		}
+
+		bool BinaryView::ForEachElement(const std::function<bool(const BinaryView& element)>& callback) const {
+			if (GetType() != BinaryType::ARRAY)
+				return false;
+
+			size_t size = GetSize();
+			BinaryView element = First();
+			for (size_t i = 0; i < size && element.IsValid(); i++) {
+				if (!callback(element))
+					break;
+				element = element.Next();
+			}
+
+			return true;
+		}
+
+		bool BinaryView::ForEachField(const std::function<bool(std::string_view key, const BinaryView& value)>& callback) const {
+			if (GetType() != BinaryType::MAP)
+				return false;
+
+			size_t size = GetSize();
+			BinaryView element = First();
+			for (size_t i = 0; i < size && element.IsValid(); i++) {
+				BinaryView value = element.Next();
+				if (!callback(element.AsString(), value))
+					break;
+				element = value.Next();
+			}
+
+			return true;
+		}
+
+		BinaryView BinaryView::First() const {
+			Header header;
+			if (!ReadHeader(data, end, header))
+				return BinaryView();
+			return BinaryView(data + header.headerSize, end);
+		}
+
+		BinaryView BinaryView::Next() const {
+			size_t size = GetValueSize(data, end);
+			if (size == 0)
+				return BinaryView();
+			return BinaryView(data + size, end);
+		}
+
+
+
+
+
+		BinaryFile::BinaryFile() {
+		}
+
+		BinaryFile::BinaryFile(const std::string& path) {
+			Open(path);
+		}
+
+		bool BinaryFile::Open(const std::string& path) {
+			return file.Open(path);
+		}
+
+		void BinaryFile::Close() {
+			file.Close();
+		}
+
+		bool BinaryFile::IsOpen() const {
+			return file.IsOpen();
+		}
+
+		BinaryView BinaryFile::GetRoot() const {
+			if (!file.IsOpen())
+				return BinaryView();
+			return BinaryView(file.GetView());
+		}
+
+
+
+
+
+		BinaryWriter::BinaryWriter() {
+		}
+
+		BinaryWriter& BinaryWriter::BeginArray(size_t count) {
+			BeforeValue();
+			WriteHeader(0x90, 16, 0, 0xDC, 0xDD, count);
+			remaining.push_back(count);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::BeginMap(size_t count) {
+			BeforeValue();
+			WriteHeader(0x80, 16, 0, 0xDE, 0xDF, count);
+			remaining.push_back((uint64_t)count * 2);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Key(std::string_view key) {
+			return Value(key);
+		}
+
+		BinaryWriter& BinaryWriter::Null() {
+			BeforeValue();
+			buffer.push_back((char)0xC0);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Value(bool value) {
+			BeforeValue();
+			buffer.push_back(value ? (char)0xC3 : (char)0xC2);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Value(float value) {
+			BeforeValue();
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			buffer.push_back((char)0xCA);
+			WriteBigEndian(bits, 4);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Value(double value) {
+			BeforeValue();
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			buffer.push_back((char)0xCB);
+			WriteBigEndian(bits, 8);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Value(const char* value) {
+			return Value(std::string_view(value));
+		}
+
+		BinaryWriter& BinaryWriter::Value(const std::string& value) {
+			return Value(std::string_view(value));
+		}
+
+		BinaryWriter& BinaryWriter::Value(std::string_view value) {
+			BeforeValue();
+			WriteHeader(0xA0, 32, 0xD9, 0xDA, 0xDB, value.size());
+			buffer.append(value.data(), value.size());
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Value(const nlohmann::json& value) {
+			BeforeValue();
+			nlohmann::json::to_msgpack(value, nlohmann::detail::output_adapter<char>(buffer));
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::Binary(const void* data, size_t size) {
+			BeforeValue();
+			WriteHeader(0, 0, 0xC4, 0xC5, 0xC6, size);
+			buffer.append((const char*)data, size);
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::WriteInteger(int64_t value) {
+			BeforeValue();
+			if (value >= -32) {
+				buffer.push_back((char)(int8_t)value);
+			}
+			else if (value >= std::numeric_limits<int8_t>::min()) {
+				buffer.push_back((char)0xD0);
+				WriteBigEndian((uint64_t)value, 1);
+			}
+			else if (value >= std::numeric_limits<int16_t>::min()) {
+				buffer.push_back((char)0xD1);
+				WriteBigEndian((uint64_t)value, 2);
+			}
+			else if (value >= std::numeric_limits<int32_t>::min()) {
+				buffer.push_back((char)0xD2);
+				WriteBigEndian((uint64_t)value, 4);
+			}
+			else {
+				buffer.push_back((char)0xD3);
+				WriteBigEndian((uint64_t)value, 8);
+			}
+			return *this;
+		}
+
+		BinaryWriter& BinaryWriter::WriteUnsigned(uint64_t value) {
+			BeforeValue();
+			if (value <= 0x7F) {
+				buffer.push_back((char)value);
+			}
+			else if (value <= std::numeric_limits<uint8_t>::max()) {
+				buffer.push_back((char)0xCC);
+				WriteBigEndian(value, 1);
+			}
+			else if (value <= std::numeric_limits<uint16_t>::max()) {
+				buffer.push_back((char)0xCD);
+				WriteBigEndian(value, 2);
+			}
+			else if (value <= std::numeric_limits<uint32_t>::max()) {
+				buffer.push_back((char)0xCE);
+				WriteBigEndian(value, 4);
+			}
+			else {
+				buffer.push_back((char)0xCF);
+				WriteBigEndian(value, 8);
+			}
+			return *this;
+		}
+
+		// Writes the smallest possible type marker for the length. A fixedLimit or base8 of 0 means the format has no such variant
+		void BinaryWriter::WriteHeader(uint8_t fixed, uint8_t fixedLimit, uint8_t base8, uint8_t base16, uint8_t base32, uint64_t length) {
+			if (length < fixedLimit) {
+				buffer.push_back((char)(fixed | length));
+			}
+			else if (base8 != 0 && length <= std::numeric_limits<uint8_t>::max()) {
+				buffer.push_back((char)base8);
+				WriteBigEndian(length, 1);
+			}
+			else if (length <= std::numeric_limits<uint16_t>::max()) {
+				buffer.push_back((char)base16);
+				WriteBigEndian(length, 2);
+			}
+			else if (length <= std::numeric_limits<uint32_t>::max()) {
+				buffer.push_back((char)base32);
+				WriteBigEndian(length, 4);
+			}
+			else {
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Length exceeds the MessagePack limit of 2^32-1");
+			}
+		}
+
+		void BinaryWriter::WriteBigEndian(uint64_t value, size_t bytes) {
+			char temp[8];
+			for (size_t i = 0; i < bytes; i++)
+				temp[i] = (char)(value >> ((bytes - 1 - i) * 8));
+			buffer.append(temp, bytes);
+		}
+
+		void BinaryWriter::BeforeValue() {
+			while (!remaining.empty() && remaining.back() == 0)
+				remaining.pop_back();
+
+			if (!remaining.empty())
+				remaining.back()--;
+		}
+
+		bool BinaryWriter::IsComplete() const {
+			for (uint64_t count : remaining) {
+				if (count != 0)
+					return false;
+			}
+			return true;
+		}
+
+		const std::string& BinaryWriter::GetData() const {
+			return buffer;
+		}
+
+		void BinaryWriter::Clear() {
+			buffer.clear();
+			remaining.clear();
+		}
+
+		bool BinaryWriter::Save(const std::string& path) const {
+
+			if (!IsComplete()) {
+				LOG_CORE_ERROR("{}(): Can't save '{}': A container did not receive all of its elements", __FUNCTION__, path);
+				return false;
+			}
+
+			if (!FileUtils::WriteBinaryFile(path, buffer)) {
+				LOG_CORE_ERROR("{}(): Failed to write file '{}'", __FUNCTION__, path);
+				return false;
+			}
+
+			return true;
+		}
+
+
+
+
+
+		bool WriteMsgPackFile(const std::string& path, const nlohmann::json& value) {
+			std::string content;
+			nlohmann::json::to_msgpack(value, nlohmann::detail::output_adapter<char>(content));
+
+			if (!FileUtils::WriteBinaryFile(path, content)) {
+				LOG_CORE_ERROR("{}(): Failed to write file '{}'", __FUNCTION__, path);
+				return false;
+			}
+
+			return true;
+		}
+
+		std::optional<nlohmann::json> ReadMsgPackFile(const std::string& path) {
+
+			BinaryFile file(path);
+			if (!file.IsOpen()) {
+				LOG_CORE_ERROR("{}(): Failed to open file '{}'", __FUNCTION__, path);
+				return std::nullopt;
+			}
+
+			nlohmann::json value = file.GetRoot().ToJson();
+			if (value.is_discarded()) {
+				LOG_CORE_ERROR("{}(): File '{}' is not valid MessagePack", __FUNCTION__, path);
+				return std::nullopt;
+			}
+
+			return value;
+		}
+
+	}
+}
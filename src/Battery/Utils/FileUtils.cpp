@@ -6,15 +6,24 @@
 #include "Battery/Core/AllegroContext.h"
 #include "Battery/Core/Config.h"
 #include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
 #include "Battery/AllegroDeps.h"
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // We want to use std::min() and std::max()
 #undef min
 #undef max
 
 #define CHECK_ALLEGRO_INIT() \
 	if (!Battery::AllegroContext::GetInstance()->IsInitialized()) {	\
-		throw Battery::Exception(__FUNCTION__ "(): Allegro Context is not initialized!");	\
+		throw Battery::Exception(std::string(__FUNCTION__) + "(): Allegro Context is not initialized!");	\
 	}
 
 namespace Battery {
@@ -26,7 +35,7 @@ namespace Battery {
 
 		bool FileExists(const std::string& path) {
 
-			if (!FilenameExists(path))
+			if (!FilenameExists(path) || DirectoryExists(path))
 				return false;
 
 			ALLEGRO_FILE* file = al_fopen(path.c_str(), "r");
@@ -40,46 +49,476 @@ namespace Battery {
 
 		bool DirectoryExists(const std::string& path) {
 
-			if (!FilenameExists(path))
+			// Opening is not enough to tell, on Linux a directory can be opened for reading like a file
+			std::optional<DirectoryEntry> info = GetFileInfo(path);
+			return info && info->IsDirectory();
+		}
+
+		static std::string JoinPath(const std::string& parent, const std::string& name) {
+			if (parent.empty())
+				return name;
+
+			if (parent.back() == '/' || parent.back() == '\\')
+				return parent + name;
+
+			return parent + "/" + name;
+		}
+
+#ifdef _WIN32
+		static std::wstring ToWideString(const std::string& str) {
+			int length = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.length(), nullptr, 0);
+			std::wstring wide(length, 0);
+			MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.length(), &wide[0], length);
+			return wide;
+		}
+
+		static std::string ToUTF8String(const wchar_t* str) {
+			int length = WideCharToMultiByte(CP_UTF8, 0, str, -1, nullptr, 0, nullptr, nullptr);
+			if (length <= 1)
+				return "";
+
+			std::string utf8(length - 1, 0);
+			WideCharToMultiByte(CP_UTF8, 0, str, -1, &utf8[0], length, nullptr, nullptr);
+			return utf8;
+		}
+
+		// FILETIME counts 100ns intervals since 1601-01-01
+		static std::time_t ToTimeT(const FILETIME& time) {
+			uint64_t filetime = (uint64_t)time.dwHighDateTime << 32 | time.dwLowDateTime;
+			return (std::time_t)(filetime / 10000000ULL) - 11644473600LL;
+		}
+#endif
+
+		// A single open directory listing: FindFirstFileEx() on Windows, opendir()/readdir() everywhere else.
+		// Both deliver the type of an entry without an additional call per file, Windows also delivers size and time
+		struct NativeDirectory {
+			std::string path;
+			size_t depth = 0;
+
+#ifdef _WIN32
+			HANDLE handle = INVALID_HANDLE_VALUE;
+			WIN32_FIND_DATAW findData;
+			bool findDataPending = false;
+#else
+			DIR* handle = nullptr;
+#endif
+
+			NativeDirectory(const std::string& path, size_t depth) : path(path), depth(depth) {
+#ifdef _WIN32
+				std::wstring pattern = ToWideString(JoinPath(path, "*"));
+				handle = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch,
+					nullptr, FIND_FIRST_EX_LARGE_FETCH);
+				findDataPending = (handle != INVALID_HANDLE_VALUE);
+#else
+				handle = opendir(path.c_str());
+#endif
+			}
+
+			~NativeDirectory() {
+#ifdef _WIN32
+				if (handle != INVALID_HANDLE_VALUE)
+					FindClose(handle);
+#else
+				if (handle != nullptr)
+					closedir(handle);
+#endif
+			}
+
+			NativeDirectory(const NativeDirectory&) = delete;
+			void operator=(const NativeDirectory&) = delete;
+
+			bool IsOpen() const {
+#ifdef _WIN32
+				return handle != INVALID_HANDLE_VALUE;
+#else
+				return handle != nullptr;
+#endif
+			}
+
+			// Read the next entry, "." and ".." are skipped. Only name, type, size and time are filled in.
+			// Returns false when no entries are left
+			bool Read(DirectoryEntry& entry) {
+				if (!IsOpen())
+					return false;
+
+#ifdef _WIN32
+				while (true) {
+					if (!findDataPending && !FindNextFileW(handle, &findData))
+						return false;
+
+					findDataPending = false;
+
+					const wchar_t* name = findData.cFileName;
+					if (wcscmp(name, L".") == 0 || wcscmp(name, L"..") == 0)
+						continue;
+
+					entry.name = ToUTF8String(name);
+
+					DWORD attributes = findData.dwFileAttributes;
+					bool isLink = (attributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+						(findData.dwReserved0 == IO_REPARSE_TAG_SYMLINK || findData.dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT);
+
+					if (isLink)
+						entry.type = DirectoryEntryType::SYMLINK;
+					else if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+						entry.type = DirectoryEntryType::DIRECTORY;
+					else
+						entry.type = DirectoryEntryType::FILE;
+
+					entry.size = (uint64_t)findData.nFileSizeHigh << 32 | findData.nFileSizeLow;
+					entry.modifiedTime = ToTimeT(findData.ftLastWriteTime);
+
+					return true;
+				}
+#else
+				while (dirent* e = readdir(handle)) {
+
+					if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+						continue;
+
+					entry.name = e->d_name;
+
+					switch (e->d_type) {
+					case DT_REG: entry.type = DirectoryEntryType::FILE; break;
+					case DT_DIR: entry.type = DirectoryEntryType::DIRECTORY; break;
+					case DT_LNK: entry.type = DirectoryEntryType::SYMLINK; break;
+					case DT_UNKNOWN: entry.type = DirectoryEntryType::NONE; break;
+					default: entry.type = DirectoryEntryType::OTHER; break;
+					}
+
+					// Size and time are not part of the listing, stat relative to the open directory
+					struct stat info;
+					if (fstatat(dirfd(handle), e->d_name, &info, AT_SYMLINK_NOFOLLOW) == 0) {
+						if (entry.type == DirectoryEntryType::NONE) {
+							if (S_ISREG(info.st_mode)) entry.type = DirectoryEntryType::FILE;
+							else if (S_ISDIR(info.st_mode)) entry.type = DirectoryEntryType::DIRECTORY;
+							else if (S_ISLNK(info.st_mode)) entry.type = DirectoryEntryType::SYMLINK;
+							else entry.type = DirectoryEntryType::OTHER;
+						}
+						entry.size = entry.IsDirectory() ? 0 : (uint64_t)info.st_size;
+						entry.modifiedTime = info.st_mtime;
+					}
+
+					return true;
+				}
 				return false;
+#endif
+			}
+		};
 
-			ALLEGRO_FILE* file = al_fopen(path.c_str(), "r");
+		std::optional<DirectoryEntry> GetFileInfo(const std::string& path) {
 
-			if (file == nullptr)
-				return true;
+			DirectoryEntry entry;
+			entry.name = std::string(PathUtils::GetFilename(path));
+			entry.path = path;
 
-			al_fclose(file);
-			return false;
+#ifdef _WIN32
+			WIN32_FILE_ATTRIBUTE_DATA info;
+			if (!GetFileAttributesExW(ToWideString(path).c_str(), GetFileExInfoStandard, &info))
+				return std::nullopt;
+
+			if (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				entry.type = DirectoryEntryType::DIRECTORY;
+			else
+				entry.type = DirectoryEntryType::FILE;
+
+			entry.size = entry.IsDirectory() ? 0 : (uint64_t)info.nFileSizeHigh << 32 | info.nFileSizeLow;
+			entry.modifiedTime = ToTimeT(info.ftLastWriteTime);
+#else
+			struct stat info;
+			if (stat(path.c_str(), &info) != 0)
+				return std::nullopt;
+
+			if (S_ISREG(info.st_mode)) entry.type = DirectoryEntryType::FILE;
+			else if (S_ISDIR(info.st_mode)) entry.type = DirectoryEntryType::DIRECTORY;
+			else entry.type = DirectoryEntryType::OTHER;
+
+			entry.size = entry.IsDirectory() ? 0 : (uint64_t)info.st_size;
+			entry.modifiedTime = info.st_mtime;
+#endif
+
+			return entry;
+		}
+
+		struct DirectoryIterator::State {
+			std::vector<std::unique_ptr<NativeDirectory>> stack;
+			DirectoryEntry current;
+			bool recursive = false;
+			DirectoryFilter filter;
+
+			bool Advance() {
+				while (!stack.empty()) {
+					NativeDirectory& dir = *stack.back();
+					DirectoryEntry entry;
+
+					if (!dir.Read(entry)) {
+						stack.pop_back();
+						continue;
+					}
+
+					entry.path = JoinPath(dir.path, entry.name);
+					entry.depth = dir.depth;
+
+					if (filter && !filter(entry))
+						continue;
+
+					current = std::move(entry);
+
+					if (recursive && current.IsDirectory()) {
+						auto subdirectory = std::make_unique<NativeDirectory>(current.path, current.depth + 1);
+						if (subdirectory->IsOpen())
+							stack.push_back(std::move(subdirectory));
+					}
+
+					return true;
+				}
+
+				return false;
+			}
+		};
+
+		DirectoryIterator::DirectoryIterator() {}
+
+		DirectoryIterator::DirectoryIterator(const std::string& path, bool recursive, DirectoryFilter filter) {
+			auto root = std::make_unique<NativeDirectory>(path, 0);
+
+			if (!root->IsOpen())
+				return;
+
+			state = std::make_shared<State>();
+			state->recursive = recursive;
+			state->filter = std::move(filter);
+			state->stack.push_back(std::move(root));
+
+			if (!state->Advance())
+				state.reset();
+		}
+
+		const DirectoryEntry& DirectoryIterator::operator*() const {
+			return state->current;
+		}
+
+		const DirectoryEntry* DirectoryIterator::operator->() const {
+			return &state->current;
+		}
+
+		DirectoryIterator& DirectoryIterator::operator++() {
+			if (state && !state->Advance())
+				state.reset();
+
+			return *this;
+		}
+
+		bool DirectoryIterator::operator==(const DirectoryIterator& other) const {
+			return state == other.state;
+		}
+
+		bool DirectoryIterator::operator!=(const DirectoryIterator& other) const {
+			return state != other.state;
+		}
+
+		MappedFile::MappedFile() {}
+
+		MappedFile::MappedFile(const std::string& path) {
+			Open(path);
+		}
+
+		MappedFile::MappedFile(MappedFile&& other) noexcept {
+			data = other.data;
+			size = other.size;
+			open = other.open;
+			other.data = nullptr;
+			other.size = 0;
+			other.open = false;
+		}
+
+		MappedFile::~MappedFile() {
+			Close();
+		}
+
+		MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+			if (this != &other) {
+				Close();
+				data = other.data;
+				size = other.size;
+				open = other.open;
+				other.data = nullptr;
+				other.size = 0;
+				other.open = false;
+			}
+			return *this;
+		}
+
+		bool MappedFile::Open(const std::string& path) {
+			Close();
+
+#ifdef _WIN32
+			HANDLE file = CreateFileW(ToWideString(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize)) {
+				CloseHandle(file);
+				return false;
+			}
+
+			// Empty files can't be mapped, but are valid nonetheless
+			if (fileSize.QuadPart > 0) {
+				HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping == nullptr) {
+					CloseHandle(file);
+					return false;
+				}
+
+				// The view keeps the mapping alive, both handles can be closed right away
+				data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+				CloseHandle(file);
+
+				if (data == nullptr)
+					return false;
+			}
+			else {
+				CloseHandle(file);
+			}
+
+			size = (size_t)fileSize.QuadPart;
+#else
+			int file = ::open(path.c_str(), O_RDONLY);
+
+			if (file < 0)
+				return false;
+
+			struct stat info;
+			if (fstat(file, &info) != 0) {
+				::close(file);
+				return false;
+			}
+
+			if (info.st_size > 0) {
+				void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+				::close(file);
+
+				if (mapped == MAP_FAILED)
+					return false;
+
+				madvise(mapped, (size_t)info.st_size, MADV_SEQUENTIAL);
+				data = (const char*)mapped;
+			}
+			else {
+				::close(file);
+			}
+
+			size = (size_t)info.st_size;
+#endif
+
+			open = true;
+			return true;
+		}
+
+		void MappedFile::Close() {
+			if (data != nullptr) {
+#ifdef _WIN32
+				UnmapViewOfFile(data);
+#else
+				munmap((void*)data, size);
+#endif
+			}
+
+			data = nullptr;
+			size = 0;
+			open = false;
+		}
+
+		bool MappedFile::IsOpen() const {
+			return open;
+		}
+
+		const char* MappedFile::GetData() const {
+			return data != nullptr ? data : "";
+		}
+
+		size_t MappedFile::GetSize() const {
+			return size;
 		}
 
 		std::vector<std::string> GetDirectoryContent(const std::string& path) {
 			std::vector<std::string> elements;
 
-			if (!DirectoryExists(path))
-				return elements;
+			for (const DirectoryEntry& entry : DirectoryIterator(path)) {
+				elements.push_back(entry.name);
+			}
 
-			ALLEGRO_FS_ENTRY* dir = al_create_fs_entry(path.c_str());
+			return elements;
+		}
 
-			if (dir == nullptr)
-				return elements;
+		std::vector<DirectoryEntry> EnumerateDirectory(const std::string& path, bool recursive, DirectoryFilter filter) {
+			std::vector<DirectoryEntry> entries;
 
-			ALLEGRO_FS_ENTRY* e;
-			al_open_directory(dir);
-			do {
-				e = al_read_directory(dir);
+			for (const DirectoryEntry& entry : DirectoryIterator(path, recursive, std::move(filter))) {
+				entries.push_back(entry);
+			}
+
+			return entries;
+		}
+
+		std::vector<DirectoryEntry> EnumerateDirectoryParallel(const std::string& path, DirectoryFilter filter, size_t threadCount) {
+
+			std::vector<DirectoryEntry> topLevel = EnumerateDirectory(path, false, filter);
+
+			// Every top-level subdirectory is one job, the results are merged in order afterwards
+			std::vector<size_t> jobs;
+			for (size_t i = 0; i < topLevel.size(); i++) {
+				if (topLevel[i].IsDirectory())
+					jobs.push_back(i);
+			}
+
+			std::vector<std::vector<DirectoryEntry>> subtrees(topLevel.size());
+			std::atomic<size_t> nextJob(0);
 
-				if (e != nullptr) {
-					elements.push_back(GetFilenameFromPath(al_get_fs_entry_name(e)));
+			auto worker = [&]() {
+				size_t job;
+				while ((job = nextJob++) < jobs.size()) {
+					size_t index = jobs[job];
+					subtrees[index] = EnumerateDirectory(topLevel[index].path, true, filter);
+
+					for (DirectoryEntry& entry : subtrees[index]) {
+						entry.depth++;
+					}
 				}
+			};
 
-				al_destroy_fs_entry(e);
+			if (threadCount == 0)
+				threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			threadCount = std::min(threadCount, jobs.size());
 
-			} while (e != nullptr);
-			al_close_directory(dir);
+			// The calling thread does its share as well
+			std::vector<std::thread> threads;
+			for (size_t i = 1; i < threadCount; i++) {
+				threads.emplace_back(worker);
+			}
+			worker();
 
-			al_destroy_fs_entry(dir);
+			for (std::thread& thread : threads) {
+				thread.join();
+			}
 
-			return elements;
+			size_t count = topLevel.size();
+			for (const auto& subtree : subtrees) {
+				count += subtree.size();
+			}
+
+			std::vector<DirectoryEntry> entries;
+			entries.reserve(count);
+			for (size_t i = 0; i < topLevel.size(); i++) {
+				entries.push_back(std::move(topLevel[i]));
+				std::move(subtrees[i].begin(), subtrees[i].end(), std::back_inserter(entries));
+			}
+
+			return entries;
 		}
 
 		bool MakeDirectory(const std::string& path) {
@@ -153,29 +592,81 @@ namespace Battery {
 			return true;
 		}
 
+		bool WriteBinaryFile(const std::string& path, std::string_view content) {
+
+			PrepareDirectory(GetDirectoryFromPath(path));
+
+			ALLEGRO_FILE* file = al_fopen(path.c_str(), "wb");
+
+			if (file == nullptr)
+				return false;
+
+			size_t written = al_fwrite(file, content.data(), content.size());
+			bool failed = al_ferror(file) || written != content.size();
+
+			if (!al_fclose(file) || failed) {
+				RemoveFile(path);
+				return false;
+			}
+
+			return true;
+		}
+
 		bool RemoveFile(const std::string& path) {
 			return al_remove_filename(path.c_str());
 		}
 
-		bool RemoveDirectory(const std::string& path) {
+		// Delete a link or special file itself. al_remove_filename() follows links: A link to a directory
+		// would be treated as a directory and a dangling link can't be removed at all
+		static bool RemoveLink(const std::string& path) {
+#ifdef _WIN32
+			std::wstring widePath = ToWideString(path);
+			DWORD attributes = GetFileAttributesW(widePath.c_str());	// Of the link, not of its target
+			if (attributes == INVALID_FILE_ATTRIBUTES)
+				return false;
 
-			if (!DirectoryExists(path)) {							// If directory can't be accessed, check if the parent can
-				return FilenameExists(GetDirectoryFromPath(path));	// be accessed to see if it's a permission problem
-			}
+			// Directory symlinks and junctions are removed like an empty directory, the target is untouched
+			if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+				return RemoveDirectoryW(widePath.c_str()) != 0;
 
-			std::vector<std::string> content = GetDirectoryContent(path);
+			return DeleteFileW(widePath.c_str()) != 0;
+#else
+			return unlink(path.c_str()) == 0;
+#endif
+		}
+
+		// Delete everything inside the directory, the type of every entry is known from the listing.
+		// Links are never followed, only the link itself is removed
+		static bool RemoveDirectoryEntries(const std::string& path) {
 
-			for (std::string e : content) {
-				if (DirectoryExists(path + "/" + e)) {
-					if (!RemoveDirectory(path + "/" + e))
+			// The listing is collected first, so it is not modified while it's being read
+			for (const DirectoryEntry& entry : EnumerateDirectory(path)) {
+				if (entry.IsDirectory()) {
+					if (!RemoveDirectoryEntries(entry.path) || !RemoveFile(entry.path))
+						return false;
+				}
+				else if (entry.type == DirectoryEntryType::SYMLINK || entry.type == DirectoryEntryType::OTHER) {
+					if (!RemoveLink(entry.path))
 						return false;
 				}
 				else {
-					if (!RemoveFile(path + "/" + e))
+					if (!RemoveFile(entry.path))
 						return false;
 				}
 			}
 
+			return true;
+		}
+
+		bool RemoveDirectory(const std::string& path) {
+
+			if (!DirectoryExists(path)) {							// If directory can't be accessed, check if the parent can
+				return FilenameExists(GetDirectoryFromPath(path));	// be accessed to see if it's a permission problem
+			}
+
+			if (!RemoveDirectoryEntries(path))
+				return false;
+
 			return RemoveFile(path);
 		}
 
@@ -185,20 +676,7 @@ namespace Battery {
 				return false;
 			}
 
-			std::vector<std::string> content = GetDirectoryContent(path);
-
-			for (std::string e : content) {
-				if (DirectoryExists(path + "/" + e)) {
-					if (!RemoveDirectory(path + "/" + e))
-						return false;
-				}
-				else {
-					if (!RemoveFile(path + "/" + e))
-						return false;
-				}
-			}
-
-			return true;
+			return RemoveDirectoryEntries(path);
 		}
 
 		bool PrepareEmptyDirectory(const std::string& path) {
@@ -519,65 +997,47 @@ namespace Battery {
 
 
 		std::string GetFilenameFromPath(const std::string& path) {
-			ALLEGRO_PATH* p = al_create_path(path.c_str());
-
-			std::string filename = al_get_path_filename(p);
-
-			al_destroy_path(p);
-			return filename;
+			return std::string(PathUtils::GetFilename(path));
 		}
 
 		std::string GetBasenameFromPath(const std::string& path) {
-			ALLEGRO_PATH* p = al_create_path(path.c_str());
-
-			std::string filename = al_get_path_basename(p);
-
-			al_destroy_path(p);
-			return filename;
+			return std::string(PathUtils::GetStem(path));
 		}
 
 		std::string GetExtensionFromPath(const std::string& path) {
-			ALLEGRO_PATH* p = al_create_path(path.c_str());
-
-			std::string filename = al_get_path_extension(p);
-
-			al_destroy_path(p);
-			return filename;
+			return std::string(PathUtils::GetExtension(path));
 		}
 
 		std::vector<std::string> GetComponentsFromPath(const std::string& path) {
-			ALLEGRO_PATH* p = al_create_path(path.c_str());
 
 			std::vector<std::string> v;
 
 			if (path.length() == 0)
 				return v;
 
-			if (std::string(al_get_path_drive(p)) != "") {	// There is a drive letter, absolute path
-				v.push_back(std::string(al_get_path_drive(p)));
-
-				for (int i = 1; i < al_get_path_num_components(p); i++)
-					v.push_back(std::string(al_get_path_component(p, i)));
-			}
-			else {	// There is no drive letter, relative path
-				for (int i = 0; i < al_get_path_num_components(p); i++)
-					v.push_back(std::string(al_get_path_component(p, i)));
-			}
+			if (PathUtils::IsSeparator(path[0]))	// Absolute path without drive letter starts with an empty component
+				v.push_back("");
 
-			if (std::string(al_get_path_filename(p)).length() > 0)
-				v.push_back(std::string(al_get_path_filename(p)));
+			for (std::string_view component : PathUtils::Components(path))
+				v.emplace_back(component);
 
-			al_destroy_path(p);
 			return v;
 		}
 
 		std::string GetDirectoryFromPath(const std::string& path) {
 
-			std::vector<std::string> arr = GetComponentsFromPath(path);
 			std::string p;
+			size_t count = PathUtils::Components(path).size();
+
+			if (path.length() > 0 && PathUtils::IsSeparator(path[0]))
+				p += "/";
 
-			for (size_t i = 0; i < arr.size() - 1; i++)
-				p += arr[i] + "/";
+			for (std::string_view component : PathUtils::Components(path)) {
+				if (count-- <= 1)
+					break;
+				p.append(component.data(), component.size());
+				p += "/";
+			}
 
 			return p;
 		}
@@ -604,7 +1064,7 @@ namespace Battery {
 				}
 				break;
 			default:
-				throw Battery::Exception("Invalid enum supplied to " __FUNCTION__ "()");
+				throw Battery::Exception("Invalid enum supplied to " + std::string(__FUNCTION__) + "()");
 			}
 
 			return str;
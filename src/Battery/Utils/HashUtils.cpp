@@ -0,0 +1,132 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/HashUtils.h"
+#include "Battery/Utils/FileUtils.h"
+
+namespace Battery {
+	namespace HashUtils {
+
+		// Constants and structure of XXH64, see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+		static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+		static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+		static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+		static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+		static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+		static inline uint64_t RotateLeft(uint64_t value, int bits) {
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		// Input is read as little endian, which every supported platform is
+		static inline uint64_t Read64(const uint8_t* data) {
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		static inline uint32_t Read32(const uint8_t* data) {
+			uint32_t value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		static inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+			accumulator += input * PRIME2;
+			accumulator = RotateLeft(accumulator, 31);
+			return accumulator * PRIME1;
+		}
+
+		static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+			accumulator ^= Round(0, value);
+			return accumulator * PRIME1 + PRIME4;
+		}
+
+		uint64_t Hash64(const void* data, size_t size, uint64_t seed) {
+
+			const uint8_t* current = (const uint8_t*)data;
+			const uint8_t* end = current + size;
+			uint64_t hash;
+
+			if (size >= 32) {
+				uint64_t v1 = seed + PRIME1 + PRIME2;
+				uint64_t v2 = seed + PRIME2;
+				uint64_t v3 = seed;
+				uint64_t v4 = seed - PRIME1;
+
+				// Four independent lanes, 32 bytes per iteration
+				const uint8_t* limit = end - 32;
+				do {
+					v1 = Round(v1, Read64(current));
+					v2 = Round(v2, Read64(current + 8));
+					v3 = Round(v3, Read64(current + 16));
+					v4 = Round(v4, Read64(current + 24));
+					current += 32;
+				} while (current <= limit);
+
+				hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+				hash = MergeRound(hash, v1);
+				hash = MergeRound(hash, v2);
+				hash = MergeRound(hash, v3);
+				hash = MergeRound(hash, v4);
+			}
+			else {
+				hash = seed + PRIME5;
+			}
+
+			hash += (uint64_t)size;
+
+			while (end - current >= 8) {
+				hash ^= Round(0, Read64(current));
+				hash = RotateLeft(hash, 27) * PRIME1 + PRIME4;
+				current += 8;
+			}
+
+			if (end - current >= 4) {
+				hash ^= (uint64_t)Read32(current) * PRIME1;
+				hash = RotateLeft(hash, 23) * PRIME2 + PRIME3;
+				current += 4;
+			}
+
+			while (current < end) {
+				hash ^= (uint64_t)(*current) * PRIME5;
+				hash = RotateLeft(hash, 11) * PRIME1;
+				current++;
+			}
+
+			// Final avalanche
+			hash ^= hash >> 33;
+			hash *= PRIME2;
+			hash ^= hash >> 29;
+			hash *= PRIME3;
+			hash ^= hash >> 32;
+
+			return hash;
+		}
+
+		uint64_t Hash64(std::string_view str, uint64_t seed) {
+			return Hash64(str.data(), str.size(), seed);
+		}
+
+		std::optional<uint64_t> HashFile(const std::string& path) {
+			FileUtils::MappedFile file(path);
+
+			if (!file.IsOpen())
+				return std::nullopt;
+
+			return Hash64(file.GetData(), file.GetSize());
+		}
+
+		std::string ToHexString(uint64_t hash) {
+			static const char* hex = "0123456789abcdef";
+			std::string str(16, '0');
+
+			for (int i = 15; i >= 0; i--) {
+				str[i] = hex[hash & 0xF];
+				hash >>= 4;
+			}
+
+			return str;
+		}
+
+	}
+}
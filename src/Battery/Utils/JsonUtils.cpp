@@ -0,0 +1,438 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/JsonUtils.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Core/Exception.h"
+#include "Battery/Log/Log.h"
+
+namespace Battery {
+	namespace JsonUtils {
+
+		// Builds a DOM for one element of the top-level array at a time and hands it to the callback
+		class ArrayElementSax : public SaxHandler {
+		public:
+			ArrayElementSax(std::function<bool(nlohmann::json& element)> callback) : callback(std::move(callback)) {}
+
+			bool null() override {
+				return AddValue(nullptr);
+			}
+
+			bool boolean(bool val) override {
+				return AddValue(val);
+			}
+
+			bool number_integer(number_integer_t val) override {
+				return AddValue(val);
+			}
+
+			bool number_unsigned(number_unsigned_t val) override {
+				return AddValue(val);
+			}
+
+			bool number_float(number_float_t val, const string_t& s) override {
+				return AddValue(val);
+			}
+
+			bool string(string_t& val) override {
+				return AddValue(std::move(val));
+			}
+
+			bool start_object(std::size_t elements) override {
+				return StartContainer(nlohmann::json::object());
+			}
+
+			bool key(string_t& val) override {
+				currentKey = std::move(val);
+				return true;
+			}
+
+			bool end_object() override {
+				return EndContainer();
+			}
+
+			bool start_array(std::size_t elements) override {
+				if (!rootStarted) {		// The top-level array itself is never built
+					rootStarted = true;
+					return true;
+				}
+				return StartContainer(nlohmann::json::array());
+			}
+
+			bool end_array() override {
+				if (stack.empty())		// End of the top-level array
+					return true;
+
+				return EndContainer();
+			}
+
+			bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex) override {
+				LOG_CORE_ERROR("JSON parse error at byte {}: {}", position, ex.what());
+				return false;
+			}
+
+			bool stopped = false;
+
+		private:
+			bool AddValue(nlohmann::json&& value) {
+				if (!rootStarted) {
+					LOG_CORE_ERROR("Can't iterate JSON array elements: The top-level value is not an array!");
+					return false;
+				}
+
+				if (stack.empty()) {
+					element = std::move(value);
+					return Emit();
+				}
+
+				nlohmann::json* parent = stack.back();
+				if (parent->is_object())
+					(*parent)[currentKey] = std::move(value);
+				else
+					parent->push_back(std::move(value));
+
+				return true;
+			}
+
+			bool StartContainer(nlohmann::json&& container) {
+				if (!rootStarted) {
+					LOG_CORE_ERROR("Can't iterate JSON array elements: The top-level value is not an array!");
+					return false;
+				}
+
+				if (stack.empty()) {
+					element = std::move(container);
+					stack.push_back(&element);
+					return true;
+				}
+
+				// The parent is not modified while the child is open, so the pointer stays valid
+				nlohmann::json* parent = stack.back();
+				if (parent->is_object()) {
+					stack.push_back(&((*parent)[currentKey] = std::move(container)));
+				}
+				else {
+					parent->push_back(std::move(container));
+					stack.push_back(&parent->back());
+				}
+
+				return true;
+			}
+
+			bool EndContainer() {
+				stack.pop_back();
+
+				if (stack.empty())
+					return Emit();
+
+				return true;
+			}
+
+			bool Emit() {
+				bool proceed = callback(element);
+				element = nullptr;
+				stopped = !proceed;
+				return proceed;
+			}
+
+			std::function<bool(nlohmann::json& element)> callback;
+			nlohmann::json element;
+			std::vector<nlohmann::json*> stack;
+			std::string currentKey;
+			bool rootStarted = false;
+		};
+
+		bool ParseFileSax(const std::string& path, SaxHandler* handler) {
+
+			FileUtils::MappedFile file(path);
+
+			if (!file.IsOpen()) {
+				LOG_CORE_ERROR("{}(): Can't open file '{}'", __FUNCTION__, path);
+				return false;
+			}
+
+			return ParseSax(file.GetView(), handler);
+		}
+
+		bool ParseSax(std::string_view json, SaxHandler* handler) {
+
+			if (handler == nullptr)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): The supplied SAX handler is nullptr!");
+
+			const char* begin = json.data();
+			return nlohmann::json::sax_parse(begin, begin + json.size(), handler);
+		}
+
+		bool ForEachArrayElement(const std::string& path, std::function<bool(nlohmann::json& element)> callback) {
+
+			ArrayElementSax handler(std::move(callback));
+
+			if (ParseFileSax(path, &handler))
+				return true;
+
+			return handler.stopped;		// Stopped by the callback is not an error
+		}
+
+
+
+
+
+
+		JsonWriter::JsonWriter() {}
+
+		JsonWriter::JsonWriter(const std::string& path) {
+			Open(path);
+		}
+
+		JsonWriter::~JsonWriter() {
+			if (IsOpen()) {
+				Close();
+			}
+		}
+
+		bool JsonWriter::Open(const std::string& path) {
+
+			if (IsOpen()) {
+				Close();
+			}
+
+			FileUtils::PrepareDirectory(FileUtils::GetDirectoryFromPath(path));
+
+			file = al_fopen(path.c_str(), "wb");
+
+			if (file == nullptr) {
+				LOG_CORE_ERROR("{}(): Can't open file '{}' for writing", __FUNCTION__, path);
+				return false;
+			}
+
+			buffer.clear();
+			buffer.reserve(BATTERY_JSON_WRITER_BUFFER_SIZE);
+			scopes.clear();
+			rootWritten = false;
+			failed = false;
+			bytesWritten = 0;
+			return true;
+		}
+
+		bool JsonWriter::Close() {
+
+			if (!IsOpen())
+				return false;
+
+			Flush();
+			al_fclose(file);
+			file = nullptr;
+
+			if (!scopes.empty()) {
+				LOG_CORE_ERROR("{}(): JSON document was closed with {} unfinished objects or arrays", __FUNCTION__, scopes.size());
+				return false;
+			}
+
+			return !failed;
+		}
+
+		bool JsonWriter::IsOpen() const {
+			return file != nullptr;
+		}
+
+		bool JsonWriter::HasFailed() const {
+			return failed;
+		}
+
+		uint64_t JsonWriter::GetBytesWritten() const {
+			return bytesWritten + buffer.size();
+		}
+
+		JsonWriter& JsonWriter::BeginObject() {
+			BeforeValue();
+			Write("{");
+			scopes.push_back({ true, true, false });
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::EndObject() {
+			if (scopes.empty() || !scopes.back().isObject || scopes.back().keyWritten)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): No object to end or a key is missing its value!");
+
+			Write("}");
+			scopes.pop_back();
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::BeginArray() {
+			BeforeValue();
+			Write("[");
+			scopes.push_back({ false, true, false });
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::EndArray() {
+			if (scopes.empty() || scopes.back().isObject)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): No array to end!");
+
+			Write("]");
+			scopes.pop_back();
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Key(std::string_view key) {
+			if (scopes.empty() || !scopes.back().isObject || scopes.back().keyWritten)
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Keys can only be written inside of an object, followed by a value!");
+
+			Scope& scope = scopes.back();
+			if (!scope.empty)
+				Write(",");
+
+			scope.empty = false;
+			scope.keyWritten = true;
+			WriteString(key);
+			Write(":");
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Null() {
+			BeforeValue();
+			Write("null");
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Value(bool value) {
+			BeforeValue();
+			Write(value ? "true" : "false");
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Value(double value) {
+			BeforeValue();
+
+			if (!std::isfinite(value)) {	// Same as nlohmann::json: NaN and infinity become null
+				Write("null");
+				return *this;
+			}
+
+			char str[64];
+			char* end = nlohmann::detail::to_chars(str, str + sizeof(str), value);
+			Write(std::string_view(str, end - str));
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Value(const char* value) {
+			return Value(std::string_view(value));
+		}
+
+		JsonWriter& JsonWriter::Value(const std::string& value) {
+			return Value(std::string_view(value));
+		}
+
+		JsonWriter& JsonWriter::Value(std::string_view value) {
+			BeforeValue();
+			WriteString(value);
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::Value(const nlohmann::json& value) {
+			BeforeValue();
+			Write(value.dump());
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::WriteInteger(int64_t value) {
+			BeforeValue();
+			Write(std::to_string(value));
+			return *this;
+		}
+
+		JsonWriter& JsonWriter::WriteUnsigned(uint64_t value) {
+			BeforeValue();
+			Write(std::to_string(value));
+			return *this;
+		}
+
+		void JsonWriter::WriteString(std::string_view value) {
+			static const char* hex = "0123456789abcdef";
+
+			// Copy everything that does not need escaping in one piece
+			buffer.push_back('"');
+			size_t runStart = 0;
+			for (size_t i = 0; i < value.size(); i++) {
+				unsigned char c = value[i];
+				if (c >= 0x20 && c != '"' && c != '\\')
+					continue;
+
+				buffer.append(value.data() + runStart, i - runStart);
+				runStart = i + 1;
+
+				switch (c) {
+				case '"':  buffer += "\\\""; break;
+				case '\\': buffer += "\\\\"; break;
+				case '\b': buffer += "\\b"; break;
+				case '\f': buffer += "\\f"; break;
+				case '\n': buffer += "\\n"; break;
+				case '\r': buffer += "\\r"; break;
+				case '\t': buffer += "\\t"; break;
+				default:
+					buffer += "\\u00";
+					buffer.push_back(hex[c >> 4]);
+					buffer.push_back(hex[c & 0x0F]);
+					break;
+				}
+			}
+			buffer.append(value.data() + runStart, value.size() - runStart);
+			buffer.push_back('"');
+
+			if (buffer.size() >= BATTERY_JSON_WRITER_BUFFER_SIZE)
+				Flush();
+		}
+
+		void JsonWriter::BeforeValue() {
+
+			if (!IsOpen())
+				throw Battery::Exception(std::string(__FUNCTION__) + "(): Can't write JSON: No file is open!");
+
+			if (scopes.empty()) {
+				if (rootWritten)
+					throw Battery::Exception(std::string(__FUNCTION__) + "(): A JSON document can only have one top-level value!");
+
+				rootWritten = true;
+				return;
+			}
+
+			Scope& scope = scopes.back();
+			if (scope.isObject) {
+				if (!scope.keyWritten)
+					throw Battery::Exception(std::string(__FUNCTION__) + "(): Values inside of an object need a Key() first!");
+
+				scope.keyWritten = false;
+				return;
+			}
+
+			if (!scope.empty)
+				Write(",");
+
+			scope.empty = false;
+		}
+
+		void JsonWriter::Write(std::string_view str) {
+			buffer.append(str.data(), str.size());
+
+			if (buffer.size() >= BATTERY_JSON_WRITER_BUFFER_SIZE)
+				Flush();
+		}
+
+		void JsonWriter::Flush() {
+
+			if (file == nullptr || buffer.empty())
+				return;
+
+			size_t written = al_fwrite(file, buffer.data(), buffer.size());
+			bytesWritten += written;
+
+			if (written != buffer.size() || al_ferror(file)) {
+				LOG_CORE_ERROR("{}(): Failed to write JSON data to the file!", __FUNCTION__);
+				failed = true;
+			}
+
+			buffer.clear();
+		}
+
+	}
+}
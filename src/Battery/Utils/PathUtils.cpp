@@ -0,0 +1,206 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/PathUtils.h"
+
+namespace Battery {
+	namespace PathUtils {
+
+		Components::Iterator::Iterator() {
+		}
+
+		Components::Iterator::Iterator(std::string_view path, size_t position) : path(path), begin(position), end(position) {
+			while (begin < path.size() && IsSeparator(path[begin]))
+				begin++;
+			FindEnd();
+		}
+
+		std::string_view Components::Iterator::operator*() const {
+			return path.substr(begin, end - begin);
+		}
+
+		Components::Iterator& Components::Iterator::operator++() {
+			begin = end;
+			while (begin < path.size() && IsSeparator(path[begin]))
+				begin++;
+			FindEnd();
+			return *this;
+		}
+
+		bool Components::Iterator::operator==(const Iterator& other) const {
+			return path.data() == other.path.data() && begin == other.begin;
+		}
+
+		bool Components::Iterator::operator!=(const Iterator& other) const {
+			return !(*this == other);
+		}
+
+		void Components::Iterator::FindEnd() {
+			end = begin;
+			while (end < path.size() && !IsSeparator(path[end]))
+				end++;
+		}
+
+		Components::Components(std::string_view path) : path(path) {
+		}
+
+		Components::Iterator Components::begin() const {
+			return Iterator(path, 0);
+		}
+
+		Components::Iterator Components::end() const {
+			return Iterator(path, path.size());
+		}
+
+		size_t Components::size() const {
+			size_t count = 0;
+			for (auto it = begin(); it != end(); ++it)
+				count++;
+			return count;
+		}
+
+
+
+
+
+		std::string_view GetFilename(std::string_view path) {
+			size_t separator = path.find_last_of("/\\");
+			if (separator == std::string_view::npos)
+				return path;
+			return path.substr(separator + 1);
+		}
+
+		std::string_view GetStem(std::string_view path) {
+			std::string_view filename = GetFilename(path);
+			if (filename == "." || filename == "..")
+				return filename;
+
+			size_t dot = filename.rfind('.');
+			if (dot == std::string_view::npos)
+				return filename;
+			return filename.substr(0, dot);
+		}
+
+		std::string_view GetExtension(std::string_view path) {
+			std::string_view filename = GetFilename(path);
+			if (filename == "." || filename == "..")
+				return std::string_view();
+
+			size_t dot = filename.rfind('.');
+			if (dot == std::string_view::npos)
+				return std::string_view();
+			return filename.substr(dot);
+		}
+
+		std::string_view GetParent(std::string_view path) {
+			size_t separator = path.find_last_of("/\\");
+			if (separator == std::string_view::npos)
+				return std::string_view();
+			return path.substr(0, separator + 1);
+		}
+
+		static bool HasDrive(std::string_view path) {
+			return path.size() >= 2 && path[1] == ':' && std::isalpha((unsigned char)path[0]);
+		}
+
+		bool IsAbsolute(std::string_view path) {
+			return (!path.empty() && IsSeparator(path[0])) || HasDrive(path);
+		}
+
+		bool HasExtension(std::string_view path, std::string_view extension) {
+			std::string_view actual = GetExtension(path);
+
+			if (!actual.empty())
+				actual.remove_prefix(1);
+			if (!extension.empty() && extension[0] == '.')
+				extension.remove_prefix(1);
+
+			if (actual.size() != extension.size())
+				return false;
+
+			for (size_t i = 0; i < actual.size(); i++) {
+				if (std::tolower((unsigned char)actual[i]) != std::tolower((unsigned char)extension[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		void JoinTo(std::string& result, std::string_view base, std::string_view path) {
+
+			if (base.empty() || IsAbsolute(path)) {
+				result.assign(path.data(), path.size());
+				return;
+			}
+
+			result.assign(base.data(), base.size());
+			if (!path.empty() && !IsSeparator(result.back()))
+				result.push_back('/');
+			result.append(path.data(), path.size());
+		}
+
+		void NormalizeTo(std::string& result, std::string_view path) {
+
+			result.clear();
+			if (path.empty())
+				return;
+
+			size_t start = 0;
+			bool rooted = false;
+
+			if (HasDrive(path)) {
+				result.append(path.data(), 2);
+				start = 2;
+			}
+			if (start < path.size() && IsSeparator(path[start])) {
+				result.push_back('/');
+				rooted = true;
+			}
+
+			size_t rootLength = result.size();
+			size_t depth = 0;		// Number of components which can be removed by ".."
+
+			for (std::string_view component : Components(path.substr(start))) {
+
+				if (component == ".")
+					continue;
+
+				if (component == "..") {
+					if (depth > 0) {
+						size_t separator = result.rfind('/');
+						result.resize(separator == std::string::npos || separator < rootLength ? rootLength : separator);
+						depth--;
+						continue;
+					}
+					if (rooted)		// Nothing is above the root
+						continue;
+				}
+				else {
+					depth++;
+				}
+
+				if (result.size() > rootLength)
+					result.push_back('/');
+				result.append(component.data(), component.size());
+			}
+
+			if (IsSeparator(path.back()) && result.size() > rootLength)
+				result.push_back('/');
+
+			if (result.empty())
+				result = ".";
+		}
+
+		std::string Join(std::string_view base, std::string_view path) {
+			std::string result;
+			JoinTo(result, base, path);
+			return result;
+		}
+
+		std::string Normalize(std::string_view path) {
+			std::string result;
+			NormalizeTo(result, path);
+			return result;
+		}
+
+	}
+}
@@ -0,0 +1,118 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/ThreadPool.h"
+
+namespace Battery {
+
+	struct ThreadPool::Job {
+		const std::function<void(size_t, size_t)>* function = nullptr;
+		size_t count = 0;
+		size_t chunks = 0;
+		std::atomic<size_t> nextChunk = 0;
+		std::atomic<size_t> finishedChunks = 0;
+	};
+
+	// Set on threads which are currently running a job, to run nested calls inline
+	static thread_local bool insideJob = false;
+
+	ThreadPool::ThreadPool(size_t threadCount) {
+
+		if (threadCount == 0) {
+			size_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		for (size_t i = 0; i < threadCount; i++) {
+			workers.emplace_back(&ThreadPool::WorkerThread, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function) {
+
+		if (count == 0)
+			return;
+
+		if (workers.empty() || count == 1 || insideJob) {
+			function(0, count);
+			return;
+		}
+
+		std::lock_guard<std::mutex> call(callMutex);
+
+		// A few chunks per thread, so that uneven work is still balanced
+		auto job = std::make_shared<Job>();
+		job->function = &function;
+		job->count = count;
+		job->chunks = std::min(count, (workers.size() + 1) * 4);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			currentJob = job;
+		}
+		condition.notify_all();
+
+		RunJob(*job);
+
+		// Workers may still hold on to the job afterwards, but they can't claim any chunk anymore
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [&] { return job->finishedChunks == job->chunks; });
+		currentJob = nullptr;
+	}
+
+	size_t ThreadPool::GetThreadCount() const {
+		return workers.size();
+	}
+
+	ThreadPool& ThreadPool::GetShared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::WorkerThread() {
+
+		std::shared_ptr<Job> job;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [&] { return stopping || (currentJob != nullptr && currentJob != job); });
+				if (stopping)
+					return;
+				job = currentJob;
+			}
+
+			RunJob(*job);
+		}
+	}
+
+	void ThreadPool::RunJob(Job& job) {
+
+		insideJob = true;
+
+		size_t chunk;
+		while ((chunk = job.nextChunk++) < job.chunks) {
+			size_t begin = job.count * chunk / job.chunks;
+			size_t end = job.count * (chunk + 1) / job.chunks;
+			(*job.function)(begin, end);
+
+			if (++job.finishedChunks == job.chunks) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+
+		insideJob = false;
+	}
+
+}
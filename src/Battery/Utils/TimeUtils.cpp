@@ -41,7 +41,7 @@ namespace Battery {
 				std::this_thread::sleep_for(std::chrono::microseconds((long long)(seconds * 1000000)));
 			}
 			else {
-				LOG_CORE_ERROR(__FUNCTION__ "(): Can't sleep: The Allegro context was not initialized!");
+				LOG_CORE_ERROR("{}(): Can't sleep: The Allegro context was not initialized!", __FUNCTION__);
 			}
 		}
 
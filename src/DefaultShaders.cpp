@@ -213,6 +213,54 @@ namespace Battery {
 		"	FragColor = color;\n"
 		"}\n"
 		"\n";
+
+
+
+
+
+
+	// For the batched sprites, their vertices carry the color as 4 bytes in the first user attribute
+
+	const std::string BATTERY_SHADER_SOURCE_VERTEX_SPRITE = "\n"
+		"\n"
+		"#version 130\n"
+		"\n"
+		"attribute vec4 al_pos;\n"
+		"attribute vec2 al_texcoord;\n"
+		"attribute vec4 al_user_attr_0;\n"
+		"\n"
+		"uniform mat4 al_projview_matrix;\n"
+		"uniform bool al_use_tex_matrix;\n"
+		"uniform mat4 al_tex_matrix;\n"
+		"\n"
+		"varying vec4 color;\n"
+		"varying vec2 uv;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"	color = al_user_attr_0;\n"
+		"	uv = al_use_tex_matrix ? (al_tex_matrix * vec4(al_texcoord, 0.0, 1.0)).xy : al_texcoord;\n"
+		"	gl_Position = al_projview_matrix * al_pos;\n"
+		"}\n"
+		"\n";
+
+	const std::string BATTERY_SHADER_SOURCE_FRAGMENT_SPRITE = "\n"
+		"\n"
+		"#version 130\n"
+		"\n"
+		"out vec4 FragColor;\n"
+		"\n"
+		"uniform sampler2D al_tex;\n"
+		"uniform bool al_use_tex;\n"
+		"\n"
+		"varying vec4 color;\n"
+		"varying vec2 uv;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"	FragColor = al_use_tex ? color * texture2D(al_tex, uv) : color;\n"
+		"}\n"
+		"\n";
 }
 
 
@@ -4,8 +4,12 @@
 
 namespace Battery {
 
-	Exception::Exception(const std::string& msg) : std::exception(msg.c_str()) {
+	Exception::Exception(const std::string& msg) : message(msg) {
 
 	}
 
+	const char* Exception::what() const noexcept {
+		return message.c_str();
+	}
+
 }
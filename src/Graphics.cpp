@@ -16,8 +16,8 @@ namespace Battery {
 		double __thickness = 3;
 		bool __fillenabled = true;
 		bool __strokeenabled = true;
-		enum class LINECAP __linecap = LINECAP::ROUND;
-		enum class LINEJOIN __linejoin = LINEJOIN::ROUND;
+		LINECAP __linecap = LINECAP::ROUND;
+		LINEJOIN __linejoin = LINEJOIN::ROUND;
 
 		void DrawBackground(glm::vec3 color) {
 			al_clear_to_color(ConvertAllegroColor(color));
@@ -51,14 +51,22 @@ namespace Battery {
 			__strokeenabled = false;
 		}
 
-		void UseLineCap(enum class LINECAP linecap) {
+		void UseLineCap(LINECAP linecap) {
 			__linecap = linecap;
 		}
 
-		void UseLineJoin(enum class LINEJOIN linejoin) {
+		void UseLineJoin(LINEJOIN linejoin) {
 			__linejoin = linejoin;
 		}
 
+		LINECAP GetLineCap() {
+			return __linecap;
+		}
+
+		LINEJOIN GetLineJoin() {
+			return __linejoin;
+		}
+
 		void DrawLine(glm::vec2 p1, glm::vec2 p2) {
 			if (__strokeenabled) {
 				al_draw_line(p1.x, p1.y, p2.x, p2.y, ConvertAllegroColor(__strokecolor), static_cast<float>(__thickness));
@@ -6,6 +6,8 @@
 
 int main(int argc, const char** argv) {
 
+	int exitCode = EXIT_FAILURE;
+
 	try {
 		LOG_INIT();
 
@@ -19,6 +21,7 @@ int main(int argc, const char** argv) {
 		// Start the engine up
 		LOG_CORE_TRACE("Application created, running");
 		app->Run(argc, argv);
+		exitCode = app->GetExitCode();
 
 		// Destroy the application
 		LOG_CORE_TRACE("Application stopped, destroying");
@@ -33,4 +36,5 @@ int main(int argc, const char** argv) {
 	}
 
 	LOG_CORE_TRACE("Application destroyed, main() returned");
+	return exitCode;
 }
@@ -0,0 +1,66 @@
+
+#include "Battery/pch.h"
+#include "Battery/Core/AssetCache.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+static uint32_t ReadFirstPixel(ALLEGRO_BITMAP* bitmap) {
+	ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+	if (region == nullptr)
+		return 0;
+
+	uint32_t pixel = *(uint32_t*)region->data;
+	al_unlock_bitmap(bitmap);
+	return pixel;
+}
+
+TEST(AssetCacheDiskCacheKeepsPixelFlags) {
+
+	// A translucent pixel looks different with and without premultiplied alpha
+	std::string image = Tests::GetTempPath("translucent.png");
+	uint8_t pixel[4] = { 200, 100, 50, 128 };
+	Texture2D source;
+	CHECK(source.LoadPixels(pixel, 4, PixelConvert::PixelLayout::RGBA8, 1, 1, ALLEGRO_NO_PREMULTIPLIED_ALPHA));
+	CHECK(source.SaveImage(image));
+
+	// Decoded directly, the reference for both variants
+	const int variants[] = { 0, ALLEGRO_NO_PREMULTIPLIED_ALPHA };
+	uint32_t expected[2];
+	for (int i = 0; i < 2; i++) {
+		al_set_new_bitmap_flags(variants[i]);
+		ALLEGRO_BITMAP* bitmap = al_load_bitmap(image.c_str());
+		CHECK(bitmap != nullptr);
+		if (bitmap == nullptr)
+			return;
+		expected[i] = ReadFirstPixel(bitmap);
+		al_destroy_bitmap(bitmap);
+	}
+	CHECK(expected[0] != expected[1]);
+
+	std::string cacheDirectory = Tests::GetTempPath("cache");
+	AssetCache::SetDiskCacheDirectory(cacheDirectory);
+
+	// The first round decodes and writes the cache files, the second one must read them back
+	for (int round = 0; round < 2; round++) {
+		AssetCacheStats before = AssetCache::GetStats();
+
+		for (int i = 0; i < 2; i++) {
+			ALLEGRO_BITMAP* bitmap = AssetCache::LoadBitmap(image, variants[i]);
+			CHECK(bitmap != nullptr);
+			if (bitmap == nullptr)
+				continue;
+			CHECK(ReadFirstPixel(bitmap) == expected[i]);
+			CHECK((al_get_bitmap_flags(bitmap) & ALLEGRO_NO_PREMULTIPLIED_ALPHA) == variants[i]);
+			al_destroy_bitmap(bitmap);
+		}
+
+		AssetCacheStats after = AssetCache::GetStats();
+		CHECK(after.misses - before.misses == (round == 0 ? 2 : 0));
+		CHECK(after.diskHits - before.diskHits == (round == 0 ? 0 : 2));
+	}
+
+	AssetCache::SetDiskCacheDirectory("");
+	FileUtils::RemoveDirectory(cacheDirectory);
+}
@@ -0,0 +1,51 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/AsyncTextureLoader.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+static uint32_t ReadFirstPixel(ALLEGRO_BITMAP* bitmap) {
+	ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+	if (region == nullptr)
+		return 0;
+
+	uint32_t pixel = *(uint32_t*)region->data;
+	al_unlock_bitmap(bitmap);
+	return pixel;
+}
+
+TEST(AsyncTextureLoaderKeepsFlags) {
+
+	std::string image = Tests::GetTempPath("async.png");
+	uint8_t pixel[4] = { 200, 100, 50, 128 };
+	Texture2D source;
+	CHECK(source.LoadPixels(pixel, 4, PixelConvert::PixelLayout::RGBA8, 1, 1, ALLEGRO_NO_PREMULTIPLIED_ALPHA));
+	CHECK(source.SaveImage(image));
+
+	for (int flags : { 0, ALLEGRO_NO_PREMULTIPLIED_ALPHA | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR }) {
+		al_set_new_bitmap_flags(flags);
+		ALLEGRO_BITMAP* expected = al_load_bitmap(image.c_str());
+		CHECK(expected != nullptr);
+		if (expected == nullptr)
+			return;
+
+		// Normally uploaded every frame, the tests run before the first one
+		TextureHandle handle = AsyncTextureLoader::Load(image, flags);
+		double start = TimeUtils::GetRuntime();
+		while (!handle.IsResident() && !handle.HasFailed() && TimeUtils::GetRuntime() - start < 10.0) {
+			AsyncTextureLoader::Update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		CHECK(handle.IsResident());
+		if (handle.IsResident()) {
+			ALLEGRO_BITMAP* bitmap = handle.Get().GetAllegroBitmap();
+			CHECK((al_get_bitmap_flags(bitmap) & flags) == flags);
+			CHECK(ReadFirstPixel(bitmap) == ReadFirstPixel(expected));
+		}
+
+		al_destroy_bitmap(expected);
+	}
+}
@@ -0,0 +1,86 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/AtlasPacker.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+// Inserts random rectangles until 50 in a row didn't fit anymore, returns the placements including their padding
+static std::vector<AtlasRect> Fill(AtlasPacker& packer, int minSize, int maxSize, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> size(minSize, maxSize);
+	std::vector<AtlasRect> placed;
+
+	int padding = packer.GetPadding();
+	for (int failures = 0; failures < 50;) {
+		int width = size(random);
+		int height = size(random);
+		std::optional<AtlasRect> rect = packer.Insert(width, height);
+		if (!rect) {
+			failures++;
+			continue;
+		}
+
+		failures = 0;
+		placed.push_back({ rect->x - padding, rect->y - padding, width + 2 * padding, height + 2 * padding });
+	}
+	return placed;
+}
+
+TEST(AtlasPackerPlacementsDontOverlap) {
+
+	for (int padding : { 0, 1, 3 }) {
+		AtlasPacker packer(512, 256, padding);
+		std::vector<AtlasRect> placed = Fill(packer, 4, 48, 34 + padding);
+		CHECK(packer.GetRectCount() == placed.size());
+
+		bool inside = true;
+		bool overlapping = false;
+		uint64_t area = 0;
+		for (size_t i = 0; i < placed.size(); i++) {
+			const AtlasRect& a = placed[i];
+			inside &= a.x >= 0 && a.y >= 0 && a.x + a.width <= 512 && a.y + a.height <= 256;
+			area += (uint64_t)a.width * a.height;
+
+			for (size_t j = i + 1; j < placed.size(); j++) {
+				const AtlasRect& b = placed[j];
+				overlapping |= a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+			}
+		}
+		CHECK(inside);
+		CHECK(!overlapping);
+		CHECK(std::abs(packer.GetOccupancy() - area / (512.f * 256.f)) < 1e-6f);
+		CHECK(packer.GetOccupancy() > 0.7f);
+
+		packer.Clear();
+		CHECK(packer.GetRectCount() == 0 && packer.GetOccupancy() == 0.f);
+		CHECK(packer.Insert(512 - 2 * padding, 256 - 2 * padding).has_value());
+	}
+
+	AtlasPacker packer(64, 64, 1);
+	CHECK(!packer.Insert(0, 8));
+	CHECK(!packer.Insert(63, 8));
+	CHECK(packer.Insert(62, 8).has_value());
+}
+
+BENCHMARK(AtlasPacker) {
+
+	struct Case {
+		const char* name;
+		int minSize;
+		int maxSize;
+	};
+	const Case cases[] = { { "glyphs 6-24 px", 6, 24 }, { "sprites 8-64 px", 8, 64 }, { "images 16-256 px", 16, 256 } };
+
+	for (const Case& c : cases) {
+		AtlasPacker packer(2048, 2048, 1);
+		double seconds = Tests::MeasureFastest(3, [&] {
+			packer.Clear();
+			Fill(packer, c.minSize, c.maxSize, 2048);
+		});
+		Tests::Report("AtlasPacker", c.name, { { "rects", (double)packer.GetRectCount() },
+			{ "occupancy %", packer.GetOccupancy() * 100.0 }, { "ms", seconds * 1000.0 } });
+	}
+}
@@ -0,0 +1,192 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/BinaryUtils.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// Arrays nested 'depth' times around a single integer
+static std::string NestedArrays(size_t depth) {
+	BinaryUtils::BinaryWriter writer;
+	for (size_t i = 0; i < depth; i++) {
+		writer.BeginArray(1);
+	}
+	writer.Value(42);
+	return writer.GetData();
+}
+
+TEST(BinaryToJsonLimitsDepth) {
+
+	std::string allowed = NestedArrays(BATTERY_BINARY_MAX_DEPTH);
+	nlohmann::json value = BinaryUtils::BinaryView(allowed).ToJson();
+	CHECK(!value.is_discarded());
+
+	const nlohmann::json* innermost = &value;
+	while (innermost->is_array() && innermost->size() == 1) {
+		innermost = &(*innermost)[0];
+	}
+	CHECK(*innermost == 42);
+
+	// Deep enough to overflow the stack without the limit
+	CHECK(BinaryUtils::BinaryView(NestedArrays(BATTERY_BINARY_MAX_DEPTH + 1)).ToJson().is_discarded());
+	CHECK(BinaryUtils::BinaryView(std::string(1000000, '\x91')).ToJson().is_discarded());
+
+	// Maps count the same way
+	BinaryUtils::BinaryWriter maps;
+	for (size_t i = 0; i <= BATTERY_BINARY_MAX_DEPTH; i++) {
+		maps.BeginMap(1).Key("a");
+	}
+	maps.Null();
+	CHECK(BinaryUtils::BinaryView(maps.GetData()).ToJson().is_discarded());
+}
+
+TEST(BinaryRoundTrip) {
+
+	const uint8_t blob[] = { 0, 1, 2, 254, 255 };
+	std::string longString(300, 'x');
+	glm::mat4 transform(1.f);
+	transform[3] = glm::vec4(1.f, -2.f, 3.5f, 1.f);
+	glm::mat2x3 shear = { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f };
+
+	BinaryUtils::BinaryWriter writer;
+	writer.BeginMap(16)
+		.Key("null").Null()
+		.Field("true", true)
+		.Field("small", 7)
+		.Field("negative", -100000)
+		.Field("min", std::numeric_limits<int64_t>::min())
+		.Field("max", std::numeric_limits<uint64_t>::max())
+		.Field("float", 0.25f)
+		.Field("double", 1.0 / 3.0)
+		.Field("string", "text")
+		.Field("long", longString)
+		.Key("blob").Binary(blob, sizeof(blob))
+		.Key("array").BeginArray(3).Value(1).Value("two").BeginMap(1).Field("three", 3.0)
+		.Field("vec3", glm::vec3(1.5f, -2.f, 1e10f))
+		.Field("ivec2", glm::ivec2(-3, 4))
+		.Field("mat4", transform)
+		.Field("mat2x3", shear);
+	CHECK(writer.IsComplete());
+
+	BinaryUtils::BinaryView root(writer.GetData());
+	CHECK(root.IsMap() && root.GetSize() == 16);
+	CHECK(root.GetByteSize() == writer.GetData().size());
+	CHECK(root["null"].IsNull());
+	CHECK(root["true"].AsBool() == true);
+	CHECK(root["small"].AsInt() == 7 && root["small"].GetByteSize() == 1);
+	CHECK(root["negative"].AsInt() == -100000);
+	CHECK(root["min"].AsInt() == std::numeric_limits<int64_t>::min());
+	CHECK(root["max"].AsUnsigned() == std::numeric_limits<uint64_t>::max());
+	CHECK(root["float"].AsFloat() == 0.25f && root["float"].GetByteSize() == 5);
+	CHECK(root["double"].AsDouble() == 1.0 / 3.0);
+	CHECK(root["string"].AsString() == "text");
+	CHECK(root["long"].AsString() == longString);
+	CHECK(root["blob"].AsBinary() == std::string_view((const char*)blob, sizeof(blob)));
+	CHECK(root["array"].GetSize() == 3 && root["array"][1].AsString() == "two");
+	CHECK(root["array"][2]["three"].AsDouble() == 3.0);
+	CHECK(root["vec3"].AsVec(glm::vec3()) == glm::vec3(1.5f, -2.f, 1e10f));
+	CHECK(root["ivec2"].AsVec(glm::ivec2()) == glm::ivec2(-3, 4));
+	CHECK(root["mat4"].AsMat(glm::mat4()) == transform);
+	CHECK(root["mat2x3"].AsMat(glm::mat2x3()) == shear);
+
+	// Wrong types and missing values return the fallback
+	CHECK(root["string"].AsInt(-1) == -1);
+	CHECK(!root["missing"].IsValid());
+	CHECK(root["missing"].AsString("fallback") == "fallback");
+	CHECK(root["vec3"].AsVec(glm::vec2(9.f)) == glm::vec2(9.f));
+	CHECK(root["array"][3].AsDouble(2.0) == 2.0);
+
+	// The json bridge, nlohmann reads what BinaryWriter writes and the other way around
+	nlohmann::json document = {
+		{ "name", "test" }, { "values", { 1, -2, 3.5, nullptr, true } }, { "nested", { { "a", { { "b", "c" } } } } },
+		{ "large", 5000000000ULL }
+	};
+	BinaryUtils::BinaryWriter bridge;
+	bridge.Value(document);
+	CHECK(BinaryUtils::BinaryView(bridge.GetData()).ToJson() == document);
+	CHECK(nlohmann::json::from_msgpack(bridge.GetData()) == document);
+	std::vector<uint8_t> packed = nlohmann::json::to_msgpack(document);
+	CHECK(BinaryUtils::BinaryView(std::string_view((const char*)packed.data(), packed.size())).ToJson() == document);
+
+	std::string path = Tests::GetTempPath("state.msgpack");
+	CHECK(BinaryUtils::WriteMsgPackFile(path, document));
+	CHECK(BinaryUtils::ReadMsgPackFile(path) == document);
+	BinaryUtils::BinaryFile file(path);
+	CHECK(file.IsOpen() && file.GetRoot()["name"].AsString() == "test");
+}
+
+struct StateRecord {
+	uint32_t id;
+	std::string name;
+	glm::vec3 position;
+	bool active;
+	double score;
+};
+
+BENCHMARK(BinaryUtils) {
+
+	const size_t count = 200000;
+	std::vector<StateRecord> records(count);
+	for (size_t i = 0; i < count; i++) {
+		records[i] = { (uint32_t)i, "record " + std::to_string(i), { i % 1000 * 1.5f, i / 1000 * -2.5f, 0.f },
+			i % 3 == 0, i * 0.25 };
+	}
+
+	auto report = [](const std::string& variant, size_t bytes, double seconds) {
+		Tests::Report("BinaryUtils", variant, { { "MB", bytes / 1048576.0 }, { "ms", seconds * 1000.0 } });
+	};
+
+	// Writing, from the records the way the application would store them
+	std::string text;
+	double seconds = Tests::MeasureFastest(3, [&] {
+		nlohmann::json document = nlohmann::json::array();
+		for (const StateRecord& record : records) {
+			document.push_back({ { "id", record.id }, { "name", record.name },
+				{ "position", { record.position.x, record.position.y, record.position.z } },
+				{ "active", record.active }, { "score", record.score } });
+		}
+		text = document.dump();
+	});
+	report("write json::dump", text.size(), seconds);
+
+	BinaryUtils::BinaryWriter writer;
+	seconds = Tests::MeasureFastest(3, [&] {
+		writer.Clear();
+		writer.BeginArray(count);
+		for (const StateRecord& record : records) {
+			writer.BeginMap(5).Field("id", record.id).Field("name", record.name).Field("position", record.position)
+				.Field("active", record.active).Field("score", record.score);
+		}
+	});
+	const std::string& binary = writer.GetData();
+	report("write BinaryWriter", binary.size(), seconds);
+
+	// Loading everything into a DOM
+	report("load json::parse", text.size(), Tests::MeasureFastest(3, [&] {
+		nlohmann::json document = nlohmann::json::parse(text);
+	}));
+	report("load BinaryView::ToJson", binary.size(), Tests::MeasureFastest(3, [&] {
+		nlohmann::json document = BinaryUtils::BinaryView(binary).ToJson();
+	}));
+	report("load json::from_msgpack", binary.size(), Tests::MeasureFastest(3, [&] {
+		nlohmann::json document = nlohmann::json::from_msgpack(binary);
+	}));
+
+	// Reading one field of every record
+	double sum = 0.0;
+	report("scan json::parse", text.size(), Tests::MeasureFastest(3, [&] {
+		nlohmann::json document = nlohmann::json::parse(text);
+		for (const nlohmann::json& record : document) {
+			sum += record["score"].get<double>();
+		}
+	}));
+	report("scan BinaryView", binary.size(), Tests::MeasureFastest(3, [&] {
+		BinaryUtils::BinaryView(binary).ForEachElement([&](const BinaryUtils::BinaryView& record) {
+			sum += record["score"].AsDouble();
+			return true;
+		});
+	}));
+
+	if (sum == 0.0)
+		printf("  No score was read\n");
+}
@@ -0,0 +1,138 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Testing.h"
+
+#include <set>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace Battery;
+
+// A file in the root, an empty directory and a few subdirectories with files of known sizes and one more level.
+// Returns the number of entries a recursive listing finds, links excluded
+static size_t MakeTree(const std::string& root) {
+	FileUtils::PrepareEmptyDirectory(root);
+	FileUtils::WriteBinaryFile(PathUtils::Join(root, "a.txt"), "12345");
+	FileUtils::MakeDirectory(PathUtils::Join(root, "empty"));
+
+	size_t count = 2;
+	for (int i = 0; i < 4; i++) {
+		std::string directory = PathUtils::Join(root, "sub" + std::to_string(i));
+		for (int j = 0; j < 3; j++) {
+			FileUtils::WriteBinaryFile(PathUtils::Join(directory, "file" + std::to_string(j) + ".bin"), std::string(j * 100, 'x'));
+		}
+		FileUtils::WriteBinaryFile(PathUtils::Join(directory, "deeper/c.txt"), "c");
+		count += 6;
+	}
+	return count;
+}
+
+static const FileUtils::DirectoryEntry* Find(const std::vector<FileUtils::DirectoryEntry>& entries, const std::string& name) {
+	for (const FileUtils::DirectoryEntry& entry : entries) {
+		if (entry.name == name)
+			return &entry;
+	}
+	return nullptr;
+}
+
+TEST(DirectoryIteratorReportsEntries) {
+
+	std::string root = Tests::GetTempPath("tree");
+	size_t count = MakeTree(root);
+	size_t links = 0;
+#ifndef _WIN32
+	// Creating symlinks needs extra privileges on Windows
+	CHECK(symlink("sub0", PathUtils::Join(root, "link").c_str()) == 0);
+	CHECK(symlink("missing", PathUtils::Join(root, "dangling").c_str()) == 0);
+	links = 2;
+#endif
+
+	std::vector<FileUtils::DirectoryEntry> topLevel = FileUtils::EnumerateDirectory(root);
+	CHECK(topLevel.size() == 6 + links);
+
+	const FileUtils::DirectoryEntry* file = Find(topLevel, "a.txt");
+	std::time_t now = std::time(nullptr);
+	CHECK(file != nullptr && file->IsFile() && file->size == 5 && file->depth == 0);
+	CHECK(file != nullptr && file->path == PathUtils::Join(root, "a.txt"));
+	CHECK(file != nullptr && file->modifiedTime > now - 600 && file->modifiedTime < now + 600);
+
+	const FileUtils::DirectoryEntry* empty = Find(topLevel, "empty");
+	CHECK(empty != nullptr && empty->IsDirectory() && empty->size == 0);
+
+#ifndef _WIN32
+	const FileUtils::DirectoryEntry* link = Find(topLevel, "link");
+	const FileUtils::DirectoryEntry* dangling = Find(topLevel, "dangling");
+	CHECK(link != nullptr && link->type == FileUtils::DirectoryEntryType::SYMLINK);
+	CHECK(dangling != nullptr && dangling->type == FileUtils::DirectoryEntryType::SYMLINK);
+#endif
+
+	// Links are not descended into, directories come before their content
+	std::vector<FileUtils::DirectoryEntry> all = FileUtils::EnumerateDirectory(root, true);
+	CHECK(all.size() == count + links);
+
+	bool parentsFirst = true;
+	bool sizesMatch = true;
+	std::set<std::string> seen;
+	for (const FileUtils::DirectoryEntry& entry : all) {
+		std::string parent = std::string(PathUtils::GetParent(entry.path));
+		parentsFirst &= entry.depth == 0 || seen.count(parent.substr(0, parent.size() - 1)) == 1;
+		parentsFirst &= entry.depth == std::count(entry.path.begin() + root.size() + 1, entry.path.end(), '/');
+		seen.insert(entry.path);
+
+		if (entry.name.size() == 9 && entry.name.substr(0, 4) == "file")
+			sizesMatch &= entry.IsFile() && entry.size == (uint64_t)(entry.name[4] - '0') * 100;
+	}
+	CHECK(parentsFirst);
+	CHECK(sizesMatch);
+
+	// A skipped directory hides its content
+	std::vector<FileUtils::DirectoryEntry> filtered = FileUtils::EnumerateDirectory(root, true,
+		[](const FileUtils::DirectoryEntry& entry) { return entry.name != "deeper"; });
+	CHECK(filtered.size() == all.size() - 8);
+	CHECK(Find(filtered, "c.txt") == nullptr);
+
+	// Only the links are removed, not what they point to
+#ifndef _WIN32
+	CHECK(symlink("../sub0", PathUtils::Join(root, "sub1/link").c_str()) == 0);
+	CHECK(FileUtils::RemoveDirectory(PathUtils::Join(root, "sub1")));
+	CHECK(FileUtils::EnumerateDirectory(PathUtils::Join(root, "sub0"), true).size() == 5);
+#endif
+	CHECK(FileUtils::RemoveDirectory(root));
+	CHECK(!FileUtils::FilenameExists(root));
+}
+
+TEST(DirectoryParallelKeepsOrder) {
+
+	std::string root = Tests::GetTempPath("parallel");
+	MakeTree(root);
+	for (int i = 0; i < 16; i++) {
+		FileUtils::WriteBinaryFile(PathUtils::Join(root, "more" + std::to_string(i) + "/x/y/z.txt"), "z");
+	}
+
+	auto same = [](const std::vector<FileUtils::DirectoryEntry>& a, const std::vector<FileUtils::DirectoryEntry>& b) {
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++) {
+			if (a[i].path != b[i].path || a[i].name != b[i].name || a[i].depth != b[i].depth ||
+					a[i].type != b[i].type || a[i].size != b[i].size)
+				return false;
+		}
+		return true;
+	};
+
+	std::vector<FileUtils::DirectoryEntry> sequential = FileUtils::EnumerateDirectory(root, true);
+	CHECK(sequential.size() == 26 + 16 * 4);
+	for (size_t threads : { 0, 1, 2, 3, 8, 64 }) {
+		CHECK(same(FileUtils::EnumerateDirectoryParallel(root, nullptr, threads), sequential));
+	}
+
+	auto filter = [](const FileUtils::DirectoryEntry& entry) { return entry.name != "x" && entry.name != "file1.bin"; };
+	CHECK(same(FileUtils::EnumerateDirectoryParallel(root, filter, 4), FileUtils::EnumerateDirectory(root, true, filter)));
+
+	CHECK(FileUtils::EnumerateDirectoryParallel(PathUtils::Join(root, "missing")).empty());
+	CHECK(FileUtils::RemoveDirectory(root));
+}
@@ -0,0 +1,75 @@
+
+#include "Battery/pch.h"
+#include "Battery/Core/ImGuiRenderer.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// The vertex ImGui_ImplAllegro5_RenderDrawData() converts every ImDrawVert into
+struct AllegroImGuiVertex {
+	ImVec2 pos;
+	ImVec2 uv;
+	ALLEGRO_COLOR col;
+};
+
+// A draw list made of quads like ImGui's own, the colors vary so they can't be mapped once
+static void FillQuads(std::vector<ImDrawVert>& vertices, std::vector<ImDrawIdx>& indices, int quads) {
+	vertices.resize(quads * 4);
+	indices.resize(quads * 6);
+	for (int i = 0; i < quads; i++) {
+		for (int corner = 0; corner < 4; corner++) {
+			ImDrawVert& vertex = vertices[i * 4 + corner];
+			vertex.pos = ImVec2((float)(i % 100 * 8 + corner % 2 * 8), (float)(i / 100 * 8 + corner / 2 * 8));
+			vertex.uv = ImVec2((float)(corner % 2), (float)(corner / 2));
+			vertex.col = IM_COL32(i % 256, corner * 64, 255 - i % 256, 255);
+		}
+		const int quad[] = { 0, 1, 2, 1, 3, 2 };
+		for (int index = 0; index < 6; index++) {
+			indices[i * 6 + index] = (ImDrawIdx)(i % 16384 * 4 + quad[index]);
+		}
+	}
+}
+
+// Only the CPU side of a frame: Preparing the vertices, not drawing them
+BENCHMARK(ImGuiVertexPreparation) {
+
+	for (int quads : { 1000, 16000 }) {
+		std::vector<ImDrawVert> vertices;
+		std::vector<ImDrawIdx> indices;
+		FillQuads(vertices, indices, quads);
+		std::string name = std::to_string(quads * 4) + " vertices";
+
+		// The Allegro backend unindexes the list and maps every color, the indices are widened to int
+		std::vector<AllegroImGuiVertex> converted;
+		std::vector<int> convertedIndices;
+		double backend = Tests::MeasureFastest(20, [&] {
+			converted.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); i++) {
+				const ImDrawVert& source = vertices[indices[i]];
+				const unsigned char* c = (const unsigned char*)&source.col;
+				converted[i] = { source.pos, source.uv, al_map_rgba(c[0], c[1], c[2], c[3]) };
+			}
+			convertedIndices.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); i++) {
+				convertedIndices[i] = (int)indices[i];
+			}
+		});
+		Tests::Report("ImGuiVertexPreparation", name + " Allegro backend", { { "ms", backend * 1000.0 },
+			{ "bytes", (double)(converted.size() * sizeof(AllegroImGuiVertex) + convertedIndices.size() * sizeof(int)) } });
+
+		// ImGuiRenderer copies the list as it is, StreamBuffer::Write() rebases the indices into 32 bits
+		std::vector<ImDrawVert> copied;
+		std::vector<uint32_t> copiedIndices;
+		const uint32_t base = 4;
+		double renderer = Tests::MeasureFastest(20, [&] {
+			copied.resize(vertices.size());
+			memcpy(copied.data(), vertices.data(), vertices.size() * sizeof(ImDrawVert));
+			copiedIndices.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); i++) {
+				copiedIndices[i] = (uint32_t)indices[i] + base;
+			}
+		});
+		Tests::Report("ImGuiVertexPreparation", name + " ImGuiRenderer", { { "ms", renderer * 1000.0 },
+			{ "bytes", (double)(copied.size() * sizeof(ImDrawVert) + copiedIndices.size() * sizeof(uint32_t)) } });
+	}
+}
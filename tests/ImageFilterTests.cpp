@@ -0,0 +1,145 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/ImageFilter.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+// An image with 4 channels and padding at the end of every row, so reads past the row are noticed
+struct TestImage {
+	size_t width = 0;
+	size_t height = 0;
+	ptrdiff_t pitch = 0;
+	std::vector<uint8_t> pixels;
+
+	TestImage(size_t width, size_t height, size_t padding, uint8_t fill = 0)
+		: width(width), height(height), pitch((ptrdiff_t)(width * 4 + padding)), pixels(height * pitch, fill) {}
+
+	uint8_t* Pixel(size_t x, size_t y) {
+		return &pixels[y * pitch + x * 4];
+	}
+};
+
+static TestImage RandomImage(size_t width, size_t height, std::mt19937& random) {
+	TestImage image(width, height, 12);
+	for (uint8_t& value : image.pixels) {
+		value = (uint8_t)random();
+	}
+	return image;
+}
+
+// What Downsample2x() computes, pixel by pixel without SIMD
+static TestImage ReferenceDownsample(TestImage& source) {
+	TestImage result(std::max<size_t>(source.width / 2, 1), std::max<size_t>(source.height / 2, 1), 0);
+	for (size_t y = 0; y < result.height; y++) {
+		for (size_t x = 0; x < result.width; x++) {
+			size_t x1 = std::min(x * 2 + 1, source.width - 1);
+			size_t y1 = std::min(y * 2 + 1, source.height - 1);
+			for (size_t c = 0; c < 4; c++) {
+				int sum = source.Pixel(x * 2, y * 2)[c] + source.Pixel(x1, y * 2)[c] + source.Pixel(x * 2, y1)[c] + source.Pixel(x1, y1)[c];
+				result.Pixel(x, y)[c] = (uint8_t)((sum + 2) >> 2);
+			}
+		}
+	}
+	return result;
+}
+
+TEST(Downsample2xMatchesReference) {
+
+	std::mt19937 random(37);
+	bool allMatch = true;
+	bool paddingKept = true;
+	for (size_t width : { 1, 2, 3, 5, 7, 8, 9, 17, 33, 67 }) {
+		for (size_t height : { 1, 2, 3, 5, 31 }) {
+			TestImage source = RandomImage(width, height, random);
+			TestImage expected = ReferenceDownsample(source);
+
+			for (ThreadPool* pool : { (ThreadPool*)nullptr, &ThreadPool::GetShared() }) {
+				TestImage result(expected.width, expected.height, 8, 0xCD);
+				ImageFilter::Downsample2x(source.pixels.data(), source.pitch, width, height, result.pixels.data(), result.pitch, pool);
+
+				for (size_t y = 0; y < result.height; y++) {
+					allMatch &= memcmp(result.Pixel(0, y), expected.Pixel(0, y), result.width * 4) == 0;
+					paddingKept &= std::all_of(result.Pixel(0, y) + result.width * 4, result.Pixel(0, y) + result.pitch,
+						[](uint8_t value) { return value == 0xCD; });
+				}
+			}
+		}
+	}
+	CHECK(allMatch);
+	CHECK(paddingKept);
+}
+
+TEST(ResizeLanczosKeepsImages) {
+
+	// A solid color stays the same at any size, the weights are normalized
+	TestImage solid(23, 17, 4);
+	for (size_t y = 0; y < solid.height; y++) {
+		for (size_t x = 0; x < solid.width; x++) {
+			const uint8_t color[] = { 200, 100, 30, 255 };
+			memcpy(solid.Pixel(x, y), color, 4);
+		}
+	}
+
+	bool solidKept = true;
+	for (size_t size : { 1, 5, 11, 23, 40, 97 }) {
+		TestImage result(size, size / 2 + 1, 4);
+		ImageFilter::Resize(solid.pixels.data(), solid.pitch, solid.width, solid.height, result.pixels.data(), result.pitch,
+			result.width, result.height, ImageFilter::ResizeFilter::LANCZOS3, &ThreadPool::GetShared());
+
+		for (size_t y = 0; y < result.height; y++) {
+			for (size_t x = 0; x < result.width; x++) {
+				const uint8_t* p = result.Pixel(x, y);
+				solidKept &= std::abs(p[0] - 200) <= 1 && std::abs(p[1] - 100) <= 1 && std::abs(p[2] - 30) <= 1 && p[3] == 255;
+			}
+		}
+	}
+	CHECK(solidKept);
+
+	// The same size is an exact copy, the kernel is zero at every other whole pixel
+	std::mt19937 random(3);
+	TestImage source = RandomImage(31, 19, random);
+	TestImage copy(31, 19, 0);
+	ImageFilter::Resize(source.pixels.data(), source.pitch, 31, 19, copy.pixels.data(), copy.pitch, 31, 19,
+		ImageFilter::ResizeFilter::LANCZOS3);
+	bool copied = true;
+	for (size_t y = 0; y < copy.height; y++) {
+		copied &= memcmp(copy.Pixel(0, y), source.Pixel(0, y), copy.width * 4) == 0;
+	}
+	CHECK(copied);
+
+	// A horizontal ramp stays rising and keeps its average when it's reduced, the rows stay alike
+	TestImage ramp(256, 8, 0);
+	for (size_t y = 0; y < ramp.height; y++) {
+		for (size_t x = 0; x < ramp.width; x++) {
+			memset(ramp.Pixel(x, y), (int)x, 4);
+		}
+	}
+	TestImage reduced(37, 3, 0);
+	ImageFilter::Resize(ramp.pixels.data(), ramp.pitch, 256, 8, reduced.pixels.data(), reduced.pitch, 37, 3,
+		ImageFilter::ResizeFilter::LANCZOS3);
+	bool rising = true;
+	bool rowsAlike = true;
+	int sum = 0;
+	for (size_t x = 0; x < reduced.width; x++) {
+		rising &= x == 0 || reduced.Pixel(x, 0)[0] > reduced.Pixel(x - 1, 0)[0];
+		rowsAlike &= reduced.Pixel(x, 0)[0] == reduced.Pixel(x, 2)[0] && reduced.Pixel(x, 0)[3] == reduced.Pixel(x, 0)[0];
+		sum += reduced.Pixel(x, 0)[0];
+	}
+	CHECK(rising);
+	CHECK(rowsAlike);
+	CHECK(std::abs(sum / 37.f - 127.5f) < 1.5f);
+
+	// A hard edge rings, but the result is clamped instead of wrapping around
+	TestImage edge(16, 1, 0);
+	for (size_t x = 8; x < 16; x++) {
+		memset(edge.Pixel(x, 0), 255, 4);
+	}
+	TestImage enlarged(64, 1, 0);
+	ImageFilter::Resize(edge.pixels.data(), edge.pitch, 16, 1, enlarged.pixels.data(), enlarged.pitch, 64, 1,
+		ImageFilter::ResizeFilter::LANCZOS3);
+	CHECK(enlarged.Pixel(0, 0)[0] == 0 && enlarged.Pixel(63, 0)[0] == 255);
+	CHECK(enlarged.Pixel(30, 0)[0] < 64 && enlarged.Pixel(33, 0)[0] > 192);
+}
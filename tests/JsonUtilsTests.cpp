@@ -0,0 +1,142 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/JsonUtils.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// One large top-level array of records, like a save game or a log dump. The keys are sorted like a DOM keeps them
+static bool WriteRecords(const std::string& path, size_t count) {
+	JsonUtils::JsonWriter writer(path);
+	writer.BeginArray();
+	for (size_t i = 0; i < count; i++) {
+		writer.BeginObject()
+			.Field("active", i % 3 == 0)
+			.Field("id", i)
+			.Field("name", "record " + std::to_string(i))
+			.Key("parent").Null()
+			.Key("position").BeginArray().Value(i % 1000 * 1.5).Value(i / 1000 * -2.5).Value(0).EndArray()
+			.Field("score", i * 0.25)
+			.Key("tags").BeginArray().Value("a").Value("bc").EndArray()
+			.EndObject();
+	}
+	writer.EndArray();
+	return writer.Close();
+}
+
+// Counts the records and sums their ids, without keeping anything
+class RecordCounter : public JsonUtils::SaxHandler {
+public:
+	bool null() override { return true; }
+	bool boolean(bool val) override { return true; }
+	bool number_integer(number_integer_t val) override { return true; }
+	bool number_unsigned(number_unsigned_t val) override {
+		if (depth == 2 && lastKey == "id")
+			idSum += val;
+		return true;
+	}
+	bool number_float(number_float_t val, const string_t& s) override { return true; }
+	bool string(string_t& val) override { return true; }
+	bool start_object(std::size_t elements) override {
+		if (++depth == 2)
+			records++;
+		return true;
+	}
+	bool key(string_t& val) override {
+		lastKey = val;
+		return true;
+	}
+	bool end_object() override { depth--; return true; }
+	bool start_array(std::size_t elements) override { depth++; return true; }
+	bool end_array() override { depth--; return true; }
+	bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex) override {
+		return false;
+	}
+
+	size_t records = 0;
+	uint64_t idSum = 0;
+
+private:
+	int depth = 0;
+	std::string lastKey;
+};
+
+TEST(JsonSaxMatchesDom) {
+
+	std::string path = Tests::GetTempPath("records.json");
+	CHECK(WriteRecords(path, 1000));
+
+	// The writer formats exactly like dump()
+	std::string text = FileUtils::ReadFile(path).content();
+	nlohmann::json document = nlohmann::json::parse(text, nullptr, false);
+	CHECK(document.is_array() && document.size() == 1000);
+	CHECK(document.dump() == text);
+
+	RecordCounter counter;
+	CHECK(JsonUtils::ParseFileSax(path, &counter));
+	CHECK(counter.records == 1000);
+	CHECK(counter.idSum == 999 * 1000 / 2);
+
+	size_t index = 0;
+	bool allMatch = true;
+	CHECK(JsonUtils::ForEachArrayElement(path, [&](nlohmann::json& element) {
+		allMatch &= index < document.size() && element == document[index];
+		index++;
+		return true;
+	}));
+	CHECK(allMatch && index == document.size());
+
+	// Stopping early is not an error
+	index = 0;
+	CHECK(JsonUtils::ForEachArrayElement(path, [&](nlohmann::json& element) { return ++index < 10; }));
+	CHECK(index == 10);
+
+	RecordCounter invalid;
+	CHECK(!JsonUtils::ParseSax("[{\"id\": 1}, ", &invalid));
+}
+
+BENCHMARK(JsonParsing) {
+
+	const size_t records = 200000;
+	std::string path = Tests::GetTempPath("large.json");
+	if (!WriteRecords(path, records)) {
+		printf("  Can't write '%s'\n", path.c_str());
+		return;
+	}
+	double megabytes = FileUtils::MappedFile(path).GetSize() / 1048576.0;
+
+	// Time of the fastest run, peak memory above what was allocated before
+	auto measure = [&](const std::string& variant, const std::function<void()>& parse) {
+		size_t baseline = Tests::GetAllocatedBytes();
+		Tests::ResetPeakAllocatedBytes();
+		double seconds = Tests::MeasureFastest(3, parse);
+		Tests::Report("JsonParsing", variant, { { "ms", seconds * 1000.0 }, { "MB/s", megabytes / seconds },
+			{ "peak MB", (Tests::GetPeakAllocatedBytes() - baseline) / 1048576.0 } });
+	};
+
+	printf("  %zu records, %.1f MB\n", records, megabytes);
+
+	// How documents were loaded before: Read the whole file, then build the DOM
+	measure("nlohmann::json::parse", [&] {
+		nlohmann::json document = nlohmann::json::parse(FileUtils::ReadFile(path).content(), nullptr, false);
+		if (document.size() != records)
+			printf("  nlohmann::json::parse() returned %zu records\n", document.size());
+	});
+
+	measure("ParseFileSax", [&] {
+		RecordCounter counter;
+		if (!JsonUtils::ParseFileSax(path, &counter) || counter.records != records)
+			printf("  ParseFileSax() counted %zu records\n", counter.records);
+	});
+
+	measure("ForEachArrayElement", [&] {
+		size_t count = 0;
+		JsonUtils::ForEachArrayElement(path, [&](nlohmann::json& element) {
+			count++;
+			return true;
+		});
+		if (count != records)
+			printf("  ForEachArrayElement() returned %zu records\n", count);
+	});
+}
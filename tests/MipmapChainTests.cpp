@@ -0,0 +1,53 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/MipmapChain.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+TEST(MipmapChainSelectsLevels) {
+
+	// Odd sizes, so the levels are smaller than an exact halving
+	std::vector<uint32_t> pixels(37 * 20, 0xFF8040C0);
+	Texture2D texture;
+	CHECK(texture.LoadPixels(pixels.data(), 37 * 4, PixelConvert::PixelLayout::RGBA8, 37, 20));
+
+	MipmapChain chain;
+	CHECK(chain.Build(SharedTexture(std::move(texture))));
+	CHECK(chain.GetLevelCount() == 6);
+
+	std::vector<glm::ivec2> sizes;
+	for (size_t level = 0; level < chain.GetLevelCount(); level++) {
+		sizes.push_back({ chain.GetLevel(level).GetWidth(), chain.GetLevel(level).GetHeight() });
+	}
+	CHECK((sizes == std::vector<glm::ivec2>{ { 37, 20 }, { 18, 10 }, { 9, 5 }, { 4, 2 }, { 2, 1 }, { 1, 1 } }));
+
+	// The selected level covers the size on screen, the next one wouldn't anymore
+	bool covering = true;
+	bool smallest = true;
+	for (float width = 0.f; width <= 80.f; width += 0.7f) {
+		for (float height = 0.f; height <= 45.f; height += 0.9f) {
+			glm::vec2 size = { std::max(width, 1.f), std::max(height, 1.f) };
+			size_t level = chain.SelectLevel({ width, height });
+			covering &= level == 0 || (sizes[level].x >= size.x && sizes[level].y >= size.y);
+			smallest &= level + 1 == sizes.size() || sizes[level + 1].x < size.x || sizes[level + 1].y < size.y;
+
+			// Flipped sprites have negative sizes
+			covering &= chain.SelectLevel({ -width, height }) == level && chain.SelectLevel({ width, -height }) == level;
+		}
+	}
+	CHECK(covering);
+	CHECK(smallest);
+	CHECK(chain.SelectLevel({ 18.4f, 10.f }) == 0);
+	CHECK(chain.SelectLevel({ 18.f, 10.f }) == 1);
+	CHECK(chain.SelectLevel({ 0.f, 0.f }) == 5);
+
+	// Stops as soon as both sides are at most minSize
+	Texture2D source;
+	CHECK(source.LoadPixels(pixels.data(), 37 * 4, PixelConvert::PixelLayout::RGBA8, 37, 20));
+	CHECK(chain.Build(SharedTexture(std::move(source)), ImageFilter::ResizeFilter::LANCZOS3, 8));
+	CHECK(chain.GetLevelCount() == 4 && chain.GetLevel(3).GetWidth() == 4);
+
+	chain.Clear();
+	CHECK(!chain.IsValid() && chain.SelectLevel({ 10.f, 10.f }) == 0);
+}
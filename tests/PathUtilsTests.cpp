@@ -0,0 +1,179 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// The FileUtils helpers before PathUtils: Every call parsed the path into an ALLEGRO_PATH
+namespace AllegroPath {
+
+	static std::string GetFilenameFromPath(const std::string& path) {
+		ALLEGRO_PATH* p = al_create_path(path.c_str());
+		std::string filename = al_get_path_filename(p);
+		al_destroy_path(p);
+		return filename;
+	}
+
+	static std::string GetBasenameFromPath(const std::string& path) {
+		ALLEGRO_PATH* p = al_create_path(path.c_str());
+		std::string filename = al_get_path_basename(p);
+		al_destroy_path(p);
+		return filename;
+	}
+
+	static std::string GetExtensionFromPath(const std::string& path) {
+		ALLEGRO_PATH* p = al_create_path(path.c_str());
+		std::string filename = al_get_path_extension(p);
+		al_destroy_path(p);
+		return filename;
+	}
+
+	static std::vector<std::string> GetComponentsFromPath(const std::string& path) {
+		ALLEGRO_PATH* p = al_create_path(path.c_str());
+		std::vector<std::string> v;
+
+		if (path.length() == 0) {
+			al_destroy_path(p);
+			return v;
+		}
+
+		if (std::string(al_get_path_drive(p)) != "") {
+			v.push_back(std::string(al_get_path_drive(p)));
+			for (int i = 1; i < al_get_path_num_components(p); i++)
+				v.push_back(std::string(al_get_path_component(p, i)));
+		}
+		else {
+			for (int i = 0; i < al_get_path_num_components(p); i++)
+				v.push_back(std::string(al_get_path_component(p, i)));
+		}
+
+		if (std::string(al_get_path_filename(p)).length() > 0)
+			v.push_back(std::string(al_get_path_filename(p)));
+
+		al_destroy_path(p);
+		return v;
+	}
+
+	static std::string GetDirectoryFromPath(const std::string& path) {
+		std::vector<std::string> arr = GetComponentsFromPath(path);
+		std::string p;
+		for (size_t i = 0; i + 1 < arr.size(); i++)
+			p += arr[i] + "/";
+		return p;
+	}
+
+}
+
+// Asset paths like a game looks them up
+static std::vector<std::string> AssetPaths(size_t count) {
+	const char* roots[] = { "/home/user/.local/share/Game/", "assets/", "../shared/assets/" };
+	const char* folders[] = { "textures/tiles/", "sounds/effects/", "fonts/", "maps/level_03/" };
+	const char* extensions[] = { ".png", ".ogg", ".ttf", ".json" };
+
+	std::vector<std::string> paths(count);
+	for (size_t i = 0; i < count; i++) {
+		paths[i] = std::string(roots[i % 3]) + folders[i / 3 % 4] + "item_" + std::to_string(i) + extensions[i / 12 % 4];
+	}
+	return paths;
+}
+
+TEST(PathUtilsSplitsPaths) {
+
+	CHECK(PathUtils::GetFilename("C:/some/file.txt") == "file.txt");
+	CHECK(PathUtils::GetFilename("C:\\some\\dir\\") == "");
+	CHECK(PathUtils::GetStem("C:/some/multiple.dots.txt") == "multiple.dots");
+	CHECK(PathUtils::GetExtension("C:/some/multiple.dots.txt") == ".txt");
+	CHECK(PathUtils::GetExtension("some.dir/file") == "");
+	CHECK(PathUtils::GetParent("C:/some/file.txt") == "C:/some/");
+	CHECK(PathUtils::GetParent("file.txt") == "");
+	CHECK(PathUtils::IsAbsolute("C:/some") && PathUtils::IsAbsolute("/home") && !PathUtils::IsAbsolute("some/file"));
+	CHECK(PathUtils::HasExtension("image.PNG", "png") && PathUtils::HasExtension("image.png", ".Png"));
+	CHECK(!PathUtils::HasExtension("image.png", "pn"));
+
+	std::vector<std::string_view> components;
+	for (std::string_view component : PathUtils::Components("C:/some//file.txt")) {
+		components.push_back(component);
+	}
+	CHECK((components == std::vector<std::string_view>{ "C:", "some", "file.txt" }));
+	CHECK(PathUtils::Components("/").size() == 0);
+
+	CHECK(PathUtils::Join("assets", "file.png") == "assets/file.png");
+	CHECK(PathUtils::Join("assets/", "/abs/file.png") == "/abs/file.png");
+	CHECK(PathUtils::Normalize("C:\\some\\.\\dir/../file.txt") == "C:/some/file.txt");
+	CHECK(PathUtils::Normalize("../a/./b/../../..") == "../..");
+	CHECK(PathUtils::Normalize("/../a//b/") == "/a/b/");
+	CHECK(PathUtils::Normalize("a/..") == ".");
+
+	// The FileUtils helpers keep their results, including the empty leading component of rooted paths
+	CHECK((FileUtils::GetComponentsFromPath("/home/file.txt") == std::vector<std::string>{ "", "home", "file.txt" }));
+	CHECK(FileUtils::GetDirectoryFromPath("/home/user/file.txt") == "/home/user/");
+	CHECK(FileUtils::GetDirectoryFromPath("") == "");
+	CHECK(FileUtils::GetBasenameFromPath("assets/image.png") == "image");
+}
+
+BENCHMARK(PathUtils) {
+
+	std::vector<std::string> paths = AssetPaths(10000);
+	size_t sink = 0;
+
+	// Nanoseconds per path of the fastest run, and the heap memory PathUtils needs for it
+	auto report = [&](const std::string& function, const std::function<void()>& allegroPath,
+			const std::function<void()>& fileUtils, const std::function<void()>& pathUtils) {
+		double allegro = Tests::MeasureFastest(10, allegroPath);
+		double helpers = Tests::MeasureFastest(10, fileUtils);
+		size_t baseline = Tests::GetAllocatedBytes();
+		Tests::ResetPeakAllocatedBytes();
+		double views = Tests::MeasureFastest(10, pathUtils);
+		size_t heap = Tests::GetPeakAllocatedBytes() - baseline;
+		Tests::Report("PathUtils", function, { { "ALLEGRO_PATH [ns]", allegro * 1e9 / paths.size() },
+			{ "FileUtils [ns]", helpers * 1e9 / paths.size() }, { "PathUtils [ns]", views * 1e9 / paths.size() },
+			{ "PathUtils heap bytes", (double)heap } });
+	};
+
+	report("filename", [&] {
+		for (const std::string& path : paths) sink += AllegroPath::GetFilenameFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += FileUtils::GetFilenameFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += PathUtils::GetFilename(path).size();
+	});
+
+	report("basename", [&] {
+		for (const std::string& path : paths) sink += AllegroPath::GetBasenameFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += FileUtils::GetBasenameFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += PathUtils::GetStem(path).size();
+	});
+
+	report("extension", [&] {
+		for (const std::string& path : paths) sink += AllegroPath::GetExtensionFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += FileUtils::GetExtensionFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += PathUtils::GetExtension(path).size();
+	});
+
+	report("components", [&] {
+		for (const std::string& path : paths) sink += AllegroPath::GetComponentsFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += FileUtils::GetComponentsFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) {
+			for (std::string_view component : PathUtils::Components(path)) sink += component.size();
+		}
+	});
+
+	report("directory", [&] {
+		for (const std::string& path : paths) sink += AllegroPath::GetDirectoryFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += FileUtils::GetDirectoryFromPath(path).size();
+	}, [&] {
+		for (const std::string& path : paths) sink += PathUtils::GetParent(path).size();
+	});
+
+	if (sink == 0)
+		printf("  No path was split\n");
+}
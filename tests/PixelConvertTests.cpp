@@ -0,0 +1,210 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/PixelConvert.h"
+#include "Battery/Renderer/Texture2D.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+static std::vector<uint8_t> RandomBytes(size_t count, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::vector<uint8_t> bytes(count);
+	for (uint8_t& byte : bytes) {
+		byte = (uint8_t)random();
+	}
+	return bytes;
+}
+
+// The channels of one pixel, read through the masks and shifts of the spec like clip describes them
+static glm::u8vec4 ReadChannels(const clip::image& image, size_t x, size_t y) {
+	const clip::image_spec& spec = image.spec();
+	uint32_t pixel = 0;
+	memcpy(&pixel, image.data() + y * spec.bytes_per_row + x * spec.bits_per_pixel / 8, spec.bits_per_pixel / 8);
+
+	return glm::u8vec4((pixel & spec.red_mask) >> spec.red_shift, (pixel & spec.green_mask) >> spec.green_shift,
+		(pixel & spec.blue_mask) >> spec.blue_shift, spec.alpha_mask == 0 ? 255 : (pixel & spec.alpha_mask) >> spec.alpha_shift);
+}
+
+// The conversion Texture2D used before PixelConvert: Every pixel is mapped and put on its own
+static ALLEGRO_BITMAP* LoadPerPixel(const clip::image& image) {
+	const clip::image_spec& spec = image.spec();
+	al_set_new_bitmap_flags(0);
+	ALLEGRO_BITMAP* bitmap = al_create_bitmap(spec.width, spec.height);
+	if (bitmap == nullptr)
+		return nullptr;
+
+	ALLEGRO_STATE state;
+	al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+	al_set_target_bitmap(bitmap);
+	al_lock_bitmap(bitmap, al_get_bitmap_format(bitmap), ALLEGRO_LOCK_WRITEONLY);
+
+	for (size_t y = 0; y < spec.height; y++) {
+		for (size_t x = 0; x < spec.width; x++) {
+			glm::u8vec4 color = ReadChannels(image, x, y);
+			al_put_pixel((int)x, (int)y, al_map_rgba(color.r, color.g, color.b, color.a));
+		}
+	}
+
+	al_unlock_bitmap(bitmap);
+	al_restore_state(&state);
+	return bitmap;
+}
+
+static std::vector<uint32_t> ReadPixels(ALLEGRO_BITMAP* bitmap) {
+	int width = al_get_bitmap_width(bitmap);
+	int height = al_get_bitmap_height(bitmap);
+	std::vector<uint32_t> pixels((size_t)width * height);
+
+	ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+	if (region == nullptr)
+		return {};
+
+	for (int y = 0; y < height; y++) {
+		memcpy(&pixels[(size_t)y * width], (uint8_t*)region->data + (ptrdiff_t)y * region->pitch, (size_t)width * 4);
+	}
+
+	al_unlock_bitmap(bitmap);
+	return pixels;
+}
+
+// Widths around the 4 pixels of an SSE2 step, so every length of the scalar tail is covered
+static const size_t TEST_WIDTHS[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 16, 17, 31, 33, 67 };
+static const PixelConvert::PixelLayout TEST_LAYOUTS[] = { PixelConvert::PixelLayout::BGRA8,
+	PixelConvert::PixelLayout::RGBA8, PixelConvert::PixelLayout::RGB8 };
+
+TEST(PixelConvertRowsMatchMasks) {
+
+	for (PixelConvert::PixelLayout layout : TEST_LAYOUTS) {
+		for (size_t width : TEST_WIDTHS) {
+			clip::image_spec spec = PixelConvert::GetClipSpec(layout, width, 1);
+			std::vector<uint8_t> source = RandomBytes(spec.bytes_per_row, (uint32_t)width);
+			clip::image image(source.data(), spec);
+			CHECK(PixelConvert::GetLayout(spec) == layout);
+
+			for (PixelConvert::PixelLayout destinationLayout : { PixelConvert::PixelLayout::RGBA8, PixelConvert::PixelLayout::BGRA8 }) {
+				for (bool opaque : { false, true }) {
+					// One pixel more than converted, which must not be touched
+					std::vector<uint8_t> destination(width * 4 + 4, 0xAB);
+					PixelConvert::ConvertRow(source.data(), layout, destination.data(), destinationLayout, width, opaque);
+
+					bool matches = true;
+					for (size_t x = 0; x < width; x++) {
+						glm::u8vec4 color = ReadChannels(image, x, 0);
+						if (opaque)
+							color.a = 255;
+						if (destinationLayout == PixelConvert::PixelLayout::BGRA8)
+							std::swap(color.r, color.b);
+						matches &= memcmp(&destination[x * 4], &color, 4) == 0;
+					}
+					CHECK(matches);
+					CHECK(destination[width * 4] == 0xAB);
+				}
+			}
+		}
+	}
+}
+
+TEST(PixelConvertMatchesPerPixelLoading) {
+
+	for (PixelConvert::PixelLayout layout : TEST_LAYOUTS) {
+		for (size_t width : TEST_WIDTHS) {
+			const size_t height = 3;
+			clip::image_spec spec = PixelConvert::GetClipSpec(layout, width, height);
+			std::vector<uint8_t> source = RandomBytes(spec.bytes_per_row * height, (uint32_t)(width * 7 + (int)layout));
+			clip::image image(source.data(), spec);
+
+			Texture2D texture(image);
+			ALLEGRO_BITMAP* reference = LoadPerPixel(image);
+			CHECK(reference != nullptr);
+			if (reference == nullptr)
+				return;
+
+			CHECK(ReadPixels(texture.GetAllegroBitmap()) == ReadPixels(reference));
+			al_destroy_bitmap(reference);
+		}
+	}
+}
+
+TEST(PackColorMatchesAllegro) {
+
+	// In range, fractions are truncated like the implicit conversion of al_map_rgba(tint.r, ...) did
+	std::mt19937 random(48);
+	std::uniform_real_distribution<float> channel(0.f, 256.f);
+	bool mapped = true;
+	bool scalarMatches = true;
+	for (int i = 0; i < 100000; i++) {
+		glm::vec4 color = { channel(random), channel(random), channel(random), channel(random) };
+		color = glm::min(color, glm::vec4(255.f));
+		if (i < 256)
+			color = glm::vec4((float)i, i + 0.5f, i + 0.999f, std::nextafter((float)i, 0.f));
+
+		unsigned char r, g, b, a;
+		al_unmap_rgba(al_map_rgba((unsigned char)color.r, (unsigned char)color.g, (unsigned char)color.b,
+			(unsigned char)color.a), &r, &g, &b, &a);
+		uint32_t expected = r | g << 8 | b << 16 | (uint32_t)a << 24;
+		mapped &= PixelConvert::PackColor(color) == expected;
+		scalarMatches &= PixelConvert::PackColorScalar(color) == expected;
+	}
+	CHECK(mapped);
+	CHECK(scalarMatches);
+
+	// Out of range and invalid channels are clamped, NaN becomes 0
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float infinity = std::numeric_limits<float>::infinity();
+	const std::pair<glm::vec4, uint32_t> cases[] = {
+		{ { -1.f, -0.5f, -1e9f, -infinity }, 0x00000000 },
+		{ { 256.f, 255.5f, 1e9f, infinity }, 0xFFFFFFFF },
+		{ { nan, 10.f, nan, 20.f }, 0x14000A00 },
+		{ { -nan, 300.f, 12.7f, nan }, 0x000CFF00 },
+		{ { 0.f, -0.f, 1.f, 254.99f }, 0xFE010000 }
+	};
+	for (auto& [color, expected] : cases) {
+		CHECK(PixelConvert::PackColor(color) == expected);
+		CHECK(PixelConvert::PackColorScalar(color) == expected);
+	}
+	CHECK(PixelConvert::UnpackColor(PixelConvert::PackColor({ 1.f, 2.f, 3.f, 4.f })) == glm::vec4(1.f, 2.f, 3.f, 4.f));
+}
+
+BENCHMARK(PixelConvert4K) {
+
+	const size_t width = 3840;
+	const size_t height = 2160;
+	const double megapixels = width * height / 1e6;
+
+	for (PixelConvert::PixelLayout layout : TEST_LAYOUTS) {
+		clip::image_spec spec = PixelConvert::GetClipSpec(layout, width, height);
+		std::vector<uint8_t> source = RandomBytes(spec.bytes_per_row * height, 4096);
+		clip::image image(source.data(), spec);
+		std::vector<uint32_t> destination(width * height);
+		std::string name = layout == PixelConvert::PixelLayout::BGRA8 ? "BGRA8" : (layout == PixelConvert::PixelLayout::RGBA8 ? "RGBA8" : "RGB8");
+
+		auto report = [&](const std::string& variant, double seconds) {
+			Tests::Report("PixelConvert4K", name + " " + variant, { { "ms", seconds * 1000.0 },
+				{ "MPixel/s", megapixels / seconds } });
+		};
+
+		// The conversion alone, into memory
+		report("ConvertImage", Tests::MeasureFastest(10, [&] {
+			PixelConvert::ConvertImage(source.data(), spec.bytes_per_row, layout, destination.data(), width * 4,
+				PixelConvert::PixelLayout::RGBA8, width, height);
+		}));
+		report("masks and shifts", Tests::MeasureFastest(3, [&] {
+			for (size_t y = 0; y < height; y++) {
+				for (size_t x = 0; x < width; x++) {
+					glm::u8vec4 color = ReadChannels(image, x, y);
+					memcpy(&destination[y * width + x], &color, 4);
+				}
+			}
+		}));
+
+		// Loading into a bitmap, the way Texture2D did before and does now
+		report("Texture2D", Tests::MeasureFastest(5, [&] {
+			Texture2D texture(image);
+		}));
+		report("al_put_pixel", Tests::MeasureFastest(1, [&] {
+			al_destroy_bitmap(LoadPerPixel(image));
+		}));
+	}
+}
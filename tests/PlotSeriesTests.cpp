@@ -0,0 +1,157 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/PlotSeries.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+// Irregular timestamps like frame times, with occasional spikes and repeated values
+static std::vector<glm::dvec2> RandomSamples(size_t count, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::exponential_distribution<double> step(60.0);
+	std::normal_distribution<double> noise(16.0, 2.0);
+
+	std::vector<glm::dvec2> samples(count);
+	double x = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		x += random() % 8 == 0 ? 0.0 : step(random);
+		double y = random() % 200 == 0 ? 100.0 + random() % 50 : std::round(noise(random) * 4.0) / 4.0;
+		samples[i] = { x, y };
+	}
+	return samples;
+}
+
+// Every pixel column of the view must keep its first, lowest, highest and last sample, the first ones of equal values
+static bool KeepsColumns(const std::vector<glm::dvec2>& samples, const std::vector<glm::dvec2>& points,
+		double xMin, double xMax, int columns) {
+
+	double columnWidth = (xMax - xMin) / columns;
+	std::map<int64_t, std::vector<glm::dvec2>> expected;
+	for (const glm::dvec2& sample : samples) {
+		if (sample.x < xMin || sample.x > xMax)
+			continue;
+
+		int64_t column = (int64_t)std::floor((sample.x - xMin) / columnWidth);
+		auto it = expected.find(column);
+		if (it == expected.end()) {
+			expected[column] = { sample, sample, sample, sample };
+			continue;
+		}
+
+		std::vector<glm::dvec2>& kept = it->second;
+		if (sample.y < kept[1].y)
+			kept[1] = sample;
+		if (sample.y > kept[2].y)
+			kept[2] = sample;
+		kept[3] = sample;
+	}
+
+	for (auto& [column, kept] : expected) {
+		for (const glm::dvec2& sample : kept) {
+			if (std::find(points.begin(), points.end(), sample) == points.end())
+				return false;
+		}
+	}
+	return true;
+}
+
+// Samples with the same x can be reordered by y, a vertical line looks the same
+static bool IsSortedSubset(const std::vector<glm::dvec2>& samples, const std::vector<glm::dvec2>& points) {
+	for (size_t i = 0; i < points.size(); i++) {
+		if (i > 0 && points[i].x < points[i - 1].x)
+			return false;
+
+		auto sameX = std::equal_range(samples.begin(), samples.end(), points[i],
+			[](const glm::dvec2& a, const glm::dvec2& b) { return a.x < b.x; });
+		if (std::find(sameX.first, sameX.second, points[i]) == sameX.second)
+			return false;
+	}
+	return true;
+}
+
+TEST(PlotSeriesDecimateKeepsColumns) {
+
+	std::vector<glm::dvec2> samples = RandomSamples(200000, 42);
+	PlotSeries series;
+	series.Append(samples.data(), samples.size());
+	CHECK(series.GetSize() == samples.size());
+	double duration = samples.back().x;
+
+	// Zoomed out, zoomed in and views starting and ending between samples, odd column counts included
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> position(-10.0, duration + 10.0);
+	bool columnsKept = true;
+	bool subset = true;
+	bool reduced = true;
+	for (int view = 0; view < 200; view++) {
+		double a = position(random);
+		double b = view % 4 == 0 ? a + std::ldexp(duration, -(view % 13)) : position(random);
+		double xMin = std::min(a, b);
+		double xMax = std::max(a, b);
+		int columns = 50 + (int)(random() % 1900);
+
+		const std::vector<glm::dvec2>& points = series.Decimate(xMin, xMax, columns);
+		columnsKept &= KeepsColumns(samples, points, xMin, xMax, columns);
+		subset &= IsSortedSubset(samples, points);
+		reduced &= points.size() <= (size_t)columns * 4 + 12;
+	}
+	CHECK(columnsKept);
+	CHECK(subset);
+	CHECK(reduced);
+	CHECK(series.GetCachedLevels() <= BATTERY_PLOT_SERIES_MAX_LEVELS);
+
+	// Few samples in view are returned as they are, with one neighbour on either side
+	const std::vector<glm::dvec2>& close = series.Decimate(samples[1000].x, samples[1010].x, 800);
+	CHECK(close.size() >= 11 && close.size() <= 24);
+	CHECK(IsSortedSubset(samples, close));
+
+	CHECK(!series.Append(samples.back().x - 1.0, 0.0));
+	CHECK(!series.Append(samples.back().x + 1.0, NAN));
+	CHECK(series.Decimate(5.0, 5.0, 100).empty() && series.Decimate(0.0, 1.0, 0).empty());
+}
+
+TEST(PlotSeriesRemoveBeforeKeepsBuckets) {
+
+	std::vector<glm::dvec2> samples = RandomSamples(50000, 3);
+	PlotSeries series;
+	series.Append(samples.data(), samples.size());
+
+	// Cache a few levels first, then cut through the middle of their buckets
+	double duration = samples.back().x;
+	for (int columns : { 100, 400, 1600 }) {
+		series.Decimate(0.0, duration, columns);
+	}
+
+	bool sameAsNew = true;
+	bool levelsKept = true;
+	for (double cut : { 0.0, 1.37, duration / 3.0, duration / 2.0 + 0.001 }) {
+		size_t levels = series.GetCachedLevels();
+		series.RemoveBefore(cut);
+		levelsKept &= series.GetCachedLevels() == levels;
+		samples.erase(samples.begin(), std::lower_bound(samples.begin(), samples.end(), cut,
+			[](const glm::dvec2& sample, double x) { return sample.x < x; }));
+		sameAsNew &= series.GetSize() == samples.size() && series.GetSamples() == samples;
+
+		PlotSeries fresh;
+		fresh.Append(samples.data(), samples.size());
+		for (int columns : { 100, 400, 1600 }) {
+			std::vector<glm::dvec2> points = series.Decimate(cut - 1.0, duration, columns);
+			sameAsNew &= points == fresh.Decimate(cut - 1.0, duration, columns);
+		}
+	}
+	CHECK(sameAsNew);
+	CHECK(levelsKept);
+
+	// Appending continues the trimmed buckets
+	series.Append(duration + 1.0, 5.0);
+	samples.push_back({ duration + 1.0, 5.0 });
+	PlotSeries fresh;
+	fresh.Append(samples.data(), samples.size());
+	std::vector<glm::dvec2> points = series.Decimate(duration / 2.0, duration + 1.0, 300);
+	CHECK(points == fresh.Decimate(duration / 2.0, duration + 1.0, 300));
+
+	series.RemoveBefore(duration + 2.0);
+	CHECK(series.GetSize() == 0 && series.GetCachedLevels() == 0);
+}
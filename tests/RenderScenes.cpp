@@ -0,0 +1,214 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Renderer/RenderRegression.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// 10k labels per frame, e.g. a plot or a map full of annotations
+static constexpr int LABEL_COLUMNS = 100;
+static constexpr int LABEL_ROWS = 100;
+static constexpr int LABEL_SIZE = 6;
+
+// Loaded once Allegro is set up, they live as long as the scenes are run
+struct SceneResources {
+	Font font;
+	Texture2D checkerboard;
+	TextureAtlas atlas;
+	std::vector<AtlasRegion> sprites;
+
+	SceneResources() : atlas(256) {}
+
+	bool Load() {
+
+		if (!font.Load(Tests::GetDataPath("Lato-Regular.ttf")))
+			return false;
+
+		// The glyphs of the labels are rasterized beforehand, so the scene doesn't update the atlas while drawing
+		font.Shape("0123456789", LABEL_SIZE);
+
+		// 8x8 fields, each one of them differently colored
+		std::vector<uint8_t> pixels(16 * 16 * 4);
+		for (int y = 0; y < 16; y++) {
+			for (int x = 0; x < 16; x++) {
+				uint8_t* pixel = &pixels[(y * 16 + x) * 4];
+				bool dark = ((x / 2) + (y / 2)) % 2 == 0;
+				pixel[0] = dark ? 40 : (uint8_t)(x * 16);
+				pixel[1] = dark ? 40 : (uint8_t)(y * 16);
+				pixel[2] = dark ? 80 : 255;
+				pixel[3] = 255;
+			}
+		}
+		if (!checkerboard.LoadPixels(pixels.data(), 16 * 4, PixelConvert::PixelLayout::RGBA8, 16, 16))
+			return false;
+
+		// Sprites with a transparent border, packed into one atlas page
+		for (int size = 8; size <= 32; size += 8) {
+			Texture2D sprite(size, size);
+			ALLEGRO_STATE state;
+			al_store_state(&state, ALLEGRO_STATE_TARGET_BITMAP);
+			al_set_target_bitmap(sprite.GetAllegroBitmap());
+			al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+			for (int y = 1; y < size - 1; y++) {
+				for (int x = 1; x < size - 1; x++) {
+					al_put_pixel(x, y, al_map_rgba(255, (uint8_t)(x * 255 / size), (uint8_t)(y * 255 / size), 255));
+				}
+			}
+			al_restore_state(&state);
+
+			auto region = atlas.Add("sprite" + std::to_string(size), sprite);
+			if (!region)
+				return false;
+			sprites.push_back(*region);
+		}
+
+		return true;
+	}
+};
+
+static void AddScenes(RenderRegression& regression, SceneResources& resources) {
+
+	regression.AddScene("lines", { 128, 128 }, [] {
+		for (int i = 0; i < 12; i++) {
+			float angle = glm::radians(i * 30.f + 7.f);
+			glm::vec2 direction = { cos(angle), sin(angle) };
+			Renderer2D::DrawLine(glm::vec2(64.f) + direction * 10.f, glm::vec2(64.f) + direction * 58.f,
+				1.f + i * 0.75f, { 255, i * 20, 255 - i * 20, 255 });
+		}
+		Renderer2D::DrawLine({ 4.5f, 120.f }, { 123.5f, 100.f }, 6.f, { 255, 255, 255, 128 });
+		Renderer2D::DrawLine({ 10.f, 10.f }, { 118.f, 10.f }, 1.f, { 0, 255, 0, 255 }, 0.f);
+	});
+
+	regression.AddScene("circles", { 128, 128 }, [] {
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				glm::vec2 center = { 16.f + i * 32.f + j * 0.25f, 16.f + j * 32.f };
+				float radius = 4.f + i * 3.f + j;
+				glm::vec4 fill = (j % 2 == 0) ? glm::vec4(40, 120, 255, 255) : glm::vec4(0, 0, 0, 0);
+				Renderer2D::DrawCircle(center, radius, (float)i, { 255, 200, 0, 255 }, fill);
+			}
+		}
+		Renderer2D::DrawCircle({ 64.f, 64.f }, 40.f, 3.f, { 255, 255, 255, 100 }, { 255, 0, 0, 60 });
+	});
+
+	regression.AddScene("arcs", { 128, 128 }, [] {
+		for (int i = 0; i < 6; i++) {
+			float start = i * 50.f;
+			Renderer2D::DrawArc({ 64.f, 64.f }, 10.f + i * 9.f, start, start + 60.f + i * 45.f, 2.f + i,
+				{ 255 - i * 40, 100 + i * 30, 200, 255 });
+		}
+		Renderer2D::DrawArc({ 64.f, 64.f }, 60.f, 330.f, 30.f, 4.f, { 255, 255, 255, 160 });
+	});
+
+	regression.AddScene("rects", { 128, 128 }, [] {
+		Renderer2D::DrawRectangle({ 8.f, 8.f }, { 56.f, 40.f }, 0.f, { 0, 0, 0, 0 }, { 200, 60, 60, 255 });
+		Renderer2D::DrawRectangle({ 72.f, 8.f }, { 120.f, 40.f }, 3.f, { 60, 200, 60, 255 }, { 0, 0, 0, 0 });
+		Renderer2D::DrawRectangle({ 8.5f, 56.5f }, { 56.5f, 88.5f }, 2.f, { 255, 255, 255, 255 }, { 60, 60, 200, 255 });
+		Renderer2D::DrawRectangle({ 40.f, 72.f }, { 100.f, 120.f }, 1.f, { 255, 255, 0, 200 }, { 255, 128, 0, 128 });
+		Renderer2D::DrawRectangle({ 110.f, 60.f }, { 112.f, 124.f }, 0.f, { 0, 0, 0, 0 }, { 0, 255, 255, 255 });
+	});
+
+	regression.AddScene("paths", { 128, 128 }, [] {
+		std::vector<glm::vec2> zigzag;
+		for (int i = 0; i < 6; i++) {
+			zigzag.push_back({ 12.f + i * 20.f, (i % 2 == 0) ? 12.f : 36.f });
+		}
+
+		const Graphics::LINEJOIN joins[] = { Graphics::LINEJOIN::MITER, Graphics::LINEJOIN::BEVEL,
+			Graphics::LINEJOIN::ROUND };
+		const Graphics::LINECAP caps[] = { Graphics::LINECAP::SQUARE, Graphics::LINECAP::TRIANGLE,
+			Graphics::LINECAP::ROUND };
+		for (int i = 0; i < 3; i++) {
+			StrokeStyle style;
+			style.thickness = 6.f;
+			style.join = joins[i];
+			style.cap = caps[i];
+			std::vector<glm::vec2> points = zigzag;
+			for (glm::vec2& point : points) {
+				point.y += i * 32.f;
+			}
+			Renderer2D::DrawPolyline(points.data(), points.size(), { 100 + i * 70, 200, 255 - i * 70, 255 }, style);
+		}
+
+		std::vector<glm::vec2> star;
+		for (int i = 0; i < 10; i++) {
+			float angle = glm::radians(i * 36.f - 90.f);
+			float radius = (i % 2 == 0) ? 20.f : 8.f;
+			star.push_back(glm::vec2(100.f, 108.f) + glm::vec2(cos(angle), sin(angle)) * radius);
+		}
+		Renderer2D::DrawPath(star, 2.f, { 255, 255, 255, 255 });
+	});
+
+	regression.AddScene("sprites", { 128, 128 }, [&resources] {
+		Renderer2D::DrawTexture({ 4.f, 4.f }, { 68.f, 68.f }, resources.checkerboard);
+		Renderer2D::DrawTexture({ 76.f, 4.f }, { 124.f, 36.f }, resources.checkerboard, { 255, 128, 128, 255 });
+		Renderer2D::DrawTexture({ 36.f, 36.f }, { 100.f, 100.f }, resources.checkerboard, { 255, 255, 255, 100 });
+
+		float x = 4.f;
+		for (const AtlasRegion& sprite : resources.sprites) {
+			float size = (float)sprite.rect.width;
+			Renderer2D::DrawSprite({ x, 124.f - size }, { x + size, 124.f }, resources.atlas, sprite);
+			x += size + 4.f;
+		}
+	});
+
+	regression.AddScene("text", { 128, 128 }, [&resources] {
+		Renderer2D::DrawString(resources.font, "Battery", { 4.f, 2.f }, 24.f, { 255, 255, 255, 255 });
+		Renderer2D::DrawString(resources.font, "Kerning: AVA To Wa", { 4.f, 32.f }, 16.f, { 255, 220, 120, 255 });
+		Renderer2D::DrawString(resources.font, "Two lines\nof small text", { 4.f, 56.f }, 12.f, { 120, 200, 255, 255 });
+		Renderer2D::DrawString(resources.font, "0123456789", { 4.5f, 100.25f }, 14.f, { 255, 255, 255, 140 });
+	});
+
+	// The labels repeat every 10 rows and columns, which keeps the golden image small
+	regression.AddScene("labels", { 800, 600 }, [&resources] {
+		for (int y = 0; y < LABEL_ROWS; y++) {
+			for (int x = 0; x < LABEL_COLUMNS; x++) {
+				std::string label = std::to_string((y % 10) * 10 + x % 10);
+				Renderer2D::DrawString(resources.font, label, { x * 8.f, y * 6.f }, (float)LABEL_SIZE, { 255, 255, 255, 255 });
+			}
+		}
+	});
+}
+
+TEST(RenderRegression) {
+
+	SceneResources resources;
+	CHECK(resources.Load());
+
+	RenderRegression regression(Tests::GetGoldenDirectory());
+	AddScenes(regression, resources);
+
+	std::vector<RenderRegressionResult> results;
+	CHECK(regression.RunFromCommandLine(Tests::GetArgs(), &results) == 0);
+
+	for (const RenderRegressionResult& result : results) {
+		// All labels come from the pages of one atlas, every page must be drawn in a single batch
+		if (result.name == "labels")
+			CHECK(result.spriteBatches > 0 && result.spriteBatches <= resources.font.GetAtlas().GetPageCount());
+
+		if (result.goldenWritten)
+			printf("  %s: Wrote the golden image\n", result.name.c_str());
+		else if (result.goldenMissing)
+			printf("  %s: Missing golden image, run with --update to write it\n", result.name.c_str());
+		else if (!result.passed)
+			printf("  %s: %zu pixels differ by up to %d\n", result.name.c_str(), result.differentPixels,
+				result.maxDifference);
+	}
+}
+
+BENCHMARK(RenderScenes) {
+
+	SceneResources resources;
+	if (!resources.Load())
+		return;
+
+	RenderRegression regression(Tests::GetGoldenDirectory());
+	AddScenes(regression, resources);
+
+	for (const RenderRegressionResult& result : regression.Run("", 20)) {
+		Tests::Report("RenderScenes", result.name, { { "cpuTime [ms]", result.cpuTime * 1000.0 },
+			{ "drawCalls", (double)result.drawCalls }, { "spriteBatches", (double)result.spriteBatches },
+			{ "vertices", (double)result.vertices } });
+	}
+}
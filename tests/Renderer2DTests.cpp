@@ -0,0 +1,118 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Core/Application.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+struct TestSprite {
+	glm::vec2 point1;
+	glm::vec2 point2;
+	size_t texture;
+	glm::vec4 tint;
+};
+
+static bool LoadSolidTexture(Texture2D& texture, uint8_t r, uint8_t g, uint8_t b) {
+	std::vector<uint8_t> pixels(4 * 4 * 4);
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		pixels[i] = r;
+		pixels[i + 1] = g;
+		pixels[i + 2] = b;
+		pixels[i + 3] = 255;
+	}
+	return texture.LoadPixels(pixels.data(), 4 * 4, PixelConvert::PixelLayout::RGBA8, 4, 4);
+}
+
+// Draws the sprites into the target, with a flush after every sprite they are drawn exactly in submission order
+static std::vector<uint32_t> DrawSprites(Texture2D& target, const std::vector<Texture2D>& textures,
+		const std::vector<TestSprite>& sprites, bool flushEach, Renderer2DStats* stats = nullptr) {
+
+	Scene scene(GetApplication()->window, target);
+	Renderer2D::BeginScene(&scene);
+	Renderer2D::DrawBackground({ 0, 0, 0, 0 });
+	Renderer2D::ResetStats();
+	for (const TestSprite& sprite : sprites) {
+		Renderer2D::DrawTexture(sprite.point1, sprite.point2, textures[sprite.texture], sprite.tint);
+		if (flushEach)
+			Renderer2D::FlushSprites();
+	}
+	Renderer2D::EndScene();
+	if (stats != nullptr)
+		*stats = Renderer2D::GetStats();
+
+	std::vector<uint32_t> pixels;
+	ALLEGRO_BITMAP* bitmap = target.GetAllegroBitmap();
+	ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+	if (region == nullptr)
+		return pixels;
+
+	int width = al_get_bitmap_width(bitmap);
+	int height = al_get_bitmap_height(bitmap);
+	pixels.resize((size_t)width * height);
+	for (int y = 0; y < height; y++) {
+		memcpy(&pixels[(size_t)y * width], (uint8_t*)region->data + (ptrdiff_t)y * region->pitch, (size_t)width * 4);
+	}
+	al_unlock_bitmap(bitmap);
+	return pixels;
+}
+
+TEST(SpriteSortingKeepsOverlapOrder) {
+
+	std::vector<Texture2D> textures(3);
+	CHECK(LoadSolidTexture(textures[0], 255, 0, 0));
+	CHECK(LoadSolidTexture(textures[1], 0, 255, 0));
+	CHECK(LoadSolidTexture(textures[2], 0, 0, 255));
+	Texture2D target(96, 96);
+	CHECK(target.IsValid());
+
+	// Translucent sprites, so any reordered overlapping pair changes the blended color
+	std::mt19937 random(46);
+	std::uniform_real_distribution<float> position(-8.f, 96.f);
+	std::uniform_real_distribution<float> size(2.f, 24.f);
+	bool allMatch = true;
+	size_t sortedBatches = 0;
+	size_t submittedBatches = 0;
+	for (int scene = 0; scene < 20; scene++) {
+		std::vector<TestSprite> sprites(200);
+		for (TestSprite& sprite : sprites) {
+			sprite.point1 = { std::floor(position(random)), std::floor(position(random)) };
+			sprite.point2 = sprite.point1 + glm::floor(glm::vec2(size(random), size(random)));
+			sprite.texture = random() % textures.size();
+			sprite.tint = { 255, 255, 255, (float)(96 + random() % 128) };
+		}
+
+		Renderer2DStats stats;
+		std::vector<uint32_t> sorted = DrawSprites(target, textures, sprites, false, &stats);
+		std::vector<uint32_t> submitted = DrawSprites(target, textures, sprites, true);
+		allMatch &= !sorted.empty() && sorted == submitted;
+		sortedBatches += stats.spriteBatches;
+		submittedBatches += stats.spriteBatches + stats.batchesSaved;
+	}
+	CHECK(allMatch);
+	CHECK(sortedBatches < submittedBatches);
+
+	// Sprites which don't overlap are merged by texture
+	std::vector<TestSprite> apart;
+	for (int i = 0; i < 8; i++) {
+		apart.push_back({ { i * 12.f, 0.f }, { i * 12.f + 8.f, 8.f }, (size_t)(i % 2), { 255, 255, 255, 255 } });
+	}
+	Renderer2DStats stats;
+	DrawSprites(target, textures, apart, false, &stats);
+	CHECK(stats.spriteBatches == 2 && stats.batchesSaved == 6);
+
+	// Layers can need more batches than the submission order: texture 0 on layers 0 and 1, then texture 1 on layer 0
+	Scene scene(GetApplication()->window, target);
+	Renderer2D::BeginScene(&scene);
+	Renderer2D::ResetStats();
+	Renderer2D::DrawTexture({ 0.f, 0.f }, { 8.f, 8.f }, textures[0]);
+	Renderer2D::SetSortOrder(1);
+	Renderer2D::DrawTexture({ 16.f, 0.f }, { 24.f, 8.f }, textures[0]);
+	Renderer2D::SetSortOrder(0);
+	Renderer2D::DrawTexture({ 32.f, 0.f }, { 40.f, 8.f }, textures[1]);
+	Renderer2D::EndScene();
+	stats = Renderer2D::GetStats();
+	CHECK(stats.spriteBatches == 3 && stats.batchesSaved == 0);
+}
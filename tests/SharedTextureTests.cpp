@@ -0,0 +1,111 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Renderer2D.h"
+#include "Battery/Renderer/SharedTexture.h"
+#include "Testing.h"
+
+using namespace Battery;
+
+// Every clone goes through Texture2D, so the counter sees all calls to al_clone_bitmap() of the tests below
+class CloneCounter {
+public:
+	size_t Get() const {
+		return Texture2D::GetCloneCount() - start;
+	}
+
+private:
+	size_t start = Texture2D::GetCloneCount();
+};
+
+TEST(SharedTextureCopiesDontClone) {
+
+	SharedTexture texture(Texture2D(16, 16));
+	CloneCounter clones;
+
+	SharedTexture copy = texture;
+	SharedTexture assigned;
+	assigned = copy;
+	std::vector<SharedTexture> handles(100, texture);
+
+	CHECK(clones.Get() == 0);
+	CHECK(copy.GetAllegroBitmap() == texture.GetAllegroBitmap());
+	CHECK(assigned.GetAllegroBitmap() == texture.GetAllegroBitmap());
+	CHECK(texture.GetUseCount() == 103);
+	CHECK(texture.IsShared());
+}
+
+TEST(SceneTexturesGrowWithoutCloning) {
+
+	// The container of Scene, growing it must move the textures
+	decltype(Scene::textures) textures;
+	std::vector<ALLEGRO_BITMAP*> bitmaps;
+	CloneCounter clones;
+
+	for (int i = 0; i < 100; i++) {
+		textures.emplace_back(8, 8);
+		bitmaps.push_back(textures.back().GetAllegroBitmap());
+	}
+	textures.push_back(Texture2D(8, 8));
+	textures.insert(textures.begin(), Texture2D(8, 8));
+
+	CHECK(clones.Get() == 0);
+	for (size_t i = 0; i < bitmaps.size(); i++) {
+		CHECK(textures[i + 1].GetAllegroBitmap() == bitmaps[i]);
+	}
+}
+
+TEST(SharedTextureGetMutableClonesOnlyShared) {
+
+	SharedTexture texture(Texture2D(16, 16));
+	ALLEGRO_BITMAP* original = texture.GetAllegroBitmap();
+
+	// Unique: Modified in place
+	CloneCounter uniqueClones;
+	texture.GetMutable();
+	CHECK(uniqueClones.Get() == 0);
+	CHECK(texture.GetAllegroBitmap() == original);
+
+	// Shared: Cloned once, the other handle keeps the original
+	SharedTexture copy = texture;
+	CloneCounter sharedClones;
+	copy.GetMutable();
+	CHECK(sharedClones.Get() == 1);
+	CHECK(copy.GetAllegroBitmap() != original);
+	CHECK(texture.GetAllegroBitmap() == original);
+	CHECK(!copy.IsShared() && !texture.IsShared());
+
+	// Unique again after the clone
+	copy.GetMutable();
+	CHECK(sharedClones.Get() == 1);
+
+	// Not owned by the handle, e.g. from the AssetCache: Always cloned once
+	auto foreign = std::make_shared<const Texture2D>(16, 16);
+	SharedTexture borrowed(foreign);
+	CloneCounter foreignClones;
+	borrowed.GetMutable();
+	borrowed.GetMutable();
+	CHECK(foreignClones.Get() == 1);
+	CHECK(borrowed.GetAllegroBitmap() != foreign->GetAllegroBitmap());
+}
+
+TEST(SharedTextureSetFlagsClonesOnce) {
+
+	SharedTexture texture(Texture2D(16, 16));
+
+	// Allegro can't change the flags of a bitmap, so even a unique texture is cloned, but only once
+	CloneCounter uniqueClones;
+	CHECK(texture.SetFlags(ALLEGRO_MIN_LINEAR));
+	CHECK(uniqueClones.Get() == 1);
+	CHECK(texture->GetFlags() & ALLEGRO_MIN_LINEAR);
+
+	// Shared: Cloned once with the new flags, not once for GetMutable() and once for the flags
+	SharedTexture copy = texture;
+	ALLEGRO_BITMAP* original = texture.GetAllegroBitmap();
+	CloneCounter sharedClones;
+	CHECK(copy.SetFlags(ALLEGRO_MAG_LINEAR));
+	CHECK(sharedClones.Get() == 1);
+	CHECK(copy->GetFlags() & ALLEGRO_MAG_LINEAR);
+	CHECK(texture.GetAllegroBitmap() == original);
+	CHECK(texture->GetFlags() & ALLEGRO_MIN_LINEAR);
+	CHECK(!(texture->GetFlags() & ALLEGRO_MAG_LINEAR));
+}
@@ -0,0 +1,117 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/SpatialIndex.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+struct Bounds {
+	glm::vec2 min;
+	glm::vec2 max;
+};
+
+// Mostly small items spread over the world, a few of them very large
+static std::vector<Bounds> RandomItems(size_t count, float worldSize, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(0.f, worldSize);
+	std::uniform_real_distribution<float> size(1.f, 50.f);
+	std::uniform_real_distribution<float> largeSize(worldSize / 20.f, worldSize / 2.f);
+
+	std::vector<Bounds> items(count);
+	for (size_t i = 0; i < count; i++) {
+		glm::vec2 min = { position(random), position(random) };
+		glm::vec2 extent = (i % 1000 == 0) ? glm::vec2(largeSize(random), largeSize(random)) : glm::vec2(size(random), size(random));
+		items[i] = { min, min + extent };
+	}
+	return items;
+}
+
+// The reference, every item is tested in order
+static void QueryLinear(const std::vector<Bounds>& items, const glm::vec2& min, const glm::vec2& max,
+		std::vector<uint32_t>& result) {
+
+	result.clear();
+	for (uint32_t i = 0; i < items.size(); i++) {
+		if (items[i].max.x >= min.x && items[i].min.x <= max.x && items[i].max.y >= min.y && items[i].min.y <= max.y)
+			result.push_back(i);
+	}
+}
+
+TEST(SpatialIndexMatchesLinearScan) {
+
+	const float worldSize = 2000.f;
+	std::vector<Bounds> items = RandomItems(20000, worldSize, 43);
+
+	SpatialIndex index;
+	for (const Bounds& item : items) {
+		index.Insert(item.min, item.max);
+	}
+	CHECK(index.GetSize() == items.size());
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-100.f, worldSize);
+	std::vector<uint32_t> expected;
+
+	// From single points up to views larger than the world
+	bool allMatch = true;
+	for (float viewSize : { 0.f, 10.f, 100.f, 500.f, 3000.f }) {
+		for (int i = 0; i < 50; i++) {
+			glm::vec2 min = { position(random), position(random) };
+			glm::vec2 max = min + viewSize;
+			QueryLinear(items, min, max, expected);
+			allMatch &= index.Query(min, max) == expected;
+		}
+	}
+	CHECK(allMatch);
+
+	// Items inserted after a query are found by the next one
+	uint32_t added = index.Insert({ 5000.f, 5000.f }, { 5001.f, 5001.f });
+	CHECK(index.Query({ 4990.f, 4990.f }, { 5010.f, 5010.f }) == std::vector<uint32_t>{ added });
+
+	index.Clear();
+	CHECK(index.GetSize() == 0);
+	CHECK(index.Query({ 0.f, 0.f }, { worldSize, worldSize }).empty());
+}
+
+BENCHMARK(SpatialIndex) {
+
+	const float worldSize = 100000.f;
+	std::vector<Bounds> items = RandomItems(1000000, worldSize, 1);
+
+	SpatialIndex index;
+	for (const Bounds& item : items) {
+		index.Insert(item.min, item.max);
+	}
+
+	// The first query builds the grid
+	double build = Tests::MeasureFastest(1, [&] { index.Query({ 0.f, 0.f }, { 0.f, 0.f }); });
+	Tests::Report("SpatialIndex", "build 1M items", { { "ms", build * 1000.0 } });
+
+	std::vector<uint32_t> linear;
+	for (float zoom : { 1.f, 4.f, 16.f, 64.f, 256.f }) {
+		glm::vec2 viewSize = glm::vec2(worldSize / zoom);
+
+		// Panning over the world, the time is the average of one query
+		const int views = 16;
+		size_t visible = 0;
+		double start = TimeUtils::GetRuntime();
+		for (int i = 0; i < views; i++) {
+			glm::vec2 min = (glm::vec2(worldSize) - viewSize) * glm::vec2(i / 4, i % 4) / 3.f;
+			visible += index.Query(min, min + viewSize).size();
+		}
+		double indexed = (TimeUtils::GetRuntime() - start) / views;
+
+		start = TimeUtils::GetRuntime();
+		for (int i = 0; i < views; i++) {
+			glm::vec2 min = (glm::vec2(worldSize) - viewSize) * glm::vec2(i / 4, i % 4) / 3.f;
+			QueryLinear(items, min, min + viewSize, linear);
+		}
+		double scanned = (TimeUtils::GetRuntime() - start) / views;
+
+		Tests::Report("SpatialIndex", "zoom " + std::to_string((int)zoom) + "x", { { "visible", (double)visible / views },
+			{ "query [ms]", indexed * 1000.0 }, { "linear [ms]", scanned * 1000.0 } });
+	}
+}
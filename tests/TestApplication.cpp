@@ -0,0 +1,52 @@
+
+#include "Battery/pch.h"
+#include "Battery/Core/Application.h"
+#include "Testing.h"
+
+/// <summary>
+/// Runs the tests headless with the software backend of Renderer2D, the exit code is the number of failed tests:
+///   BatteryTests [--test <filter>] [--dir <tests directory>] [RenderRegression options]
+///   BatteryTests --benchmark [<filter>]
+/// The tests directory defaults to '../tests' from the executable. The options of the render regression are
+/// the ones of RenderRegression::RunFromCommandLine(), e.g. --update writes new golden images.
+/// </summary>
+class TestApplication : public Battery::Application {
+public:
+	TestApplication() : Battery::Application(BATTERY_MIN_WINDOW_WIDTH, BATTERY_MIN_WINDOW_HEIGHT,
+		"BatteryTests", Battery::RenderBackend::SOFTWARE) {}
+
+	bool OnStartup() override {
+
+		std::string filter;
+		bool benchmark = false;
+
+		for (size_t i = 1; i < args.size(); i++) {
+			bool hasValue = i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0;
+
+			if (args[i] == "--test" && hasValue) {
+				filter = args[++i];
+			}
+			else if (args[i] == "--benchmark") {
+				benchmark = true;
+				if (hasValue)
+					filter = args[++i];
+			}
+		}
+
+		Tests::SetArgs(args);
+
+		if (benchmark) {
+			Tests::RunBenchmarks(filter);
+			CloseApplication(EXIT_SUCCESS);
+		}
+		else {
+			CloseApplication(std::min(Tests::RunTests(filter), 255));
+		}
+
+		return true;
+	}
+};
+
+Battery::Application* Battery::CreateApplication() {
+	return new TestApplication();
+}
@@ -0,0 +1,191 @@
+
+#include "Battery/pch.h"
+#include "Battery/Utils/FileUtils.h"
+#include "Battery/Utils/PathUtils.h"
+#include "Battery/Utils/TimeUtils.h"
+#include "Testing.h"
+
+// Every allocation is counted, so benchmarks can report the memory a variant needs at its peak.
+// The size is kept in front of the block, which keeps the alignment of malloc()
+static constexpr size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+static std::atomic<size_t> allocatedBytes = 0;
+static std::atomic<size_t> peakAllocatedBytes = 0;
+
+void* operator new(size_t size) {
+	uint8_t* block = (uint8_t*)malloc(size + ALLOCATION_HEADER);
+	if (block == nullptr)
+		throw std::bad_alloc();
+
+	*(size_t*)block = size;
+	size_t allocated = allocatedBytes.fetch_add(size) + size;
+	size_t peak = peakAllocatedBytes.load();
+	while (allocated > peak && !peakAllocatedBytes.compare_exchange_weak(peak, allocated));
+
+	return block + ALLOCATION_HEADER;
+}
+
+void operator delete(void* pointer) noexcept {
+	if (pointer == nullptr)
+		return;
+
+	uint8_t* block = (uint8_t*)pointer - ALLOCATION_HEADER;
+	allocatedBytes.fetch_sub(*(size_t*)block);
+	free(block);
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete[](void* pointer) noexcept {
+	operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept {
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t size) noexcept {
+	operator delete(pointer);
+}
+
+namespace Tests {
+
+	struct Entry {
+		std::string name;
+		TestFunction function;
+	};
+
+	// Registered from static initializers, so they are constructed on first use
+	static std::vector<Entry>& GetTests() {
+		static std::vector<Entry> tests;
+		return tests;
+	}
+
+	static std::vector<Entry>& GetBenchmarks() {
+		static std::vector<Entry> benchmarks;
+		return benchmarks;
+	}
+
+	static std::vector<std::string> arguments;
+	static size_t failures = 0;
+
+	bool RegisterTest(const char* name, TestFunction function) {
+		GetTests().push_back({ name, function });
+		return true;
+	}
+
+	bool RegisterBenchmark(const char* name, TestFunction function) {
+		GetBenchmarks().push_back({ name, function });
+		return true;
+	}
+
+	int RunTests(const std::string& filter) {
+
+		int failedTests = 0;
+		int ranTests = 0;
+
+		for (const Entry& test : GetTests()) {
+			if (test.name.find(filter) == std::string::npos)
+				continue;
+
+			failures = 0;
+			try {
+				test.function();
+			}
+			catch (const std::exception& e) {
+				Fail(test.name.c_str(), 0, std::string("Unhandled exception: ") + e.what());
+			}
+
+			printf("[%s] %s\n", failures == 0 ? "  OK  " : "FAILED", test.name.c_str());
+			ranTests++;
+			if (failures > 0)
+				failedTests++;
+		}
+
+		Battery::FileUtils::RemoveDirectory(GetTempPath(""));
+		printf("%d of %d tests passed\n", ranTests - failedTests, ranTests);
+		return failedTests;
+	}
+
+	void RunBenchmarks(const std::string& filter) {
+
+		for (const Entry& benchmark : GetBenchmarks()) {
+			if (benchmark.name.find(filter) == std::string::npos)
+				continue;
+
+			printf("%s\n", benchmark.name.c_str());
+			benchmark.function();
+		}
+
+		Battery::FileUtils::RemoveDirectory(GetTempPath(""));
+	}
+
+	void Fail(const char* file, int line, const std::string& message) {
+		printf("  %s:%d: %s\n", file, line, message.c_str());
+		failures++;
+	}
+
+	const std::vector<std::string>& GetArgs() {
+		return arguments;
+	}
+
+	void SetArgs(const std::vector<std::string>& args) {
+		arguments = args;
+	}
+
+	static std::string GetTestsDirectory() {
+		for (size_t i = 0; i + 1 < arguments.size(); i++) {
+			if (arguments[i] == "--dir")
+				return arguments[i + 1];
+		}
+		return Battery::PathUtils::Join(Battery::FileUtils::GetExecutableDirectory(), "../tests");
+	}
+
+	std::string GetDataPath(const std::string& file) {
+		return Battery::PathUtils::Join(Battery::PathUtils::Join(GetTestsDirectory(), "data"), file);
+	}
+
+	std::string GetGoldenDirectory() {
+		return Battery::PathUtils::Join(GetTestsDirectory(), "golden");
+	}
+
+	std::string GetTempPath(const std::string& file) {
+		std::string directory = Battery::PathUtils::Join(GetTestsDirectory(), "temp");
+		Battery::FileUtils::PrepareDirectory(directory);
+		return file.empty() ? directory : Battery::PathUtils::Join(directory, file);
+	}
+
+	double MeasureFastest(size_t iterations, const std::function<void()>& function) {
+		double fastest = std::numeric_limits<double>::max();
+		for (size_t i = 0; i < std::max<size_t>(iterations, 1); i++) {
+			double start = Battery::TimeUtils::GetRuntime();
+			function();
+			fastest = std::min(fastest, Battery::TimeUtils::GetRuntime() - start);
+		}
+		return fastest;
+	}
+
+	size_t GetAllocatedBytes() {
+		return allocatedBytes.load();
+	}
+
+	size_t GetPeakAllocatedBytes() {
+		return peakAllocatedBytes.load();
+	}
+
+	void ResetPeakAllocatedBytes() {
+		peakAllocatedBytes.store(allocatedBytes.load());
+	}
+
+	void Report(const std::string& benchmark, const std::string& variant,
+			const std::vector<std::pair<std::string, double>>& values) {
+
+		printf("  %-24s %-28s", benchmark.c_str(), variant.c_str());
+		for (auto& [name, value] : values) {
+			printf("  %s: %.3f", name.c_str(), value);
+		}
+		printf("\n");
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Battery/pch.h"
+
+/// <summary>
+/// A minimal test and benchmark registry for the test application of the engine. Tests and benchmarks are
+/// functions registered with TEST() and BENCHMARK() in any file of the project. CHECK() records a failure
+/// and the test continues. Everything runs in OnStartup() of a headless application, so Allegro and the
+/// software backend of Renderer2D are set up, but there is no display.
+/// </summary>
+namespace Tests {
+
+	using TestFunction = void(*)();
+
+	bool RegisterTest(const char* name, TestFunction function);
+	bool RegisterBenchmark(const char* name, TestFunction function);
+
+	// Runs all tests whose name contains the filter, returns the number of failed tests
+	int RunTests(const std::string& filter);
+	void RunBenchmarks(const std::string& filter);
+
+	void Fail(const char* file, int line, const std::string& message);
+
+	// The arguments of the test application, e.g. for RenderRegression::RunFromCommandLine()
+	const std::vector<std::string>& GetArgs();
+	void SetArgs(const std::vector<std::string>& args);
+
+	// Test data and golden images are looked up relative to the working directory, which is 'tests'
+	std::string GetDataPath(const std::string& file);
+	std::string GetGoldenDirectory();
+	// A scratch directory which is removed when the tests are done
+	std::string GetTempPath(const std::string& file);
+
+	// Seconds of the fastest iteration
+	double MeasureFastest(size_t iterations, const std::function<void()>& function);
+	// Bytes allocated with operator new, which is counted by the test application
+	size_t GetAllocatedBytes();
+	// The most allocated at once since the last reset
+	size_t GetPeakAllocatedBytes();
+	void ResetPeakAllocatedBytes();
+	// Prints one row of benchmark results, e.g. Report("Json", "SAX", { { "ms", 12.3 }, { "MB", 1.5 } })
+	void Report(const std::string& benchmark, const std::string& variant,
+		const std::vector<std::pair<std::string, double>>& values);
+
+}
+
+#define TEST(name) \
+	static void name##Test(); \
+	static bool name##TestRegistered = Tests::RegisterTest(#name, name##Test); \
+	static void name##Test()
+
+#define BENCHMARK(name) \
+	static void name##Benchmark(); \
+	static bool name##BenchmarkRegistered = Tests::RegisterBenchmark(#name, name##Benchmark); \
+	static void name##Benchmark()
+
+#define CHECK(expression) \
+	do { if (!(expression)) Tests::Fail(__FILE__, __LINE__, #expression); } while (false)
@@ -0,0 +1,77 @@
+
+#include "Battery/pch.h"
+#include "Battery/Renderer/Texture2D.h"
+#include "Battery/Graphics.h"
+#include "Testing.h"
+
+#include <random>
+
+using namespace Battery;
+
+// The readback Texture2D::GetClipImage() used before PixelConvert: One al_get_pixel() per pixel
+static std::vector<uint32_t> ReadPerPixel(ALLEGRO_BITMAP* bitmap) {
+	int width = al_get_bitmap_width(bitmap);
+	int height = al_get_bitmap_height(bitmap);
+	std::vector<uint32_t> pixels((size_t)width * height);
+
+	al_lock_bitmap(bitmap, al_get_bitmap_format(bitmap), ALLEGRO_LOCK_READONLY);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			glm::vec4 color = Graphics::ConvertAllegroColor(al_get_pixel(bitmap, x, y));
+			pixels[(size_t)y * width + x] = (uint32_t)color.a << 24 | (uint32_t)color.b << 16 | (uint32_t)color.g << 8 |
+				(uint32_t)color.r;
+		}
+	}
+	al_unlock_bitmap(bitmap);
+
+	return pixels;
+}
+
+TEST(Texture2DPixelsRoundTrip) {
+
+	// The native formats LockBitmap() uses directly, each one takes another path through PixelConvert
+	const int formats[] = { ALLEGRO_PIXEL_FORMAT_ABGR_8888, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_PIXEL_FORMAT_ARGB_8888 };
+	const int widths[] = { 1, 3, 4, 5, 7, 16, 17, 67 };
+	const int height = 5;
+
+	std::mt19937 random(32);
+
+	for (int format : formats) {
+		for (int width : widths) {
+			// Padded rows, to check that the pitch is respected
+			size_t pitch = (size_t)width * 4 + 12;
+			std::vector<uint8_t> source(pitch * height);
+			for (uint8_t& byte : source) {
+				byte = (uint8_t)random();
+			}
+
+			ALLEGRO_STATE state;
+			al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+			al_set_new_bitmap_format(format);
+			Texture2D texture;
+			bool loaded = texture.LoadPixels(source.data(), pitch, PixelConvert::PixelLayout::RGBA8, width, height);
+			al_restore_state(&state);
+
+			CHECK(loaded);
+			if (!loaded)
+				return;
+			CHECK(al_get_bitmap_format(texture.GetAllegroBitmap()) == format);
+
+			auto image = texture.GetClipImage();
+			CHECK(image.has_value());
+			if (!image)
+				return;
+
+			auto& [pixels, spec] = *image;
+			CHECK(PixelConvert::GetLayout(spec) == PixelConvert::PixelLayout::RGBA8);
+			CHECK(spec.width == (unsigned long)width && spec.height == (unsigned long)height);
+			CHECK(pixels == ReadPerPixel(texture.GetAllegroBitmap()));
+
+			bool roundTrip = true;
+			for (int y = 0; y < height; y++) {
+				roundTrip &= memcmp(&pixels[(size_t)y * width], &source[y * pitch], (size_t)width * 4) == 0;
+			}
+			CHECK(roundTrip);
+		}
+	}
+}